@@ -76,6 +76,7 @@ endif()
 
 # set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -Wno-format-security")
 target_link_libraries(SahCore PUBLIC
+        basisu_transcoder
         cereal::cereal
         EASTL
         EnTT::EnTT
@@ -88,6 +89,7 @@ target_link_libraries(SahCore PUBLIC
         imguizmo
         Jolt
         magic_enum::magic_enum
+        meshoptimizer
         NRD
         NRDIntegration
         NRI
@@ -62,7 +62,8 @@ Engine::Engine() :
 
     render_world = eastl::make_unique<render::RenderWorld>(
         renderer->get_mesh_storage(),
-        renderer->get_material_storage()
+        renderer->get_material_storage(),
+        renderer->get_texture_loader().get_streamer()
         );
 
     render_world->setup_observers(world);
@@ -137,6 +138,8 @@ void Engine::tick() {
 
     update_perf_tracker();
 
+    resource_loader.tick();
+
     spawn_new_game_objects();
 
     SystemInterface::get().poll_input(player_input);
@@ -163,6 +166,8 @@ void Engine::tick() {
 
     world.tick(delta_time);
 
+    physics_world.sync_transforms_to_bodies(world);
+
     // UI
 
     ui_controller->tick();
@@ -338,13 +343,37 @@ void Engine::update_perf_tracker() {
 
 void Engine::spawn_new_game_objects() {
     auto& registry = world.get_registry();
+
+    // Group the spawners by prefab, so that each prefab gets spawned in one batch
+    auto spawners_by_prefab = eastl::unordered_map<ResourcePath, eastl::vector<entt::entity>>{};
     registry.view<SpwanPrefabComponent>().each(
-        [&](const entt::entity entity, const SpwanPrefabComponent& spawn_prefab_comp
-        ) {
-            const auto transform = registry.get<TransformComponent>(entity);
-            // Replace this node with the prefab
-            const auto instance = add_prefab_to_world(spawn_prefab_comp.prefab_path,
-                                                      transform.get_local_to_world());
+        [&](const entt::entity entity, const SpwanPrefabComponent& spawn_prefab_comp) {
+            spawners_by_prefab[spawn_prefab_comp.prefab_path].emplace_back(entity);
+        });
+
+    auto transforms = eastl::vector<float4x4>{};
+    for(const auto& [prefab_path, spawners] : spawners_by_prefab) {
+        transforms.clear();
+        for(const auto spawner : spawners) {
+            transforms.emplace_back(registry.get<TransformComponent>(spawner).get_local_to_world());
+        }
+
+        // Replace each spawner with an instance of the prefab. If the prefab is broken, the spawners give up. The
+        // prefab isn't cached, so later spawners will try it again
+        auto instances = eastl::vector<entt::handle>{};
+        try {
+            instances = prefab_loader.spawn_prefabs(prefab_path, world, transforms);
+        } catch(const std::exception& e) {
+            logger->error("Could not spawn prefab {}: {}", prefab_path, e.what());
+            for(const auto spawner : spawners) {
+                registry.remove<SpwanPrefabComponent>(spawner);
+            }
+            continue;
+        }
+
+        for(auto i = 0u; i < spawners.size(); i++) {
+            const auto entity = spawners[i];
+            const auto& instance = instances[i];
 
             eastl::string name = "Spawned Entity";
             const auto* entity_info = registry.try_get<EntityInfoComponent>(entity);
@@ -358,8 +387,11 @@ void Engine::spawn_new_game_objects() {
             }
             instance.emplace_or_replace<EntityInfoComponent>(EntityInfoComponent{.name = name});
 
+            // The spawner isn't destroyed until World::tick, so take its component now to make sure it only spawns once
+            registry.remove<SpwanPrefabComponent>(entity);
             world.destroy_entity(entity);
-        });
+        }
+    }
 }
 
 void Engine::exit() {
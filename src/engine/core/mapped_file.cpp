@@ -0,0 +1,123 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+eastl::optional<MappedFile> MappedFile::open(const std::filesystem::path& filepath) {
+    auto file = MappedFile{};
+
+#if defined(_WIN32)
+    file.file_handle = CreateFileW(
+        filepath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if(file.file_handle == INVALID_HANDLE_VALUE) {
+        file.file_handle = nullptr;
+        return eastl::nullopt;
+    }
+
+    auto file_size = LARGE_INTEGER{};
+    if(!GetFileSizeEx(file.file_handle, &file_size) || file_size.QuadPart == 0) {
+        return eastl::nullopt;
+    }
+    file.size = static_cast<size_t>(file_size.QuadPart);
+
+    file.mapping_handle = CreateFileMappingW(file.file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(file.mapping_handle == nullptr) {
+        return eastl::nullopt;
+    }
+
+    file.data = static_cast<const std::byte*>(MapViewOfFile(file.mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if(file.data == nullptr) {
+        return eastl::nullopt;
+    }
+#else
+    const auto fd = ::open(filepath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return eastl::nullopt;
+    }
+
+    struct stat file_stat = {};
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return eastl::nullopt;
+    }
+    file.size = static_cast<size_t>(file_stat.st_size);
+
+    auto* mapping = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if(mapping == MAP_FAILED) {
+        return eastl::nullopt;
+    }
+
+    file.data = static_cast<const std::byte*>(mapping);
+#endif
+
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile&& old) noexcept {
+    *this = eastl::move(old);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& old) noexcept {
+    if(this != &old) {
+        close();
+
+        data = old.data;
+        size = old.size;
+        old.data = nullptr;
+        old.size = 0;
+
+#if defined(_WIN32)
+        file_handle = old.file_handle;
+        mapping_handle = old.mapping_handle;
+        old.file_handle = nullptr;
+        old.mapping_handle = nullptr;
+#endif
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+eastl::span<const std::byte> MappedFile::get_data() const {
+    return {data, size};
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if(data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if(mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+    }
+    if(file_handle != nullptr) {
+        CloseHandle(file_handle);
+    }
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    if(data != nullptr) {
+        munmap(const_cast<std::byte*>(data), size);
+    }
+#endif
+
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#include <EASTL/optional.h>
+#include <EASTL/span.h>
+
+/**
+ * A read-only memory-mapped file. The mapping lives as long as this object does
+ */
+class MappedFile {
+public:
+    /**
+     * Maps the file at the given path. Returns an empty optional if the file can't be opened or mapped
+     */
+    static eastl::optional<MappedFile> open(const std::filesystem::path& filepath);
+
+    MappedFile() = default;
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    MappedFile(MappedFile&& old) noexcept;
+    MappedFile& operator=(MappedFile&& old) noexcept;
+
+    ~MappedFile();
+
+    eastl::span<const std::byte> get_data() const;
+
+private:
+    const std::byte* data = nullptr;
+
+    size_t size = 0;
+
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+
+    void* mapping_handle = nullptr;
+#endif
+
+    void close();
+};
@@ -0,0 +1,64 @@
+#include "thread_pool.hpp"
+
+#include <tracy/Tracy.hpp>
+
+ThreadPool& ThreadPool::get() {
+    static auto instance = ThreadPool{};
+    return instance;
+}
+
+ThreadPool::ThreadPool(uint32_t num_threads_in) {
+    if(num_threads_in == 0) {
+        num_threads_in = eastl::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    workers.reserve(num_threads_in);
+    for(auto i = 0u; i < num_threads_in; i++) {
+        workers.emplace_back([this] { worker_main(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        auto lock = std::unique_lock{tasks_mutex};
+        stopping = true;
+    }
+    tasks_cv.notify_all();
+
+    for(auto& worker : workers) {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::get_num_threads() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::push_task(std::function<void()>&& task) {
+    {
+        auto lock = std::unique_lock{tasks_mutex};
+        tasks.emplace_back(std::move(task));
+    }
+    tasks_cv.notify_one();
+}
+
+void ThreadPool::worker_main() {
+    tracy::SetThreadName("Worker");
+
+    while(true) {
+        auto task = std::function<void()>{};
+        {
+            auto lock = std::unique_lock{tasks_mutex};
+            tasks_cv.wait(lock, [&] { return stopping || !tasks.empty(); });
+
+            if(stopping && tasks.empty()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/deque.h>
+#include <EASTL/vector.h>
+
+/**
+ * Simple pool of worker threads for CPU-side engine work - resource imports, texture decoding, etc
+ *
+ * Jolt has its own job system for physics. This pool is for everything else
+ */
+class ThreadPool {
+public:
+    /**
+     * Gets the engine-wide thread pool, creating it if needed
+     */
+    static ThreadPool& get();
+
+    /**
+     * Creates a pool with the given number of worker threads. 0 means one less than the number of hardware threads
+     */
+    explicit ThreadPool(uint32_t num_threads_in = 0);
+
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    ~ThreadPool();
+
+    uint32_t get_num_threads() const;
+
+    /**
+     * Adds a task to the pool, returning a future for its result. Exceptions thrown by the task are stored in the
+     * future
+     */
+    template<typename TaskType>
+    auto enqueue(TaskType&& task) -> std::future<std::invoke_result_t<TaskType>>;
+
+    /**
+     * Runs task_func(i) for every i in [0, count). The calling thread participates, so this is safe to call from
+     * inside a pool task without deadlocking. Does not return until every invocation has finished
+     *
+     * If any invocation throws, the first exception is rethrown on the calling thread
+     */
+    template<typename TaskFunc>
+    void parallel_for(size_t count, TaskFunc&& task_func);
+
+private:
+    eastl::vector<std::thread> workers;
+
+    std::mutex tasks_mutex;
+
+    std::condition_variable tasks_cv;
+
+    eastl::deque<std::function<void()>> tasks;
+
+    bool stopping = false;
+
+    void push_task(std::function<void()>&& task);
+
+    void worker_main();
+};
+
+template<typename TaskType>
+auto ThreadPool::enqueue(TaskType&& task) -> std::future<std::invoke_result_t<TaskType>> {
+    using ResultType = std::invoke_result_t<TaskType>;
+
+    // std::function needs a copyable callable, so the packaged task lives in a shared pointer
+    auto packaged = std::make_shared<std::packaged_task<ResultType()>>(std::forward<TaskType>(task));
+    auto future = packaged->get_future();
+
+    push_task([packaged] { (*packaged)(); });
+
+    return future;
+}
+
+template<typename TaskFunc>
+void ThreadPool::parallel_for(const size_t count, TaskFunc&& task_func) {
+    if(count == 0) {
+        return;
+    }
+
+    struct ParallelForState {
+        std::atomic<size_t> next_index = 0;
+        std::atomic<size_t> num_finished = 0;
+        size_t count = 0;
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        std::exception_ptr exception;
+    };
+
+    // Helpers may start after the calling thread has finished all the work and returned, so the shared state must
+    // outlive this stack frame. The task itself does not - a helper only touches it if it claimed an index, and the
+    // calling thread waits for every claimed index to finish
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+
+    const auto run_items = [state, &task_func] {
+        for(auto i = state->next_index.fetch_add(1); i < state->count; i = state->next_index.fetch_add(1)) {
+            try {
+                task_func(i);
+            } catch(...) {
+                auto lock = std::unique_lock{state->mutex};
+                if(!state->exception) {
+                    state->exception = std::current_exception();
+                }
+            }
+
+            if(state->num_finished.fetch_add(1) + 1 == state->count) {
+                auto lock = std::unique_lock{state->mutex};
+                state->done_cv.notify_all();
+            }
+        }
+    };
+
+    const auto num_helpers = eastl::min(static_cast<size_t>(get_num_threads()), count - 1);
+    for(auto i = 0u; i < num_helpers; i++) {
+        push_task(run_items);
+    }
+
+    run_items();
+
+    {
+        auto lock = std::unique_lock{state->mutex};
+        state->done_cv.wait(lock, [&] { return state->num_finished.load() == state->count; });
+    }
+
+    if(state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
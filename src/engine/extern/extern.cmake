@@ -87,6 +87,13 @@ FetchContent_Declare(
         GIT_TAG         v0.9.5
 )
 
+FetchContent_Declare(
+        meshoptimizer
+        GIT_REPOSITORY  https://github.com/zeux/meshoptimizer.git
+        GIT_SHALLOW     ON
+        GIT_TAG         v0.23
+)
+
 # Manually include NRD's dependencies because...?
 FetchContent_Declare(
         mathlib
@@ -227,6 +234,7 @@ FetchContent_MakeAvailable(
         glm
         JoltPhysics
         fetch_magic_enum
+        meshoptimizer
         NRD
         NRI
         recast
@@ -249,6 +257,16 @@ if(ANDROID)
         FetchContent_MakeAvailable(libadrenotools)
 endif()
 
+if(SAH_BUILD_TESTS)
+        FetchContent_Declare(
+                catch2
+                GIT_REPOSITORY  https://github.com/catchorg/Catch2.git
+                GIT_SHALLOW     ON
+                GIT_TAG         v3.8.1
+        )
+        FetchContent_MakeAvailable(catch2)
+endif()
+
 if(SAH_USE_STREAMLINE)
     set(STREAMLINE_FEATURE_DLSS_SR ON CACHE BOOL "" FORCE)
     set(STREAMLINE_FEATURE_DLSS_RR ON CACHE BOOL "" FORCE)
@@ -406,6 +424,30 @@ else()
     target_include_directories(stb INTERFACE ${fetch_stb_SOURCE_DIR})
 endif()
 
+# We only need the transcoder, not the encoder that basis_universal's CMakeLists builds
+FetchContent_Declare(
+        basis_universal
+        GIT_REPOSITORY  https://github.com/BinomialLLC/basis_universal.git
+        GIT_TAG         v1_50_0_2
+)
+FetchContent_GetProperties(basis_universal)
+if(basis_universal_POPULATED)
+    message("Basis Universal automatically populated")
+else()
+    FetchContent_Populate(basis_universal)
+    add_library(basisu_transcoder STATIC
+            ${basis_universal_SOURCE_DIR}/transcoder/basisu_transcoder.cpp
+            ${basis_universal_SOURCE_DIR}/zstd/zstddeclib.c
+            )
+    target_include_directories(basisu_transcoder PUBLIC
+            ${basis_universal_SOURCE_DIR}/transcoder
+            )
+    target_compile_definitions(basisu_transcoder PUBLIC
+            BASISD_SUPPORT_KTX2=1
+            BASISD_SUPPORT_KTX2_ZSTD=1
+            )
+endif()
+
 set(SAH_EXTERNAL_NATVIS_FILES
         "${FETCHCONTENT_BASE_DIR}/eastl-src/doc/EASTL.natvis"
         "${FETCHCONTENT_BASE_DIR}/entt-src/natvis/entt/signal.natvis"
@@ -82,10 +82,6 @@ namespace physics {
             object_vs_object_layer_filter);
 
         // TODO: Set a contact listener? I think we want one?
-
-        // Register transform change listeners
-        auto& registry = world.get_registry();
-        registry.on_update<TransformComponent>().connect<&PhysicsWorld::on_transform_update>(this);
     }
 
     PhysicsWorld::~PhysicsWorld() {
@@ -107,12 +103,23 @@ namespace physics {
         // Sync physics -> transforms
         auto& registry = world.get_registry();
         registry.view<TransformComponent, CollisionComponent>().each(
-            [&](entt::entity entity, const TransformComponent& transform, const CollisionComponent& collision) {
+            [&](entt::entity entity, TransformComponent& transform, const CollisionComponent& collision) {
                 const auto layer = body_interface.GetObjectLayer(collision.body_id);
                 if(layer != layers::MOVING) {
                     return;
                 }
 
+                // Sleeping bodies didn't move, so their transform is already where the body is
+                if(!body_interface.IsActive(collision.body_id)) {
+                    return;
+                }
+
+                // Something moved the entity this frame. That move wins, sync_transforms_to_bodies will teleport the
+                // body
+                if(transform.is_dirty) {
+                    return;
+                }
+
                 JPH::Vec3 position;
                 JPH::Quat orientation;
                 body_interface.GetPositionAndRotation(collision.body_id, position, orientation);
@@ -126,6 +133,8 @@ namespace physics {
                         trans.set_local_transform(inverse_parent * new_matrix);
                     });
 
+                // Set after the patch, since patching clears it
+                transform.is_moved_by_physics = true;
             });
 
         const auto visualizer = Engine::get().get_renderer().get_active_visualizer();
@@ -303,27 +312,43 @@ namespace physics {
 #endif
     }
 
-    void PhysicsWorld::on_transform_update(const entt::registry& registry, const entt::entity entity) const {
-        if(registry.all_of<TransformComponent, CollisionComponent>(entity)) {
-            const auto& transform = registry.get<TransformComponent>(entity);
-            const auto& collision = registry.get<CollisionComponent>(entity);
-
-            auto& body_interface = get_body_interface();
+    void PhysicsWorld::sync_transforms_to_bodies(const World& world) const {
+        ZoneScoped;
 
-            const auto matrix = transform.get_local_to_world();
+        const auto& registry = world.get_registry();
+        const auto changed_entities = world.get_changed_transforms();
+        const auto changed_matrices = world.get_changed_local_to_world();
+        for(auto i = 0u; i < changed_entities.size(); i++) {
+            const auto* collision = registry.try_get<CollisionComponent>(changed_entities[i]);
+            if(collision == nullptr) {
+                continue;
+            }
 
-            glm::vec3 scale;
-            glm::quat orientation;
-            glm::vec3 translation;
-            glm::vec3 skew;
-            glm::vec4 perspective;
-            glm::decompose(matrix, scale, orientation, translation, skew, perspective);
+            // The body is already there
+            if(registry.get<TransformComponent>(changed_entities[i]).is_moved_by_physics) {
+                continue;
+            }
 
-            body_interface.SetPositionAndRotation(
-                collision.body_id,
-                to_jolt(translation),
-                to_jolt(orientation),
-                JPH::EActivation::Activate);
+            update_body_transform(*collision, changed_matrices[i]);
         }
     }
+
+    void PhysicsWorld::update_body_transform(
+        const CollisionComponent& collision, const float4x4& local_to_world
+    ) const {
+        auto& body_interface = get_body_interface();
+
+        glm::vec3 scale;
+        glm::quat orientation;
+        glm::vec3 translation;
+        glm::vec3 skew;
+        glm::vec4 perspective;
+        glm::decompose(local_to_world, scale, orientation, translation, skew, perspective);
+
+        body_interface.SetPositionAndRotation(
+            collision.body_id,
+            to_jolt(translation),
+            to_jolt(orientation),
+            JPH::EActivation::Activate);
+    }
 }
@@ -20,6 +20,8 @@
 class World;
 
 namespace physics {
+    struct CollisionComponent;
+
     struct MeshBodyCreateInfo {
         eastl::vector<float3> vertices;
 
@@ -49,6 +51,12 @@ namespace physics {
 
         void tick(float delta_time, World& world);
 
+        /**
+         * Moves the bodies of entities whose transform changed in the last World::tick. Skips changes that tick copied
+         * from the bodies
+         */
+        void sync_transforms_to_bodies(const World& world) const;
+
         bool cast_ray(const JPH::RRayCast& ray, JPH::RayCastResult& result) const;
 
         JPH::BodyInterface& get_body_interface() const;
@@ -78,6 +86,6 @@ namespace physics {
 
         void debug_draw_physics();
 
-        void on_transform_update(const entt::registry& registry, entt::entity entity) const;
+        void update_body_transform(const CollisionComponent& collision, const float4x4& local_to_world) const;
     };
 }
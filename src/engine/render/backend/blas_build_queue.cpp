@@ -61,12 +61,12 @@ namespace render {
 
             barriers.reserve(batch_size);
 
+            auto geometries = eastl::vector<VkAccelerationStructureGeometryKHR>{};
             auto build_geometry_infos = eastl::vector<VkAccelerationStructureBuildGeometryInfoKHR>{};
             auto build_range_infos = eastl::vector<VkAccelerationStructureBuildRangeInfoKHR>{};
-            auto build_range_info_ptrs = eastl::vector<VkAccelerationStructureBuildRangeInfoKHR*>{};
+            geometries.reserve(batch_size);
             build_geometry_infos.reserve(batch_size);
             build_range_infos.reserve(batch_size);
-            build_range_info_ptrs.reserve(batch_size);
 
             auto scratch_buffer_address = round_up<uint64_t>(scratch_buffer->address, alignment);
 
@@ -87,9 +87,9 @@ namespace render {
                 auto& info = job.build_info;
                 info.dstAccelerationStructure = job.handle->acceleration_structure;
                 info.geometryCount = 1;
-                info.pGeometries = &job.create_info;
                 info.scratchData = {.deviceAddress = scratch_buffer_address};
                 build_geometry_infos.emplace_back(info);
+                geometries.emplace_back(job.create_info);
 
                 scratch_buffer_address += job.handle->scratch_buffer_size;
 
@@ -100,7 +100,6 @@ namespace render {
                         .firstVertex = 0,
                         .transformOffset = 0,
                     });
-                build_range_info_ptrs.emplace_back(&build_range_infos.back());
             }
 
             graph.add_pass(
@@ -109,12 +108,21 @@ namespace render {
                     .buffers = barriers,
                     .execute = [
                         &backend,
+                        geometries = eastl::move(geometries),
                         build_geometry_infos = eastl::move(build_geometry_infos),
-                        build_range_infos = eastl::move(build_range_infos),
-                        build_range_info_ptrs = eastl::move(build_range_info_ptrs)]
-                (const CommandBuffer& commands) {
+                        build_range_infos = eastl::move(build_range_infos)]
+                (const CommandBuffer& commands) mutable {
                         TracyVkZone(backend.get_tracy_context(), commands.get_vk_commands(), "BLAS Build");
 
+                        // The graph records this pass after pending_jobs is cleared, so the build infos point into
+                        // data owned by the lambda
+                        auto build_range_info_ptrs = eastl::vector<VkAccelerationStructureBuildRangeInfoKHR*>{};
+                        build_range_info_ptrs.reserve(build_range_infos.size());
+                        for(auto i = 0u; i < build_geometry_infos.size(); i++) {
+                            build_geometry_infos[i].pGeometries = &geometries[i];
+                            build_range_info_ptrs.emplace_back(&build_range_infos[i]);
+                        }
+
                         commands.build_acceleration_structures(build_geometry_infos, build_range_info_ptrs);
                     }
                 });
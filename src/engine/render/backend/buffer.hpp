@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include <vk_mem_alloc.h>
 #include <EASTL/string.h>
 
@@ -23,6 +25,11 @@ namespace render {
          */
         DeviceAddress address;
 
+        /**
+         * Where the ResourceAccessTracker keeps this buffer's state. See GpuTexture::access_tracker_slot
+         */
+        uint32_t access_tracker_slot = UINT32_MAX;
+
         bool operator==(const GpuBuffer& other) const;
     };
 
@@ -10,7 +10,9 @@
 namespace render {
     static std::shared_ptr<spdlog::logger> logger;
 
-    CommandAllocator::CommandAllocator(RenderBackend& backend_in, const uint32_t queue_index) : backend{ &backend_in } {
+    CommandAllocator::CommandAllocator(
+        RenderBackend& backend_in, const uint32_t queue_index, const VkCommandBufferLevel level_in
+    ) : backend{ &backend_in }, level{ level_in } {
         if (logger == nullptr) {
             logger = SystemInterface::get().get_logger("CommandAllocator");
         }
@@ -31,6 +33,7 @@ namespace render {
 
     CommandAllocator::CommandAllocator(CommandAllocator&& old) noexcept : backend{ old.backend },
         command_pool{ old.command_pool },
+        level{ old.level },
         command_buffers{ std::move(old.command_buffers) },
         available_command_buffers{
             std::move(old.command_buffers)
@@ -41,6 +44,7 @@ namespace render {
     CommandAllocator& CommandAllocator::operator=(CommandAllocator&& old) noexcept {
         backend = old.backend;
         command_pool = old.command_pool;
+        level = old.level;
         command_buffers = std::move(old.command_buffers);
         available_command_buffers = std::move(old.command_buffers);
 
@@ -80,7 +84,7 @@ namespace render {
         const auto alloc_info = VkCommandBufferAllocateInfo{
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
             .commandPool = command_pool,
-            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .level = level,
             .commandBufferCount = 1,
         };
 
@@ -12,7 +12,11 @@ namespace render {
     public:
         CommandAllocator() = default;
 
-        CommandAllocator(RenderBackend& backend_in, uint32_t queue_index);
+        CommandAllocator(
+            RenderBackend& backend_in,
+            uint32_t queue_index,
+            VkCommandBufferLevel level_in = VK_COMMAND_BUFFER_LEVEL_PRIMARY
+        );
 
         CommandAllocator(const CommandAllocator& other) = delete;
         CommandAllocator& operator=(const CommandAllocator& other) = delete;
@@ -41,6 +45,12 @@ namespace render {
 
         VkCommandPool command_pool = VK_NULL_HANDLE;
 
+        /**
+         * Level of every command buffer from this allocator. Primary and secondary command buffers can't be swapped, so
+         * one allocator only hands out one level
+         */
+        VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
         eastl::vector<VkCommandBuffer> command_buffers;
 
         eastl::vector<VkCommandBuffer> available_command_buffers;
@@ -37,6 +37,18 @@ namespace render {
         vkBeginCommandBuffer(commands, &begin_info);
     }
 
+    void CommandBuffer::begin_secondary() const {
+        constexpr auto inheritance_info = VkCommandBufferInheritanceInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        };
+        const auto begin_info = VkCommandBufferBeginInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = &inheritance_info,
+        };
+        vkBeginCommandBuffer(commands, &begin_info);
+    }
+
     void CommandBuffer::set_marker(const std::string& marker_name) const {
         if(vkCmdSetCheckpointNV != nullptr) {
             vkCmdSetCheckpointNV(commands, marker_name.c_str());
@@ -300,6 +312,10 @@ namespace render {
         const uint32_t num_vertices, const uint32_t num_instances, const uint32_t first_vertex,
         const uint32_t first_instance
         ) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDraw(commands, num_vertices, num_instances, first_vertex, first_instance);
@@ -310,6 +326,10 @@ namespace render {
         const uint32_t first_index,
         const uint32_t first_vertex, const uint32_t first_instance
         ) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDrawIndexed(
@@ -323,18 +343,30 @@ namespace render {
     }
 
     void CommandBuffer::draw_indirect(const BufferHandle indirect_buffer) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDrawIndirect(commands, indirect_buffer->buffer, 0, 1, 0);
     }
 
     void CommandBuffer::draw_indexed_indirect(const BufferHandle indirect_buffer) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDrawIndexedIndirect(commands, indirect_buffer->buffer, 0, 1, 0);
     }
 
     void CommandBuffer::draw_indexed_indirect(BufferHandle indirect_buffer, uint32_t max_count) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDrawIndexedIndirectCount(
@@ -351,6 +383,10 @@ namespace render {
     void CommandBuffer::draw_indexed_indirect(
         const BufferHandle indirect_buffer, const BufferHandle count_buffer, const uint32_t max_count
         ) {
+        if(skip_draws) {
+            return;
+        }
+
         commit_bindings();
 
         vkCmdDrawIndexedIndirectCount(
@@ -365,6 +401,10 @@ namespace render {
     }
 
     void CommandBuffer::draw_triangle() {
+        if(skip_draws) {
+            return;
+        }
+
         set_cull_mode(VK_CULL_MODE_NONE);
 
         commit_bindings();
@@ -412,9 +452,19 @@ namespace render {
         // vkCmdExecuteGeneratedCommandsNV(commands, VK_FALSE, &info);
     }
 
+    void CommandBuffer::execute_secondary_command_buffers(const eastl::span<const VkCommandBuffer> secondaries) const {
+        if(secondaries.empty()) {
+            return;
+        }
+
+        vkCmdExecuteCommands(commands, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    }
+
     void CommandBuffer::bind_pipeline(const ComputePipelineHandle& pipeline) {
         current_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
 
+        pipeline->wait_until_created();
+
         save_pipeline_layout_info(*pipeline);
 
         vkCmdBindPipeline(commands, current_bind_point, pipeline->pipeline);
@@ -436,7 +486,11 @@ namespace render {
             bound_view_mask,
             using_fragment_shading_rate_attachment);
 
-        vkCmdBindPipeline(commands, current_bind_point, vk_pipeline);
+        // The PSO may still be compiling, or it may have failed. Skip draws rather than stall the frame
+        skip_draws = vk_pipeline == VK_NULL_HANDLE;
+        if(!skip_draws) {
+            vkCmdBindPipeline(commands, current_bind_point, vk_pipeline);
+        }
 
         are_bindings_dirty = true;
     }
@@ -473,6 +527,18 @@ namespace render {
         set_push_constant(index + 1, buffer_handle->address.high_bits());
     }
 
+    void CommandBuffer::bind_buffer_reference(
+        const uint32_t index, const BufferHandle buffer_handle, const VkDeviceSize offset
+    ) {
+        if(buffer_handle->address == 0) {
+            throw std::runtime_error{"Buffer was not created with a device address! Is it a uniform buffer?"};
+        }
+
+        const auto address = DeviceAddress{buffer_handle->address + offset};
+        set_push_constant(index, address.low_bits());
+        set_push_constant(index + 1, address.high_bits());
+    }
+
     void CommandBuffer::bind_descriptor_set(const uint32_t set_index, const DescriptorSet& set) {
         return bind_descriptor_set(set_index, set.descriptor_set);
     }
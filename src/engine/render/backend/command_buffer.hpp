@@ -54,6 +54,11 @@ namespace render {
 
         void begin() const;
 
+        /**
+         * Begins a secondary command buffer. It may begin and end its own dynamic rendering, but can't continue one
+         * from the primary command buffer that executes it
+         */
+        void begin_secondary() const;
 
         void set_marker(const std::string& marker_name) const;
 
@@ -195,6 +200,11 @@ namespace render {
          */
         void execute_commands();
 
+        /**
+         * Executes some secondary command buffers, in order
+         */
+        void execute_secondary_command_buffers(eastl::span<const VkCommandBuffer> secondaries) const;
+
         void bind_pipeline(const ComputePipelineHandle& pipeline);
 
         void bind_pipeline(const GraphicsPipelineHandle& pipeline);
@@ -216,6 +226,11 @@ namespace render {
          */
         void bind_buffer_reference(uint32_t index, BufferHandle buffer_handle);
 
+        /**
+         * Binds the address of a location in a buffer, for when the shader should only see part of the buffer
+         */
+        void bind_buffer_reference(uint32_t index, BufferHandle buffer_handle, VkDeviceSize offset);
+
         void bind_descriptor_set(uint32_t set_index, const DescriptorSet& set);
 
         void bind_descriptor_set(uint32_t set_index, VkDescriptorSet set);
@@ -277,6 +292,12 @@ namespace render {
 
         bool are_bindings_dirty = false;
 
+        /**
+         * Whether the bound graphics pipeline has no PSO, because it's still compiling or it failed to compile. Draws
+         * are skipped until a pipeline with a PSO is bound
+         */
+        bool skip_draws = false;
+
         /**
          * Cache of buffer barriers for events
          *
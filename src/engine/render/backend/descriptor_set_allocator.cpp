@@ -10,6 +10,8 @@ namespace render {
 
     DescriptorSetBuilder DescriptorSetAllocator::build_set(const PipelineBase* pipeline,
                                                            const uint32_t set_index) {
+        pipeline->wait_until_created();
+
         const auto name = fmt::format("{} set {}", pipeline->name.c_str(), set_index);
         return build_set(pipeline->descriptor_sets.at(set_index), name);
     }
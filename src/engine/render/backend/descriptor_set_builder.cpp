@@ -1,5 +1,6 @@
 #include "descriptor_set_builder.hpp"
 
+#include <EASTL/algorithm.h>
 #include <spdlog/fmt/bundled/format.h>
 
 #include "render/backend/descriptor_set_allocator.hpp"
@@ -119,6 +120,83 @@ namespace render {
         }
     }
 
+    bool DescriptorSet::rewrite_bindings(
+        RenderBackend& backend, const eastl::span<const TextureHandle> textures,
+        const eastl::span<const BufferHandle> buffers
+    ) const {
+        ZoneScoped;
+
+        const auto contains_texture = [&](const TextureHandle texture) {
+            return eastl::find(textures.begin(), textures.end(), texture) != textures.end();
+        };
+        const auto contains_buffer = [&](const BufferHandle buffer) {
+            return eastl::find(buffers.begin(), buffers.end(), buffer) != buffers.end();
+        };
+
+        // The writes point into these, so they must not reallocate
+        auto buffer_infos = eastl::vector<VkDescriptorBufferInfo>{};
+        buffer_infos.reserve(bindings.size());
+        auto image_infos = eastl::vector<VkDescriptorImageInfo>{};
+        image_infos.reserve(bindings.size());
+        auto writes = eastl::vector<VkWriteDescriptorSet>{};
+        writes.reserve(bindings.size());
+
+        auto binding_idx = 0u;
+        for (const auto& resource : bindings) {
+            const auto& binding_info = set_info.bindings.at(binding_idx);
+            auto write = VkWriteDescriptorSet{
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptor_set,
+                .dstBinding = binding_idx,
+                .descriptorCount = 1,
+                .descriptorType = binding_info.descriptorType,
+            };
+
+            if (is_buffer_type(binding_info.descriptorType) && contains_buffer(resource.buffer)) {
+                write.pBufferInfo = &buffer_infos.emplace_back(
+                    VkDescriptorBufferInfo{
+                        .buffer = resource.buffer->buffer,
+                        .offset = resource.offset,
+                        .range = resource.buffer->create_info.size - resource.offset
+                    });
+                writes.emplace_back(write);
+            }
+            else if (is_texture_type(binding_info.descriptorType) && contains_texture(resource.texture)) {
+                write.pImageInfo = &image_infos.emplace_back(
+                    VkDescriptorImageInfo{
+                        .imageView = resource.texture->image_view,
+                        .imageLayout = to_image_layout(binding_info.descriptorType)
+                    });
+                writes.emplace_back(write);
+            }
+            else if (is_combined_image_sampler(binding_info.descriptorType) &&
+                contains_texture(resource.combined_image_sampler.texture)) {
+                write.pImageInfo = &image_infos.emplace_back(
+                    VkDescriptorImageInfo{
+                        .sampler = resource.combined_image_sampler.sampler,
+                        .imageView = resource.combined_image_sampler.texture->image_view,
+                        .imageLayout = to_image_layout(binding_info.descriptorType)
+                    });
+                writes.emplace_back(write);
+            }
+
+            binding_idx++;
+        }
+
+        if (writes.empty()) {
+            return false;
+        }
+
+        vkUpdateDescriptorSets(
+            backend.get_device(),
+            static_cast<uint32_t>(writes.size()),
+            writes.data(),
+            0,
+            nullptr);
+
+        return true;
+    }
+
     DescriptorSetBuilder::DescriptorSetBuilder(
         RenderBackend& backend_in, DescriptorSetAllocator& allocator_in, DescriptorSetInfo set_info_in,
         const std::string_view name_in
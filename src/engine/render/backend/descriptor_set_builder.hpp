@@ -4,6 +4,7 @@
 #include <string_view>
 
 #include <EASTL/fixed_vector.h>
+#include <EASTL/span.h>
 
 #include "render/backend/acceleration_structure.hpp"
 #include "render/backend/buffer_usage_token.hpp"
@@ -48,6 +49,16 @@ namespace render {
             TextureUsageList& texture_usages,
             BufferUsageList& buffer_usages
         ) const;
+
+        /**
+         * Rewrites the bindings that reference any of the given resources, so they point at whatever is behind the
+         * handle now. Only valid before any command buffer that uses the set is submitted
+         *
+         * @return True if any binding was rewritten
+         */
+        bool rewrite_bindings(
+            RenderBackend& backend, eastl::span<const TextureHandle> textures, eastl::span<const BufferHandle> buffers
+        ) const;
     };
 
     class DescriptorSetBuilder {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include <EASTL/string.h>
 #include <volk.h>
 #include <vk_mem_alloc.h>
@@ -8,6 +10,12 @@ namespace render {
     enum class TextureAllocationType {
         Vma,
         Swapchain,
+
+        /**
+         * Bound to memory that someone else owns, possibly shared with other resources. Destroying the texture doesn't
+         * free the memory
+         */
+        Placed,
     };
 
     struct VmaTextureAllocation {
@@ -44,6 +52,12 @@ namespace render {
 
         VmaTextureAllocation vma;
 
+        /**
+         * Where the ResourceAccessTracker keeps this texture's state. The tracker assigns it on the texture's first
+         * use, and frees it when the texture is destroyed
+         */
+        uint32_t access_tracker_slot = UINT32_MAX;
+
         bool operator==(const GpuTexture& other) const;
 
         glm::uvec2 get_resolution() const;
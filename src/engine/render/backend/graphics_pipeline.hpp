@@ -4,6 +4,7 @@
 #include <EASTL/vector.h>
 #include <cstdint>
 
+#include "render/backend/handles.hpp"
 #include "render/backend/pipeline_interface.hpp"
 
 namespace render {
@@ -22,7 +23,7 @@ namespace render {
 
         VkPipelineCreateFlags flags;
 
-        eastl::vector<std::byte> vertex_shader;
+        ShaderHandle vertex_shader = nullptr;
 
         VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
@@ -30,9 +31,9 @@ namespace render {
 
         eastl::fixed_vector<VkVertexInputAttributeDescription, 8> vertex_attributes;
 
-        eastl::vector<std::byte> geometry_shader;
+        ShaderHandle geometry_shader = nullptr;
 
-        eastl::vector<std::byte> fragment_shader;
+        ShaderHandle fragment_shader = nullptr;
 
         VkPipelineDepthStencilStateCreateInfo depth_stencil_state = {};
 
@@ -45,5 +46,16 @@ namespace render {
         uint32_t group_index;
 
         eastl::fixed_vector<VkDynamicState, 8> dynamic_states;
+
+        /**
+         * Compiles the PSO in the background. Null until the pipeline is first bound
+         */
+        std::shared_ptr<PipelineCompileJob> compile_job;
+
+        /**
+         * Whether the compile job failed and the failure has been reported. The pipeline is never compiled again, and
+         * draws that use it are skipped
+         */
+        bool has_failed = false;
     };
 }
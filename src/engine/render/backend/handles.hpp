@@ -14,4 +14,6 @@ namespace render {
     using HitGroupHandle = struct HitGroup*;
 
     using RayTracingPipelineHandle = struct RayTracingPipeline*;
+
+    using ShaderHandle = const struct Shader*;
 }
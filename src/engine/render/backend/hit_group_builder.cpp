@@ -1,7 +1,6 @@
 #include "hit_group_builder.hpp"
 
 #include "render/backend/pipeline_cache.hpp"
-#include "core/system_interface.hpp"
 #include "resources/resource_path.hpp"
 
 namespace render {
@@ -17,45 +16,25 @@ namespace render {
     }
 
     HitGroupBuilder& HitGroupBuilder::add_occlusion_closesthit_shader(const ResourcePath& shader_path) {
-        const auto shader_maybe = SystemInterface::get().load_file(shader_path);
-        if (!shader_maybe) {
-            throw std::runtime_error{ fmt::format("Could not load closesthit shader {}", shader_path.to_string()) };
-        }
-
-        occlusion_closesthit_shader = *shader_maybe;
+        occlusion_closesthit_shader = cache.get_shader_cache().load_shader(shader_path);
 
         return *this;
     }
 
     HitGroupBuilder& HitGroupBuilder::add_occlusion_anyhit_shader(const ResourcePath& shader_path) {
-        const auto shader_maybe = SystemInterface::get().load_file(shader_path);
-        if (!shader_maybe) {
-            throw std::runtime_error{ fmt::format("Could not load anyhit shader {}", shader_path.to_string()) };
-        }
-
-        occlusion_anyhit_shader = *shader_maybe;
+        occlusion_anyhit_shader = cache.get_shader_cache().load_shader(shader_path);
 
         return *this;
     }
 
     HitGroupBuilder& HitGroupBuilder::add_gi_closesthit_shader(const ResourcePath& shader_path) {
-        const auto shader_maybe = SystemInterface::get().load_file(shader_path);
-        if (!shader_maybe) {
-            throw std::runtime_error{ fmt::format("Could not load closesthit shader {}", shader_path.to_string()) };
-        }
-
-        gi_closesthit_shader = *shader_maybe;
+        gi_closesthit_shader = cache.get_shader_cache().load_shader(shader_path);
 
         return *this;
     }
 
     HitGroupBuilder& HitGroupBuilder::add_gi_anyhit_shader(const ResourcePath& shader_path) {
-        const auto shader_maybe = SystemInterface::get().load_file(shader_path);
-        if (!shader_maybe) {
-            throw std::runtime_error{ fmt::format("Could not load anyhit shader {}", shader_path.to_string()) };
-        }
-
-        gi_anyhit_shader = *shader_maybe;
+        gi_anyhit_shader = cache.get_shader_cache().load_shader(shader_path);
 
         return *this;
     }
@@ -45,9 +45,9 @@ namespace render {
          */
         eastl::array<VkRayTracingShaderGroupCreateInfoKHR, 2> groups;
 
-        eastl::vector<std::byte> occlusion_closesthit_shader;
-        eastl::vector<std::byte> occlusion_anyhit_shader;
-        eastl::vector<std::byte> gi_closesthit_shader;
-        eastl::vector<std::byte> gi_anyhit_shader;
+        ShaderHandle occlusion_closesthit_shader = nullptr;
+        ShaderHandle occlusion_anyhit_shader = nullptr;
+        ShaderHandle gi_closesthit_shader = nullptr;
+        ShaderHandle gi_anyhit_shader = nullptr;
     };
 }
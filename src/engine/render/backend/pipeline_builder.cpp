@@ -132,14 +132,13 @@ namespace render {
 
     static bool collect_push_constants(
         std::string_view shader_name,
-        const eastl::vector<SpvReflectBlockVariable*>& spv_push_constants,
-        VkShaderStageFlags shader_stage,
+        eastl::span<const VkPushConstantRange> stage_push_constants,
         eastl::fixed_vector<VkPushConstantRange, 4>& push_constants
         );
 
     static void collect_vertex_attributes(
         const VertexLayout& vertex_layout,
-        const eastl::vector<SpvReflectInterfaceVariable*>& inputs,
+        eastl::span<const ShaderInputVariable> inputs,
         eastl::fixed_vector<VkVertexInputAttributeDescription, 8>& vertex_attributes,
         bool& needs_position_buffer,
         bool& needs_data_buffer,
@@ -203,44 +202,18 @@ namespace render {
         if(vertex_shader) {
             throw std::runtime_error{"Vertex shader already loaded set"};
         }
-        const auto vertex_shader_maybe = SystemInterface::get().load_file(vertex_path);
-
-        if(!vertex_shader_maybe) {
-            throw std::runtime_error{"Could not load vertex shader"};
-        }
-
-        vertex_shader = *vertex_shader_maybe;
-        vertex_shader_name = vertex_path.to_string().c_str();
-
-        const auto shader_module = spv_reflect::ShaderModule{
-            vertex_shader->size(),
-            vertex_shader->data(),
-            SPV_REFLECT_MODULE_FLAG_NO_COPY
-        };
-        if(shader_module.GetResult() != SPV_REFLECT_RESULT_SUCCESS) {
-            throw std::runtime_error{"Could not perform reflection on vertex shader"};
-        }
 
-        logger->trace("Beginning reflection on vertex shader {}", vertex_shader_name);
+        auto& shader_cache = cache.get_shader_cache();
+        vertex_shader = shader_cache.load_shader(vertex_path);
 
-        collect_bindings(
-            *vertex_shader_maybe,
-            vertex_shader_name,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            descriptor_sets,
-            push_constants);
+        logger->trace("Collecting bindings for vertex shader {}", vertex_shader->name.c_str());
 
-        // Collect inputs
-        uint32_t input_count;
-        auto result = shader_module.EnumerateInputVariables(&input_count, nullptr);
-        assert(result == SPV_REFLECT_RESULT_SUCCESS);
-        auto spv_vertex_inputs = eastl::vector<SpvReflectInterfaceVariable*>{input_count};
-        result = shader_module.EnumerateInputVariables(&input_count, spv_vertex_inputs.data());
-        assert(result == SPV_REFLECT_RESULT_SUCCESS);
+        const auto reflection = shader_cache.get_reflection(vertex_shader, VK_SHADER_STAGE_VERTEX_BIT);
+        merge_reflection(reflection, vertex_shader->name.c_str(), descriptor_sets, push_constants);
 
         collect_vertex_attributes(
             *vertex_layout,
-            spv_vertex_inputs,
+            reflection.inputs,
             vertex_attributes,
             need_position_buffer,
             need_data_buffer,
@@ -255,29 +228,14 @@ namespace render {
             throw std::runtime_error{"Geometry shader already set!"};
         }
 
-        const auto geometry_shader_maybe = SystemInterface::get().load_file(geometry_path);
-        if(!geometry_shader_maybe) {
-            throw std::runtime_error{"Could not load geometry shader"};
-        }
-
-        geometry_shader = *geometry_shader_maybe;
-        geometry_shader_name = geometry_path.to_string().c_str();
-
-        const auto shader_module = spv_reflect::ShaderModule{
-            geometry_shader->size(),
-            geometry_shader->data(),
-            SPV_REFLECT_MODULE_FLAG_NO_COPY
-        };
-        if(shader_module.GetResult() != SpvReflectResult::SPV_REFLECT_RESULT_SUCCESS) {
-            throw std::runtime_error{"Could not perform reflection on geometry shader"};
-        }
+        auto& shader_cache = cache.get_shader_cache();
+        geometry_shader = shader_cache.load_shader(geometry_path);
 
-        logger->trace("Beginning reflection on geometry shader {}", geometry_shader_name);
+        logger->trace("Collecting bindings for geometry shader {}", geometry_shader->name.c_str());
 
-        collect_bindings(
-            *geometry_shader,
-            geometry_shader_name,
-            VK_SHADER_STAGE_GEOMETRY_BIT,
+        merge_reflection(
+            shader_cache.get_reflection(geometry_shader, VK_SHADER_STAGE_GEOMETRY_BIT),
+            geometry_shader->name.c_str(),
             descriptor_sets,
             push_constants);
 
@@ -289,21 +247,14 @@ namespace render {
             throw std::runtime_error{"Fragment shader already set"};
         }
 
-        const auto fragment_shader_maybe = SystemInterface::get().load_file(fragment_path);
-
-        if(!fragment_shader_maybe) {
-            throw std::runtime_error{"Could not load fragment shader"};
-        }
-
-        fragment_shader = *fragment_shader_maybe;
-        fragment_shader_name = fragment_path.to_string().c_str();
+        auto& shader_cache = cache.get_shader_cache();
+        fragment_shader = shader_cache.load_shader(fragment_path);
 
-        logger->trace("Beginning reflection on fragment shader {}", fragment_shader_name);
+        logger->trace("Collecting bindings for fragment shader {}", fragment_shader->name.c_str());
 
-        collect_bindings(
-            *fragment_shader,
-            fragment_shader_name,
-            VK_SHADER_STAGE_FRAGMENT_BIT,
+        merge_reflection(
+            shader_cache.get_reflection(fragment_shader, VK_SHADER_STAGE_FRAGMENT_BIT),
+            fragment_shader->name.c_str(),
             descriptor_sets,
             push_constants
             );
@@ -512,72 +463,67 @@ namespace render {
 
     bool collect_push_constants(
         const std::string_view shader_name,
-        const eastl::vector<SpvReflectBlockVariable*>& spv_push_constants,
-        const VkShaderStageFlags shader_stage,
+        const eastl::span<const VkPushConstantRange> stage_push_constants,
         eastl::fixed_vector<VkPushConstantRange, 4>& push_constants
         ) {
         bool has_error = false;
 
-        for(const auto& constant_range : spv_push_constants) {
+        for(const auto& constant_range : stage_push_constants) {
             auto existing_constant = std::find_if(
                 push_constants.begin(),
                 push_constants.end(),
                 [&](const VkPushConstantRange& existing_range) {
-                    return existing_range.offset == constant_range->offset;
+                    return existing_range.offset == constant_range.offset;
                 }
                 );
             if(existing_constant != push_constants.end()) {
-                if(existing_constant->size != constant_range->size) {
+                if(existing_constant->size != constant_range.size) {
                     logger->error(
                         "Push constant range at offset {} has size {} in shader {}, but it had size {} earlier",
-                        constant_range->offset,
-                        constant_range->size,
+                        constant_range.offset,
+                        constant_range.size,
                         std::string_view{shader_name.data(), shader_name.size()},
                         existing_constant->size
                         );
                     has_error = true;
 
                     // Expand the size - is this correct?
-                    existing_constant->size = std::max(existing_constant->size, constant_range->size);
+                    existing_constant->size = std::max(existing_constant->size, constant_range.size);
                 }
 
                 // Make the range visible to this stage
-                existing_constant->stageFlags |= shader_stage;
+                existing_constant->stageFlags |= constant_range.stageFlags;
             } else {
                 // New range!
-                push_constants.emplace_back(
-                    VkPushConstantRange{
-                        .stageFlags = static_cast<VkShaderStageFlags>(shader_stage),
-                        .offset = constant_range->offset,
-                        .size = constant_range->size
-                    }
-                    );
+                push_constants.emplace_back(constant_range);
             }
         }
 
         return has_error;
     }
 
-    bool collect_bindings(
+    ShaderReflection reflect_shader(
         eastl::span<const std::byte> shader_instructions, const std::string_view shader_name,
-        const VkShaderStageFlags shader_stage,
-        eastl::fixed_vector<DescriptorSetInfo, 8>& descriptor_sets,
-        eastl::fixed_vector<VkPushConstantRange, 4>& push_constants
+        const VkShaderStageFlagBits shader_stage
         ) {
+        ZoneScoped;
+
         if(logger == nullptr) {
             init_logger();
         }
 
+        logger->trace("Beginning reflection on shader {}", shader_name);
+
         const auto shader_module = spv_reflect::ShaderModule{
             shader_instructions.size(),
             shader_instructions.data(),
             SPV_REFLECT_MODULE_FLAG_NO_COPY
         };
         if(shader_module.GetResult() != SpvReflectResult::SPV_REFLECT_RESULT_SUCCESS) {
-            throw std::runtime_error{"Could not perform reflection on shader"};
+            throw std::runtime_error{fmt::format("Could not perform reflection on shader {}", shader_name)};
         }
 
-        bool has_error = false;
+        auto reflection = ShaderReflection{};
 
         // Collect descriptor set info
         uint32_t set_count;
@@ -587,7 +533,7 @@ namespace render {
         result = shader_module.EnumerateDescriptorSets(&set_count, sets.data());
         assert(result == SPV_REFLECT_RESULT_SUCCESS);
 
-        has_error |= collect_descriptor_sets(sets, shader_stage, descriptor_sets);
+        collect_descriptor_sets(sets, shader_stage, reflection.descriptor_sets);
 
         // Collect push constant info
         uint32_t constant_count;
@@ -597,19 +543,82 @@ namespace render {
         result = shader_module.EnumeratePushConstantBlocks(&constant_count, spv_push_constants.data());
         assert(result == SPV_REFLECT_RESULT_SUCCESS);
 
-        has_error |= collect_push_constants(
-            shader_name,
-            spv_push_constants,
-            shader_stage,
-            push_constants
-            );
+        for(const auto* constant_range : spv_push_constants) {
+            reflection.push_constants.emplace_back(
+                VkPushConstantRange{
+                    .stageFlags = static_cast<VkShaderStageFlags>(shader_stage),
+                    .offset = constant_range->offset,
+                    .size = constant_range->size
+                });
+        }
 
-        return has_error;
+        // Collect inputs. Only vertex shaders have inputs that the pipeline cares about
+        if(shader_stage == VK_SHADER_STAGE_VERTEX_BIT) {
+            uint32_t input_count;
+            result = shader_module.EnumerateInputVariables(&input_count, nullptr);
+            assert(result == SPV_REFLECT_RESULT_SUCCESS);
+            auto spv_inputs = eastl::vector<SpvReflectInterfaceVariable*>{input_count};
+            result = shader_module.EnumerateInputVariables(&input_count, spv_inputs.data());
+            assert(result == SPV_REFLECT_RESULT_SUCCESS);
+
+            for(const auto* input : spv_inputs) {
+                if(input->name == nullptr) {
+                    continue; // UGH
+                }
+                reflection.inputs.emplace_back(ShaderInputVariable{.name = input->name, .location = input->location});
+            }
+        }
+
+        return reflection;
+    }
+
+    bool merge_reflection(
+        const ShaderReflection& reflection, const std::string_view shader_name,
+        eastl::fixed_vector<DescriptorSetInfo, 8>& descriptor_sets,
+        eastl::fixed_vector<VkPushConstantRange, 4>& push_constants
+        ) {
+        if(descriptor_sets.size() < reflection.descriptor_sets.size()) {
+            descriptor_sets.resize(reflection.descriptor_sets.size());
+        }
+
+        for(auto set_index = 0u; set_index < reflection.descriptor_sets.size(); set_index++) {
+            const auto& stage_set = reflection.descriptor_sets[set_index];
+            if(stage_set.bindings.empty()) {
+                continue;
+            }
+
+            auto& set_info = descriptor_sets[set_index];
+            if(set_info.bindings.size() < stage_set.bindings.size()) {
+                set_info.bindings.resize(stage_set.bindings.size());
+            }
+
+            for(auto binding_index = 0u; binding_index < stage_set.bindings.size(); binding_index++) {
+                const auto& stage_binding = stage_set.bindings[binding_index];
+                if(stage_binding.stageFlags == 0) {
+                    // The stage doesn't use this binding, it's only there to keep the indices right
+                    continue;
+                }
+
+                const auto old_stage_flags = set_info.bindings[binding_index].stageFlags;
+                set_info.bindings[binding_index] = stage_binding;
+                set_info.bindings[binding_index].stageFlags |= old_stage_flags;
+            }
+
+            set_info.has_variable_count_binding |= stage_set.has_variable_count_binding;
+
+            auto binding_index = 0;
+            for(auto& binding : set_info.bindings) {
+                binding.binding = binding_index;
+                binding_index++;
+            }
+        }
+
+        return collect_push_constants(shader_name, reflection.push_constants, push_constants);
     }
 
     void collect_vertex_attributes(
         const VertexLayout& vertex_layout,
-        const eastl::vector<SpvReflectInterfaceVariable*>& inputs,
+        const eastl::span<const ShaderInputVariable> inputs,
         eastl::fixed_vector<VkVertexInputAttributeDescription, 8>& vertex_attributes,
         bool& needs_position_buffer,
         bool& needs_data_buffer,
@@ -617,16 +626,13 @@ namespace render {
         ) {
         needs_position_buffer = false;
         needs_data_buffer = false;
-        for(const auto* input : inputs) {
-            if(input->name == nullptr) {
-                continue; // UGH
-            }
-            if(auto itr = vertex_layout.attributes.find(input->name); itr != vertex_layout.attributes.end()) {
+        for(const auto& input : inputs) {
+            if(auto itr = vertex_layout.attributes.find(input.name); itr != vertex_layout.attributes.end()) {
                 auto& attribute = vertex_attributes.emplace_back(itr->second);
-                attribute.location = input->location;
+                attribute.location = input.location;
             }
 
-            const auto string_name = std::string{input->name};
+            const auto string_name = std::string{input.name.c_str()};
 
             if(string_name.find(POSITION_VERTEX_ATTRIBUTE_NAME.c_str()) != std::string::npos) {
                 needs_position_buffer = true;
@@ -640,10 +646,10 @@ namespace render {
                 needs_data_buffer = true;
             } else if(string_name.find(PRIMITIVE_ID_VERTEX_ATTRIBUTE_NAME.c_str()) != std::string::npos) {
                 needs_primitive_id_buffer = true;
-            } else if(input->location != 0xFFFFFFFF) {
+            } else if(input.location != 0xFFFFFFFF) {
                 // -1 is used for some builtin things i guess
                 // I can't
-                logger->error("Vertex input {} unrecognized", input->location);
+                logger->error("Vertex input {} unrecognized", input.location);
             }
         }
     }
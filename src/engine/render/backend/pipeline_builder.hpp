@@ -11,6 +11,7 @@
 
 #include "render/backend/graphics_pipeline.hpp"
 #include "render/backend/handles.hpp"
+#include "render/backend/shader_cache.hpp"
 #include "resources/resource_path.hpp"
 
 struct SpvReflectDescriptorSet;
@@ -22,10 +23,23 @@ namespace render {
 
     class RenderBackend;
 
-    bool collect_bindings(
+    /**
+     * Reflects one shader stage. This is slow, prefer ShaderCache::get_reflection
+     */
+    ShaderReflection reflect_shader(
         eastl::span<const std::byte> shader_instructions,
         std::string_view shader_name,
-        VkShaderStageFlags shader_stage,
+        VkShaderStageFlagBits shader_stage
+    );
+
+    /**
+     * Adds one stage's descriptor sets and push constants to a pipeline's layout
+     *
+     * @return True if the stage's push constants disagree with the other stages', false if everything's fine
+     */
+    bool merge_reflection(
+        const ShaderReflection& reflection,
+        std::string_view shader_name,
         eastl::fixed_vector<DescriptorSetInfo, 8>& descriptor_sets,
         eastl::fixed_vector<VkPushConstantRange, 4>& push_constants
     );
@@ -99,8 +113,8 @@ namespace render {
         /**
          * Sets the vertex shader to use
          *
-         * This method loads the vertex shader from storage, performs reflection on it to see what descriptors it needs, and
-         * saves that information internally
+         * This method gets the vertex shader and its reflection from the shader cache to see what descriptors it needs,
+         * and saves that information internally
          *
          * Vertex shader inputs must follow a specific format:
          * 0: position (vec3)
@@ -158,19 +172,13 @@ namespace render {
         std::string name;
 
         /**
-         * Vertex shader SPIR-V code. If this is present, you may not load another vertex shader
+         * Vertex shader. If this is present, you may not load another vertex shader
          */
-        eastl::optional<eastl::vector<std::byte>> vertex_shader;
-
-        std::string vertex_shader_name;
-
-        eastl::optional<eastl::vector<std::byte>> geometry_shader;
-
-        std::string geometry_shader_name;
+        ShaderHandle vertex_shader = nullptr;
 
-        eastl::optional<eastl::vector<std::byte>> fragment_shader;
+        ShaderHandle geometry_shader = nullptr;
 
-        std::string fragment_shader_name;
+        ShaderHandle fragment_shader = nullptr;
 
         /**
          * Map from set number to the descriptor set info
@@ -1,9 +1,15 @@
+#include <atomic>
+#include <fstream>
+#include <magic_enum.hpp>
 #include <vulkan/vk_enum_string_helper.h>
 
 #include "render/backend/pipeline_cache.hpp"
 
+#include "console/cvars.hpp"
 #include "core/math_utils.hpp"
+#include "core/thread_pool.hpp"
 #include "render/backend/pipeline_builder.hpp"
+#include "render/backend/pipeline_compile_job.hpp"
 #include "render/backend/ray_tracing_pipeline.hpp"
 #include "render/backend/render_backend.hpp"
 #include "core/system_interface.hpp"
@@ -12,12 +18,53 @@
 namespace render {
     static std::shared_ptr<spdlog::logger> logger;
 
+    static auto cvar_warmup = AutoCVar_Int{
+        "r.PipelineCache.Warmup",
+        "Whether to compile the graphics pipeline variants from the last run on background threads at startup",
+        1
+    };
+
+    static auto cvar_async_compile = AutoCVar_Int{
+        "r.PipelineCache.AsyncCompile",
+        "Whether to compile pipelines on the thread pool. Draws skip graphics pipelines that are still compiling",
+        1
+    };
+
+    /**
+     * Makes sure a job has finished, ignoring any errors. Errors were already reported to whoever used the pipeline
+     */
+    static void finish_job(const std::shared_ptr<PipelineCompileJob>& job) {
+        if(job == nullptr) {
+            return;
+        }
+
+        try {
+            job->run();
+        } catch(const std::exception& e) {
+            logger->error("Pipeline job failed: {}", e.what());
+        }
+    }
+
+    /**
+     * Reads a graphics pipeline's PSO. A compile job may publish it from another thread at any time, but it never
+     * changes after that, so the PSO is all that most binds need to look at
+     */
+    static VkPipeline load_pso(GraphicsPipeline& pipeline) {
+        return std::atomic_ref{pipeline.pipeline}.load(std::memory_order_acquire);
+    }
+
     PipelineCache::PipelineCache(RenderBackend& backend_in) :
-        backend{backend_in} {
+        backend{backend_in}, shader_cache{backend_in} {
         if(logger == nullptr) {
             logger = SystemInterface::get().get_logger("PipelineCache");
             logger->set_level(spdlog::level::debug);
         }
+
+        device_info = PipelineCacheDeviceInfo::from_properties(backend.get_physical_device().properties);
+
+        create_vk_pipeline_cache();
+
+        load_manifest();
     }
 
     PipelineCache::~PipelineCache() {
@@ -35,13 +82,9 @@ namespace render {
         if(!pipeline_builder.vertex_shader) {
             throw std::runtime_error{"Vertex shader is required!"};
         }
-        pipeline.vertex_shader = *pipeline_builder.vertex_shader;
-        if(pipeline_builder.geometry_shader) {
-            pipeline.geometry_shader = *pipeline_builder.geometry_shader;
-        }
-        if(pipeline_builder.fragment_shader) {
-            pipeline.fragment_shader = *pipeline_builder.fragment_shader;
-        }
+        pipeline.vertex_shader = pipeline_builder.vertex_shader;
+        pipeline.geometry_shader = pipeline_builder.geometry_shader;
+        pipeline.fragment_shader = pipeline_builder.fragment_shader;
 
         pipeline.depth_stencil_state = pipeline_builder.depth_stencil_state;
         pipeline.raster_state = pipeline_builder.raster_state;
@@ -66,40 +109,71 @@ namespace render {
 
         pipeline.dynamic_states = pipeline_builder.dynamic_states;
 
-        return &(*pipelines.emplace(std::move(pipeline)));
+        auto* handle = &(*pipelines.emplace(std::move(pipeline)));
+
+        if(cvar_warmup.get() != 0) {
+            warm_up_pipeline(handle);
+        }
+
+        return handle;
     }
 
     ComputePipelineHandle PipelineCache::create_pipeline(const ResourcePath& shader_file_path) {
         logger->debug("Creating compute PSO {}", shader_file_path);
 
-        const auto instructions = *SystemInterface::get().load_file(shader_file_path);
+        auto* pipeline = &(*compute_pipelines.emplace());
+        pipeline->name = shader_file_path.to_string().c_str();
+
+        start_creation(
+            *pipeline,
+            [this, pipeline, shader_file_path] {
+                create_compute_pipeline(*pipeline, shader_cache.load_shader(shader_file_path));
+            });
 
-        return create_pipeline(shader_file_path.to_string().c_str(), instructions);
+        return pipeline;
     }
 
     ComputePipelineHandle PipelineCache::create_pipeline(const std::string_view pipeline_name,
                                                          eastl::span<const std::byte> instructions
         ) {
-        const auto module_create_info = VkShaderModuleCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = instructions.size(),
-            .pCode = reinterpret_cast<const uint32_t*>(instructions.data()),
-        };
+        auto* pipeline = &(*compute_pipelines.emplace());
+        pipeline->name = pipeline_name;
+
+        const auto shader = shader_cache.add_shader(pipeline_name, instructions);
 
-        VkShaderModule module;
-        vkCreateShaderModule(backend.get_device(), &module_create_info, nullptr, &module);
-        backend.set_object_name(module, fmt::format("{} VkShaderModule", pipeline_name));
+        start_creation(
+            *pipeline,
+            [this, pipeline, shader] {
+                create_compute_pipeline(*pipeline, shader);
+            });
+
+        return pipeline;
+    }
 
-        auto pipeline = ComputePipeline{};
+    void PipelineCache::start_creation(PipelineBase& pipeline, std::function<void()>&& work) {
+        auto job = std::make_shared<PipelineCompileJob>(std::move(work));
+        pipeline.creation_job = job;
+
+        if(cvar_async_compile.get() != 0) {
+            ThreadPool::get().enqueue([job] { job->run(); });
+        } else {
+            job->run();
+        }
+    }
+
+    void PipelineCache::create_compute_pipeline(ComputePipeline& pipeline, const ShaderHandle shader) const {
+        ZoneScoped;
+
+        const auto& pipeline_name = pipeline.name;
+
+        const auto module = shader_cache.get_module(shader);
 
-        pipeline.name = pipeline_name;
         pipeline.push_constant_stages = VK_SHADER_STAGE_COMPUTE_BIT;
 
         eastl::fixed_vector<VkPushConstantRange, 4> push_constants;
-        collect_bindings(
-            instructions,
+        merge_reflection(
+            shader_cache.get_reflection(shader, VK_SHADER_STAGE_COMPUTE_BIT),
             pipeline.name,
-            VK_SHADER_STAGE_COMPUTE_BIT,
             pipeline.descriptor_sets,
             push_constants);
 
@@ -126,14 +200,14 @@ namespace render {
 
         auto result = vkCreateComputePipelines(
             backend.get_device(),
-            VK_NULL_HANDLE,
+            vk_pipeline_cache,
             1,
             &create_info,
             nullptr,
             &pipeline.pipeline);
         if(result != VK_SUCCESS) {
-            logger->error("Could not create pipeline {}: Vulkan error {}", pipeline_name, string_VkResult(result));
-            return {};
+            throw std::runtime_error{
+                fmt::format("Could not create pipeline {}: Vulkan error {}", pipeline_name, string_VkResult(result))};
         }
 
         logger->trace("Created pipeline");
@@ -144,10 +218,6 @@ namespace render {
         backend.set_object_name(pipeline.layout, layout_name);
 
         logger->trace("Named pipeline and pipeline layout");
-
-        vkDestroyShaderModule(backend.get_device(), module, nullptr);
-
-        return &(*compute_pipelines.emplace(std::move(pipeline)));
     }
 
     GraphicsPipelineHandle
@@ -157,7 +227,14 @@ namespace render {
         auto vk_pipelines = eastl::vector<VkPipeline>{};
         vk_pipelines.reserve(pipelines_in.size());
         for(const auto& pipeline : pipelines_in) {
-            vk_pipelines.emplace_back(pipeline->pipeline);
+            // The PSO may be published by a compile job on another thread
+            const auto vk_pipeline = load_pso(*pipeline);
+            if(vk_pipeline == VK_NULL_HANDLE) {
+                throw std::runtime_error{
+                    fmt::format("Pipeline {} must be compiled before it can join a pipeline group", pipeline->name)
+                };
+            }
+            vk_pipelines.emplace_back(vk_pipeline);
         }
         const auto group_info = VkGraphicsPipelineShaderGroupsCreateInfoNV{
             .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_SHADER_GROUPS_CREATE_INFO_NV,
@@ -171,7 +248,7 @@ namespace render {
         };
         vkCreateGraphicsPipelines(
             backend.get_device(),
-            VK_NULL_HANDLE,
+            vk_pipeline_cache,
             1,
             &create_info,
             nullptr,
@@ -188,67 +265,114 @@ namespace render {
 
         ZoneScoped;
 
-        if(pipeline->pipeline != VK_NULL_HANDLE) {
-            return pipeline->pipeline;
+        if(const auto vk_pipeline = load_pso(*pipeline); vk_pipeline != VK_NULL_HANDLE) {
+            return vk_pipeline;
+        }
+
+        auto job = std::shared_ptr<PipelineCompileJob>{};
+        {
+            auto lock = std::unique_lock{graphics_pipelines_mutex};
+
+            // The PSO may have been published while we waited for the lock
+            if(const auto vk_pipeline = load_pso(*pipeline); vk_pipeline != VK_NULL_HANDLE) {
+                return vk_pipeline;
+            }
+
+            // Someone already heard about the failure. Throwing every frame wouldn't tell them anything new
+            if(pipeline->has_failed) {
+                return VK_NULL_HANDLE;
+            }
+
+            if(pipeline->compile_job == nullptr) {
+                auto variant = GraphicsPipelineVariant{
+                    .depth_format = depth_format.value_or(VK_FORMAT_UNDEFINED),
+                    .view_mask = view_mask,
+                    .use_fragment_shading_rate_attachment = use_fragment_shading_rate_attachment,
+                };
+                variant.color_formats.assign(color_attachment_formats.begin(), color_attachment_formats.end());
+
+                pipeline->compile_job = std::make_shared<PipelineCompileJob>(
+                    [this, pipeline, variant] {
+                        const auto vk_pipeline = compile_graphics_pipeline(*pipeline, variant);
+                        if(vk_pipeline == VK_NULL_HANDLE) {
+                            throw std::runtime_error{
+                                fmt::format("Could not compile graphics pipeline {}", pipeline->name)
+                            };
+                        }
+
+                        if(!pipeline->name.empty()) {
+                            add_to_manifest(pipeline->name, variant);
+                        }
+
+                        std::atomic_ref{pipeline->pipeline}.store(vk_pipeline, std::memory_order_release);
+                    });
+
+                if(cvar_async_compile.get() != 0) {
+                    ThreadPool::get().enqueue([job = pipeline->compile_job] { job->run(); });
+                }
+            }
+
+            job = pipeline->compile_job;
         }
 
+        if(cvar_async_compile.get() != 0 && !job->is_done()) {
+            // Still compiling, there's nothing to bind yet
+            return VK_NULL_HANDLE;
+        }
+
+        try {
+            job->run();
+        } catch(const std::exception&) {
+            // The job keeps the error. Report it once, to whichever thread gets here first
+            auto lock = std::unique_lock{graphics_pipelines_mutex};
+            if(pipeline->has_failed) {
+                return VK_NULL_HANDLE;
+            }
+            pipeline->has_failed = true;
+            throw;
+        }
+
+        return load_pso(*pipeline);
+    }
+
+    bool PipelineCache::is_pipeline_ready(const GraphicsPipelineHandle pipeline) const {
+        return load_pso(*pipeline) != VK_NULL_HANDLE;
+    }
+
+    VkPipeline PipelineCache::compile_graphics_pipeline(
+        const GraphicsPipeline& pipeline, const GraphicsPipelineVariant& variant
+    ) const {
+        ZoneScoped;
+
         const auto device = backend.get_device();
 
         auto stages = eastl::vector<VkPipelineShaderStageCreateInfo>{};
         stages.reserve(3);
 
-        const auto vertex_module_create_info = VkShaderModuleCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = static_cast<uint32_t>(pipeline->vertex_shader.size()),
-            .pCode = reinterpret_cast<const uint32_t*>(pipeline->vertex_shader.data()),
-        };
-
-        VkShaderModule vertex_module;
-        vkCreateShaderModule(device, &vertex_module_create_info, nullptr, &vertex_module);
-        backend.set_object_name(vertex_module, fmt::format("{} vertex module", pipeline->name));
-
         stages.emplace_back(
             VkPipelineShaderStageCreateInfo{
                 .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                 .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                .module = vertex_module,
+                .module = shader_cache.get_module(pipeline.vertex_shader),
                 .pName = "main",
             });
 
-        VkShaderModule geometry_module = VK_NULL_HANDLE;
-        if(!pipeline->geometry_shader.empty()) {
-            const auto geometry_module_create_info = VkShaderModuleCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                .codeSize = static_cast<uint32_t>(pipeline->geometry_shader.size()),
-                .pCode = reinterpret_cast<const uint32_t*>(pipeline->geometry_shader.data()),
-            };
-            vkCreateShaderModule(device, &geometry_module_create_info, nullptr, &geometry_module);
-            backend.set_object_name(geometry_module, fmt::format("{} geometry module", pipeline->name));
-
+        if(pipeline.geometry_shader != nullptr) {
             stages.emplace_back(
                 VkPipelineShaderStageCreateInfo{
                     .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                     .stage = VK_SHADER_STAGE_GEOMETRY_BIT,
-                    .module = geometry_module,
+                    .module = shader_cache.get_module(pipeline.geometry_shader),
                     .pName = "main",
                 });
         }
 
-        VkShaderModule fragment_module = VK_NULL_HANDLE;
-        if(!pipeline->fragment_shader.empty()) {
-            const auto fragment_module_create_info = VkShaderModuleCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                .codeSize = static_cast<uint32_t>(pipeline->fragment_shader.size()),
-                .pCode = reinterpret_cast<const uint32_t*>(pipeline->fragment_shader.data()),
-            };
-            vkCreateShaderModule(device, &fragment_module_create_info, nullptr, &fragment_module);
-            backend.set_object_name(fragment_module, fmt::format("{} fragment module", pipeline->name));
-
+        if(pipeline.fragment_shader != nullptr) {
             stages.emplace_back(
                 VkPipelineShaderStageCreateInfo{
                     .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                     .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                    .module = fragment_module,
+                    .module = shader_cache.get_module(pipeline.fragment_shader),
                     .pName = "main",
                 });
         }
@@ -256,15 +380,15 @@ namespace render {
         // ReSharper disable CppVariableCanBeMadeConstexpr
         const auto vertex_input_stage = VkPipelineVertexInputStateCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-            .vertexBindingDescriptionCount = static_cast<uint32_t>(pipeline->vertex_inputs.size()),
-            .pVertexBindingDescriptions = pipeline->vertex_inputs.data(),
-            .vertexAttributeDescriptionCount = static_cast<uint32_t>(pipeline->vertex_attributes.size()),
-            .pVertexAttributeDescriptions = pipeline->vertex_attributes.data(),
+            .vertexBindingDescriptionCount = static_cast<uint32_t>(pipeline.vertex_inputs.size()),
+            .pVertexBindingDescriptions = pipeline.vertex_inputs.data(),
+            .vertexAttributeDescriptionCount = static_cast<uint32_t>(pipeline.vertex_attributes.size()),
+            .pVertexAttributeDescriptions = pipeline.vertex_attributes.data(),
         };
 
         const auto input_assembly_state = VkPipelineInputAssemblyStateCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-            .topology = pipeline->topology,
+            .topology = pipeline.topology,
         };
 
         const auto viewport_state = VkPipelineViewportStateCreateInfo{
@@ -281,12 +405,12 @@ namespace render {
 
         const auto color_blend_state = VkPipelineColorBlendStateCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-            .flags = pipeline->blend_flags,
-            .attachmentCount = static_cast<uint32_t>(pipeline->blends.size()),
-            .pAttachments = pipeline->blends.data(),
+            .flags = pipeline.blend_flags,
+            .attachmentCount = static_cast<uint32_t>(pipeline.blends.size()),
+            .pAttachments = pipeline.blends.data(),
         };
 
-        auto dynamic_states = pipeline->dynamic_states;
+        auto dynamic_states = pipeline.dynamic_states;
         dynamic_states.emplace_back(VK_DYNAMIC_STATE_VIEWPORT);
         dynamic_states.emplace_back(VK_DYNAMIC_STATE_SCISSOR);
         dynamic_states.emplace_back(VK_DYNAMIC_STATE_FRONT_FACE);
@@ -300,10 +424,10 @@ namespace render {
 
         auto rendering_info = VkPipelineRenderingCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
-            .viewMask = view_mask,
-            .colorAttachmentCount = static_cast<uint32_t>(color_attachment_formats.size()),
-            .pColorAttachmentFormats = color_attachment_formats.data(),
-            .depthAttachmentFormat = depth_format.value_or(VK_FORMAT_UNDEFINED),
+            .viewMask = variant.view_mask,
+            .colorAttachmentCount = static_cast<uint32_t>(variant.color_formats.size()),
+            .pColorAttachmentFormats = variant.color_formats.data(),
+            .depthAttachmentFormat = variant.depth_format,
         };
         // ReSharper restore CppVariableCanBeMadeConstexpr
 
@@ -311,7 +435,7 @@ namespace render {
             .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
             .pNext = &rendering_info,
 
-            .flags = pipeline->flags,
+            .flags = pipeline.flags,
 
             .stageCount = static_cast<uint32_t>(stages.size()),
             .pStages = stages.data(),
@@ -321,20 +445,20 @@ namespace render {
 
             .pViewportState = &viewport_state,
 
-            .pRasterizationState = &pipeline->raster_state,
+            .pRasterizationState = &pipeline.raster_state,
             .pMultisampleState = &multisample_state,
 
-            .pDepthStencilState = &pipeline->depth_stencil_state,
+            .pDepthStencilState = &pipeline.depth_stencil_state,
 
             .pColorBlendState = &color_blend_state,
 
             .pDynamicState = &dynamic_state,
 
-            .layout = pipeline->layout
+            .layout = pipeline.layout
         };
 
         auto shading_rate_create_info = VkPipelineFragmentShadingRateStateCreateInfoKHR{};
-        if(use_fragment_shading_rate_attachment) {
+        if(variant.use_fragment_shading_rate_attachment) {
             create_info.flags |= VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
 
             shading_rate_create_info = {
@@ -348,42 +472,32 @@ namespace render {
             rendering_info.pNext = &shading_rate_create_info;
         }
 
-        logger->trace("About to compile PSO {}", pipeline->name);
+        logger->trace("About to compile PSO {}", pipeline.name);
+        auto vk_pipeline = VkPipeline{VK_NULL_HANDLE};
         const auto result = vkCreateGraphicsPipelines(
             device,
-            VK_NULL_HANDLE,
+            vk_pipeline_cache,
             1,
             &create_info,
             nullptr,
-            &pipeline->pipeline
+            &vk_pipeline
             );
         if(result != VK_SUCCESS) {
-            logger->error("Could not create pipeline {}: {}", pipeline->name, string_VkResult(result));
-        }
-
-        if(!pipeline->name.empty()) {
-            backend.set_object_name(pipeline->pipeline, pipeline->name);
+            logger->error("Could not create pipeline {}: {}", pipeline.name, string_VkResult(result));
         }
 
-        vkDestroyShaderModule(device, vertex_module, nullptr);
-        if(geometry_module != VK_NULL_HANDLE) {
-            vkDestroyShaderModule(device, geometry_module, nullptr);
-        }
-        if(fragment_module != VK_NULL_HANDLE) {
-            vkDestroyShaderModule(device, fragment_module, nullptr);
+        if(!pipeline.name.empty()) {
+            backend.set_object_name(vk_pipeline, pipeline.name);
         }
 
-        return pipeline->pipeline;
+        return vk_pipeline;
     }
 
     void PipelineCache::add_miss_shaders(
         const eastl::span<const std::byte> occlusion_miss, const eastl::span<const std::byte> gi_miss
         ) {
-        occlusion_miss_shader.resize(occlusion_miss.size());
-        std::memcpy(occlusion_miss_shader.data(), occlusion_miss.data(), occlusion_miss.size_bytes());
-
-        gi_miss_shader.resize(gi_miss.size());
-        std::memcpy(gi_miss_shader.data(), gi_miss.data(), gi_miss.size_bytes());
+        occlusion_miss_shader = shader_cache.add_shader("Occlusion miss shader", occlusion_miss);
+        gi_miss_shader = shader_cache.add_shader("GI miss shader", gi_miss);
     }
 
     HitGroupHandle PipelineCache::add_hit_group(const HitGroupBuilder& shader_group) {
@@ -398,6 +512,10 @@ namespace render {
             }));
     }
 
+    ShaderCache& PipelineCache::get_shader_cache() {
+        return shader_cache;
+    }
+
     RayTracingPipelineHandle PipelineCache::create_ray_tracing_pipeline(const ResourcePath& raygen_shader_path,
                                                                         bool skip_gi_miss_shader
         ) {
@@ -418,11 +536,28 @@ namespace render {
         auto groups = eastl::vector<VkRayTracingShaderGroupCreateInfoKHR>{};
         groups.reserve(shader_groups.size() * 2 + 2);
 
-        auto modules = eastl::vector<VkShaderModuleCreateInfo>{};
-        modules.reserve(stages.capacity());
-
         eastl::fixed_vector<VkPushConstantRange, 4> push_constants;
 
+        // Adds a stage for the shader and its bindings to the layout. Returns the stage's index
+        const auto add_stage = [&](const ShaderHandle shader, const VkShaderStageFlagBits stage) {
+            const auto stage_index = static_cast<uint32_t>(stages.size());
+            stages.emplace_back(
+                VkPipelineShaderStageCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                    .stage = stage,
+                    .module = shader_cache.get_module(shader),
+                    .pName = "main"
+                });
+
+            merge_reflection(
+                shader_cache.get_reflection(shader, stage),
+                shader->name.c_str(),
+                pipeline.descriptor_sets,
+                push_constants);
+
+            return stage_index;
+        };
+
         // Add stages for each shader group, and add two groups for each shader group. Occlusion is first, GI is second
         for(const auto& shader_group : shader_groups) {
             // Occlusion
@@ -431,64 +566,16 @@ namespace render {
                 auto occlusion_anyhit_index = VK_SHADER_UNUSED_KHR;
 
                 // Occlusion stages
-                const auto& occlusion_anyhit_shader = shader_group.occlusion_anyhit_shader;
-                if(!occlusion_anyhit_shader.empty()) {
-                    occlusion_anyhit_index = static_cast<uint32_t>(stages.size());
-
-                    const auto& module_create_info = modules.emplace_back(
-                        VkShaderModuleCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                            .codeSize = occlusion_anyhit_shader.size() * sizeof(uint8_t),
-                            .pCode = reinterpret_cast<const uint32_t*>(occlusion_anyhit_shader.data())
-                        });
-
-                    VkShaderModule occlusion_anyhit_module;
-                    vkCreateShaderModule(device, &module_create_info, nullptr, &occlusion_anyhit_module);
-
-                    stages.emplace_back(
-                        VkPipelineShaderStageCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                            .stage = VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
-                            .module = occlusion_anyhit_module,
-                            .pName = "main"
-                        });
-
-                    collect_bindings(
-                        occlusion_anyhit_shader,
-                        shader_group.name,
-                        VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
-                        pipeline.descriptor_sets,
-                        push_constants);
+                if(shader_group.occlusion_anyhit_shader != nullptr) {
+                    occlusion_anyhit_index = add_stage(
+                        shader_group.occlusion_anyhit_shader,
+                        VK_SHADER_STAGE_ANY_HIT_BIT_KHR);
                 }
 
-                const auto& occlusion_closesthit_shader = shader_group.occlusion_closesthit_shader;
-                if(!occlusion_closesthit_shader.empty()) {
-                    occlusion_closesthit_index = static_cast<uint32_t>(stages.size());
-
-                    const auto& module_create_info = modules.emplace_back(
-                        VkShaderModuleCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                            .codeSize = occlusion_closesthit_shader.size() * sizeof(uint8_t),
-                            .pCode = reinterpret_cast<const uint32_t*>(occlusion_closesthit_shader.data())
-                        });
-
-                    VkShaderModule occlusion_closesthit_module;
-                    vkCreateShaderModule(device, &module_create_info, nullptr, &occlusion_closesthit_module);
-
-                    stages.emplace_back(
-                        VkPipelineShaderStageCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                            .stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
-                            .module = occlusion_closesthit_module,
-                            .pName = "main"
-                        });
-
-                    collect_bindings(
-                        occlusion_closesthit_shader,
-                        shader_group.name,
-                        VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
-                        pipeline.descriptor_sets,
-                        push_constants);
+                if(shader_group.occlusion_closesthit_shader != nullptr) {
+                    occlusion_closesthit_index = add_stage(
+                        shader_group.occlusion_closesthit_shader,
+                        VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR);
                 }
 
                 // Occlusion group
@@ -510,64 +597,14 @@ namespace render {
                 auto gi_closesthit_index = VK_SHADER_UNUSED_KHR;
                 auto gi_anyhit_index = VK_SHADER_UNUSED_KHR;
 
-                const auto& gi_anyhit_shader = shader_group.gi_anyhit_shader;
-                if(!gi_anyhit_shader.empty()) {
-                    gi_anyhit_index = static_cast<uint32_t>(stages.size());
-
-                    const auto& module_create_info = modules.emplace_back(
-                        VkShaderModuleCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                            .codeSize = gi_anyhit_shader.size() * sizeof(uint8_t),
-                            .pCode = reinterpret_cast<const uint32_t*>(gi_anyhit_shader.data())
-                        });
-
-                    VkShaderModule gi_anyhit_module;
-                    vkCreateShaderModule(device, &module_create_info, nullptr, &gi_anyhit_module);
-
-                    stages.emplace_back(
-                        VkPipelineShaderStageCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                            .stage = VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
-                            .module = gi_anyhit_module,
-                            .pName = "main"
-                        });
-
-                    collect_bindings(
-                        gi_anyhit_shader,
-                        shader_group.name,
-                        VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
-                        pipeline.descriptor_sets,
-                        push_constants);
+                if(shader_group.gi_anyhit_shader != nullptr) {
+                    gi_anyhit_index = add_stage(shader_group.gi_anyhit_shader, VK_SHADER_STAGE_ANY_HIT_BIT_KHR);
                 }
 
-                const auto& gi_closesthit_shader = shader_group.gi_closesthit_shader;
-                if(!gi_closesthit_shader.empty()) {
-                    gi_closesthit_index = static_cast<uint32_t>(stages.size());
-
-                    const auto& module_create_info = modules.emplace_back(
-                        VkShaderModuleCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                            .codeSize = gi_closesthit_shader.size() * sizeof(uint8_t),
-                            .pCode = reinterpret_cast<const uint32_t*>(gi_closesthit_shader.data())
-                        });
-
-                    VkShaderModule gi_closesthit_module;
-                    vkCreateShaderModule(device, &module_create_info, nullptr, &gi_closesthit_module);
-
-                    stages.emplace_back(
-                        VkPipelineShaderStageCreateInfo{
-                            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                            .stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
-                            .module = gi_closesthit_module,
-                            .pName = "main"
-                        });
-
-                    collect_bindings(
-                        gi_closesthit_shader,
-                        shader_group.name,
-                        VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
-                        pipeline.descriptor_sets,
-                        push_constants);
+                if(shader_group.gi_closesthit_shader != nullptr) {
+                    gi_closesthit_index = add_stage(
+                        shader_group.gi_closesthit_shader,
+                        VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR);
                 }
 
                 // GI group
@@ -588,23 +625,7 @@ namespace render {
 
         // Occlusion miss
         {
-            const auto& miss_module_create_info = modules.emplace_back(
-                VkShaderModuleCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                    .codeSize = occlusion_miss_shader.size() * sizeof(uint8_t),
-                    .pCode = reinterpret_cast<const uint32_t*>(occlusion_miss_shader.data())
-                });
-
-            VkShaderModule occlusion_miss_module;
-            vkCreateShaderModule(device, &miss_module_create_info, nullptr, &occlusion_miss_module);
-
-            stages.emplace_back(
-                VkPipelineShaderStageCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                    .stage = VK_SHADER_STAGE_MISS_BIT_KHR,
-                    .module = occlusion_miss_module,
-                    .pName = "main"
-                });
+            add_stage(occlusion_miss_shader, VK_SHADER_STAGE_MISS_BIT_KHR);
 
             groups.emplace_back(
                 VkRayTracingShaderGroupCreateInfoKHR{
@@ -615,36 +636,13 @@ namespace render {
                     .anyHitShader = VK_SHADER_UNUSED_KHR,
                     .intersectionShader = VK_SHADER_UNUSED_KHR,
                 });
-
-            collect_bindings(
-                occlusion_miss_shader,
-                "Occlusion miss shader",
-                VK_SHADER_STAGE_MISS_BIT_KHR,
-                pipeline.descriptor_sets,
-                push_constants);
         }
 
         auto num_miss_shaders = 1u;
         // GI miss
         if(!skip_gi_miss_shader) {
             num_miss_shaders = 2;
-            const auto& miss_module_create_info = modules.emplace_back(
-                VkShaderModuleCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                    .codeSize = gi_miss_shader.size() * sizeof(uint8_t),
-                    .pCode = reinterpret_cast<const uint32_t*>(gi_miss_shader.data())
-                });
-
-            VkShaderModule gi_miss_module;
-            vkCreateShaderModule(device, &miss_module_create_info, nullptr, &gi_miss_module);
-
-            stages.emplace_back(
-                VkPipelineShaderStageCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                    .stage = VK_SHADER_STAGE_MISS_BIT_KHR,
-                    .module = gi_miss_module,
-                    .pName = "main"
-                });
+            add_stage(gi_miss_shader, VK_SHADER_STAGE_MISS_BIT_KHR);
 
             groups.emplace_back(
                 VkRayTracingShaderGroupCreateInfoKHR{
@@ -655,39 +653,13 @@ namespace render {
                     .anyHitShader = VK_SHADER_UNUSED_KHR,
                     .intersectionShader = VK_SHADER_UNUSED_KHR,
                 });
-
-            collect_bindings(
-                gi_miss_shader,
-                "GI miss shader",
-                VK_SHADER_STAGE_MISS_BIT_KHR,
-                pipeline.descriptor_sets,
-                push_constants);
         }
 
-        const auto raygen_shader_index = miss_shader_index + num_miss_shaders;
         const auto raygen_group_index = static_cast<uint32_t>(groups.size());
 
-        const auto raygen_shader_maybe = SystemInterface::get().load_file(raygen_shader_path);
-        if(!raygen_shader_maybe) {
-            throw std::runtime_error{fmt::format("Could not load raygen shader {}", raygen_shader_path)};
-        }
-        const auto& raygen_module_create_info = modules.emplace_back(
-            VkShaderModuleCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                .codeSize = raygen_shader_maybe->size() * sizeof(uint8_t),
-                .pCode = reinterpret_cast<const uint32_t*>(raygen_shader_maybe->data())
-            });
-
-        VkShaderModule raygen_module;
-        vkCreateShaderModule(device, &raygen_module_create_info, nullptr, &raygen_module);
-
-        stages.emplace_back(
-            VkPipelineShaderStageCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                .stage = VK_SHADER_STAGE_RAYGEN_BIT_KHR,
-                .module = raygen_module,
-                .pName = "main"
-            });
+        const auto raygen_shader_index = add_stage(
+            shader_cache.load_shader(raygen_shader_path),
+            VK_SHADER_STAGE_RAYGEN_BIT_KHR);
 
         groups.emplace_back(
             VkRayTracingShaderGroupCreateInfoKHR{
@@ -699,14 +671,6 @@ namespace render {
                 .intersectionShader = VK_SHADER_UNUSED_KHR,
             });
 
-        const auto raygen_shader_name = raygen_shader_path.to_string();
-        collect_bindings(
-            *raygen_shader_maybe,
-            std::string_view{raygen_shader_name.c_str()},
-            VK_SHADER_STAGE_RAYGEN_BIT_KHR,
-            pipeline.descriptor_sets,
-            push_constants);
-
         // Find the greatest offset + size in the push constant ranges, assume that every other push constant is used
         for(auto& range : push_constants) {
             range.stageFlags = VK_SHADER_STAGE_ALL;
@@ -737,7 +701,7 @@ namespace render {
         auto result = vkCreateRayTracingPipelinesKHR(
             device,
             VK_NULL_HANDLE,
-            VK_NULL_HANDLE,
+            vk_pipeline_cache,
             1,
             &create_info,
             nullptr,
@@ -830,17 +794,186 @@ namespace render {
             .size = shader_group_handle_size * num_miss_shaders
         };
 
-        for(const auto& stage_info : stages) {
-            vkDestroyShaderModule(device, stage_info.module, nullptr);
-        }
-
         return &(*ray_tracing_pipelines.emplace(std::move(pipeline)));
     }
 
     void PipelineCache::destroy_all_pipelines() {
+        // Background tasks read and write the pipelines, so they must finish first
+        for(auto& task : warmup_tasks) {
+            task.wait();
+        }
+        warmup_tasks.clear();
+
+        for(const auto& pipeline : pipelines) {
+            finish_job(pipeline.compile_job);
+        }
+        for(const auto& pipeline : compute_pipelines) {
+            finish_job(pipeline.creation_job);
+        }
+
+        save_vk_pipeline_cache();
+        save_manifest();
+        shader_cache.save_reflection();
+
         pipelines.clear();
         shader_groups.clear();
         ray_tracing_pipelines.clear();
         compute_pipelines.clear();
+
+        shader_cache.destroy_modules();
+
+        vkDestroyPipelineCache(backend.get_device(), vk_pipeline_cache, nullptr);
+        vk_pipeline_cache = VK_NULL_HANDLE;
+    }
+
+    std::filesystem::path PipelineCache::get_pipeline_cache_path() {
+        return SystemInterface::get().get_cache_folder() / "pipelines" / "pipeline_cache.bin";
+    }
+
+    std::filesystem::path PipelineCache::get_manifest_path() {
+        return SystemInterface::get().get_cache_folder() / "pipelines" / "manifest.txt";
+    }
+
+    static eastl::vector<std::byte> read_whole_file(const std::filesystem::path& filepath) {
+        auto file = std::ifstream{filepath, std::ios::binary | std::ios::ate};
+        if(!file.is_open()) {
+            return {};
+        }
+
+        auto data = eastl::vector<std::byte>(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        return data;
+    }
+
+    void PipelineCache::create_vk_pipeline_cache() {
+        ZoneScoped;
+
+        const auto filepath = get_pipeline_cache_path();
+        const auto file = read_whole_file(filepath);
+
+        auto initial_data = eastl::span<const std::byte>{};
+        if(!file.empty()) {
+            const auto contents = read_pipeline_cache_file(file, device_info);
+            if(contents.status == PipelineCacheFileStatus::Valid) {
+                initial_data = contents.cache_data;
+                logger->info("Loaded {} bytes of pipeline cache data", initial_data.size());
+            } else {
+                logger->info(
+                    "Ignoring pipeline cache {}: {}",
+                    filepath.string(),
+                    magic_enum::enum_name(contents.status));
+            }
+        }
+
+        const auto create_info = VkPipelineCacheCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = initial_data.size(),
+            .pInitialData = initial_data.data(),
+        };
+        auto result = vkCreatePipelineCache(backend.get_device(), &create_info, nullptr, &vk_pipeline_cache);
+        if(result != VK_SUCCESS && !initial_data.empty()) {
+            // The driver may still reject data that passed our checks. Start over with an empty cache
+            logger->warn("Could not create pipeline cache from saved data: {}", string_VkResult(result));
+            const auto empty_create_info = VkPipelineCacheCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            };
+            result = vkCreatePipelineCache(backend.get_device(), &empty_create_info, nullptr, &vk_pipeline_cache);
+        }
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not create pipeline cache: {}", string_VkResult(result))};
+        }
+
+        backend.set_object_name(vk_pipeline_cache, "Pipeline cache");
+    }
+
+    void PipelineCache::save_vk_pipeline_cache() const {
+        ZoneScoped;
+
+        if(vk_pipeline_cache == VK_NULL_HANDLE) {
+            return;
+        }
+
+        const auto device = backend.get_device();
+
+        auto data_size = size_t{0};
+        auto result = vkGetPipelineCacheData(device, vk_pipeline_cache, &data_size, nullptr);
+        if(result != VK_SUCCESS) {
+            logger->error("Could not get pipeline cache size: {}", string_VkResult(result));
+            return;
+        }
+
+        auto cache_data = eastl::vector<std::byte>(data_size);
+        result = vkGetPipelineCacheData(device, vk_pipeline_cache, &data_size, cache_data.data());
+        if(result != VK_SUCCESS) {
+            logger->error("Could not get pipeline cache data: {}", string_VkResult(result));
+            return;
+        }
+        cache_data.resize(data_size);
+
+        const auto file = write_pipeline_cache_file(device_info, cache_data);
+        SystemInterface::get().write_file(get_pipeline_cache_path(), file.data(), static_cast<uint32_t>(file.size()));
+
+        logger->info("Saved {} bytes of pipeline cache data", data_size);
+    }
+
+    void PipelineCache::load_manifest() {
+        ZoneScoped;
+
+        const auto file = read_whole_file(get_manifest_path());
+        manifest = read_pipeline_manifest(
+            eastl::string_view{reinterpret_cast<const char*>(file.data()), file.size()});
+
+        logger->debug("Loaded {} pipeline variants from the manifest", manifest.size());
+    }
+
+    void PipelineCache::save_manifest() const {
+        ZoneScoped;
+
+        auto lock = std::unique_lock{manifest_mutex};
+
+        const auto text = write_pipeline_manifest(manifest);
+        SystemInterface::get().write_file(get_manifest_path(), text.data(), static_cast<uint32_t>(text.size()));
+    }
+
+    void PipelineCache::warm_up_pipeline(const GraphicsPipelineHandle pipeline) {
+        if(pipeline->name.empty()) {
+            return;
+        }
+
+        auto lock = std::unique_lock{manifest_mutex};
+
+        for(const auto& entry : manifest) {
+            if(entry.pipeline_name != pipeline->name.c_str()) {
+                continue;
+            }
+
+            logger->trace("Warming up PSO {}", pipeline->name);
+
+            warmup_tasks.emplace_back(
+                ThreadPool::get().enqueue(
+                    [this, pipeline, variant = entry.variant] {
+                        const auto vk_pipeline = compile_graphics_pipeline(*pipeline, variant);
+                        if(vk_pipeline != VK_NULL_HANDLE) {
+                            vkDestroyPipeline(backend.get_device(), vk_pipeline, nullptr);
+                        }
+                    }));
+        }
+    }
+
+    void PipelineCache::add_to_manifest(
+        const std::string& pipeline_name, const GraphicsPipelineVariant& variant
+    ) const {
+        auto entry = PipelineManifestEntry{
+            .pipeline_name = eastl::string{pipeline_name.c_str(), pipeline_name.size()},
+            .variant = variant
+        };
+
+        auto lock = std::unique_lock{manifest_mutex};
+
+        if(eastl::find(manifest.begin(), manifest.end(), entry) == manifest.end()) {
+            manifest.emplace_back(eastl::move(entry));
+        }
     }
 }
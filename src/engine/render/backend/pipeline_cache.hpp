@@ -1,5 +1,10 @@
 #pragma once
 
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+
 #include <plf_colony.h>
 #include <EASTL/span.h>
 #include <EASTL/optional.h>
@@ -9,10 +14,27 @@
 #include "render/backend/compute_shader.hpp"
 #include "render/backend/graphics_pipeline.hpp"
 #include "render/backend/pipeline_builder.hpp"
+#include "render/backend/pipeline_cache_file.hpp"
+#include "render/backend/shader_cache.hpp"
 
 namespace render {
     class RenderBackend;
 
+    /**
+     * Creates and owns all the pipelines
+     *
+     * Everything compiles through one VkPipelineCache, which we save to the cache folder on shutdown and load on the
+     * next launch. The cache also records which attachment formats each graphics pipeline got compiled for. When a
+     * graphics pipeline that we've seen before is created, we compile its recorded variants on the thread pool, so
+     * that the driver has them cached by the time the pipeline is first bound
+     *
+     * Compiles happen on the thread pool. Compute pipelines load and reflect their shader in the background, and block
+     * on first use if they aren't done by then. Graphics pipelines start compiling the first time they're bound, and
+     * draws that use them are skipped until they're ready
+     *
+     * Graphics, compute, and ray tracing pipelines all get their shaders through one ShaderCache, so a shader that's
+     * used by many pipelines is loaded, reflected, and turned into a VkShaderModule once
+     */
     class PipelineCache {
     public:
         explicit PipelineCache(RenderBackend& backend_in);
@@ -21,12 +43,23 @@ namespace render {
 
         GraphicsPipelineHandle create_pipeline(const GraphicsPipelineBuilder& pipeline_builder);
 
+        /**
+         * Creates a compute pipeline. The shader is loaded, reflected, and compiled in the background. Anything that
+         * needs the pipeline's layout or PSO waits for that to finish
+         */
         ComputePipelineHandle create_pipeline(const ResourcePath& shader_file_path);
 
         ComputePipelineHandle create_pipeline(std::string_view pipeline_name, eastl::span<const std::byte> instructions);
 
         GraphicsPipelineHandle create_pipeline_group(eastl::span<GraphicsPipelineHandle> pipelines_in);
 
+        /**
+         * Gets the PSO for a graphics pipeline, starting the compile if this is the first time we've seen it. Returns
+         * VK_NULL_HANDLE while the pipeline is compiling
+         *
+         * If the compile failed, the first call after that throws the error, like PipelineBase::wait_until_created.
+         * Every call after that returns VK_NULL_HANDLE
+         */
         VkPipeline get_pipeline(
             GraphicsPipelineHandle pipeline,
             eastl::span<const VkFormat> color_attachment_formats,
@@ -35,6 +68,11 @@ namespace render {
             bool use_fragment_shading_rate_attachment = false
         ) const;
 
+        /**
+         * Checks if a graphics pipeline has a PSO that can be bound. Pipelines that failed to compile never will
+         */
+        bool is_pipeline_ready(GraphicsPipelineHandle pipeline) const;
+
         /**
          * Registers global miss shaders, to be used for all RT pipelines
          */
@@ -46,6 +84,8 @@ namespace render {
          */
         HitGroupHandle add_hit_group(const HitGroupBuilder& shader_group);
 
+        ShaderCache& get_shader_cache();
+
         RayTracingPipelineHandle create_ray_tracing_pipeline(const ResourcePath& raygen_shader_path, bool skip_gi_miss_shader = false);
 
         /**
@@ -60,16 +100,71 @@ namespace render {
     private:
         RenderBackend& backend;
 
+        VkPipelineCache vk_pipeline_cache = VK_NULL_HANDLE;
+
+        PipelineCacheDeviceInfo device_info;
+
+        /**
+         * Thread-safe, so pipeline compiles can use it from the thread pool
+         */
+        mutable ShaderCache shader_cache;
+
+        mutable std::mutex manifest_mutex;
+
+        /**
+         * Variants from the manifest of the last run, plus every variant compiled this run
+         */
+        mutable eastl::vector<PipelineManifestEntry> manifest;
+
+        eastl::vector<std::future<void>> warmup_tasks;
+
         plf::colony<GraphicsPipeline> pipelines;
 
+        /**
+         * Guards each graphics pipeline's compile job, since passes may be recorded on multiple threads. The PSO itself
+         * is read and written atomically, so binding a pipeline that's already compiled never takes the lock
+         */
+        mutable std::mutex graphics_pipelines_mutex;
+
         plf::colony<ComputePipeline> compute_pipelines;
 
         plf::colony<HitGroup> shader_groups;
 
-        eastl::vector<std::byte> occlusion_miss_shader;
+        ShaderHandle occlusion_miss_shader = nullptr;
 
-        eastl::vector<std::byte> gi_miss_shader;
+        ShaderHandle gi_miss_shader = nullptr;
 
         plf::colony<RayTracingPipeline> ray_tracing_pipelines;
+
+        static std::filesystem::path get_pipeline_cache_path();
+
+        static std::filesystem::path get_manifest_path();
+
+        void create_vk_pipeline_cache();
+
+        void save_vk_pipeline_cache() const;
+
+        void load_manifest();
+
+        void save_manifest() const;
+
+        /**
+         * Compiles the manifest's variants of a pipeline on the thread pool. The results are thrown away, they only
+         * exist to fill the VkPipelineCache
+         */
+        void warm_up_pipeline(GraphicsPipelineHandle pipeline);
+
+        void add_to_manifest(const std::string& pipeline_name, const GraphicsPipelineVariant& variant) const;
+
+        /**
+         * Gives the pipeline a creation job that runs the work, either on the thread pool or right now
+         */
+        static void start_creation(PipelineBase& pipeline, std::function<void()>&& work);
+
+        void create_compute_pipeline(ComputePipeline& pipeline, ShaderHandle shader) const;
+
+        VkPipeline compile_graphics_pipeline(
+            const GraphicsPipeline& pipeline, const GraphicsPipelineVariant& variant
+        ) const;
     };
 }
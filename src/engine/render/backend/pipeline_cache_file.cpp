@@ -0,0 +1,193 @@
+#include "pipeline_cache_file.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "extern/cityhash/city_hash.hpp"
+
+namespace render {
+    /**
+     * 'SPSO'
+     */
+    constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x4F535053;
+
+    struct PipelineCacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+        uint32_t padding;
+        uint64_t data_size;
+        uint64_t data_hash;
+    };
+
+    static uint64_t hash_cache_data(const eastl::span<const std::byte> cache_data) {
+        return CityHash64(reinterpret_cast<const char*>(cache_data.data()), cache_data.size());
+    }
+
+    PipelineCacheDeviceInfo PipelineCacheDeviceInfo::from_properties(const VkPhysicalDeviceProperties& properties) {
+        auto info = PipelineCacheDeviceInfo{
+            .vendor_id = properties.vendorID,
+            .device_id = properties.deviceID,
+            .driver_version = properties.driverVersion,
+        };
+        std::memcpy(info.pipeline_cache_uuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        return info;
+    }
+
+    eastl::vector<std::byte> write_pipeline_cache_file(
+        const PipelineCacheDeviceInfo& device, const eastl::span<const std::byte> cache_data
+    ) {
+        auto header = PipelineCacheFileHeader{
+            .magic = PIPELINE_CACHE_MAGIC,
+            .version = PIPELINE_CACHE_FILE_VERSION,
+            .vendor_id = device.vendor_id,
+            .device_id = device.device_id,
+            .driver_version = device.driver_version,
+            .padding = 0,
+            .data_size = cache_data.size(),
+            .data_hash = hash_cache_data(cache_data),
+        };
+        std::memcpy(header.pipeline_cache_uuid, device.pipeline_cache_uuid.data(), VK_UUID_SIZE);
+
+        auto file = eastl::vector<std::byte>(sizeof(PipelineCacheFileHeader) + cache_data.size());
+        std::memcpy(file.data(), &header, sizeof(PipelineCacheFileHeader));
+        if(!cache_data.empty()) {
+            std::memcpy(file.data() + sizeof(PipelineCacheFileHeader), cache_data.data(), cache_data.size());
+        }
+
+        return file;
+    }
+
+    PipelineCacheFileContents read_pipeline_cache_file(
+        const eastl::span<const std::byte> file, const PipelineCacheDeviceInfo& device
+    ) {
+        if(file.size() < sizeof(PipelineCacheFileHeader)) {
+            return {.status = PipelineCacheFileStatus::Truncated};
+        }
+
+        auto header = PipelineCacheFileHeader{};
+        std::memcpy(&header, file.data(), sizeof(PipelineCacheFileHeader));
+
+        if(header.magic != PIPELINE_CACHE_MAGIC) {
+            return {.status = PipelineCacheFileStatus::WrongMagic};
+        }
+
+        if(header.version != PIPELINE_CACHE_FILE_VERSION) {
+            return {.status = PipelineCacheFileStatus::WrongVersion};
+        }
+
+        auto file_device = PipelineCacheDeviceInfo{
+            .vendor_id = header.vendor_id,
+            .device_id = header.device_id,
+            .driver_version = header.driver_version,
+        };
+        std::memcpy(file_device.pipeline_cache_uuid.data(), header.pipeline_cache_uuid, VK_UUID_SIZE);
+        if(file_device != device) {
+            return {.status = PipelineCacheFileStatus::WrongDevice};
+        }
+
+        if(header.data_size > file.size() - sizeof(PipelineCacheFileHeader)) {
+            return {.status = PipelineCacheFileStatus::Truncated};
+        }
+
+        const auto cache_data = file.subspan(sizeof(PipelineCacheFileHeader), header.data_size);
+        if(hash_cache_data(cache_data) != header.data_hash) {
+            return {.status = PipelineCacheFileStatus::Corrupt};
+        }
+
+        return {.status = PipelineCacheFileStatus::Valid, .cache_data = cache_data};
+    }
+
+    eastl::string write_pipeline_manifest(const eastl::span<const PipelineManifestEntry> entries) {
+        auto manifest = fmt::format("pipeline-manifest {}\n", PIPELINE_MANIFEST_VERSION);
+
+        for(const auto& entry : entries) {
+            const auto& variant = entry.variant;
+            fmt::format_to(
+                std::back_inserter(manifest),
+                "{}\t{}\t{}\t{}\t",
+                entry.pipeline_name.c_str(),
+                variant.view_mask,
+                variant.use_fragment_shading_rate_attachment ? 1 : 0,
+                static_cast<uint32_t>(variant.depth_format));
+            for(auto i = 0u; i < variant.color_formats.size(); i++) {
+                if(i > 0) {
+                    manifest.push_back(',');
+                }
+                fmt::format_to(std::back_inserter(manifest), "{}", static_cast<uint32_t>(variant.color_formats[i]));
+            }
+            manifest.push_back('\n');
+        }
+
+        return eastl::string{manifest.c_str(), manifest.size()};
+    }
+
+    /**
+     * Splits off the text before the next separator, advancing the input past the separator
+     */
+    static eastl::string_view next_token(eastl::string_view& text, const char separator) {
+        const auto separator_pos = text.find(separator);
+        const auto token = text.substr(0, separator_pos);
+        text = separator_pos == eastl::string_view::npos ? eastl::string_view{} : text.substr(separator_pos + 1);
+        return token;
+    }
+
+    static bool parse_uint(const eastl::string_view text, uint32_t& value) {
+        const auto* end = text.data() + text.size();
+        const auto [ptr, error] = std::from_chars(text.data(), end, value);
+        return error == std::errc{} && ptr == end;
+    }
+
+    eastl::vector<PipelineManifestEntry> read_pipeline_manifest(eastl::string_view manifest) {
+        auto entries = eastl::vector<PipelineManifestEntry>{};
+
+        const auto version_line = next_token(manifest, '\n');
+        const auto expected_version_line = fmt::format("pipeline-manifest {}", PIPELINE_MANIFEST_VERSION);
+        if(version_line != eastl::string_view{expected_version_line.data(), expected_version_line.size()}) {
+            return entries;
+        }
+
+        while(!manifest.empty()) {
+            auto line = next_token(manifest, '\n');
+            if(line.empty()) {
+                continue;
+            }
+
+            auto entry = PipelineManifestEntry{};
+            const auto pipeline_name = next_token(line, '\t');
+            entry.pipeline_name.assign(pipeline_name.data(), pipeline_name.size());
+
+            auto use_fsr = 0u;
+            auto depth_format = 0u;
+            if(entry.pipeline_name.empty() ||
+                !parse_uint(next_token(line, '\t'), entry.variant.view_mask) ||
+                !parse_uint(next_token(line, '\t'), use_fsr) ||
+                !parse_uint(next_token(line, '\t'), depth_format)) {
+                continue;
+            }
+            entry.variant.use_fragment_shading_rate_attachment = use_fsr != 0;
+            entry.variant.depth_format = static_cast<VkFormat>(depth_format);
+
+            auto is_valid = true;
+            while(!line.empty() && is_valid) {
+                auto color_format = 0u;
+                is_valid = parse_uint(next_token(line, ','), color_format);
+                if(is_valid) {
+                    entry.variant.color_formats.emplace_back(static_cast<VkFormat>(color_format));
+                }
+            }
+
+            if(is_valid) {
+                entries.emplace_back(eastl::move(entry));
+            }
+        }
+
+        return entries;
+    }
+}
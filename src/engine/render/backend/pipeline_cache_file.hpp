@@ -0,0 +1,121 @@
+#pragma once
+
+#include <EASTL/array.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/span.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <volk.h>
+
+namespace render {
+    /**
+     * Identifies the device and driver that produced some pipeline cache data. Data from any other device or driver
+     * is useless at best, and can crash a driver that doesn't validate it properly at worst
+     */
+    struct PipelineCacheDeviceInfo {
+        uint32_t vendor_id = 0;
+
+        uint32_t device_id = 0;
+
+        uint32_t driver_version = 0;
+
+        eastl::array<uint8_t, VK_UUID_SIZE> pipeline_cache_uuid = {};
+
+        static PipelineCacheDeviceInfo from_properties(const VkPhysicalDeviceProperties& properties);
+
+        bool operator==(const PipelineCacheDeviceInfo& other) const = default;
+    };
+
+    enum class PipelineCacheFileStatus {
+        Valid,
+        /**
+         * The file is shorter than its header says it should be
+         */
+        Truncated,
+        /**
+         * The file isn't a pipeline cache file at all
+         */
+        WrongMagic,
+        /**
+         * The file was written by an older or newer version of the engine
+         */
+        WrongVersion,
+        /**
+         * The file was written on a different device or driver version
+         */
+        WrongDevice,
+        /**
+         * The cache data doesn't match its checksum
+         */
+        Corrupt,
+    };
+
+    struct PipelineCacheFileContents {
+        PipelineCacheFileStatus status = PipelineCacheFileStatus::Truncated;
+
+        /**
+         * The VkPipelineCache data, pointing into the file. Empty unless the status is Valid
+         */
+        eastl::span<const std::byte> cache_data;
+    };
+
+    /**
+     * Bump this whenever the file layout changes, so that stale files get thrown away
+     */
+    constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+    /**
+     * Wraps VkPipelineCache data in a header that records which device and driver it came from
+     */
+    eastl::vector<std::byte> write_pipeline_cache_file(
+        const PipelineCacheDeviceInfo& device, eastl::span<const std::byte> cache_data
+    );
+
+    /**
+     * Checks that a pipeline cache file is intact and came from the given device and driver
+     *
+     * This does not touch the GPU, so it can run against made-up device info
+     */
+    PipelineCacheFileContents read_pipeline_cache_file(
+        eastl::span<const std::byte> file, const PipelineCacheDeviceInfo& device
+    );
+
+    /**
+     * One attachment configuration that a graphics pipeline was compiled for
+     */
+    struct GraphicsPipelineVariant {
+        eastl::fixed_vector<VkFormat, 8> color_formats;
+
+        VkFormat depth_format = VK_FORMAT_UNDEFINED;
+
+        uint32_t view_mask = 0;
+
+        bool use_fragment_shading_rate_attachment = false;
+
+        bool operator==(const GraphicsPipelineVariant& other) const = default;
+    };
+
+    /**
+     * Every graphics pipeline variant that the game compiled, by pipeline name. We write this out at shutdown so that
+     * the next launch can compile the same variants on background threads before they're needed
+     */
+    struct PipelineManifestEntry {
+        eastl::string pipeline_name;
+
+        GraphicsPipelineVariant variant;
+
+        bool operator==(const PipelineManifestEntry& other) const = default;
+    };
+
+    constexpr uint32_t PIPELINE_MANIFEST_VERSION = 1;
+
+    /**
+     * Writes a manifest as text, one variant per line
+     */
+    eastl::string write_pipeline_manifest(eastl::span<const PipelineManifestEntry> entries);
+
+    /**
+     * Parses a manifest. Returns no entries if the manifest is from another version. Malformed lines are skipped
+     */
+    eastl::vector<PipelineManifestEntry> read_pipeline_manifest(eastl::string_view manifest);
+}
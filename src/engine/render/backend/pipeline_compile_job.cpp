@@ -0,0 +1,30 @@
+#include "pipeline_compile_job.hpp"
+
+namespace render {
+    PipelineCompileJob::PipelineCompileJob(std::function<void()>&& work_in) : work{std::move(work_in)} {}
+
+    void PipelineCompileJob::run() {
+        std::call_once(
+            once,
+            [&] {
+                try {
+                    work();
+                } catch(...) {
+                    exception = std::current_exception();
+                }
+
+                // Let go of anything the work captured
+                work = {};
+
+                done.store(true);
+            });
+
+        if(exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    bool PipelineCompileJob::is_done() const {
+        return done.load();
+    }
+}
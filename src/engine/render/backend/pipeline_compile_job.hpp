@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace render {
+    /**
+     * Some pipeline work that runs on the thread pool
+     *
+     * Whichever thread needs the result first runs the work itself if the pool hasn't started it yet, and waits for it
+     * if the pool has. Either way a thread never waits on a task that's stuck in the pool's queue, so waiting from
+     * inside a pool task can't deadlock
+     */
+    class PipelineCompileJob {
+    public:
+        explicit PipelineCompileJob(std::function<void()>&& work_in);
+
+        PipelineCompileJob(const PipelineCompileJob& other) = delete;
+        PipelineCompileJob& operator=(const PipelineCompileJob& other) = delete;
+
+        /**
+         * Runs the work if nothing has yet, otherwise waits for it to finish. Rethrows anything the work threw
+         */
+        void run();
+
+        bool is_done() const;
+
+    private:
+        std::function<void()> work;
+
+        std::once_flag once;
+
+        std::exception_ptr exception;
+
+        std::atomic<bool> done = false;
+    };
+}
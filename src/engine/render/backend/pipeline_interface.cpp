@@ -1,5 +1,6 @@
 #include "pipeline_interface.hpp"
 
+#include "render/backend/pipeline_compile_job.hpp"
 #include "render/backend/render_backend.hpp"
 
 namespace render {
@@ -21,7 +22,8 @@ namespace render {
         descriptor_sets{ std::move(old.descriptor_sets) },
         descriptor_set_layouts{
             std::move(old.descriptor_set_layouts)
-        } {
+        },
+        creation_job{ std::move(old.creation_job) } {
         old.pipeline = VK_NULL_HANDLE;
         old.layout = VK_NULL_HANDLE;
     }
@@ -36,6 +38,7 @@ namespace render {
         push_constant_stages = old.push_constant_stages;
         descriptor_sets = std::move(old.descriptor_sets);
         descriptor_set_layouts = std::move(old.descriptor_set_layouts);
+        creation_job = std::move(old.creation_job);
 
         old.pipeline = VK_NULL_HANDLE;
         old.layout = VK_NULL_HANDLE;
@@ -109,4 +112,14 @@ namespace render {
     DescriptorSetBuilder PipelineBase::begin_building_set(const uint32_t set_index) const {
         return RenderBackend::get().get_transient_descriptor_allocator().build_set(this,  set_index);
     }
+
+    void PipelineBase::wait_until_created() const {
+        if (creation_job != nullptr) {
+            creation_job->run();
+        }
+    }
+
+    bool PipelineBase::is_created() const {
+        return creation_job == nullptr || creation_job->is_done();
+    }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include <volk.h>
@@ -12,6 +13,7 @@ namespace render {
 
 namespace render {
     class RenderBackend;
+    class PipelineCompileJob;
 
     struct PipelineBase {
         std::string name;
@@ -28,6 +30,12 @@ namespace render {
 
         eastl::fixed_vector<VkDescriptorSetLayout, 8> descriptor_set_layouts;
 
+        /**
+         * Fills in the rest of this struct in the background, for pipelines that load and reflect their shaders off the
+         * calling thread. Null for pipelines that were created in full up front
+         */
+        std::shared_ptr<PipelineCompileJob> creation_job;
+
         PipelineBase() = default;
 
         ~PipelineBase();
@@ -46,5 +54,13 @@ namespace render {
         );
 
         DescriptorSetBuilder begin_building_set(uint32_t set_index) const;
+
+        /**
+         * Blocks until the creation job has filled in the layout, reflection data, and PSO. Runs the job on this thread
+         * if the thread pool hasn't gotten to it yet
+         */
+        void wait_until_created() const;
+
+        bool is_created() const;
     };
 }
@@ -20,24 +20,24 @@ namespace render {
         uint32_t index = 0;
 
         /**
-         * Anyhit shader to use when testing for occlusion. Empty for solid hitgroups
+         * Anyhit shader to use when testing for occlusion. Null for solid hitgroups
          */
-        eastl::vector<std::byte> occlusion_anyhit_shader;
+        ShaderHandle occlusion_anyhit_shader = nullptr;
 
         /**
          * Closesthit shader to use when testing occlusion
          */
-        eastl::vector<std::byte> occlusion_closesthit_shader;
+        ShaderHandle occlusion_closesthit_shader = nullptr;
 
         /**
-         * Anyhit shader to use when sampling GI. Empty for solid hitgroups
+         * Anyhit shader to use when sampling GI. Null for solid hitgroups
          */
-        eastl::vector<std::byte> gi_anyhit_shader;
+        ShaderHandle gi_anyhit_shader = nullptr;
 
         /**
          * Closesthit shader to use when sampling GI
          */
-        eastl::vector<std::byte> gi_closesthit_shader;
+        ShaderHandle gi_closesthit_shader = nullptr;
     };
 
     struct RayTracingPipeline : PipelineBase
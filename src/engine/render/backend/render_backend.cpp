@@ -49,7 +49,7 @@ namespace render {
         return lib_vulkan;
     }
 
-    RenderBackend::RenderBackend() : resource_access_synchronizer{*this} {
+    RenderBackend::RenderBackend() {
         ZoneScoped;
 
         logger = SystemInterface::get().get_logger("RenderBackend");
@@ -464,10 +464,6 @@ namespace render {
         global_descriptor_allocator = eastl::make_unique<DescriptorSetAllocator>(*this);
         global_descriptor_allocator->init(device.device);
 
-        frame_descriptor_allocators = {DescriptorSetAllocator{*this}, DescriptorSetAllocator{*this}};
-        for(auto& frame_allocator : frame_descriptor_allocators) {
-            frame_allocator.init(device.device);
-        }
         descriptor_layout_cache.init(device.device);
 
         allocator = eastl::make_unique<ResourceAllocator>(*this);
@@ -477,6 +473,8 @@ namespace render {
 
         blas_build_queue = eastl::make_unique<BlasBuildQueue>();
 
+        transient_resource_pool = eastl::make_unique<TransientResourcePool>(*this);
+
         pipeline_cache = eastl::make_unique<PipelineCache>(*this);
 
         texture_descriptor_pool = eastl::make_unique<TextureDescriptorPool>(*this);
@@ -596,6 +594,8 @@ namespace render {
             }
         }
 
+        upload_queue->begin_frame(cur_frame_idx);
+
         swapchain_semaphore = create_transient_semaphore("Acquire swapchain semaphore");
         {
             ZoneScopedN("Acquire swapchain image");
@@ -620,7 +620,11 @@ namespace render {
 
             allocator->free_resources_for_frame(cur_frame_idx);
 
-            frame_descriptor_allocators[cur_frame_idx].reset_pools();
+            auto lock = std::lock_guard{thread_contexts_mutex};
+            for(auto& [thread_id, context] : thread_contexts) {
+                context->secondary_command_allocators[cur_frame_idx].reset();
+                context->descriptor_allocators[cur_frame_idx].reset_pools();
+            }
         }
 
         vkResetFences(device, 1, &frame_fences[cur_frame_idx]);
@@ -845,6 +849,10 @@ namespace render {
         return cur_frame_idx;
     }
 
+    uint32_t RenderBackend::get_frame_count() const {
+        return total_num_frames;
+    }
+
     ResourceUploadQueue& RenderBackend::get_upload_queue() const {
         return *upload_queue;
     }
@@ -853,6 +861,10 @@ namespace render {
         return *blas_build_queue;
     }
 
+    TransientResourcePool& RenderBackend::get_transient_resource_pool() const {
+        return *transient_resource_pool;
+    }
+
     ResourceAccessTracker& RenderBackend::get_resource_access_tracker() {
         return resource_access_synchronizer;
     }
@@ -877,6 +889,41 @@ namespace render {
             fmt::format("{} for frame {}", name, cur_frame_idx));
     }
 
+    CommandBuffer RenderBackend::create_secondary_command_buffer(const std::string& name) {
+        auto& context = get_thread_context();
+        return CommandBuffer{
+            context.secondary_command_allocators[cur_frame_idx].allocate_command_buffer(
+                fmt::format("{} for frame {}", name, cur_frame_idx)),
+            *this
+        };
+    }
+
+    void RenderBackend::return_secondary_command_buffer(const CommandBuffer& commands) {
+        auto& context = get_thread_context();
+        context.secondary_command_allocators[cur_frame_idx].return_command_buffer(commands.get_vk_commands());
+    }
+
+    RenderBackend::ThreadContext& RenderBackend::get_thread_context() {
+        auto lock = std::lock_guard{thread_contexts_mutex};
+
+        auto& context = thread_contexts[std::this_thread::get_id()];
+        if(context == nullptr) {
+            context = eastl::make_unique<ThreadContext>();
+            for(auto& command_allocator : context->secondary_command_allocators) {
+                command_allocator = CommandAllocator{
+                    *this, graphics_queue_family_index, VK_COMMAND_BUFFER_LEVEL_SECONDARY
+                };
+            }
+
+            context->descriptor_allocators = {DescriptorSetAllocator{*this}, DescriptorSetAllocator{*this}};
+            for(auto& descriptor_allocator : context->descriptor_allocators) {
+                descriptor_allocator.init(device.device);
+            }
+        }
+
+        return *context;
+    }
+
     void RenderBackend::create_command_pools() {
         ZoneScoped;
 
@@ -925,7 +972,7 @@ namespace render {
     }
 
     DescriptorSetAllocator& RenderBackend::get_transient_descriptor_allocator() {
-        return frame_descriptor_allocators[cur_frame_idx];
+        return get_thread_context().descriptor_allocators[cur_frame_idx];
     }
 
     VkSemaphore RenderBackend::create_transient_semaphore(const std::string& name) {
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <mutex>
+#include <thread>
+
 #include <EASTL/array.h>
 #include <EASTL/unique_ptr.h>
+#include <EASTL/unordered_map.h>
 
 #include <volk.h>
 #include <VkBootstrap.h>
@@ -19,6 +23,7 @@
 #include "render/backend/pipeline_cache.hpp"
 #include "render/backend/command_buffer.hpp"
 #include "render/backend/resource_upload_queue.hpp"
+#include "render/backend/transient_resource_pool.hpp"
 #include "render/backend/constants.hpp"
 #include "shared/prelude.h"
 
@@ -118,6 +123,11 @@ namespace render {
 
         uint32_t get_current_gpu_frame() const;
 
+        /**
+         * Number of frames since startup. Unlike the GPU frame index, this never wraps
+         */
+        uint32_t get_frame_count() const;
+
         /**
          * Begins the frame
          *
@@ -140,6 +150,8 @@ namespace render {
 
         BlasBuildQueue& get_blas_build_queue() const;
 
+        TransientResourcePool& get_transient_resource_pool() const;
+
         ResourceAccessTracker& get_resource_access_tracker();
 
         PipelineCache& get_pipeline_cache() const;
@@ -156,7 +168,8 @@ namespace render {
         /**
          * Creates a descriptor builder for descriptors that can be blown away after this frame
          *
-         * Callers should make no effort to save these descriptors
+         * Callers should make no effort to save these descriptors. Each thread gets its own allocator, so this is safe
+         * to call from render graph passes that are recorded on worker threads
          */
         DescriptorSetAllocator& get_transient_descriptor_allocator();
 
@@ -174,6 +187,21 @@ namespace render {
          */
         VkCommandBuffer create_transfer_command_buffer(const std::string& name);
 
+        /**
+         * Creates a secondary graphics command buffer from the calling thread's command pool. Safe to call from any
+         * thread
+         *
+         * The caller must begin the command buffer with begin_secondary, and must hand it back with
+         * return_secondary_command_buffer from the same thread once it's recorded
+         */
+        CommandBuffer create_secondary_command_buffer(const std::string& name);
+
+        /**
+         * Gives a recorded secondary command buffer back to the calling thread's command pool. It's recycled when this
+         * frame index comes back around
+         */
+        void return_secondary_command_buffer(const CommandBuffer& commands);
+
         /**
          * Submits a command buffer to the backend
          *
@@ -256,6 +284,8 @@ namespace render {
 
         eastl::unique_ptr<BlasBuildQueue> blas_build_queue = {};
 
+        eastl::unique_ptr<TransientResourcePool> transient_resource_pool = {};
+
         ResourceAccessTracker resource_access_synchronizer;
 
         eastl::unique_ptr<PipelineCache> pipeline_cache = {};
@@ -268,11 +298,22 @@ namespace render {
 
         eastl::unique_ptr<DescriptorSetAllocator> global_descriptor_allocator;
 
-        eastl::vector<DescriptorSetAllocator> frame_descriptor_allocators;
+        /**
+         * Command and descriptor pools for one thread. Vulkan pools may only be used by one thread at a time, so each
+         * thread that records commands or allocates transient descriptors gets its own
+         */
+        struct ThreadContext {
+            eastl::array<CommandAllocator, num_in_flight_frames> secondary_command_allocators = {};
+
+            eastl::vector<DescriptorSetAllocator> descriptor_allocators;
+        };
 
-        vkutil::DescriptorLayoutCache descriptor_layout_cache;
+        std::mutex thread_contexts_mutex;
 
-        VkPipelineCache vk_pipeline_cache = VK_NULL_HANDLE;
+        eastl::unordered_map<std::thread::id, eastl::unique_ptr<ThreadContext>, std::hash<std::thread::id>>
+        thread_contexts;
+
+        vkutil::DescriptorLayoutCache descriptor_layout_cache;
 
         TextureHandle white_texture_handle = nullptr;
         TextureHandle default_normalmap_handle = nullptr;
@@ -344,6 +385,11 @@ namespace render {
 
         void create_command_pools();
 
+        /**
+         * Gets the calling thread's command and descriptor pools, creating them if needed
+         */
+        ThreadContext& get_thread_context();
+
         /**
          * Creates a semaphore that'll be destroyed at the start of next frame
          *
@@ -384,6 +430,9 @@ namespace render {
         else if constexpr (std::is_same_v<VulkanType, VkPipelineLayout>) {
             object_type = VK_OBJECT_TYPE_PIPELINE_LAYOUT;
         }
+        else if constexpr (std::is_same_v<VulkanType, VkPipelineCache>) {
+            object_type = VK_OBJECT_TYPE_PIPELINE_CACHE;
+        }
         else if constexpr (std::is_same_v<VulkanType, VkShaderModule>) {
             object_type = VK_OBJECT_TYPE_SHADER_MODULE;
         }
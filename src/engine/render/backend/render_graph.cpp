@@ -1,11 +1,14 @@
 #include "render_graph.hpp"
 
 #include <magic_enum.hpp>
+#include <EASTL/algorithm.h>
 #include <EASTL/span.h>
 #include <spdlog/logger.h>
 #include <spdlog/sinks/android_sink.h>
 
+#include "console/cvars.hpp"
 #include "core/system_interface.hpp"
+#include "core/thread_pool.hpp"
 #include "render/backend/pipeline_cache.hpp"
 #include "render/backend/render_backend.hpp"
 #include "render/backend/resource_access_synchronizer.hpp"
@@ -15,8 +18,67 @@
 namespace render {
     static std::shared_ptr<spdlog::logger> logger;
 
+    static auto cvar_cull_passes = AutoCVar_Int{
+        "r.RenderGraph.CullPasses", "Whether to remove render graph passes whose outputs are never used", 1
+    };
+
+    static auto cvar_reorder_passes = AutoCVar_Int{
+        "r.RenderGraph.ReorderPasses",
+        "Whether to group independent render graph passes together, so they share one batch of barriers",
+        1
+    };
+
+    static auto cvar_parallel_recording = AutoCVar_Int{
+        "r.RenderGraph.ParallelRecording",
+        "Whether to record render graph passes on worker threads, into secondary command buffers",
+        1
+    };
+
+    static auto cvar_min_passes_per_secondary = AutoCVar_Int{
+        "r.RenderGraph.MinPassesPerSecondary",
+        "Smallest run of passes worth recording into its own secondary command buffer. Shorter runs are recorded into "
+        "the primary command buffer",
+        4
+    };
+
+    /**
+     * Adds a usage to a list, combining it with any existing usage of the same texture
+     */
+    static void merge_usage(TextureUsageList& usages, const TextureUsageToken& usage) {
+        if (auto itr = std::ranges::find_if(
+            usages,
+            [&](const TextureUsageToken& token) {
+                return token.texture == usage.texture && token.has_same_subresources(usage);
+            }); itr != usages.end()) {
+            itr->stage |= usage.stage;
+            itr->access |= usage.access;
+            itr->layout = usage.layout;
+        }
+        else {
+            usages.emplace_back(usage);
+        }
+    }
+
+    /**
+     * Adds a usage to a list, combining it with any existing usage of the same buffer
+     */
+    static void merge_usage(BufferUsageList& usages, const BufferUsageToken& usage) {
+        if (auto itr = std::ranges::find_if(
+            usages,
+            [&](const BufferUsageToken& token) {
+                return token.buffer == usage.buffer;
+            }); itr != usages.end()) {
+            itr->stage |= usage.stage;
+            itr->access |= usage.access;
+        }
+        else {
+            usages.emplace_back(usage);
+        }
+    }
+
     RenderGraph::RenderGraph(RenderBackend& backend_in) : backend{ backend_in },
         access_tracker{ backend.get_resource_access_tracker() },
+        transient_pool{ backend.get_transient_resource_pool() },
         cmds{
             backend.create_graphics_command_buffer(
                 "Render graph command buffer"
@@ -28,13 +90,18 @@ namespace render {
         }
 
         cmds.begin();
+
+        passes.reserve(128);
     }
 
     void RenderGraph::add_transition_pass(const TransitionPass& pass) {
-        add_pass(
+        enqueue_pass(
             {
-                .name = "transition_pass", .textures = pass.textures, .buffers = pass.buffers,
-                .execute = [](CommandBuffer&) {}
+                .name = "transition_pass",
+                .textures = pass.textures,
+                .buffers = pass.buffers,
+                .is_fence = true,
+                .record = [](CommandBuffer&) {}
             }
         );
     }
@@ -51,6 +118,7 @@ namespace render {
                         pass.dst, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT
                     }
                 },
+                .has_side_effects = false,
                 .execute = [=](const CommandBuffer& commands) {
                     commands.copy_buffer_to_buffer(pass.dst, 0, pass.src, 0);
                 }
@@ -77,6 +145,7 @@ namespace render {
                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
                         }
                     },
+                    .has_side_effects = false,
                     .execute = [=](const CommandBuffer& commands) {
                         commands.copy_image_to_image(pass.src, pass.dst);
                     }
@@ -96,46 +165,53 @@ namespace render {
                     .access = VK_ACCESS_2_TRANSFER_WRITE_BIT
                 }
             },
-            .execute = [&](const CommandBuffer& commands) {
+            .has_side_effects = false,
+            .execute = [=](const CommandBuffer& commands) {
                 commands.fill_buffer(buffer, clear_value, offset, num_bytes);
             }});
     }
 
     void RenderGraph::add_pass(ComputePass pass) {
-        num_passes++;
         if (!pass.name.empty()) {
             logger->trace("Adding compute pass {}", pass.name);
-
-            cmds.begin_label(pass.name);
         }
 
         for (const auto& set : pass.descriptor_sets) {
             set.get_resource_usage_information(pass.textures, pass.buffers);
         }
+        save_transient_descriptor_sets(pass.descriptor_sets, pass.textures, pass.buffers);
 
-        update_accesses_and_issues_barriers(pass.textures, pass.buffers);
-
-        access_tracker.issue_barriers(cmds);
+        enqueue_pass(
+            {
+                .name = pass.name,
+                .textures = std::move(pass.textures),
+                .buffers = std::move(pass.buffers),
+                .has_side_effects = pass.has_side_effects,
+                .record = [name = pass.name, execute = std::move(pass.execute)](CommandBuffer& commands) {
+                    if (!name.empty()) {
+                        commands.begin_label(name);
+                    }
 
-        {
-            ZoneTransientN(zone, pass.name.c_str(), true);
+                    {
+                        ZoneTransientN(zone, name.c_str(), true);
 
-            pass.execute(cmds);
-        }
+                        execute(commands);
+                    }
 
-        if (!pass.name.empty()) {
-            cmds.end_label();
-        }
+                    if (!name.empty()) {
+                        commands.end_label();
+                    }
+                }
+            });
     }
 
     void RenderGraph::add_render_pass(DynamicRenderingPass pass) {
-        num_passes++;
-
         logger->trace("Adding dynamic render pass {}", pass.name);
 
         for (const auto& set : pass.descriptor_sets) {
             set.get_resource_usage_information(pass.textures, pass.buffers);
         }
+        save_transient_descriptor_sets(pass.descriptor_sets, pass.textures, pass.buffers);
 
         auto num_layers = 0u;
         for (const auto& attachment_token : pass.color_attachments) {
@@ -201,58 +277,78 @@ namespace render {
             );
         }
 
-        update_accesses_and_issues_barriers(pass.textures, pass.buffers);
+        auto render_area_size = glm::uvec2{};
+        if (pass.depth_attachment) {
+            render_area_size = {
+                pass.depth_attachment->image->create_info.extent.width,
+                pass.depth_attachment->image->create_info.extent.height
+            };
+        }
+        else if (!pass.color_attachments.empty()) {
+            render_area_size = {
+                pass.color_attachments[0].image->create_info.extent.width,
+                pass.color_attachments[0].image->create_info.extent.height
+            };
+        }
+
+        auto rendering_info = RenderingInfo{
+            .render_area_begin = {},
+            .render_area_size = render_area_size,
+            .layer_count = num_layers,
+            .view_mask = pass.view_mask.value_or(0),
+            .color_attachments = pass.color_attachments,
+            .depth_attachment = pass.depth_attachment,
+            .shading_rate_image = pass.shading_rate_image,
+        };
 
-        cmds.begin_label(pass.name);
-        {
-            access_tracker.issue_barriers(cmds);
+        auto record = [name = pass.name, rendering_info, execute = std::move(pass.execute)](CommandBuffer& commands) {
+            commands.begin_label(name);
 
-            auto render_area_size = glm::uvec2{};
-            if (pass.depth_attachment) {
-                render_area_size = {
-                    pass.depth_attachment->image->create_info.extent.width,
-                    pass.depth_attachment->image->create_info.extent.height
-                };
-            }
-            else if (!pass.color_attachments.empty()) {
-                render_area_size = {
-                    pass.color_attachments[0].image->create_info.extent.width,
-                    pass.color_attachments[0].image->create_info.extent.height
-                };
-            }
+            commands.begin_rendering(rendering_info);
 
-            auto rendering_info = RenderingInfo{
-                .render_area_begin = {},
-                .render_area_size = render_area_size,
-                .layer_count = num_layers,
-                .view_mask = pass.view_mask.value_or(0),
-                .color_attachments = pass.color_attachments,
-                .depth_attachment = pass.depth_attachment,
-                .shading_rate_image = pass.shading_rate_image,
-            };
+            execute(commands);
 
-            cmds.begin_rendering(rendering_info);
+            commands.end_rendering();
 
-            pass.execute(cmds);
+            commands.end_label();
+        };
 
-            cmds.end_rendering();
-        }
-        cmds.end_label();
+        enqueue_pass(
+            {
+                .name = pass.name,
+                .textures = std::move(pass.textures),
+                .buffers = std::move(pass.buffers),
+                .has_side_effects = pass.has_side_effects,
+                .record = std::move(record)
+            });
     }
 
-    void RenderGraph::update_accesses_and_issues_barriers(
-        const eastl::span<TextureUsageToken> textures,
-        const eastl::span<BufferUsageToken> buffers
-    ) const {
-        for (const auto& buffer_token : buffers) {
-            access_tracker.set_resource_usage(buffer_token);
-        }
+    void RenderGraph::enqueue_pass(RenderGraphPass&& pass) {
+        passes.emplace_back(std::move(pass));
+    }
 
-        for (const auto& texture_token : textures) {
-            access_tracker.set_resource_usage(texture_token);
+    void RenderGraph::save_transient_descriptor_sets(
+        const eastl::span<const DescriptorSet> descriptor_sets, const TextureUsageList& textures,
+        const BufferUsageList& buffers
+    ) {
+        const auto uses_transients = eastl::any_of(
+                textures.begin(),
+                textures.end(),
+                [&](const TextureUsageToken& token) {
+                    return transients.textures.count(token.texture) != 0;
+                }) ||
+            eastl::any_of(
+                buffers.begin(),
+                buffers.end(),
+                [&](const BufferUsageToken& token) {
+                    return transients.buffers.count(token.buffer) != 0;
+                });
+        if (uses_transients) {
+            transient_descriptor_sets.insert(
+                transient_descriptor_sets.end(),
+                descriptor_sets.begin(),
+                descriptor_sets.end());
         }
-
-        access_tracker.issue_barriers(cmds);
     }
 
     static ComputePipelineHandle image_copy_shader = nullptr;
@@ -308,9 +404,12 @@ namespace render {
     }
 
     void RenderGraph::begin_label(const std::string& label) {
-        add_pass(
+        enqueue_pass(
             {
-                .execute = [label = std::move(label)](CommandBuffer& commands) {
+                .name = label,
+                .is_fence = true,
+                .record_on_primary = true,
+                .record = [label](CommandBuffer& commands) {
                     commands.begin_label(label);
                 }
             }
@@ -318,17 +417,244 @@ namespace render {
     }
 
     void RenderGraph::end_label() {
-        add_pass(
+        enqueue_pass(
             {
-                .execute = [](CommandBuffer& commands) {
+                .name = "end_label",
+                .is_fence = true,
+                .record_on_primary = true,
+                .record = [](CommandBuffer& commands) {
                     commands.end_label();
                 }
             }
         );
     }
 
-    void RenderGraph::finish() const {
+    void RenderGraph::finish() {
+        ZoneScoped;
+
+        schedule = compile_render_graph(
+            passes,
+            transients,
+            {
+                .cull_passes = cvar_cull_passes.get() != 0,
+                .reorder_passes = cvar_reorder_passes.get() != 0
+            });
+
+        for (const auto pass_index : schedule.culled_passes) {
+            logger->trace("Culled pass {}", passes[pass_index].name);
+        }
+
+        const auto lifetimes = compute_transient_lifetimes(passes, schedule, transients);
+
+        // The transients were handed out before we knew when they'd be used. If two that share memory are alive at the
+        // same time, the pool moves one of them, and the descriptor sets that reference it must follow. Nothing has
+        // been recorded yet, so render targets and barriers pick up the new resources on their own
+        const auto moved_transients = transient_pool.resolve_aliasing_conflicts(lifetimes);
+        if (!moved_transients.textures.empty() || !moved_transients.buffers.empty()) {
+            for (const auto& set : transient_descriptor_sets) {
+                set.rewrite_bindings(
+                    backend,
+                    {moved_transients.textures.data(), moved_transients.textures.size()},
+                    {moved_transients.buffers.data(), moved_transients.buffers.size()});
+            }
+        }
+
+        // Every pass in a batch is independent of the others, so the batch's usages can be merged. That gives us at
+        // most one barrier per resource, all issued with a single vkCmdPipelineBarrier2. Each batch's barriers depend
+        // on every batch before it, so we work them all out here. That leaves recording, which only reads the passes,
+        // free to happen on any thread
+        auto batch_barriers = eastl::vector<ResourceBarriers>{};
+        batch_barriers.reserve(schedule.batches.size());
+        auto textures = TextureUsageList{};
+        auto buffers = BufferUsageList{};
+        for (auto batch_index = 0u; batch_index < schedule.batches.size(); batch_index++) {
+            const auto& batch = schedule.batches[batch_index];
+            textures.clear();
+            buffers.clear();
+
+            discard_transients(lifetimes, batch_index);
+
+            for (const auto pass_index : batch.passes) {
+                const auto& pass = passes[pass_index];
+                if (pass.skip_barriers) {
+                    for (const auto& texture_token : pass.textures) {
+                        access_tracker.set_resource_usage(texture_token, true);
+                    }
+                    continue;
+                }
+
+                for (const auto& buffer_token : pass.buffers) {
+                    merge_usage(buffers, buffer_token);
+                }
+                for (const auto& texture_token : pass.textures) {
+                    merge_usage(textures, texture_token);
+                }
+            }
+
+            for (const auto& buffer_token : buffers) {
+                access_tracker.set_resource_usage(buffer_token);
+            }
+
+            for (const auto& texture_token : textures) {
+                access_tracker.set_resource_usage(texture_token);
+            }
+
+            batch_barriers.emplace_back(access_tracker.take_barriers());
+        }
+
+        auto segments = plan_recording_segments();
+
+        auto parallel_segments = eastl::vector<RecordingSegment*>{};
+        for (auto& segment : segments) {
+            if (segment.is_parallel) {
+                parallel_segments.push_back(&segment);
+            }
+        }
+
+        ThreadPool::get().parallel_for(
+            parallel_segments.size(),
+            [&](const size_t i) {
+                ZoneScopedN("Record secondary command buffer");
+
+                auto& segment = *parallel_segments[i];
+                auto commands = backend.create_secondary_command_buffer("Render graph secondary command buffer");
+                commands.begin_secondary();
+                record_segment(commands, segment, batch_barriers);
+                commands.end();
+
+                segment.secondary_commands = commands.get_vk_commands();
+                backend.return_secondary_command_buffer(commands);
+            });
+
+        // Stitch everything together in submission order
+        for (const auto& segment : segments) {
+            if (segment.is_parallel) {
+                cmds.execute_secondary_command_buffers({&segment.secondary_commands, 1});
+            } else {
+                record_segment(cmds, segment, batch_barriers);
+            }
+        }
+
         cmds.end();
+
+        transient_pool.end_frame();
+    }
+
+    eastl::vector<RenderGraph::RecordingSegment> RenderGraph::plan_recording_segments() const {
+        auto& thread_pool = ThreadPool::get();
+        const auto is_parallel_enabled = cvar_parallel_recording.get() != 0 && thread_pool.get_num_threads() > 0;
+        const auto min_passes = static_cast<uint32_t>(eastl::max(cvar_min_passes_per_secondary.get(), 1));
+
+        // Aim for one segment per thread, including the thread that's calling finish(). Debug labels split the frame
+        // into more segments than that, which helps the thread pool balance the load
+        const auto num_passes = static_cast<uint32_t>(passes.size() - schedule.culled_passes.size());
+        const auto num_threads = thread_pool.get_num_threads() + 1;
+        const auto target_passes = eastl::max(min_passes, (num_passes + num_threads - 1) / num_threads);
+
+        auto segments = eastl::vector<RecordingSegment>{};
+        auto segment = RecordingSegment{};
+
+        const auto close_segment = [&] {
+            if (segment.num_batches > 0) {
+                segment.is_parallel = is_parallel_enabled && segment.num_passes >= min_passes;
+                segments.emplace_back(segment);
+            }
+            segment = RecordingSegment{};
+        };
+
+        for (auto batch_index = 0u; batch_index < schedule.batches.size(); batch_index++) {
+            const auto& batch = schedule.batches[batch_index];
+            const auto needs_primary = std::ranges::any_of(
+                batch.passes,
+                [&](const uint32_t pass_index) {
+                    return passes[pass_index].record_on_primary;
+                });
+
+            if (needs_primary) {
+                close_segment();
+                segments.emplace_back(
+                    RecordingSegment{
+                        .first_batch = batch_index,
+                        .num_batches = 1,
+                        .num_passes = static_cast<uint32_t>(batch.passes.size()),
+                    });
+                continue;
+            }
+
+            if (segment.num_batches == 0) {
+                segment.first_batch = batch_index;
+            }
+            segment.num_batches++;
+            segment.num_passes += static_cast<uint32_t>(batch.passes.size());
+
+            if (segment.num_passes >= target_passes) {
+                close_segment();
+            }
+        }
+
+        close_segment();
+
+        return segments;
+    }
+
+    void RenderGraph::record_segment(
+        CommandBuffer& commands, const RecordingSegment& segment,
+        const eastl::span<const ResourceBarriers> batch_barriers
+    ) const {
+        for (auto batch_index = segment.first_batch; batch_index < segment.first_batch + segment.num_batches;
+             batch_index++) {
+            batch_barriers[batch_index].record(commands);
+
+            for (const auto pass_index : schedule.batches[batch_index].passes) {
+                passes[pass_index].record(commands);
+            }
+        }
+    }
+
+    void RenderGraph::discard_transients(const RenderGraphLifetimes& lifetimes, const uint32_t batch_index) {
+        for (const auto& [texture, lifetime] : lifetimes.textures) {
+            if (lifetime.first_batch == batch_index) {
+                access_tracker.set_resource_usage(
+                    TextureUsageToken{
+                        .texture = texture,
+                        .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                        .access = VK_ACCESS_2_MEMORY_WRITE_BIT,
+                        .layout = VK_IMAGE_LAYOUT_UNDEFINED
+                    },
+                    true);
+            }
+        }
+
+        for (const auto& [buffer, lifetime] : lifetimes.buffers) {
+            if (lifetime.first_batch == batch_index) {
+                access_tracker.set_resource_usage(
+                    BufferUsageToken{
+                        .buffer = buffer,
+                        .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                        .access = VK_ACCESS_2_MEMORY_WRITE_BIT
+                    });
+            }
+        }
+    }
+
+    TextureHandle RenderGraph::create_transient_texture(
+        const eastl::string_view name, const TextureCreateInfo& create_info
+    ) {
+        const auto texture = transient_pool.get_texture(name, create_info);
+        transients.textures.insert(texture);
+        return texture;
+    }
+
+    BufferHandle RenderGraph::create_transient_buffer(
+        const eastl::string_view name, const size_t size, const BufferUsage usage
+    ) {
+        const auto buffer = transient_pool.get_buffer(name, size, usage);
+        transients.buffers.insert(buffer);
+        return buffer;
+    }
+
+    const RenderGraphSchedule& RenderGraph::get_schedule() const {
+        return schedule;
     }
 
     CommandBuffer&& RenderGraph::extract_command_buffer() {
@@ -342,16 +668,36 @@ namespace render {
 
         post_submit_lambdas.clear();
 
-        logger->debug("Executed {} passes", num_passes);
+        logger->debug(
+            "Executed {} passes in {} batches, culled {} passes",
+            passes.size() - schedule.culled_passes.size(),
+            schedule.batches.size(),
+            schedule.culled_passes.size());
 
-        num_passes = 0;
+        passes.clear();
     }
 
-    void RenderGraph::set_resource_usage(const TextureUsageToken& texture_usage_token, const bool skip_barrier) const {
-        access_tracker.set_resource_usage(texture_usage_token, skip_barrier);
+    void RenderGraph::set_resource_usage(const TextureUsageToken& texture_usage_token, const bool skip_barrier) {
+        enqueue_pass(
+            {
+                .name = "set_resource_usage",
+                .textures = {texture_usage_token},
+                .is_fence = true,
+                .skip_barriers = skip_barrier,
+                .record = [](CommandBuffer&) {}
+            }
+        );
     }
 
     TextureUsageToken RenderGraph::get_last_usage_token(const TextureHandle texture_handle) const {
+        for (auto itr = passes.rbegin(); itr != passes.rend(); ++itr) {
+            for (const auto& token : itr->textures) {
+                if (token.texture == texture_handle) {
+                    return token;
+                }
+            }
+        }
+
         return access_tracker.get_last_usage_token(texture_handle);
     }
 }
@@ -5,6 +5,7 @@
 #include "render/backend/render_backend.hpp"
 #include "render/backend/command_buffer.hpp"
 #include "render/backend/render_pass.hpp"
+#include "render/backend/render_graph_compiler.hpp"
 
 namespace render {
     class ResourceAccessTracker;
@@ -15,17 +16,47 @@ namespace render {
      *
      * Can automatically handle resource transitions
      *
-     * Render passes are always executed in the order they're received. Intended usage is for you to make a new render
-     * graph each frame, add passes to it, then submit it to the backend for execution. Passes may not run until the end of
-     * the frame, but they'll always run the same frame your submit the graph
+     * Intended usage is for you to make a new render graph each frame, add passes to it, then submit it to the backend
+     * for execution. Passes may not run until the end of the frame, but they'll always run the same frame your submit
+     * the graph
      *
-     * This render graph does not allocate resources. Resource allocation should be handled with the ResourceAllocator
-     * class
+     * Adding a pass doesn't record anything. finish() compiles the graph - it culls passes whose outputs nobody uses,
+     * groups independent passes into batches that share one set of barriers, and only then records every pass. This
+     * means a pass's execute function runs after the add_* call returns, so it must not capture locals by reference.
+     * Only passes without side effects are culled or reordered, see ComputePass::has_side_effects
+     *
+     * finish() records runs of passes into secondary command buffers on the thread pool, then executes them from the
+     * graph's command buffer in order. A pass's execute function may therefore run on any thread, at the same time as
+     * other passes' execute functions. It may read the scene and build transient descriptor sets, but must not touch
+     * anything else that's shared without locking it. Each run of passes starts with fresh command buffer state
+     *
+     * Most resources should be allocated with the ResourceAllocator class. Resources that only live for one frame can
+     * be created with create_transient_texture and create_transient_buffer instead. The graph works out when each
+     * transient is used, and transients that are never used at the same time share memory
      */
     class RenderGraph {
     public:
         explicit RenderGraph(RenderBackend& backend_in);
 
+        /**
+         * Creates a texture that only lives for this frame
+         *
+         * The texture's memory may be shared with other transients that aren't used at the same time, so its contents
+         * are undefined before the first pass that uses it. Every pass that touches the texture must list it in its
+         * usages, or sit between passes that do. Transients are identified by name, so use the same name every frame
+         * to get the same memory layout
+         *
+         * The handle stays the same all frame, but the image behind it may be replaced when the graph is finished. Bind
+         * the texture through the pass's descriptor sets, or look up its views in the pass's execute function
+         */
+        TextureHandle create_transient_texture(eastl::string_view name, const TextureCreateInfo& create_info);
+
+        /**
+         * Creates a buffer that only lives for this frame. See create_transient_texture. Read the buffer's device
+         * address in the pass's execute function, since the buffer may be replaced when the graph is finished
+         */
+        BufferHandle create_transient_buffer(eastl::string_view name, size_t size, BufferUsage usage);
+
         /**
          * Adds a pass that inserts a barrier for access to some resources
          *
@@ -68,7 +99,15 @@ namespace render {
 
         void end_label();
 
-        void finish() const;
+        /**
+         * Compiles the graph and records every pass into the command buffer
+         */
+        void finish();
+
+        /**
+         * Retrieves the schedule that finish() recorded the passes with. Useful for debugging the graph
+         */
+        const RenderGraphSchedule& get_schedule() const;
 
         // Kinda-internal API, useful only to Backend
 
@@ -82,10 +121,18 @@ namespace render {
          */
         void execute_post_submit_tasks();
 
-        void set_resource_usage(const TextureUsageToken& texture_usage_token, bool skip_barrier = true) const;
+        /**
+         * Tells the graph about a texture's usage, at this point in the graph. Useful after a pass that issues its own
+         * barriers for a texture
+         *
+         * @param texture_usage_token The texture's new usage
+         * @param skip_barrier If true, we assume the texture is already in this state. If false, we transition it
+         */
+        void set_resource_usage(const TextureUsageToken& texture_usage_token, bool skip_barrier = true);
 
         /**
-         * \brief Retrieves the most recent usage token for the given texture
+         * \brief Retrieves the most recent usage token for the given texture, including passes that haven't been
+         * recorded yet
          */
         TextureUsageToken get_last_usage_token(TextureHandle texture_handle) const;
 
@@ -94,99 +141,137 @@ namespace render {
 
         ResourceAccessTracker& access_tracker;
 
+        TransientResourcePool& transient_pool;
+
+        RenderGraphTransients transients;
+
         CommandBuffer cmds;
 
         eastl::vector<std::function<void()>> post_submit_lambdas;
 
-        uint32_t num_passes = 0;
+        eastl::vector<RenderGraphPass> passes;
 
-        void update_accesses_and_issues_barriers(
-            eastl::span<TextureUsageToken> textures,
-            eastl::span<BufferUsageToken> buffers
-        ) const;
+        /**
+         * Descriptor sets of the passes that use transients. finish() rewrites them if a transient moves
+         */
+        eastl::vector<DescriptorSet> transient_descriptor_sets;
 
-        void do_compute_shader_copy(const ImageCopyPass& pass);
-    };
+        RenderGraphSchedule schedule;
 
-    template <typename PushConstantsType>
-    void RenderGraph::add_compute_dispatch(const ComputeDispatch<PushConstantsType>& dispatch_info) {
-        ZoneScoped;
+        /**
+         * A run of consecutive batches that's recorded together, either into the graph's command buffer or into one
+         * secondary command buffer on a worker thread
+         */
+        struct RecordingSegment {
+            uint32_t first_batch = 0;
 
-        if (!dispatch_info.name.empty()) {
-            cmds.begin_label(dispatch_info.name);
-        }
+            uint32_t num_batches = 0;
 
-        {
-            TextureUsageList textures;
-            BufferUsageList buffers;
+            uint32_t num_passes = 0;
 
-            for (const auto& descriptor_set : dispatch_info.descriptor_sets) {
-                descriptor_set.get_resource_usage_information(textures, buffers);
-            }
+            bool is_parallel = false;
 
-            update_accesses_and_issues_barriers(textures, buffers);
+            VkCommandBuffer secondary_commands = VK_NULL_HANDLE;
+        };
 
-            cmds.bind_pipeline(dispatch_info.compute_shader);
+        void enqueue_pass(RenderGraphPass&& pass);
 
-            for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
-                const auto& set = dispatch_info.descriptor_sets.at(i);
-                cmds.bind_descriptor_set(i, set);
-            }
+        /**
+         * Remembers the pass's descriptor sets if the pass uses any transients
+         */
+        void save_transient_descriptor_sets(
+            eastl::span<const DescriptorSet> descriptor_sets, const TextureUsageList& textures,
+            const BufferUsageList& buffers
+        );
 
-            auto* push_constants_src = reinterpret_cast<const uint32_t*>(&dispatch_info.push_constants);
-            for (auto i = 0u; i < sizeof(PushConstantsType) / sizeof(uint32_t); i++) {
-                cmds.set_push_constant(i, push_constants_src[i]);
-            }
+        /**
+         * Splits the schedule into segments of roughly equal numbers of passes. Batches with passes that must be
+         * recorded on the primary command buffer get a segment to themselves
+         */
+        eastl::vector<RecordingSegment> plan_recording_segments() const;
 
-            cmds.dispatch(dispatch_info.num_workgroups.x, dispatch_info.num_workgroups.y, dispatch_info.num_workgroups.z);
+        /**
+         * Records the barriers and passes for every batch in the segment
+         */
+        void record_segment(
+            CommandBuffer& commands, const RecordingSegment& segment, eastl::span<const ResourceBarriers> batch_barriers
+        ) const;
 
-            for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
-                cmds.clear_descriptor_set(i);
-            }
-        }
+        /**
+         * Tells the access tracker that the transients that start their lifetime in this batch have lost their
+         * contents, so the next barrier discards them and waits for whatever used their memory before
+         */
+        void discard_transients(const RenderGraphLifetimes& lifetimes, uint32_t batch_index);
 
-        if (!dispatch_info.name.empty()) {
-            cmds.end_label();
-        }
-    }
+        void do_compute_shader_copy(const ImageCopyPass& pass);
+    };
 
     template <typename PushConstantsType>
-    void RenderGraph::add_compute_dispatch(const IndirectComputeDispatch<PushConstantsType>& dispatch_info) {
-        if (!dispatch_info.name.empty()) {
-            cmds.begin_label(dispatch_info.name);
-        }
-
-        {
-            TextureUsageList textures;
-            BufferUsageList buffers;
-
-            for (const auto& descriptor_set : dispatch_info.descriptor_sets) {
-                descriptor_set.get_resource_usage_information(textures, buffers);
-            }
-
-            update_accesses_and_issues_barriers(textures, buffers);
-
-            cmds.bind_pipeline(dispatch_info.compute_shader);
-
-            for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
-                const auto& set = dispatch_info.descriptor_sets.at(i);
-                cmds.bind_descriptor_set(i, set);
-            }
-
-            auto* push_constants_src = reinterpret_cast<const uint32_t*>(&dispatch_info.push_constants);
-            for (auto i = 0u; i < sizeof(PushConstantsType) / sizeof(uint32_t); i++) {
-                cmds.set_push_constant(i, push_constants_src[i]);
+    void RenderGraph::add_compute_dispatch(const ComputeDispatch<PushConstantsType>& dispatch_info) {
+        auto pass = ComputePass{
+            .name = dispatch_info.name,
+            .buffers = dispatch_info.buffers,
+            .execute = [=](CommandBuffer& commands) {
+                commands.bind_pipeline(dispatch_info.compute_shader);
+
+                for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
+                    const auto& set = dispatch_info.descriptor_sets.at(i);
+                    commands.bind_descriptor_set(i, set);
+                }
+
+                auto* push_constants_src = reinterpret_cast<const uint32_t*>(&dispatch_info.push_constants);
+                for (auto i = 0u; i < sizeof(PushConstantsType) / sizeof(uint32_t); i++) {
+                    commands.set_push_constant(i, push_constants_src[i]);
+                }
+
+                commands.dispatch(
+                    dispatch_info.num_workgroups.x,
+                    dispatch_info.num_workgroups.y,
+                    dispatch_info.num_workgroups.z);
+
+                for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
+                    commands.clear_descriptor_set(i);
+                }
             }
+        };
+        pass.descriptor_sets.assign(dispatch_info.descriptor_sets.begin(), dispatch_info.descriptor_sets.end());
 
-            cmds.dispatch_indirect(dispatch_info.dispatch);
+        add_pass(std::move(pass));
+    }
 
-            for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
-                cmds.clear_descriptor_set(i);
+    template <typename PushConstantsType>
+    void RenderGraph::add_compute_dispatch(const IndirectComputeDispatch<PushConstantsType>& dispatch_info) {
+        auto pass = ComputePass{
+            .name = dispatch_info.name,
+            .buffers = dispatch_info.buffers,
+            .execute = [=](CommandBuffer& commands) {
+                commands.bind_pipeline(dispatch_info.compute_shader);
+
+                for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
+                    const auto& set = dispatch_info.descriptor_sets.at(i);
+                    commands.bind_descriptor_set(i, set);
+                }
+
+                auto* push_constants_src = reinterpret_cast<const uint32_t*>(&dispatch_info.push_constants);
+                for (auto i = 0u; i < sizeof(PushConstantsType) / sizeof(uint32_t); i++) {
+                    commands.set_push_constant(i, push_constants_src[i]);
+                }
+
+                commands.dispatch_indirect(dispatch_info.dispatch);
+
+                for (auto i = 0u; i < dispatch_info.descriptor_sets.size(); i++) {
+                    commands.clear_descriptor_set(i);
+                }
             }
-        }
-
-        if (!dispatch_info.name.empty()) {
-            cmds.end_label();
-        }
+        };
+        pass.descriptor_sets.assign(dispatch_info.descriptor_sets.begin(), dispatch_info.descriptor_sets.end());
+        pass.buffers.emplace_back(
+            BufferUsageToken{
+                .buffer = dispatch_info.dispatch,
+                .stage = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                .access = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
+            });
+
+        add_pass(std::move(pass));
     }
 }
@@ -0,0 +1,268 @@
+#include "render_graph_compiler.hpp"
+
+#include <EASTL/algorithm.h>
+#include <tracy/Tracy.hpp>
+
+#include "render/backend/utils.hpp"
+
+namespace render {
+    constexpr auto NO_PASS = std::numeric_limits<uint32_t>::max();
+
+    using PassList = eastl::fixed_vector<uint32_t, 8>;
+
+    /**
+     * Which passes last touched a resource
+     */
+    struct ResourceAccessHistory {
+        /**
+         * Last pass that wrote to the resource or changed its layout
+         */
+        uint32_t last_exclusive_pass = NO_PASS;
+
+        /**
+         * Passes that read the resource since the last exclusive access
+         */
+        PassList readers;
+
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        bool has_layout = false;
+    };
+
+    /**
+     * Walks the passes in the order they were added, finding what each pass depends on
+     */
+    class PassDependencyTracker {
+    public:
+        /**
+         * Adds a pass's resource accesses
+         *
+         * @param pass The pass to add
+         * @param pass_index Index of the pass in the graph
+         * @param producers Receives the passes that wrote data this pass uses
+         * @param dependencies Receives every pass that must execute before this pass
+         */
+        void add_pass(const RenderGraphPass& pass, uint32_t pass_index, PassList& producers, PassList& dependencies);
+
+    private:
+        eastl::unordered_map<TextureHandle, ResourceAccessHistory> textures;
+
+        eastl::unordered_map<BufferHandle, ResourceAccessHistory> buffers;
+
+        static void add_access(
+            ResourceAccessHistory& history, uint32_t pass_index, bool is_exclusive, PassList& producers,
+            PassList& dependencies
+        );
+    };
+
+    void PassDependencyTracker::add_pass(
+        const RenderGraphPass& pass, const uint32_t pass_index, PassList& producers, PassList& dependencies
+    ) {
+        for (const auto& token : pass.buffers) {
+            add_access(buffers[token.buffer], pass_index, is_write_access(token.access), producers, dependencies);
+        }
+
+        for (const auto& token : pass.textures) {
+            auto& history = textures[token.texture];
+            // Layout transitions write to the image, so they need the same ordering as writes
+            const auto changes_layout = history.has_layout && history.layout != token.layout;
+            add_access(history, pass_index, is_write_access(token.access) || changes_layout, producers, dependencies);
+
+            history.layout = token.layout;
+            history.has_layout = true;
+        }
+    }
+
+    void PassDependencyTracker::add_access(
+        ResourceAccessHistory& history, const uint32_t pass_index, const bool is_exclusive, PassList& producers,
+        PassList& dependencies
+    ) {
+        if (history.last_exclusive_pass != NO_PASS && history.last_exclusive_pass != pass_index) {
+            producers.push_back(history.last_exclusive_pass);
+            dependencies.push_back(history.last_exclusive_pass);
+        }
+
+        if (is_exclusive) {
+            for (const auto reader : history.readers) {
+                if (reader != pass_index) {
+                    dependencies.push_back(reader);
+                }
+            }
+            history.readers.clear();
+            history.last_exclusive_pass = pass_index;
+
+        } else if (history.readers.empty() || history.readers.back() != pass_index) {
+            history.readers.push_back(pass_index);
+        }
+    }
+
+    static bool is_fence(const RenderGraphPass& pass) {
+        return pass.is_fence || (pass.textures.empty() && pass.buffers.empty());
+    }
+
+    /**
+     * Checks if the pass's usages describe everything it touches, so it's safe to move it to an earlier batch
+     */
+    static bool can_reorder(const RenderGraphPass& pass) {
+        return !is_fence(pass) && !pass.has_side_effects;
+    }
+
+    bool ResourceLifetime::is_empty() const {
+        return first_batch > last_batch;
+    }
+
+    bool ResourceLifetime::overlaps(const ResourceLifetime& other) const {
+        if (is_empty() || other.is_empty()) {
+            return false;
+        }
+
+        return first_batch <= other.last_batch && other.first_batch <= last_batch;
+    }
+
+    void ResourceLifetime::add_batch(const uint32_t batch) {
+        first_batch = eastl::min(first_batch, batch);
+        last_batch = eastl::max(last_batch, batch);
+    }
+
+    void ResourceLifetime::merge(const ResourceLifetime& other) {
+        if (other.is_empty()) {
+            return;
+        }
+
+        add_batch(other.first_batch);
+        add_batch(other.last_batch);
+    }
+
+    /**
+     * Checks if the pass writes to a resource that someone outside the graph might read
+     */
+    static bool writes_to_persistent_resource(const RenderGraphPass& pass, const RenderGraphTransients& transients) {
+        return eastl::any_of(
+                pass.textures.begin(),
+                pass.textures.end(),
+                [&](const TextureUsageToken& token) {
+                    return is_write_access(token.access) && transients.textures.count(token.texture) == 0;
+                }) ||
+            eastl::any_of(
+                pass.buffers.begin(),
+                pass.buffers.end(),
+                [&](const BufferUsageToken& token) {
+                    return is_write_access(token.access) && transients.buffers.count(token.buffer) == 0;
+                });
+    }
+
+    RenderGraphSchedule compile_render_graph(
+        const eastl::span<const RenderGraphPass> passes, const RenderGraphTransients& transients,
+        const RenderGraphCompileOptions& options
+    ) {
+        ZoneScoped;
+
+        const auto num_passes = static_cast<uint32_t>(passes.size());
+
+        auto schedule = RenderGraphSchedule{};
+
+        auto producers = PassList{};
+        auto dependencies = PassList{};
+
+        // Walk backwards from the passes that are always kept, keeping every pass that produces data for a kept pass
+        auto is_live = eastl::vector<bool>(num_passes, true);
+        if (options.cull_passes) {
+            auto pass_producers = eastl::vector<PassList>(num_passes);
+            auto tracker = PassDependencyTracker{};
+            for (auto pass_index = 0u; pass_index < num_passes; pass_index++) {
+                dependencies.clear();
+                tracker.add_pass(passes[pass_index], pass_index, pass_producers[pass_index], dependencies);
+            }
+
+            eastl::fill(is_live.begin(), is_live.end(), false);
+            for (auto i = num_passes; i > 0; i--) {
+                const auto pass_index = i - 1;
+                const auto& pass = passes[pass_index];
+                if (is_fence(pass) || pass.has_side_effects || writes_to_persistent_resource(pass, transients)) {
+                    is_live[pass_index] = true;
+                }
+
+                if (is_live[pass_index]) {
+                    for (const auto producer : pass_producers[pass_index]) {
+                        is_live[producer] = true;
+                    }
+                } else {
+                    schedule.culled_passes.push_back(pass_index);
+                }
+            }
+
+            eastl::reverse(schedule.culled_passes.begin(), schedule.culled_passes.end());
+        }
+
+        // Put each pass in the batch after the last batch it depends on. Culled passes are ignored entirely, so they
+        // don't hold back the passes after them. Passes with side effects may touch memory that no usage declares, so
+        // they're placed like fences
+        auto pass_batches = eastl::vector<uint32_t>(num_passes, 0);
+        auto tracker = PassDependencyTracker{};
+        auto first_unfenced_batch = 0u;
+        auto num_batches = 0u;
+        for (auto pass_index = 0u; pass_index < num_passes; pass_index++) {
+            if (!is_live[pass_index]) {
+                continue;
+            }
+
+            const auto& pass = passes[pass_index];
+
+            producers.clear();
+            dependencies.clear();
+            tracker.add_pass(pass, pass_index, producers, dependencies);
+
+            auto batch = first_unfenced_batch;
+            if (!options.reorder_passes || !can_reorder(pass)) {
+                batch = eastl::max(batch, num_batches);
+            } else {
+                for (const auto dependency : dependencies) {
+                    batch = eastl::max(batch, pass_batches[dependency] + 1);
+                }
+            }
+
+            pass_batches[pass_index] = batch;
+            num_batches = eastl::max(num_batches, batch + 1);
+
+            if (!can_reorder(pass)) {
+                first_unfenced_batch = batch + 1;
+            }
+        }
+
+        schedule.batches.resize(num_batches);
+        for (auto pass_index = 0u; pass_index < num_passes; pass_index++) {
+            if (is_live[pass_index]) {
+                schedule.batches[pass_batches[pass_index]].passes.push_back(pass_index);
+            }
+        }
+
+        return schedule;
+    }
+
+    RenderGraphLifetimes compute_transient_lifetimes(
+        const eastl::span<const RenderGraphPass> passes, const RenderGraphSchedule& schedule,
+        const RenderGraphTransients& transients
+    ) {
+        ZoneScoped;
+
+        auto lifetimes = RenderGraphLifetimes{};
+
+        for (auto batch_index = 0u; batch_index < schedule.batches.size(); batch_index++) {
+            for (const auto pass_index : schedule.batches[batch_index].passes) {
+                const auto& pass = passes[pass_index];
+                for (const auto& token : pass.textures) {
+                    if (transients.textures.count(token.texture) != 0) {
+                        lifetimes.textures[token.texture].add_batch(batch_index);
+                    }
+                }
+                for (const auto& token : pass.buffers) {
+                    if (transients.buffers.count(token.buffer) != 0) {
+                        lifetimes.buffers[token.buffer].add_batch(batch_index);
+                    }
+                }
+            }
+        }
+
+        return lifetimes;
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <string>
+
+#include <EASTL/fixed_vector.h>
+#include <EASTL/span.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <EASTL/vector_set.h>
+
+#include "render/backend/buffer_usage_token.hpp"
+#include "render/backend/texture_usage_token.hpp"
+
+namespace render {
+    class CommandBuffer;
+
+    /**
+     * A pass that's been added to a render graph, but not yet recorded
+     */
+    struct RenderGraphPass {
+        std::string name;
+
+        TextureUsageList textures;
+
+        BufferUsageList buffers;
+
+        /**
+         * Fences are never culled, and no pass is reordered across a fence
+         *
+         * Passes that don't declare any resources are always fences, since we can't tell what they touch. Transition
+         * passes are fences because later passes may rely on their barriers without declaring the resource themselves
+         */
+        bool is_fence = false;
+
+        /**
+         * Write this pass's texture usages into the access tracker without issuing barriers. See
+         * RenderGraph::set_resource_usage
+         */
+        bool skip_barriers = false;
+
+        /**
+         * Record this pass straight into the graph's primary command buffer, never into a secondary command buffer on a
+         * worker thread. Debug labels need this, since a label that a secondary command buffer begins must also end in
+         * that command buffer
+         */
+        bool record_on_primary = false;
+
+        /**
+         * Whether the pass may have effects that its usages don't describe, such as reads and writes through a buffer
+         * device address. We can't tell what those effects are, so passes with side effects are never culled, and are
+         * placed like fences: nothing moves across them. Passes must opt in to culling and reordering by setting this
+         * to false
+         */
+        bool has_side_effects = true;
+
+        /**
+         * Records the pass's commands. Called when the graph is finished, not when the pass is added
+         */
+        std::function<void(CommandBuffer&)> record;
+    };
+
+    /**
+     * A set of passes that don't depend on each other. They execute together after a single batch of barriers
+     */
+    struct RenderGraphBatch {
+        /**
+         * Indices of the passes in this batch, in the order they were added to the graph
+         */
+        eastl::fixed_vector<uint32_t, 8> passes;
+    };
+
+    struct RenderGraphSchedule {
+        eastl::vector<RenderGraphBatch> batches;
+
+        /**
+         * Indices of passes that were culled because nothing uses their outputs
+         */
+        eastl::vector<uint32_t> culled_passes;
+    };
+
+    /**
+     * Resources that only live for the duration of the graph. Nothing outside the graph reads them, so writing to one
+     * doesn't keep a pass alive
+     */
+    struct RenderGraphTransients {
+        eastl::vector_set<TextureHandle> textures;
+
+        eastl::vector_set<BufferHandle> buffers;
+    };
+
+    /**
+     * The batches that use a resource, from first_batch to last_batch inclusive
+     */
+    struct ResourceLifetime {
+        uint32_t first_batch = std::numeric_limits<uint32_t>::max();
+
+        uint32_t last_batch = 0;
+
+        /**
+         * True if no batch uses the resource
+         */
+        bool is_empty() const;
+
+        /**
+         * Checks if two resources are alive in the same batch. Empty lifetimes never overlap anything
+         */
+        bool overlaps(const ResourceLifetime& other) const;
+
+        /**
+         * Extends this lifetime to include the given batch
+         */
+        void add_batch(uint32_t batch);
+
+        /**
+         * Extends this lifetime to cover the other lifetime
+         */
+        void merge(const ResourceLifetime& other);
+
+        bool operator==(const ResourceLifetime& other) const = default;
+    };
+
+    struct RenderGraphLifetimes {
+        eastl::unordered_map<TextureHandle, ResourceLifetime> textures;
+
+        eastl::unordered_map<BufferHandle, ResourceLifetime> buffers;
+    };
+
+    struct RenderGraphCompileOptions {
+        /**
+         * Whether to remove passes whose outputs are never consumed
+         */
+        bool cull_passes = true;
+
+        /**
+         * Whether to move passes into earlier batches when their dependencies allow it. When false, every pass gets its
+         * own batch, in the order the passes were added
+         */
+        bool reorder_passes = true;
+    };
+
+    /**
+     * Builds a dependency graph from the passes' resource usages, culls passes that don't contribute to the frame, and
+     * groups the rest into batches of independent passes
+     *
+     * A pass is kept if it's a fence, if it has side effects, if it writes to a resource that outlives the graph, or if
+     * a kept pass reads what it wrote. We assume someone outside the graph reads every write to a non-transient resource
+     *
+     * Each pass without side effects is placed in the earliest batch after all the passes it depends on. A pass depends
+     * on the last pass that wrote to or changed the layout of a resource it uses. Passes that write to or change the
+     * layout of a resource also depend on every pass that read it since then. Fences and passes with side effects get a
+     * batch of their own, after every earlier pass
+     *
+     * This does not touch the GPU, so it can run against passes with fake resource handles
+     */
+    RenderGraphSchedule compile_render_graph(
+        eastl::span<const RenderGraphPass> passes, const RenderGraphTransients& transients,
+        const RenderGraphCompileOptions& options
+    );
+
+    /**
+     * Finds the batches that use each transient resource. Transient resources that no scheduled pass uses aren't
+     * included
+     */
+    RenderGraphLifetimes compute_transient_lifetimes(
+        eastl::span<const RenderGraphPass> passes, const RenderGraphSchedule& schedule,
+        const RenderGraphTransients& transients
+    );
+}
@@ -34,6 +34,13 @@ namespace render {
 
         eastl::fixed_vector<DescriptorSet, 8> descriptor_sets;
 
+        /**
+         * Whether the pass may do anything its usages don't describe, such as writing through a buffer device address.
+         * Set this to false to let the render graph cull the pass when nothing uses its outputs, and move it to an
+         * earlier batch when its dependencies allow it
+         */
+        bool has_side_effects = true;
+
         /**
          * Executes this render pass
          *
@@ -203,6 +210,11 @@ namespace render {
 
         eastl::optional<uint32_t> view_mask;
 
+        /**
+         * See ComputePass::has_side_effects
+         */
+        bool has_side_effects = true;
+
         std::function<void(CommandBuffer&)> execute;
     };
 
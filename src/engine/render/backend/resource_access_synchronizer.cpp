@@ -13,48 +13,71 @@
 namespace render {
     static std::shared_ptr<spdlog::logger> logger;
 
-    static bool is_write_access(const VkAccessFlagBits2 access) {
-        constexpr auto write_mask =
-            VK_ACCESS_2_SHADER_WRITE_BIT |
-            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
-            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
-            VK_ACCESS_2_TRANSFER_WRITE_BIT |
-            VK_ACCESS_2_HOST_WRITE_BIT |
-            VK_ACCESS_2_MEMORY_WRITE_BIT |
-            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
-            VK_ACCESS_2_VIDEO_DECODE_WRITE_BIT_KHR |
-            VK_ACCESS_2_VIDEO_ENCODE_WRITE_BIT_KHR |
-            VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT |
-            VK_ACCESS_2_COMMAND_PREPROCESS_WRITE_BIT_NV |
-            VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
-            VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_NV |
-            VK_ACCESS_2_MICROMAP_WRITE_BIT_EXT |
-            VK_ACCESS_2_OPTICAL_FLOW_WRITE_BIT_NV;
-        return (access & write_mask) != 0;
-    }
-
-    ResourceAccessTracker::ResourceAccessTracker(RenderBackend& backend_in) : backend{ backend_in } {
+    ResourceAccessTracker::ResourceAccessTracker() {
         if (logger == nullptr) {
             logger = SystemInterface::get().get_logger("ResourceAccessTracker");
             logger->set_level(spdlog::level::debug);
         }
     }
 
+    static constexpr auto untracked_slot = UINT32_MAX;
+
+    /**
+     * Gets a slot for a resource's state, reusing a released slot if there is one
+     */
+    template <typename StateType>
+    static uint32_t allocate_slot(eastl::vector<StateType>& states, eastl::vector<uint32_t>& free_slots) {
+        if (!free_slots.empty()) {
+            const auto slot = free_slots.back();
+            free_slots.pop_back();
+            return slot;
+        }
+
+        states.emplace_back();
+        return static_cast<uint32_t>(states.size() - 1);
+    }
+
+    /**
+     * Works out which subresources a usage covers, resolving VK_REMAINING_MIP_LEVELS and VK_REMAINING_ARRAY_LAYERS
+     */
+    static VkImageSubresourceRange get_subresource_range(const TextureUsageToken& usage) {
+        const auto& create_info = usage.texture->create_info;
+        auto aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        if (is_depth_format(create_info.format)) {
+            aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+
+        return VkImageSubresourceRange{
+            .aspectMask = static_cast<VkImageAspectFlags>(aspect),
+            .baseMipLevel = usage.first_mip,
+            .levelCount = usage.num_mips == VK_REMAINING_MIP_LEVELS
+                              ? create_info.mipLevels - usage.first_mip
+                              : usage.num_mips,
+            .baseArrayLayer = usage.first_layer,
+            .layerCount = usage.num_layers == VK_REMAINING_ARRAY_LAYERS
+                              ? create_info.arrayLayers - usage.first_layer
+                              : usage.num_layers,
+        };
+    }
+
+    static bool needs_barrier(const TextureSubresourceState& old_state, const TextureSubresourceState& new_state) {
+        // Issue a barrier if either (or both) of the accesses require writing
+        const auto needs_write_barrier = is_write_access(new_state.access) || is_write_access(old_state.access);
+        const auto needs_transition_barrier = new_state.layout != old_state.layout;
+        const auto needs_fussy_shader_barrier = new_state.stage != old_state.stage;
+        return needs_write_barrier || needs_transition_barrier || needs_fussy_shader_barrier;
+    }
+
     void ResourceAccessTracker::set_resource_usage(
         const TextureUsageToken& usage, const bool skip_barrier
     ) {
         const auto& texture = usage.texture;
-        auto aspect = VK_IMAGE_ASPECT_COLOR_BIT;
-        if (is_depth_format(texture->create_info.format)) {
-            aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-        }
 
-        if (std::ranges::find_if(
-            initial_texture_usages,
-            [=](const TextureUsageToken& token) {
-                return token.texture == texture;
-            }) == initial_texture_usages.end()) {
-            initial_texture_usages.emplace_back(TextureUsageToken{ texture, usage.stage, usage.access, usage.layout });
+        const auto is_first_use = texture->access_tracker_slot == untracked_slot;
+        if (is_first_use) {
+            texture->access_tracker_slot = allocate_slot(texture_states, free_texture_slots);
+            // Every subresource starts out undefined
+            texture_states[texture->access_tracker_slot].subresources.assign(1, TextureSubresourceState{});
 
             if (!skip_barrier) {
                 logger->trace(
@@ -63,143 +86,195 @@ namespace render {
                     string_VkImageLayout(VK_IMAGE_LAYOUT_UNDEFINED),
                     string_VkImageLayout(usage.layout)
                 );
-                image_barriers.emplace_back(
-                    VkImageMemoryBarrier2{
-                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                        .srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                        .srcAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-                        .dstStageMask = usage.stage,
-                        .dstAccessMask = usage.access,
-                        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                        .newLayout = usage.layout,
-                        .image = texture->image,
-                        .subresourceRange = {
-                            .aspectMask = static_cast<VkImageAspectFlags>(aspect),
-                            .baseMipLevel = 0,
-                            .levelCount = texture->create_info.mipLevels,
-                            .baseArrayLayer = 0,
-                            .layerCount = texture->create_info.arrayLayers,
-                        }
-                    }
-                );
             }
         }
 
-        auto existing_barrier = std::ranges::find_if(
-            last_texture_usages,
-            [=](const TextureUsageToken& token) {
-                return token.texture == texture;
-            });
+        auto& state = texture_states[texture->access_tracker_slot];
+        const auto range = get_subresource_range(usage);
+        const auto new_state = TextureSubresourceState{
+            .stage = usage.stage,
+            .access = usage.access,
+            .layout = usage.layout
+        };
 
         if (!skip_barrier) {
-            if (existing_barrier != last_texture_usages.end()) {
-                // Issue a barrier if either (or both) of the accesses require writing
-                const auto needs_write_barrier = is_write_access(usage.access) || is_write_access(existing_barrier->access);
-                const auto needs_transition_barrier = usage.layout != existing_barrier->layout;
-                const auto needs_fussy_shader_barrier = usage.stage != existing_barrier->stage;
-                if (needs_write_barrier || needs_transition_barrier || needs_fussy_shader_barrier) {
-                    if (existing_barrier->layout == VK_IMAGE_LAYOUT_UNDEFINED) {
-                        if (texture->name.empty()) {
-                            SAH_BREAKPOINT;
-                        }
-                        logger->trace(
-                            "Transitioning image {} from {} to {}",
-                            texture->name,
-                            magic_enum::enum_name(existing_barrier->layout),
-                            magic_enum::enum_name(usage.layout)
-                        );
-                    }
-                    image_barriers.emplace_back(
-                        VkImageMemoryBarrier2{
-                            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                            .srcStageMask = existing_barrier->stage,
-                            .srcAccessMask = existing_barrier->access,
-                            .dstStageMask = usage.stage,
-                            .dstAccessMask = usage.access,
-                            .oldLayout = existing_barrier->layout,
-                            .newLayout = usage.layout,
-                            .image = texture->image,
-                            .subresourceRange = {
-                                .aspectMask = static_cast<VkImageAspectFlags>(aspect),
-                                .baseMipLevel = 0,
-                                .levelCount = texture->create_info.mipLevels,
-                                .baseArrayLayer = 0,
-                                .layerCount = texture->create_info.arrayLayers,
-                            }
-                        }
-                    );
+            add_image_barriers(texture, state, range, new_state, is_first_use);
+        }
+
+        set_subresource_states(texture, state, range, new_state);
+        state.last_usage = usage;
+    }
+
+    void ResourceAccessTracker::add_image_barriers(
+        const TextureHandle texture, const TextureAccessState& state, const VkImageSubresourceRange& range,
+        const TextureSubresourceState& new_state, const bool is_first_use
+    ) {
+        const auto add_barrier = [&](
+            const TextureSubresourceState& old_state, const VkImageSubresourceRange& subresources
+        ) {
+            if (!needs_barrier(old_state, new_state)) {
+                return;
+            }
+
+            if (old_state.layout == VK_IMAGE_LAYOUT_UNDEFINED && !is_first_use) {
+                if (texture->name.empty()) {
+                    SAH_BREAKPOINT;
                 }
+                logger->trace(
+                    "Transitioning image {} from {} to {}",
+                    texture->name,
+                    magic_enum::enum_name(old_state.layout),
+                    magic_enum::enum_name(new_state.layout)
+                );
             }
+
+            image_barriers.emplace_back(
+                VkImageMemoryBarrier2{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    .srcStageMask = old_state.stage,
+                    .srcAccessMask = old_state.access,
+                    .dstStageMask = new_state.stage,
+                    .dstAccessMask = new_state.access,
+                    .oldLayout = old_state.layout,
+                    .newLayout = new_state.layout,
+                    .image = texture->image,
+                    .subresourceRange = subresources
+                }
+            );
+        };
+
+        if (state.subresources.size() == 1) {
+            add_barrier(state.subresources[0], range);
+            return;
         }
 
-        if (existing_barrier != last_texture_usages.end()) {
-            *existing_barrier = usage;
+        // The subresources are in different states. Each run of mips in the same state gets one barrier
+        const auto num_mips = texture->create_info.mipLevels;
+        const auto end_mip = range.baseMipLevel + range.levelCount;
+        for (auto layer = range.baseArrayLayer; layer < range.baseArrayLayer + range.layerCount; layer++) {
+            const auto* layer_states = &state.subresources[layer * num_mips];
+            auto run_start = range.baseMipLevel;
+            for (auto mip = run_start + 1; mip <= end_mip; mip++) {
+                if (mip == end_mip || layer_states[mip] != layer_states[run_start]) {
+                    add_barrier(
+                        layer_states[run_start],
+                        VkImageSubresourceRange{
+                            .aspectMask = range.aspectMask,
+                            .baseMipLevel = run_start,
+                            .levelCount = mip - run_start,
+                            .baseArrayLayer = layer,
+                            .layerCount = 1,
+                        });
+                    run_start = mip;
+                }
+            }
         }
-        else {
-            last_texture_usages.emplace_back(usage);
+    }
+
+    void ResourceAccessTracker::set_subresource_states(
+        const TextureHandle texture, TextureAccessState& state, const VkImageSubresourceRange& range,
+        const TextureSubresourceState& new_state
+    ) {
+        const auto num_mips = texture->create_info.mipLevels;
+        const auto num_layers = texture->create_info.arrayLayers;
+        if (range.levelCount == num_mips && range.layerCount == num_layers) {
+            state.subresources.assign(1, new_state);
+            return;
+        }
+
+        if (state.subresources.size() == 1) {
+            const auto whole_texture_state = state.subresources[0];
+            state.subresources.assign(num_mips * num_layers, whole_texture_state);
+        }
+
+        for (auto layer = range.baseArrayLayer; layer < range.baseArrayLayer + range.layerCount; layer++) {
+            for (auto mip = range.baseMipLevel; mip < range.baseMipLevel + range.levelCount; mip++) {
+                state.subresources[layer * num_mips + mip] = new_state;
+            }
         }
     }
 
     void ResourceAccessTracker::set_resource_usage(const BufferUsageToken& usage) {
-        if (std::ranges::find_if(
-            initial_buffer_usages,
-            [=](const BufferUsageToken& exiting_use) {
-                return exiting_use.buffer == usage.buffer;
-            }) == initial_buffer_usages.end()) {
-            initial_buffer_usages.emplace_back(usage);
-        }
-
-        if (auto itr = std::ranges::find_if(
-            last_buffer_usages,
-            [=](const BufferUsageToken& last_usage) {
-                return last_usage.buffer == usage.buffer;
-            }); itr != last_buffer_usages.end()) {
-            // Issue a barrier if either (or both) of the accesses require writing
-            if (is_write_access(usage.access) || is_write_access(itr->access)) {
-                // logger->trace(
-                //     "[{}]: Issuing a barrier from access {} to access {}",
-                //     buffer->name,
-                //     string_VkAccessFlags2(itr->second.access),
-                //     string_VkAccessFlags2(access)
-                // );
-
-                buffer_barriers.emplace_back(
-                    VkBufferMemoryBarrier2{
-                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-                        .srcStageMask = itr->stage,
-                        .srcAccessMask = itr->access,
-                        .dstStageMask = usage.stage,
-                        .dstAccessMask = usage.access,
-                        .buffer = usage.buffer->buffer,
-                        .size = usage.buffer->create_info.size,
-                    }
-                    );
-            }
+        const auto& buffer = usage.buffer;
+        if (buffer->access_tracker_slot == untracked_slot) {
+            buffer->access_tracker_slot = allocate_slot(buffer_states, free_buffer_slots);
+            buffer_states[buffer->access_tracker_slot] = usage;
+            return;
+        }
 
-            *itr = usage;
+        auto& last_usage = buffer_states[buffer->access_tracker_slot];
 
+        // Issue a barrier if either (or both) of the accesses require writing
+        if (is_write_access(usage.access) || is_write_access(last_usage.access)) {
+            buffer_barriers.emplace_back(
+                VkBufferMemoryBarrier2{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                    .srcStageMask = last_usage.stage,
+                    .srcAccessMask = last_usage.access,
+                    .dstStageMask = usage.stage,
+                    .dstAccessMask = usage.access,
+                    .buffer = buffer->buffer,
+                    .size = buffer->create_info.size,
+                }
+                );
         }
-        else {
-            last_buffer_usages.emplace_back(usage);
-        }
+
+        last_usage = usage;
     }
 
-    void ResourceAccessTracker::issue_barriers(const CommandBuffer& commands) {
+    bool ResourceBarriers::is_empty() const {
+        return buffer_barriers.empty() && image_barriers.empty();
+    }
+
+    void ResourceBarriers::record(const CommandBuffer& commands) const {
+        if (is_empty()) {
+            return;
+        }
+
         const static auto memory_barriers = eastl::fixed_vector<VkMemoryBarrier2, 32>{};
         commands.barrier(memory_barriers, buffer_barriers, image_barriers);
+    }
+
+    void ResourceAccessTracker::issue_barriers(const CommandBuffer& commands) {
+        take_barriers().record(commands);
+    }
+
+    ResourceBarriers ResourceAccessTracker::take_barriers() {
+        auto barriers = ResourceBarriers{
+            .buffer_barriers = eastl::move(buffer_barriers),
+            .image_barriers = eastl::move(image_barriers),
+        };
         buffer_barriers.clear();
         image_barriers.clear();
+
+        return barriers;
     }
 
     TextureUsageToken ResourceAccessTracker::get_last_usage_token(const TextureHandle texture_handle) {
-        if (auto itr = std::ranges::find_if(
-            last_texture_usages,
-            [=](const TextureUsageToken& token) {
-                return token.texture == texture_handle;
-            }); itr != last_texture_usages.end()) {
-            return *itr;
+        if (texture_handle->access_tracker_slot != untracked_slot) {
+            return texture_states[texture_handle->access_tracker_slot].last_usage;
         }
 
         throw std::runtime_error{ "Texture has no recent usages!" };
     }
+
+    void ResourceAccessTracker::release(const TextureHandle texture) {
+        if (texture->access_tracker_slot == untracked_slot) {
+            return;
+        }
+
+        texture_states[texture->access_tracker_slot] = {};
+        free_texture_slots.push_back(texture->access_tracker_slot);
+        texture->access_tracker_slot = untracked_slot;
+    }
+
+    void ResourceAccessTracker::release(const BufferHandle buffer) {
+        if (buffer->access_tracker_slot == untracked_slot) {
+            return;
+        }
+
+        buffer_states[buffer->access_tracker_slot] = {};
+        free_buffer_slots.push_back(buffer->access_tracker_slot);
+        buffer->access_tracker_slot = untracked_slot;
+    }
 }
@@ -10,13 +10,46 @@
 
 namespace render {
     class CommandBuffer;
-    class RenderBackend;
+
+    /**
+     * How one mip of one array layer of a texture was last accessed
+     */
+    struct TextureSubresourceState {
+        VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        bool operator==(const TextureSubresourceState& other) const = default;
+    };
+
+    /**
+     * Barriers that the tracker has worked out but not recorded yet
+     */
+    struct ResourceBarriers {
+        eastl::fixed_vector<VkBufferMemoryBarrier2, 32> buffer_barriers;
+
+        eastl::fixed_vector<VkImageMemoryBarrier2, 32> image_barriers;
+
+        bool is_empty() const;
+
+        void record(const CommandBuffer& commands) const;
+    };
+
     /**
      * \brief Tracks resource access, and allows querying for resource barriers
+     *
+     * Each resource's state lives in a slot that the resource knows the index of, so looking it up doesn't depend on
+     * how many resources the tracker knows about. Slots are handed out on a resource's first use and recycled when the
+     * resource is destroyed
+     *
+     * Texture usages may cover only some mips or layers, and the tracker remembers the state of each mip of each layer.
+     * Barriers only cover the subresources that need them, so e.g. a downsample chain only waits on the mip it reads
      */
     class ResourceAccessTracker {
     public:
-        explicit ResourceAccessTracker(RenderBackend& backend_in);
+        ResourceAccessTracker();
 
         void set_resource_usage(const TextureUsageToken& usage, bool skip_barrier = false);
 
@@ -24,21 +57,66 @@ namespace render {
 
         void issue_barriers(const CommandBuffer& commands);
 
+        /**
+         * Removes the pending barriers from the tracker without recording them. Lets the render graph work out every
+         * barrier in the frame up front, then record them on whichever thread records the passes
+         */
+        ResourceBarriers take_barriers();
+
         TextureUsageToken get_last_usage_token(TextureHandle texture_handle);
 
+        /**
+         * Forgets about a texture. The allocator calls this when it destroys the texture, so a new texture that reuses
+         * the handle starts out unused
+         */
+        void release(TextureHandle texture);
+
+        /**
+         * Forgets about a buffer. See release(TextureHandle)
+         */
+        void release(BufferHandle buffer);
+
     private:
-        RenderBackend& backend;
+        struct TextureAccessState {
+            TextureUsageToken last_usage;
+
+            /**
+             * State of each subresource, indexed by layer * num_mips + mip. Holds a single element while every
+             * subresource is in the same state, which is the common case
+             */
+            eastl::fixed_vector<TextureSubresourceState, 1> subresources;
+        };
 
-        eastl::vector<BufferUsageToken> initial_buffer_usages;
+        /**
+         * State of each texture, indexed by GpuTexture::access_tracker_slot
+         */
+        eastl::vector<TextureAccessState> texture_states;
 
-        eastl::vector<BufferUsageToken> last_buffer_usages;
+        eastl::vector<uint32_t> free_texture_slots;
 
-        eastl::vector<TextureUsageToken> initial_texture_usages;
+        /**
+         * Most recent usage of each buffer, indexed by GpuBuffer::access_tracker_slot
+         */
+        eastl::vector<BufferUsageToken> buffer_states;
 
-        eastl::vector<TextureUsageToken> last_texture_usages;
+        eastl::vector<uint32_t> free_buffer_slots;
 
         eastl::fixed_vector<VkBufferMemoryBarrier2, 32> buffer_barriers;
 
         eastl::fixed_vector<VkImageMemoryBarrier2, 32> image_barriers;
+
+        /**
+         * Adds barriers to move some of a texture's subresources into a new state. Subresources that are already in a
+         * compatible state don't get a barrier
+         */
+        void add_image_barriers(
+            TextureHandle texture, const TextureAccessState& state, const VkImageSubresourceRange& range,
+            const TextureSubresourceState& new_state, bool is_first_use
+        );
+
+        static void set_subresource_states(
+            TextureHandle texture, TextureAccessState& state, const VkImageSubresourceRange& range,
+            const TextureSubresourceState& new_state
+        );
     };
 }
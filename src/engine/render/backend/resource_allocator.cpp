@@ -48,11 +48,82 @@ namespace render {
     }
 
     TextureHandle ResourceAllocator::create_texture(const eastl::string_view name, const TextureCreateInfo& create_info) {
-        const auto& device = backend.get_device();
+        VkImageAspectFlags view_aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        const auto image_create_info = make_image_create_info(create_info, view_aspect);
 
-        VkImageUsageFlags vk_usage = VK_IMAGE_USAGE_SAMPLED_BIT | create_info.usage_flags;
         VmaAllocationCreateFlags vma_flags = {};
+        if(create_info.usage == TextureUsage::RenderTarget) {
+            vma_flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
+
+        const auto allocation_info = VmaAllocationCreateInfo{
+            .flags = vma_flags,
+            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+        };
+
+        auto texture = GpuTexture{
+            .type = TextureAllocationType::Vma
+        };
+
+        const auto result = vmaCreateImage(
+            vma,
+            &image_create_info,
+            &allocation_info,
+            &texture.image,
+            &texture.vma.allocation,
+            &texture.vma.allocation_info
+        );
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not create image {}", name)};
+        }
+
+        texture.name = name;
+        texture.create_info = image_create_info;
+
+        create_texture_views(texture, create_info, view_aspect, name);
+
+        auto handle = &*textures.emplace(std::move(texture));
+        return handle;
+    }
+
+    TextureHandle ResourceAllocator::create_placed_texture(
+        const eastl::string_view name, const TextureCreateInfo& create_info, const VmaAllocation memory,
+        const VkDeviceSize offset
+    ) {
+        const auto& device = backend.get_device();
+
         VkImageAspectFlags view_aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        const auto image_create_info = make_image_create_info(create_info, view_aspect);
+
+        auto texture = GpuTexture{
+            .type = TextureAllocationType::Placed
+        };
+
+        auto result = vkCreateImage(device, &image_create_info, nullptr, &texture.image);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not create image {}", name)};
+        }
+
+        result = vmaBindImageMemory2(vma, memory, offset, texture.image, nullptr);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not bind memory for image {}", name)};
+        }
+
+        texture.name = name;
+        texture.create_info = image_create_info;
+        texture.vma.allocation = memory;
+        vmaGetAllocationInfo(vma, memory, &texture.vma.allocation_info);
+
+        create_texture_views(texture, create_info, view_aspect, name);
+
+        auto handle = &*textures.emplace(std::move(texture));
+        return handle;
+    }
+
+    VkImageCreateInfo ResourceAllocator::make_image_create_info(
+        const TextureCreateInfo& create_info, VkImageAspectFlags& view_aspect
+    ) const {
+        VkImageUsageFlags vk_usage = VK_IMAGE_USAGE_SAMPLED_BIT | create_info.usage_flags;
 
         switch(create_info.usage) {
         case TextureUsage::RenderTarget:
@@ -62,7 +133,6 @@ namespace render {
             } else {
                 vk_usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
             }
-            vma_flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
             break;
 
         case TextureUsage::StaticImage:
@@ -78,7 +148,7 @@ namespace render {
             break;
         }
 
-        const auto image_create_info = VkImageCreateInfo{
+        return VkImageCreateInfo{
             .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
             .flags = create_info.flags,
             .imageType = VK_IMAGE_TYPE_2D,
@@ -92,30 +162,13 @@ namespace render {
             .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
         };
+    }
 
-        const auto allocation_info = VmaAllocationCreateInfo{
-            .flags = vma_flags,
-            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-        };
-
-        auto texture = GpuTexture{
-            .type = TextureAllocationType::Vma
-        };
-
-        auto result = vmaCreateImage(
-            vma,
-            &image_create_info,
-            &allocation_info,
-            &texture.image,
-            &texture.vma.allocation,
-            &texture.vma.allocation_info
-        );
-        if(result != VK_SUCCESS) {
-            throw std::runtime_error{fmt::format("Could not create image {}", name)};
-        }
-
-        texture.name = name;
-        texture.create_info = image_create_info;
+    void ResourceAllocator::create_texture_views(
+        GpuTexture& texture, const TextureCreateInfo& create_info, const VkImageAspectFlags view_aspect,
+        const eastl::string_view name
+    ) const {
+        const auto& device = backend.get_device();
 
         const auto image_view_name = fmt::format("{} View", name);
 
@@ -133,7 +186,7 @@ namespace render {
                     .layerCount = create_info.num_layers,
                 },
             };
-            result = vkCreateImageView(device, &view_create_info, nullptr, &texture.image_view);
+            const auto result = vkCreateImageView(device, &view_create_info, nullptr, &texture.image_view);
             if(result != VK_SUCCESS) {
                 throw std::runtime_error{fmt::format("Could not create image view {}", image_view_name)};
             }
@@ -155,7 +208,7 @@ namespace render {
                     .layerCount = create_info.num_layers,
                 },
             };
-            result = vkCreateImageView(device, &rtv_create_info, nullptr, &texture.attachment_view);
+            const auto result = vkCreateImageView(device, &rtv_create_info, nullptr, &texture.attachment_view);
             if(result != VK_SUCCESS) {
                 throw std::runtime_error{fmt::format("Could not create image view")};
             }
@@ -183,7 +236,7 @@ namespace render {
                 },
             };
             auto view = VkImageView{};
-            result = vkCreateImageView(device, &view_create_info, nullptr, &view);
+            const auto result = vkCreateImageView(device, &view_create_info, nullptr, &view);
             if(result != VK_SUCCESS) {
                 throw std::runtime_error{fmt::format("Could not create image view")};
             }
@@ -193,9 +246,6 @@ namespace render {
 
             texture.mip_views.emplace_back(view);
         }
-
-        auto handle = &*textures.emplace(std::move(texture));
-        return handle;
     }
 
     TextureHandle ResourceAllocator::create_cubemap(const eastl::string_view name, const CubemapCreateInfo& create_info) {
@@ -447,9 +497,87 @@ namespace render {
 
         const auto& device = backend.get_device();
 
-        VkBufferUsageFlags vk_usage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
         VmaAllocationCreateFlags vma_flags = {};
         VmaMemoryUsage memory_usage = {};
+        const auto create_info = make_buffer_create_info(size, usage, vma_flags, memory_usage);
+
+        const auto vma_create_info = VmaAllocationCreateInfo{
+            .flags = vma_flags,
+            .usage = memory_usage,
+        };
+
+        GpuBuffer buffer;
+        const auto result = vmaCreateBuffer(
+            vma,
+            &create_info,
+            &vma_create_info,
+            &buffer.buffer,
+            &buffer.allocation,
+            &buffer.allocation_info
+        );
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not create buffer {}", name)};
+        }
+
+        backend.set_object_name(buffer.buffer, std::string{name.data(), name.size()});
+
+        buffer.name = name;
+        buffer.create_info = create_info;
+
+        const auto info = VkBufferDeviceAddressInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = buffer.buffer
+        };
+        buffer.address = vkGetBufferDeviceAddress(device, &info);
+
+        const auto handle = &*buffers.emplace(std::move(buffer));
+        return handle;
+    }
+
+    BufferHandle ResourceAllocator::create_placed_buffer(
+        const eastl::string_view name, const size_t size, const BufferUsage usage, const VmaAllocation memory,
+        const VkDeviceSize offset
+    ) {
+        if(usage == BufferUsage::StagingBuffer || usage == BufferUsage::UniformBuffer) {
+            throw std::runtime_error{fmt::format("Buffer {} must be mappable, so it can't be placed", name)};
+        }
+
+        const auto& device = backend.get_device();
+
+        VmaAllocationCreateFlags vma_flags = {};
+        VmaMemoryUsage memory_usage = {};
+        const auto create_info = make_buffer_create_info(size, usage, vma_flags, memory_usage);
+
+        GpuBuffer buffer;
+        auto result = vkCreateBuffer(device, &create_info, nullptr, &buffer.buffer);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not create buffer {}", name)};
+        }
+
+        result = vmaBindBufferMemory2(vma, memory, offset, buffer.buffer, nullptr);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not bind memory for buffer {}", name)};
+        }
+
+        backend.set_object_name(buffer.buffer, std::string{name.data(), name.size()});
+
+        buffer.name = name;
+        buffer.create_info = create_info;
+
+        const auto info = VkBufferDeviceAddressInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = buffer.buffer
+        };
+        buffer.address = vkGetBufferDeviceAddress(device, &info);
+
+        const auto handle = &*buffers.emplace(std::move(buffer));
+        return handle;
+    }
+
+    VkBufferCreateInfo ResourceAllocator::make_buffer_create_info(
+        const size_t size, const BufferUsage usage, VmaAllocationCreateFlags& vma_flags, VmaMemoryUsage& memory_usage
+    ) const {
+        VkBufferUsageFlags vk_usage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
         switch(usage) {
         case BufferUsage::StagingBuffer:
@@ -503,6 +631,15 @@ namespace render {
             memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
             break;
 
+        case BufferUsage::AccelerationStructureInstances:
+            vk_usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            if(backend.supports_ray_tracing()) {
+                // So that TLAS builds can read the instances that the GPU patched in
+                vk_usage |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR;
+            }
+            memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+            break;
+
         case BufferUsage::ShaderBindingTable:
             vk_usage |= VK_BUFFER_USAGE_2_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR
                 |
@@ -510,44 +647,36 @@ namespace render {
             memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
             break;
         }
-        const auto create_info = VkBufferCreateInfo{
+        return VkBufferCreateInfo{
             .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
             .size = std::max(size, static_cast<size_t>(256)),
             .usage = vk_usage,
             .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
         };
 
-        const auto vma_create_info = VmaAllocationCreateInfo{
-            .flags = vma_flags,
-            .usage = memory_usage,
+    }
+
+    VmaAllocation ResourceAllocator::allocate_memory(const VkMemoryRequirements& requirements) {
+        const auto create_info = VmaAllocationCreateInfo{
+            .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+            .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         };
 
-        GpuBuffer buffer;
-        const auto result = vmaCreateBuffer(
-            vma,
-            &create_info,
-            &vma_create_info,
-            &buffer.buffer,
-            &buffer.allocation,
-            &buffer.allocation_info
-        );
+        auto memory = VmaAllocation{};
+        const auto result = vmaAllocateMemory(vma, &requirements, &create_info, &memory, nullptr);
         if(result != VK_SUCCESS) {
-            throw std::runtime_error{fmt::format("Could not create buffer {}", name)};
+            throw std::runtime_error{fmt::format("Could not allocate {} bytes of memory", requirements.size)};
         }
 
-        backend.set_object_name(buffer.buffer, std::string{name.data(), name.size()});
-
-        buffer.name = name;
-        buffer.create_info = create_info;
+        return memory;
+    }
 
-        const auto info = VkBufferDeviceAddressInfo{
-            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-            .buffer = buffer.buffer
-        };
-        buffer.address = vkGetBufferDeviceAddress(device, &info);
+    void ResourceAllocator::free_memory(const VmaAllocation memory) {
+        if(memory == VK_NULL_HANDLE) {
+            return;
+        }
 
-        const auto handle = &*buffers.emplace(std::move(buffer));
-        return handle;
+        memory_zombie_lists[backend.get_current_gpu_frame()].emplace_back(memory);
     }
 
     void* ResourceAllocator::map_buffer(const BufferHandle buffer_handle) const {
@@ -644,6 +773,7 @@ namespace render {
         ZoneScoped;
 
         const auto& device = backend.get_device();
+        auto& access_tracker = backend.get_resource_access_tracker();
 
         {
             ZoneScopedN("Acceleration structures");
@@ -662,6 +792,8 @@ namespace render {
             for(const auto handle : zombie_buffers) {
                 vmaDestroyBuffer(vma, handle->buffer, handle->allocation);
 
+                access_tracker.release(handle);
+
                 buffers.erase(buffers.get_iterator(handle));
             }
 
@@ -683,15 +815,32 @@ namespace render {
                     vkDestroyImageView(device, handle->image_view, nullptr);
                     break;
 
+                case TextureAllocationType::Placed:
+                    // Someone else owns the memory
+                    vkDestroyImage(device, handle->image, nullptr);
+                    break;
+
                 default:
                     throw std::runtime_error{"Unknown texture allocation type"};
                 }
 
+                access_tracker.release(handle);
+
                 textures.erase(textures.get_iterator(handle));
             }
 
             zombie_textures.clear();
         }
+        {
+            // Placed resources may live in this memory, so free it after destroying them
+            ZoneScopedN("Memory");
+            auto& zombie_memory = memory_zombie_lists[frame_idx];
+            for(const auto memory : zombie_memory) {
+                vmaFreeMemory(vma, memory);
+            }
+
+            zombie_memory.clear();
+        }
 
         vmaSetCurrentFrameIndex(vma, frame_idx);
     }
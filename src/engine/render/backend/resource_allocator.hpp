@@ -94,6 +94,11 @@ namespace render {
          */
         AccelerationStructure,
 
+        /**
+         * TLAS instances. A storage buffer that TLAS builds can also read instances from
+         */
+        AccelerationStructureInstances,
+
         /**
          * Shader binding table, useful for ray tracing
          */
@@ -109,6 +114,7 @@ namespace render {
         case BufferUsage::UniformBuffer: return "UniformBuffer";
         case BufferUsage::StorageBuffer: return "StorageBuffer";
         case BufferUsage::AccelerationStructure: return "AccelerationStructure";
+        case BufferUsage::AccelerationStructureInstances: return "AccelerationStructureInstances";
         case BufferUsage::ShaderBindingTable: return "ShaderBindingTable";
         default: return "unknown";
         }
@@ -169,6 +175,14 @@ namespace render {
 
         TextureHandle emplace_texture(GpuTexture&& new_texture);
 
+        /**
+         * Creates a texture in memory from allocate_memory, at the given offset. Many textures may share the same
+         * memory, as long as they're never used at the same time. Destroying the texture does not free the memory
+         */
+        TextureHandle create_placed_texture(
+            eastl::string_view name, const TextureCreateInfo& create_info, VmaAllocation memory, VkDeviceSize offset
+        );
+
         void destroy_texture(TextureHandle handle);
 
         BufferHandle create_buffer(eastl::string_view name, size_t size, BufferUsage usage);
@@ -182,6 +196,25 @@ namespace render {
 
         void destroy_buffer(BufferHandle handle);
 
+        /**
+         * Creates a buffer in memory from allocate_memory, at the given offset. The buffer can't be mapped, so only GPU
+         * usages are allowed. Destroying the buffer does not free the memory
+         */
+        BufferHandle create_placed_buffer(
+            eastl::string_view name, size_t size, BufferUsage usage, VmaAllocation memory, VkDeviceSize offset
+        );
+
+        /**
+         * Allocates a block of device-local memory to place resources in
+         */
+        VmaAllocation allocate_memory(const VkMemoryRequirements& requirements);
+
+        /**
+         * Frees memory from allocate_memory. Like the other destroy functions, the memory isn't freed until the GPU is
+         * done with this frame
+         */
+        void free_memory(VmaAllocation memory);
+
         AccelerationStructureHandle create_acceleration_structure(
             uint64_t acceleration_structure_size, VkAccelerationStructureTypeKHR type
         );
@@ -222,6 +255,20 @@ namespace render {
         eastl::array<eastl::vector<BufferHandle>, num_in_flight_frames> buffer_zombie_lists;
         eastl::array<eastl::vector<TextureHandle>, num_in_flight_frames> texture_zombie_lists;
         eastl::array<eastl::vector<AccelerationStructureHandle>, num_in_flight_frames> as_zombie_lists;
+        eastl::array<eastl::vector<VmaAllocation>, num_in_flight_frames> memory_zombie_lists;
+
+        VkImageCreateInfo make_image_create_info(
+            const TextureCreateInfo& create_info, VkImageAspectFlags& view_aspect
+        ) const;
+
+        void create_texture_views(
+            GpuTexture& texture, const TextureCreateInfo& create_info, VkImageAspectFlags view_aspect,
+            eastl::string_view name
+        ) const;
+
+        VkBufferCreateInfo make_buffer_create_info(
+            size_t size, BufferUsage usage, VmaAllocationCreateFlags& vma_flags, VmaMemoryUsage& memory_usage
+        ) const;
 
         struct SamplerCreateInfoHasher {
             std::size_t operator()(const VkSamplerCreateInfo& k) const {
@@ -1,5 +1,10 @@
 #include "resource_upload_queue.hpp"
 
+#include <cstring>
+
+#include <tracy/Tracy.hpp>
+
+#include "console/cvars.hpp"
 #include "core/issue_breakpoint.hpp"
 #include "render/backend/render_backend.hpp"
 #include "render/backend/utils.hpp"
@@ -8,35 +13,187 @@
 namespace render {
     static std::shared_ptr<spdlog::logger> logger;
 
-    ResourceUploadQueue::ResourceUploadQueue(RenderBackend& backend_in) : backend{ backend_in } {
+    static auto cvar_staging_buffer_size = AutoCVar_Int{
+        "r.RHI.StagingBufferSizeMB", "Size of the staging ring buffer that all uploads go through, in megabytes", 128
+    };
+
+    static auto cvar_upload_budget = AutoCVar_Int{
+        "r.RHI.UploadBudgetMB",
+        "Maximum number of megabytes of texture data to upload each frame. Uploads past this wait for the next frame",
+        64
+    };
+
+    /**
+     * Alignment of every staging allocation. Large enough for any texel block
+     */
+    constexpr uint64_t STAGING_ALIGNMENT = 16;
+
+    ResourceUploadQueue::ResourceUploadQueue(RenderBackend& backend_in) :
+        backend{ backend_in },
+        staging_buffer{
+            backend_in.get_global_allocator(),
+            static_cast<uint64_t>(cvar_staging_buffer_size.get()) * 1024 * 1024
+        } {
         logger = SystemInterface::get().get_logger("ResourceUploadQueue");
     }
 
+    eastl::span<uint8_t> ResourceUploadQueue::reserve_buffer_upload(
+        const BufferHandle buffer, const uint32_t size, const uint32_t dest_offset
+        ) {
+        validate_buffer_upload(buffer, size, dest_offset);
+
+        // If there's a backlog, this upload must go after it
+        if(buffer_uploads.empty()) {
+            if(const auto allocation = staging_buffer.allocate(size, STAGING_ALIGNMENT)) {
+                staged_buffer_copies.emplace_back(
+                    StagedBufferCopy{
+                        .source = staging_buffer.get_buffer(),
+                        .source_offset = allocation->offset,
+                        .destination = buffer,
+                        .dest_offset = dest_offset,
+                        .size = size,
+                    });
+                return { allocation->data, size };
+            }
+        }
+
+        auto& job = buffer_uploads.emplace_back(
+            BufferUploadJob{
+                .buffer = buffer,
+                .data = eastl::vector<uint8_t>(size),
+                .dest_offset = dest_offset,
+            });
+        return job.data;
+    }
+
     void ResourceUploadQueue::enqueue(TextureUploadJob&& job) {
-        texture_uploads.emplace_back(std::move(job));
+        texture_uploads.emplace_back(PendingTextureUpload{ .job = std::move(job) });
     }
 
     void ResourceUploadQueue::enqueue(BufferUploadJob&& job) {
+        validate_buffer_upload(job.buffer, job.data.size(), job.dest_offset);
         buffer_uploads.emplace_back(std::move(job));
     }
 
+    bool ResourceUploadQueue::has_pending_uploads(const TextureHandle texture) const {
+        return eastl::any_of(
+            texture_uploads.begin(),
+            texture_uploads.end(),
+            [&](const PendingTextureUpload& upload) { return upload.job.destination == texture; });
+    }
+
+    void ResourceUploadQueue::begin_frame(const uint32_t frame_index) {
+        cur_frame_stats.staging_bytes_in_use = staging_buffer.get_bytes_in_use();
+        last_frame_stats = cur_frame_stats;
+        cur_frame_stats = {};
+
+        staging_buffer.begin_frame(frame_index);
+
+        TracyPlot("Uploaded bytes", static_cast<int64_t>(last_frame_stats.bytes_uploaded));
+        TracyPlot("Deferred uploads", static_cast<int64_t>(last_frame_stats.num_deferred_uploads));
+    }
+
+    const UploadStats& ResourceUploadQueue::get_stats() const {
+        return last_frame_stats;
+    }
+
     void ResourceUploadQueue::flush_pending_uploads() {
-        size_t total_size = 0;
+        if (texture_uploads.empty() && buffer_uploads.empty() && staged_buffer_copies.empty()) {
+            // Nothing to upload, we can sleep easy
+            return;
+        }
+
+        ZoneScoped;
 
         auto& allocator = backend.get_global_allocator();
 
+        // Buffer uploads that reserved space in the ring are already staged. Stage the backlog after them. Buffer uploads
+        // never wait for a later frame, so anything that doesn't fit in the ring gets its own staging buffer
+
+        for (const auto& job : buffer_uploads) {
+            auto staged = stage_data(job.data);
+            if(!staged) {
+                staged = stage_data_dedicated(job.data);
+            }
+
+            staged_buffer_copies.emplace_back(
+                StagedBufferCopy{
+                    .source = staged->buffer,
+                    .source_offset = staged->offset,
+                    .destination = job.buffer,
+                    .dest_offset = job.dest_offset,
+                    .size = static_cast<uint32_t>(job.data.size()),
+                });
+        }
+        buffer_uploads.clear();
+
+        for (const auto& copy : staged_buffer_copies) {
+            cur_frame_stats.bytes_uploaded += copy.size;
+        }
+
+        // Stage texture uploads until we run out of budget. Uploads stay in order, so once one upload waits, all the
+        // uploads after it wait too
+
+        const auto budget = static_cast<uint64_t>(cvar_upload_budget.get()) * 1024 * 1024;
+
+        auto texture_copies = eastl::vector<eastl::pair<const TextureUploadJob*, StagedData>>{};
+        texture_copies.reserve(texture_uploads.size());
+
         auto before_image_barriers = eastl::vector<VkImageMemoryBarrier2>{};
         auto after_image_barriers = eastl::vector<VkImageMemoryBarrier2>{};
         before_image_barriers.reserve(texture_uploads.size());
+        after_image_barriers.reserve(texture_uploads.size());
 
-        // Look through all the upload jobs to see how big of a staging buffer we need, and to collect all the barriers
-
-        for (const auto& job : texture_uploads) {
-            total_size += job.data.size();
+        auto num_staged_textures = size_t{0};
+        auto has_deferred_upload = false;
+        for (auto& upload : texture_uploads) {
+            const auto& job = upload.job;
 
             const auto aspect = static_cast<VkImageAspectFlags>(is_depth_format(job.destination->create_info.format)
                 ? VK_IMAGE_ASPECT_DEPTH_BIT
                 : VK_IMAGE_ASPECT_COLOR_BIT);
+            const auto subresource_range = VkImageSubresourceRange{
+                .aspectMask = aspect,
+                .baseMipLevel = job.mip,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            };
+
+            auto staged = eastl::optional<StagedData>{};
+            const auto is_within_budget = cur_frame_stats.bytes_uploaded == 0 ||
+                cur_frame_stats.bytes_uploaded + job.data.size() <= budget;
+            if(!has_deferred_upload && is_within_budget) {
+                staged = stage_data(job.data);
+            }
+
+            if(!staged) {
+                has_deferred_upload = true;
+                cur_frame_stats.num_deferred_uploads++;
+
+                // Make the mip bindable while it waits. Its contents are undefined until the upload lands
+                if(!upload.is_layout_initialized) {
+                    before_image_barriers.emplace_back(
+                        VkImageMemoryBarrier2{
+                            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                            .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+                            .srcAccessMask = VK_ACCESS_2_NONE,
+                            .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                            .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+                            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            .image = job.destination->image,
+                            .subresourceRange = subresource_range,
+                        }
+                    );
+                    upload.is_layout_initialized = true;
+                }
+                continue;
+            }
+
+            num_staged_textures++;
+            cur_frame_stats.bytes_uploaded += job.data.size();
+            texture_copies.emplace_back(&job, *staged);
 
             before_image_barriers.emplace_back(
                 VkImageMemoryBarrier2{
@@ -48,13 +205,7 @@ namespace render {
                     .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
                     .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                     .image = job.destination->image,
-                    .subresourceRange = {
-                        .aspectMask = aspect,
-                        .baseMipLevel = job.mip,
-                        .levelCount = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = 1
-                    },
+                    .subresourceRange = subresource_range,
                 }
             );
             after_image_barriers.emplace_back(
@@ -67,37 +218,35 @@ namespace render {
                     .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                     .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                     .image = job.destination->image,
-                    .subresourceRange = {
-                        .aspectMask = aspect,
-                        .baseMipLevel = job.mip,
-                        .levelCount = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = 1
-                    },
+                    .subresourceRange = subresource_range,
                 }
             );
+
+            // Hand the mip over to the graphics queue once the copy is done
+            if(backend.has_separate_transfer_queue()) {
+                backend.add_transfer_barrier(
+                    VkImageMemoryBarrier2{
+                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                        .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                        .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+                        .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        .srcQueueFamilyIndex = backend.get_transfer_queue_family_index(),
+                        .dstQueueFamilyIndex = backend.get_graphics_queue_family_index(),
+                        .image = job.destination->image,
+                        .subresourceRange = subresource_range,
+                    });
+            }
         }
 
         auto before_buffer_barriers = eastl::vector<VkBufferMemoryBarrier2>{};
         auto after_buffer_barriers = eastl::vector<VkBufferMemoryBarrier2>{};
-        before_buffer_barriers.reserve(buffer_uploads.size());
-        after_buffer_barriers.reserve(buffer_uploads.size());
-
-        for (const auto& job : buffer_uploads) {
-            total_size += job.data.size();
-
-            // Bitta validation
-            if(job.data.size() > job.buffer->create_info.size - job.dest_offset) {
-                logger->error(
-                    "Trying to upload {} bytes, but buffer {} only has space for {} at offset {}",
-                    job.data.size(),
-                    job.buffer->name,
-                    job.buffer->create_info.size - job.dest_offset,
-                    job.dest_offset
-                    );
-                SAH_BREAKPOINT;
-            }
+        before_buffer_barriers.reserve(staged_buffer_copies.size());
+        after_buffer_barriers.reserve(staged_buffer_copies.size());
 
+        for (const auto& copy : staged_buffer_copies) {
             before_buffer_barriers.emplace_back(
                 VkBufferMemoryBarrier2{
                     .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
@@ -105,9 +254,9 @@ namespace render {
                     .srcAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
                     .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
                     .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                    .buffer = job.buffer->buffer,
-                    .offset = job.dest_offset,
-                    .size = job.data.size(),
+                    .buffer = copy.destination->buffer,
+                    .offset = copy.dest_offset,
+                    .size = copy.size,
                 }
                 );
             after_buffer_barriers.emplace_back(
@@ -117,29 +266,14 @@ namespace render {
                     .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
                     .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
                     .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
-                    .buffer = job.buffer->buffer,
-                    .offset = job.dest_offset,
-                    .size = job.data.size(),
+                    .buffer = copy.destination->buffer,
+                    .offset = copy.dest_offset,
+                    .size = copy.size,
                 }
                 );
         }
 
-        if (total_size == 0) {
-            // Nothing to upload, we can sleep easy
-            return;
-        }
-
-        // logger->info("Creating a staging buffer of size {}", total_size);
-
-        auto staging_buffer = allocator.create_buffer(
-            "Upload staging buffer",
-            total_size,
-            BufferUsage::StagingBuffer
-        );
-
-        auto* data_write_ptr = static_cast<uint8_t*>(staging_buffer->allocation_info.pMappedData);
-
-        // Copy the texture data to the staging buffer, and record the upload commands
+        // Record the upload commands
 
         auto cmds = backend.create_transfer_command_buffer("Transfer command buffer");
 
@@ -157,49 +291,42 @@ namespace render {
         };
         vkCmdPipelineBarrier2(cmds, &before_dependency_info);
 
-        size_t cur_offset = 0;
-
-        for (const auto& job : texture_uploads) {
-            // Copy data
-            std::memcpy(data_write_ptr + cur_offset, job.data.data(), job.data.size());
-
+        for (const auto& [job, staged] : texture_copies) {
+            const auto& extent = job->destination->create_info.extent;
             const auto region = VkBufferImageCopy{
-                .bufferOffset = cur_offset,
+                .bufferOffset = staged.offset,
                 .imageSubresource = {
-                    .aspectMask = static_cast<VkImageAspectFlags>(is_depth_format(job.destination->create_info.format)
+                    .aspectMask = static_cast<VkImageAspectFlags>(is_depth_format(job->destination->create_info.format)
                         ? VK_IMAGE_ASPECT_DEPTH_BIT
                         : VK_IMAGE_ASPECT_COLOR_BIT),
-                    .mipLevel = job.mip,
+                    .mipLevel = job->mip,
                     .baseArrayLayer = 0,
                     .layerCount = 1,
                 },
                 .imageOffset = {},
-                .imageExtent = job.destination->create_info.extent,
+                .imageExtent = {
+                    .width = eastl::max(extent.width >> job->mip, 1u),
+                    .height = eastl::max(extent.height >> job->mip, 1u),
+                    .depth = eastl::max(extent.depth >> job->mip, 1u),
+                },
             };
             vkCmdCopyBufferToImage(
                 cmds,
-                staging_buffer->buffer,
-                job.destination->image,
+                staged.buffer->buffer,
+                job->destination->image,
                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 1,
                 &region
             );
-
-            cur_offset += job.data.size();
         }
 
-        for (const auto& job : buffer_uploads) {
-            // Copy data
-            std::memcpy(data_write_ptr + cur_offset, job.data.data(), job.data.size());
-
+        for (const auto& copy : staged_buffer_copies) {
             const auto region = VkBufferCopy{
-                .srcOffset = cur_offset,
-                .dstOffset = job.dest_offset,
-                .size = job.data.size(),
+                .srcOffset = copy.source_offset,
+                .dstOffset = copy.dest_offset,
+                .size = copy.size,
             };
-            vkCmdCopyBuffer(cmds, staging_buffer->buffer, job.buffer->buffer, 1, &region);
-
-            cur_offset += job.data.size();
+            vkCmdCopyBuffer(cmds, copy.source->buffer, copy.destination->buffer, 1, &region);
         }
 
         const auto after_dependency_info = VkDependencyInfo{
@@ -216,9 +343,57 @@ namespace render {
 
         backend.submit_transfer_command_buffer(cmds);
 
-        texture_uploads.clear();
-        buffer_uploads.clear();
+        // The staged uploads are always the first ones in the list
+        texture_uploads.erase(texture_uploads.begin(), texture_uploads.begin() + num_staged_textures);
+        staged_buffer_copies.clear();
+
+        for (const auto buffer : dedicated_staging_buffers) {
+            allocator.destroy_buffer(buffer);
+        }
+        dedicated_staging_buffers.clear();
+    }
+
+    eastl::optional<ResourceUploadQueue::StagedData> ResourceUploadQueue::stage_data(
+        const eastl::span<const uint8_t> data
+        ) {
+        if (data.size() > staging_buffer.get_size()) {
+            return stage_data_dedicated(data);
+        }
+
+        const auto allocation = staging_buffer.allocate(data.size(), STAGING_ALIGNMENT);
+        if (!allocation) {
+            return eastl::nullopt;
+        }
+
+        std::memcpy(allocation->data, data.data(), data.size());
 
-        allocator.destroy_buffer(staging_buffer);
+        return StagedData{ .buffer = staging_buffer.get_buffer(), .offset = allocation->offset };
+    }
+
+    ResourceUploadQueue::StagedData ResourceUploadQueue::stage_data_dedicated(const eastl::span<const uint8_t> data) {
+        auto& allocator = backend.get_global_allocator();
+        const auto buffer = allocator.create_buffer("Upload staging buffer", data.size(), BufferUsage::StagingBuffer);
+        std::memcpy(buffer->allocation_info.pMappedData, data.data(), data.size());
+
+        dedicated_staging_buffers.emplace_back(buffer);
+        cur_frame_stats.num_dedicated_staging_buffers++;
+
+        return StagedData{ .buffer = buffer, .offset = 0 };
+    }
+
+    void ResourceUploadQueue::validate_buffer_upload(
+        const BufferHandle buffer, const size_t size, const uint32_t dest_offset
+        ) const {
+        // Bitta validation
+        if(size > buffer->create_info.size - dest_offset) {
+            logger->error(
+                "Trying to upload {} bytes, but buffer {} only has space for {} at offset {}",
+                size,
+                buffer->name,
+                buffer->create_info.size - dest_offset,
+                dest_offset
+                );
+            SAH_BREAKPOINT;
+        }
     }
 }
@@ -8,6 +8,7 @@
 
 #include "render/backend/handles.hpp"
 #include "render/backend/buffer.hpp"
+#include "render/backend/staging_ring_buffer.hpp"
 
 struct ktxTexture;
 
@@ -29,10 +30,36 @@ namespace render {
         uint32_t dest_offset;
     };
 
+    /**
+     * Statistics about one frame's uploads
+     */
+    struct UploadStats {
+        /**
+         * Number of bytes copied to the GPU
+         */
+        uint64_t bytes_uploaded = 0;
+
+        /**
+         * Number of texture uploads pushed to a later frame, because of the upload budget or a full staging buffer
+         */
+        uint32_t num_deferred_uploads = 0;
+
+        /**
+         * Number of uploads that didn't fit in the staging ring buffer and needed a staging buffer of their own
+         */
+        uint32_t num_dedicated_staging_buffers = 0;
+
+        uint64_t staging_bytes_in_use = 0;
+    };
+
     /**
      * Queues up resource uploads, then submits them
      *
-     *
+     * Uploads go through a persistent staging ring buffer. Buffer uploads can reserve space in the ring and write to it
+     * directly. Texture uploads are copied into the ring when they're flushed, as long as they fit within
+     * r.RHI.UploadBudgetMB for the frame. Texture uploads past the budget wait for a later frame. Buffer uploads are
+     * never deferred, because code often uploads to the same buffer every frame and expects the uploads to land in
+     * order
      */
     class ResourceUploadQueue {
     public:
@@ -50,10 +77,23 @@ namespace render {
         template <typename DataType>
         void upload_to_buffer(BufferHandle buffer, eastl::span<DataType> data, uint32_t dest_offset = 0);
 
+        /**
+         * Reserves space for an upload to a buffer. Write the data to the returned span before the end of the frame
+         *
+         * When the staging buffer has room, the span points straight into it and there's no intermediate copy
+         *
+         * @param buffer The buffer to upload to
+         * @param size The number of bytes to upload
+         * @param dest_offset The offset in the buffer to upload to
+         * @return Where to write the data
+         */
+        eastl::span<uint8_t> reserve_buffer_upload(BufferHandle buffer, uint32_t size, uint32_t dest_offset = 0);
+
         /**
          * Enqueues a job to upload data to one mip of a texture
          *
-         * The job is batched until the backend calls flush_pending_uploads
+         * The job is batched until the backend calls flush_pending_uploads. If the frame's upload budget is used up, the
+         * job waits for a later frame. The texture's contents are undefined until then
          *
          * @param job A job representing the upload to perform
          */
@@ -62,17 +102,90 @@ namespace render {
         void enqueue(BufferUploadJob&& job);
 
         /**
-         * Flushes all pending uploads. Records them to a command list and submits it to the backend. Also issues barriers
+         * Checks if a texture has uploads that haven't been submitted yet
+         */
+        bool has_pending_uploads(TextureHandle texture) const;
+
+        /**
+         * Frees staging memory from the last time this frame index was used. The backend calls this after waiting for
+         * the frame's fence
+         */
+        void begin_frame(uint32_t frame_index);
+
+        /**
+         * Flushes pending uploads. Records them to a command list and submits it to the backend. Also issues barriers
          * to transition the uploaded-to mips to be shader readable
          */
         void flush_pending_uploads();
 
+        /**
+         * Gets statistics about the last frame's uploads
+         */
+        const UploadStats& get_stats() const;
+
     private:
+        /**
+         * A buffer upload whose data is already in a staging buffer
+         */
+        struct StagedBufferCopy {
+            BufferHandle source;
+            uint64_t source_offset;
+            BufferHandle destination;
+            uint32_t dest_offset;
+            uint32_t size;
+        };
+
+        struct PendingTextureUpload {
+            TextureUploadJob job;
+
+            /**
+             * Whether we've transitioned the mip out of VK_IMAGE_LAYOUT_UNDEFINED, so it can be bound while the upload
+             * waits for a later frame
+             */
+            bool is_layout_initialized = false;
+        };
+
+        struct StagedData {
+            BufferHandle buffer;
+            uint64_t offset;
+        };
+
         RenderBackend& backend;
 
-        eastl::vector<TextureUploadJob> texture_uploads;
+        StagingRingBuffer staging_buffer;
 
+        eastl::vector<StagedBufferCopy> staged_buffer_copies;
+
+        eastl::vector<PendingTextureUpload> texture_uploads;
+
+        /**
+         * Buffer uploads that aren't in the staging buffer yet
+         */
         eastl::vector<BufferUploadJob> buffer_uploads;
+
+        /**
+         * Staging buffers for uploads too big for the ring. Destroyed after the next flush
+         */
+        eastl::vector<BufferHandle> dedicated_staging_buffers;
+
+        UploadStats cur_frame_stats;
+
+        UploadStats last_frame_stats;
+
+        /**
+         * Copies data to the staging ring buffer. Data that's larger than the whole ring gets a staging buffer of its
+         * own
+         *
+         * @return Where the data was staged, or nullopt if the ring is full
+         */
+        eastl::optional<StagedData> stage_data(eastl::span<const uint8_t> data);
+
+        /**
+         * Copies data to a new staging buffer. Always succeeds
+         */
+        StagedData stage_data_dedicated(eastl::span<const uint8_t> data);
+
+        void validate_buffer_upload(BufferHandle buffer, size_t size, uint32_t dest_offset) const;
     };
 
     template <typename DataType>
@@ -84,27 +197,21 @@ namespace render {
     void ResourceUploadQueue::upload_to_buffer(
         const BufferHandle buffer, eastl::span<const DataType> data, const uint32_t dest_offset
     ) {
-        auto job = BufferUploadJob{
-            .buffer = buffer,
-            .data = eastl::vector<uint8_t>(data.size() * sizeof(DataType)),
-            .dest_offset = dest_offset,
-        };
-        memcpy(job.data.data(), data.data(), data.size() * sizeof(DataType));
-
-        enqueue(std::move(job));
+        const auto destination = reserve_buffer_upload(
+            buffer,
+            static_cast<uint32_t>(data.size() * sizeof(DataType)),
+            dest_offset);
+        memcpy(destination.data(), data.data(), destination.size());
     }
 
     template <typename DataType>
     void ResourceUploadQueue::upload_to_buffer(
         const BufferHandle buffer, eastl::span<DataType> data, const uint32_t dest_offset
     ) {
-        auto job = BufferUploadJob{
-            .buffer = buffer,
-            .data = eastl::vector<uint8_t>(data.size() * sizeof(DataType)),
-            .dest_offset = dest_offset,
-        };
-        memcpy(job.data.data(), data.data(), data.size() * sizeof(DataType));
-
-        enqueue(std::move(job));
+        const auto destination = reserve_buffer_upload(
+            buffer,
+            static_cast<uint32_t>(data.size() * sizeof(DataType)),
+            dest_offset);
+        memcpy(destination.data(), data.data(), destination.size());
     }
 }
@@ -1,11 +1,65 @@
 #include "scatter_upload_buffer.hpp"
 
+#include <EASTL/array.h>
+
 #include "resources/resource_path.hpp"
+#include "render/backend/constants.hpp"
 #include "render/backend/pipeline_cache.hpp"
 
 namespace render {
     static ComputePipelineHandle scatter_shader = nullptr;
 
+    constexpr auto MIN_SCATTER_ARENA_SIZE = uint64_t{64 * 1024};
+
+    struct ScatterUploadArena {
+        BufferHandle buffer = nullptr;
+
+        uint64_t size = 0;
+
+        uint64_t used = 0;
+
+        /**
+         * The frame that the arena was last used in. We reset the arena when a new frame uses it
+         */
+        uint64_t frame = eastl::numeric_limits<uint64_t>::max();
+    };
+
+    static eastl::array<ScatterUploadArena, num_in_flight_frames> scatter_arenas;
+
+    ScatterUploadAllocation allocate_scatter_upload_memory(const uint64_t size) {
+        auto& backend = RenderBackend::get();
+
+        auto& arena = scatter_arenas[backend.get_current_gpu_frame()];
+        const auto frame = backend.get_frame_count();
+        if(arena.frame != frame) {
+            // The backend waited for this frame index's fence before starting the frame, so the GPU is done with the
+            // arena's old contents
+            arena.frame = frame;
+            arena.used = 0;
+        }
+
+        auto offset = round_up(arena.used, SCATTER_UPLOAD_ALIGNMENT);
+        if(offset + size > arena.size) {
+            auto& allocator = backend.get_global_allocator();
+
+            // Passes from earlier in this frame may still read the old buffer. Destruction waits for the GPU to finish
+            // this frame
+            allocator.destroy_buffer(arena.buffer);
+
+            arena.size = eastl::max(eastl::max(arena.size * 2, size), MIN_SCATTER_ARENA_SIZE);
+            arena.buffer = allocator.create_buffer("Scatter upload arena", arena.size, BufferUsage::StagingBuffer);
+            offset = 0;
+        }
+
+        arena.used = offset + size;
+
+        return ScatterUploadAllocation{
+            .buffer = arena.buffer,
+            .data = static_cast<uint8_t*>(arena.buffer->allocation_info.pMappedData) + offset,
+            .offset = offset,
+        };
+    }
+
     ComputePipelineHandle get_scatter_upload_shader() {
         if (!scatter_shader) {
             auto& backend = RenderBackend::get();
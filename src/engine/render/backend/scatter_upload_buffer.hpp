@@ -1,135 +1,197 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
 #include <spdlog/spdlog.h>
 
 #include "core/issue_breakpoint.hpp"
+#include "core/math_utils.hpp"
 #include "render/backend/handles.hpp"
 #include "render/backend/render_backend.hpp"
 #include "render/backend/render_graph.hpp"
 #include "core/system_interface.hpp"
 
 namespace render {
-    constexpr inline auto SCATTER_BUFFER_SIZE = 1024u;
+    /**
+     * Alignment of the indices and data in the scatter upload arena
+     */
+    constexpr inline auto SCATTER_UPLOAD_ALIGNMENT = uint64_t{16};
+
+    /**
+     * Space in the scatter upload arena
+     */
+    struct ScatterUploadAllocation {
+        BufferHandle buffer = nullptr;
+
+        /**
+         * Mapped pointer to the allocation. The memory may be write-combined, so only ever write to it
+         */
+        uint8_t* data = nullptr;
+
+        /**
+         * Offset of the allocation in the buffer
+         */
+        uint64_t offset = 0;
+    };
+
+    /**
+     * Allocates staging memory for a scatter upload
+     *
+     * Each frame in flight has its own arena buffer. Allocations are bumped out of the current frame's arena, which
+     * resets the next time that frame index comes around. When a frame needs more space than its arena has, the arena
+     * gets a buffer twice as big. The old buffer lives until the GPU is done with the frame, so earlier allocations
+     * stay valid
+     */
+    ScatterUploadAllocation allocate_scatter_upload_memory(uint64_t size);
+
+    ComputePipelineHandle get_scatter_upload_shader();
 
+    /**
+     * Collects writes to single elements of a GPU buffer, and applies them all with one compute dispatch
+     *
+     * Writes are staged on the CPU. A dense index from destination element to staged slot finds earlier writes to the
+     * same element, so add_data is O(1) and never touches GPU-visible memory. The flush copies the staged indices and
+     * data to the scatter upload arena in one sequential pass
+     *
+     * There's no capacity limit, the staging grows as needed
+     */
     template <typename DataType>
     class ScatterUploadBuffer {
     public:
+        /**
+         * Stages data for one element of the destination buffer, replacing any data already staged for that element
+         */
         void add_data(uint32_t destination_index, const DataType& data_in);
 
+        /**
+         * Copies the staged writes to the scatter upload arena, adds a pass that scatters them to the destination
+         * buffer, and clears the staged writes
+         */
         void flush_to_buffer(RenderGraph& graph, BufferHandle destination_buffer);
 
         uint32_t get_size() const;
 
-        bool is_full() const;
+        /**
+         * Destination element of each staged write, in the order they were first staged
+         */
+        eastl::span<const uint32_t> get_destination_indices() const;
 
-    private:
-        uint32_t scatter_buffer_count = 0;
+        /**
+         * Data of each staged write, in the same order as get_destination_indices
+         */
+        eastl::span<const DataType> get_staged_data() const;
 
-        BufferHandle scatter_indices = {};
-        BufferHandle scatter_data = {};
+        /**
+         * Drops the staged writes. Keeps the staging's memory for the next frame
+         */
+        void clear();
 
-        eastl::span<uint32_t> indices = {};
-        eastl::span<DataType> data = {};
+    private:
+        static constexpr auto NO_SLOT = eastl::numeric_limits<uint32_t>::max();
+
+        /**
+         * Destination element of each staged write
+         */
+        eastl::vector<uint32_t> destination_indices;
+
+        /**
+         * Data of each staged write
+         */
+        eastl::vector<DataType> staged_data;
+
+        /**
+         * Index into the staged writes for each destination element, or NO_SLOT if nothing is staged for the element
+         */
+        eastl::vector<uint32_t> slots;
     };
 
-    ComputePipelineHandle get_scatter_upload_shader();
-
     template <typename DataType>
     void ScatterUploadBuffer<DataType>::add_data(const uint32_t destination_index, const DataType& data_in) {
-        auto& backend = RenderBackend::get();
-        auto& allocator = backend.get_global_allocator();
-
-        if (!scatter_indices) {
-            scatter_indices = allocator.create_buffer(
-                "Primitive scatter indices",
-                SCATTER_BUFFER_SIZE * sizeof(uint32_t),
-                BufferUsage::StagingBuffer
-            );
-            indices = eastl::span{
-                static_cast<uint32_t*>(scatter_indices->allocation_info.pMappedData), SCATTER_BUFFER_SIZE
-            };
-            eastl::fill(indices.begin(), indices.end(), eastl::numeric_limits<uint32_t>::max());
+        if(destination_index >= slots.size()) {
+            slots.resize(destination_index + 1, NO_SLOT);
         }
 
-        // Check if we already have this index in the buffer. if so, overwrite the data for that index. If not, increment
-        // the count because we're adding to the buffer
-        auto write_index = scatter_buffer_count;
-        if (auto itr = eastl::find(indices.begin(), indices.end(), destination_index); itr != indices.end()) {
-            write_index = itr - indices.begin();
-        }
-        else {
-            scatter_buffer_count++;
-        }
-        indices[write_index] = destination_index;
-
-        if (!scatter_data) {
-            scatter_data = allocator.create_buffer(
-                "Primitive scatter data",
-                SCATTER_BUFFER_SIZE * sizeof(DataType),
-                BufferUsage::StagingBuffer
-            );
-            data = eastl::span{ static_cast<DataType*>(scatter_data->allocation_info.pMappedData), SCATTER_BUFFER_SIZE };
+        auto& slot = slots[destination_index];
+        if(slot != NO_SLOT) {
+            staged_data[slot] = data_in;
+            return;
         }
 
-        data[write_index] = data_in;
+        slot = static_cast<uint32_t>(destination_indices.size());
+        destination_indices.push_back(destination_index);
+        staged_data.push_back(data_in);
     }
 
     template <typename DataType>
     uint32_t ScatterUploadBuffer<DataType>::get_size() const {
-        return scatter_buffer_count;
+        return static_cast<uint32_t>(destination_indices.size());
+    }
+
+    template <typename DataType>
+    eastl::span<const uint32_t> ScatterUploadBuffer<DataType>::get_destination_indices() const {
+        return destination_indices;
+    }
+
+    template <typename DataType>
+    eastl::span<const DataType> ScatterUploadBuffer<DataType>::get_staged_data() const {
+        return staged_data;
     }
 
     template <typename DataType>
-    bool ScatterUploadBuffer<DataType>::is_full() const {
-        return scatter_buffer_count >= SCATTER_BUFFER_SIZE;
+    void ScatterUploadBuffer<DataType>::clear() {
+        for(const auto destination_index : destination_indices) {
+            slots[destination_index] = NO_SLOT;
+        }
+        destination_indices.clear();
+        staged_data.clear();
     }
 
     template <typename DataType>
     void ScatterUploadBuffer<DataType>::flush_to_buffer(RenderGraph& graph, BufferHandle destination_buffer) {
-        if (!scatter_indices || !scatter_data) {
+        if(destination_indices.empty()) {
             return;
         }
 
+        const auto count = static_cast<uint32_t>(destination_indices.size());
+        const auto indices_size = count * sizeof(uint32_t);
+        const auto data_offset = round_up<uint64_t>(indices_size, SCATTER_UPLOAD_ALIGNMENT);
+        const auto data_size = count * sizeof(DataType);
+
+        const auto allocation = allocate_scatter_upload_memory(data_offset + data_size);
+        std::memcpy(allocation.data, destination_indices.data(), indices_size);
+        std::memcpy(allocation.data + data_offset, staged_data.data(), data_size);
+
+        const auto scatter_shader = get_scatter_upload_shader();
+
         graph.add_pass(
             ComputePass{
                 .name = "Flush scatter buffer",
                 .buffers = {
-                    {scatter_indices, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT},
-                    {scatter_data, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT},
+                    {allocation.buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT},
                     {destination_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT},
                 },
-                .execute = [destination_buffer, indices = scatter_indices, data = scatter_data, count = scatter_buffer_count
-                ](CommandBuffer& commands) {
-                    commands.flush_buffer(indices);
-                    commands.flush_buffer(data);
+                .execute = [destination_buffer, allocation, data_offset, count,
+                    scatter_shader](CommandBuffer& commands) {
+                    commands.flush_buffer(allocation.buffer);
 
-                    commands.bind_buffer_reference(0, indices);
-                    commands.bind_buffer_reference(2, data);
+                    commands.bind_buffer_reference(0, allocation.buffer, allocation.offset);
+                    commands.bind_buffer_reference(2, allocation.buffer, allocation.offset + data_offset);
                     commands.bind_buffer_reference(4, destination_buffer);
                     commands.set_push_constant(6, count);
                     const auto data_size = static_cast<uint32_t>(sizeof(DataType) / sizeof(uint32_t));
                     commands.set_push_constant(7, data_size);
 
-                    commands.bind_pipeline(get_scatter_upload_shader());
+                    commands.bind_pipeline(scatter_shader);
 
                     commands.dispatch((count + 63) / 64, 1, 1);
-
-                    // Free the existing scatter upload buffers. We'll allocate new ones when/if we need them
-
-                    auto& backend = RenderBackend::get();
-                    auto& resources = backend.get_global_allocator();
-
-                    resources.destroy_buffer(indices);
-                    resources.destroy_buffer(data);
                 }
             }
         );
 
-        scatter_indices = {};
-        scatter_data = {};
-        scatter_buffer_count = 0;
+        clear();
     }
 }
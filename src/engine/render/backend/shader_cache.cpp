@@ -0,0 +1,403 @@
+#include "shader_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+#include <vulkan/vk_enum_string_helper.h>
+
+#include "console/cvars.hpp"
+#include "core/system_interface.hpp"
+#include "extern/cityhash/city_hash.hpp"
+#include "render/backend/pipeline_builder.hpp"
+#include "render/backend/render_backend.hpp"
+#include "resources/resource_path.hpp"
+
+namespace render {
+    static std::shared_ptr<spdlog::logger> logger;
+
+    /**
+     * 'SREF'
+     */
+    constexpr uint32_t REFLECTION_CACHE_MAGIC = 0x46455253;
+
+    /**
+     * Bump this whenever the file layout or the reflection code changes, so that stale results get thrown away
+     */
+    constexpr uint32_t REFLECTION_CACHE_VERSION = 1;
+
+    struct ReflectionCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        /**
+         * Unsized descriptor arrays get this many elements, so the results depend on it
+         */
+        uint32_t sampled_image_count;
+        uint32_t num_reflections;
+        uint64_t data_size;
+        uint64_t data_hash;
+    };
+
+    static uint32_t get_sampled_image_count() {
+        return static_cast<uint32_t>(*CVarSystem::Get()->GetIntCVar("r.RHI.SampledImageCount"));
+    }
+
+    static uint64_t get_reflection_key(const ShaderHandle shader, const VkShaderStageFlagBits stage) {
+        const auto stage_value = static_cast<uint32_t>(stage);
+        return CityHash64WithSeed(reinterpret_cast<const char*>(&stage_value), sizeof(stage_value), shader->hash);
+    }
+
+    static void write_u32(eastl::vector<std::byte>& data, const uint32_t value) {
+        const auto offset = data.size();
+        data.resize(offset + sizeof(uint32_t));
+        std::memcpy(data.data() + offset, &value, sizeof(uint32_t));
+    }
+
+    static void write_u64(eastl::vector<std::byte>& data, const uint64_t value) {
+        const auto offset = data.size();
+        data.resize(offset + sizeof(uint64_t));
+        std::memcpy(data.data() + offset, &value, sizeof(uint64_t));
+    }
+
+    static void write_reflection(eastl::vector<std::byte>& data, const ShaderReflection& reflection) {
+        write_u32(data, static_cast<uint32_t>(reflection.descriptor_sets.size()));
+        for(const auto& set : reflection.descriptor_sets) {
+            write_u32(data, set.has_variable_count_binding ? 1 : 0);
+            write_u32(data, static_cast<uint32_t>(set.bindings.size()));
+            for(const auto& binding : set.bindings) {
+                write_u32(data, binding.binding);
+                write_u32(data, static_cast<uint32_t>(binding.descriptorType));
+                write_u32(data, binding.descriptorCount);
+                write_u32(data, binding.stageFlags);
+                write_u32(data, binding.is_read_only ? 1 : 0);
+            }
+        }
+
+        write_u32(data, static_cast<uint32_t>(reflection.push_constants.size()));
+        for(const auto& range : reflection.push_constants) {
+            write_u32(data, range.stageFlags);
+            write_u32(data, range.offset);
+            write_u32(data, range.size);
+        }
+
+        write_u32(data, static_cast<uint32_t>(reflection.inputs.size()));
+        for(const auto& input : reflection.inputs) {
+            write_u32(data, input.location);
+            write_u32(data, static_cast<uint32_t>(input.name.size()));
+            const auto offset = data.size();
+            data.resize(offset + input.name.size());
+            std::memcpy(data.data() + offset, input.name.data(), input.name.size());
+        }
+    }
+
+    /**
+     * Reads values out of a byte span, failing once it runs out of bytes
+     */
+    class ReflectionCacheReader {
+    public:
+        explicit ReflectionCacheReader(const eastl::span<const std::byte> data_in) : data{data_in} {}
+
+        bool read(uint32_t& value) {
+            return read_bytes(&value, sizeof(uint32_t));
+        }
+
+        bool read(uint64_t& value) {
+            return read_bytes(&value, sizeof(uint64_t));
+        }
+
+        bool read(eastl::string& value, const uint32_t size) {
+            if(size > data.size() - offset) {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char*>(data.data() + offset), size);
+            offset += size;
+            return true;
+        }
+
+        /**
+         * Checks a count against the number of bytes left, so that a corrupt count can't make us allocate gigabytes
+         */
+        bool is_count_sane(const uint32_t count, const size_t min_element_size) const {
+            return count <= (data.size() - offset) / min_element_size;
+        }
+
+    private:
+        eastl::span<const std::byte> data;
+
+        size_t offset = 0;
+
+        bool read_bytes(void* value, const size_t size) {
+            if(size > data.size() - offset) {
+                return false;
+            }
+            std::memcpy(value, data.data() + offset, size);
+            offset += size;
+            return true;
+        }
+    };
+
+    static bool read_reflection(ReflectionCacheReader& reader, ShaderReflection& reflection) {
+        auto num_sets = 0u;
+        if(!reader.read(num_sets) || num_sets > reflection.descriptor_sets.max_size()) {
+            return false;
+        }
+        reflection.descriptor_sets.resize(num_sets);
+        for(auto& set : reflection.descriptor_sets) {
+            auto has_variable_count_binding = 0u;
+            auto num_bindings = 0u;
+            if(!reader.read(has_variable_count_binding) || !reader.read(num_bindings) ||
+                num_bindings > set.bindings.max_size()) {
+                return false;
+            }
+            set.has_variable_count_binding = has_variable_count_binding != 0;
+            set.bindings.resize(num_bindings);
+            for(auto& binding : set.bindings) {
+                auto descriptor_type = 0u;
+                auto is_read_only = 0u;
+                if(!reader.read(binding.binding) || !reader.read(descriptor_type) ||
+                    !reader.read(binding.descriptorCount) || !reader.read(binding.stageFlags) ||
+                    !reader.read(is_read_only)) {
+                    return false;
+                }
+                binding.descriptorType = static_cast<VkDescriptorType>(descriptor_type);
+                binding.pImmutableSamplers = nullptr;
+                binding.is_read_only = is_read_only != 0;
+            }
+        }
+
+        auto num_push_constants = 0u;
+        if(!reader.read(num_push_constants) || num_push_constants > reflection.push_constants.max_size()) {
+            return false;
+        }
+        reflection.push_constants.resize(num_push_constants);
+        for(auto& range : reflection.push_constants) {
+            if(!reader.read(range.stageFlags) || !reader.read(range.offset) || !reader.read(range.size)) {
+                return false;
+            }
+        }
+
+        auto num_inputs = 0u;
+        if(!reader.read(num_inputs) || !reader.is_count_sane(num_inputs, sizeof(uint32_t) * 2)) {
+            return false;
+        }
+        reflection.inputs.resize(num_inputs);
+        for(auto& input : reflection.inputs) {
+            auto name_size = 0u;
+            if(!reader.read(input.location) || !reader.read(name_size) || !reader.read(input.name, name_size)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ShaderCache::ShaderCache(RenderBackend& backend_in) : backend{backend_in} {
+        if(logger == nullptr) {
+            logger = SystemInterface::get().get_logger("ShaderCache");
+        }
+
+        load_reflection();
+    }
+
+    ShaderCache::~ShaderCache() {
+        destroy_modules();
+    }
+
+    ShaderHandle ShaderCache::load_shader(const ResourcePath& shader_path) {
+        ZoneScoped;
+
+        const auto path_string = shader_path.to_string();
+        {
+            auto lock = std::unique_lock{mutex};
+            if(const auto itr = shaders_by_path.find(path_string); itr != shaders_by_path.end()) {
+                return itr->second;
+            }
+        }
+
+        const auto instructions = SystemInterface::get().load_file(shader_path);
+        if(!instructions) {
+            throw std::runtime_error{fmt::format("Could not load shader {}", shader_path)};
+        }
+
+        const auto shader = add_shader(std::string_view{path_string.c_str(), path_string.size()}, *instructions);
+
+        auto lock = std::unique_lock{mutex};
+        shaders_by_path.emplace(path_string, shader);
+
+        return shader;
+    }
+
+    ShaderHandle ShaderCache::add_shader(const std::string_view name, const eastl::span<const std::byte> instructions) {
+        ZoneScoped;
+
+        const auto hash = CityHash64(reinterpret_cast<const char*>(instructions.data()), instructions.size());
+
+        auto lock = std::unique_lock{mutex};
+
+        if(const auto itr = shaders.find(hash); itr != shaders.end()) {
+            logger->trace("Shader {} has the same code as {}", name, itr->second->name.c_str());
+            return itr->second.get();
+        }
+
+        auto shader = eastl::make_unique<Shader>();
+        shader->name.assign(name.data(), name.size());
+        shader->hash = hash;
+        shader->instructions.assign(instructions.begin(), instructions.end());
+
+        const auto [itr, inserted] = shaders.emplace(hash, eastl::move(shader));
+        return itr->second.get();
+    }
+
+    ShaderReflection ShaderCache::get_reflection(const ShaderHandle shader, const VkShaderStageFlagBits stage) {
+        ZoneScoped;
+
+        const auto key = get_reflection_key(shader, stage);
+        {
+            auto lock = std::unique_lock{mutex};
+            if(const auto itr = reflections.find(key); itr != reflections.end()) {
+                return itr->second;
+            }
+        }
+
+        // Reflect without holding the lock, so that other threads can load and reflect other shaders meanwhile. If
+        // two threads reflect the same shader at once, they get the same results and the second one is a no-op
+        auto reflection = reflect_shader(
+            shader->instructions,
+            std::string_view{shader->name.c_str(), shader->name.size()},
+            stage);
+
+        auto lock = std::unique_lock{mutex};
+        reflections.emplace(key, reflection);
+        has_new_reflections = true;
+
+        return reflection;
+    }
+
+    VkShaderModule ShaderCache::get_module(const ShaderHandle shader) {
+        auto lock = std::unique_lock{mutex};
+
+        if(shader->module != VK_NULL_HANDLE) {
+            return shader->module;
+        }
+
+        const auto create_info = VkShaderModuleCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = shader->instructions.size(),
+            .pCode = reinterpret_cast<const uint32_t*>(shader->instructions.data()),
+        };
+
+        auto module = VkShaderModule{};
+        const auto result = vkCreateShaderModule(backend.get_device(), &create_info, nullptr, &module);
+        if(result != VK_SUCCESS) {
+            throw std::runtime_error{
+                fmt::format("Could not create shader module {}: {}", shader->name.c_str(), string_VkResult(result))};
+        }
+        backend.set_object_name(module, shader->name.c_str());
+
+        shaders.at(shader->hash)->module = module;
+
+        return module;
+    }
+
+    void ShaderCache::save_reflection() const {
+        ZoneScoped;
+
+        auto lock = std::unique_lock{mutex};
+
+        if(!has_new_reflections) {
+            return;
+        }
+
+        auto data = eastl::vector<std::byte>{};
+        for(const auto& [key, reflection] : reflections) {
+            write_u64(data, key);
+            write_reflection(data, reflection);
+        }
+
+        const auto header = ReflectionCacheHeader{
+            .magic = REFLECTION_CACHE_MAGIC,
+            .version = REFLECTION_CACHE_VERSION,
+            .sampled_image_count = get_sampled_image_count(),
+            .num_reflections = static_cast<uint32_t>(reflections.size()),
+            .data_size = data.size(),
+            .data_hash = CityHash64(reinterpret_cast<const char*>(data.data()), data.size()),
+        };
+
+        auto file = eastl::vector<std::byte>(sizeof(ReflectionCacheHeader) + data.size());
+        std::memcpy(file.data(), &header, sizeof(ReflectionCacheHeader));
+        if(!data.empty()) {
+            std::memcpy(file.data() + sizeof(ReflectionCacheHeader), data.data(), data.size());
+        }
+
+        SystemInterface::get().write_file(
+            get_reflection_cache_path(),
+            file.data(),
+            static_cast<uint32_t>(file.size()));
+
+        logger->info("Saved reflection for {} shader stages", reflections.size());
+    }
+
+    void ShaderCache::destroy_modules() {
+        auto lock = std::unique_lock{mutex};
+
+        for(auto& [hash, shader] : shaders) {
+            if(shader->module != VK_NULL_HANDLE) {
+                vkDestroyShaderModule(backend.get_device(), shader->module, nullptr);
+                shader->module = VK_NULL_HANDLE;
+            }
+        }
+    }
+
+    std::filesystem::path ShaderCache::get_reflection_cache_path() {
+        return SystemInterface::get().get_cache_folder() / "shaders" / "reflection.bin";
+    }
+
+    void ShaderCache::load_reflection() {
+        ZoneScoped;
+
+        const auto filepath = get_reflection_cache_path();
+        auto file = std::ifstream{filepath, std::ios::binary | std::ios::ate};
+        if(!file.is_open()) {
+            return;
+        }
+
+        auto contents = eastl::vector<std::byte>(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+
+        if(contents.size() < sizeof(ReflectionCacheHeader)) {
+            logger->info("Ignoring reflection cache {}: too small", filepath.string());
+            return;
+        }
+
+        auto header = ReflectionCacheHeader{};
+        std::memcpy(&header, contents.data(), sizeof(ReflectionCacheHeader));
+        if(header.magic != REFLECTION_CACHE_MAGIC || header.version != REFLECTION_CACHE_VERSION ||
+            header.sampled_image_count != get_sampled_image_count()) {
+            logger->info("Ignoring reflection cache {}: out of date", filepath.string());
+            return;
+        }
+
+        const auto data = eastl::span<const std::byte>{contents}.subspan(sizeof(ReflectionCacheHeader));
+        if(header.data_size != data.size() ||
+            CityHash64(reinterpret_cast<const char*>(data.data()), data.size()) != header.data_hash) {
+            logger->warn("Ignoring reflection cache {}: corrupt", filepath.string());
+            return;
+        }
+
+        auto reader = ReflectionCacheReader{data};
+        for(auto i = 0u; i < header.num_reflections; i++) {
+            auto key = uint64_t{0};
+            auto reflection = ShaderReflection{};
+            if(!reader.read(key) || !read_reflection(reader, reflection)) {
+                logger->warn("Ignoring reflection cache {}: corrupt", filepath.string());
+                reflections.clear();
+                return;
+            }
+            reflections.emplace(key, eastl::move(reflection));
+        }
+
+        logger->debug("Loaded reflection for {} shader stages", reflections.size());
+    }
+}
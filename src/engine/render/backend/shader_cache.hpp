@@ -0,0 +1,131 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+
+#include <EASTL/fixed_vector.h>
+#include <EASTL/span.h>
+#include <EASTL/string.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <volk.h>
+
+#include "render/backend/descriptor_set_info.hpp"
+#include "render/backend/handles.hpp"
+
+class ResourcePath;
+
+namespace render {
+    class RenderBackend;
+
+    struct ShaderInputVariable {
+        eastl::string name;
+
+        uint32_t location = 0;
+
+        bool operator==(const ShaderInputVariable& other) const = default;
+    };
+
+    /**
+     * What one shader stage needs from its pipeline layout
+     */
+    struct ShaderReflection {
+        /**
+         * Descriptor sets by set index. Sets and bindings that the shader doesn't use are present but empty, with no
+         * stage flags
+         */
+        eastl::fixed_vector<DescriptorSetInfo, 8> descriptor_sets;
+
+        eastl::fixed_vector<VkPushConstantRange, 4> push_constants;
+
+        /**
+         * Named inputs. Only filled in for vertex shaders
+         */
+        eastl::vector<ShaderInputVariable> inputs;
+    };
+
+    /**
+     * SPIR-V code that's been loaded once and is shared by every pipeline that uses it
+     */
+    struct Shader {
+        eastl::string name;
+
+        /**
+         * CityHash64 of the SPIR-V
+         */
+        uint64_t hash = 0;
+
+        eastl::vector<std::byte> instructions;
+
+        /**
+         * Created the first time a pipeline needs it
+         */
+        VkShaderModule module = VK_NULL_HANDLE;
+    };
+
+    /**
+     * Loads SPIR-V, reflects it, and makes shader modules, doing each at most once per unique shader
+     *
+     * Shaders are keyed by a hash of their contents, so two files with the same code share one shader. Reflection
+     * results are keyed by content hash and stage. We save them to the cache folder on shutdown and load them at
+     * startup, so that an unchanged shader is never reflected twice
+     *
+     * Safe to use from multiple threads
+     */
+    class ShaderCache {
+    public:
+        explicit ShaderCache(RenderBackend& backend_in);
+
+        ~ShaderCache();
+
+        ShaderCache(const ShaderCache& other) = delete;
+        ShaderCache& operator=(const ShaderCache& other) = delete;
+
+        /**
+         * Loads a shader from a file, or returns the shader we already loaded from that file. Throws if the file can't
+         * be read
+         */
+        ShaderHandle load_shader(const ResourcePath& shader_path);
+
+        /**
+         * Adds a shader from some SPIR-V in memory, or returns the existing shader with the same code
+         */
+        ShaderHandle add_shader(std::string_view name, eastl::span<const std::byte> instructions);
+
+        ShaderReflection get_reflection(ShaderHandle shader, VkShaderStageFlagBits stage);
+
+        VkShaderModule get_module(ShaderHandle shader);
+
+        /**
+         * Writes the reflection results to the cache folder, if there's anything new
+         */
+        void save_reflection() const;
+
+        /**
+         * Destroys all the shader modules. Call before destroying the device
+         */
+        void destroy_modules();
+
+    private:
+        RenderBackend& backend;
+
+        mutable std::mutex mutex;
+
+        eastl::unordered_map<uint64_t, eastl::unique_ptr<Shader>> shaders;
+
+        eastl::unordered_map<eastl::string, ShaderHandle> shaders_by_path;
+
+        /**
+         * Reflection results, keyed by a hash of the shader's hash and stage
+         */
+        eastl::unordered_map<uint64_t, ShaderReflection> reflections;
+
+        bool has_new_reflections = false;
+
+        static std::filesystem::path get_reflection_cache_path();
+
+        void load_reflection();
+    };
+}
@@ -0,0 +1,66 @@
+#include "staging_ring_buffer.hpp"
+
+#include "render/backend/resource_allocator.hpp"
+
+namespace render {
+    static uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    StagingRingBuffer::StagingRingBuffer(ResourceAllocator& allocator, const uint64_t size_in) :
+        StagingRingBuffer{allocator.create_buffer("Staging ring buffer", size_in, BufferUsage::StagingBuffer)} {}
+
+    StagingRingBuffer::StagingRingBuffer(const BufferHandle buffer_in) :
+        buffer{buffer_in},
+        mapped_data{static_cast<uint8_t*>(buffer_in->allocation_info.pMappedData)},
+        size{buffer_in->create_info.size} {}
+
+    void StagingRingBuffer::begin_frame(const uint32_t frame_index) {
+        // The last frame's allocations end at the current head
+        frame_heads[cur_frame_index] = head;
+
+        // The GPU has finished with everything allocated before this frame index's last head
+        tail = eastl::max(tail, frame_heads[frame_index]);
+        cur_frame_index = frame_index;
+    }
+
+    eastl::optional<StagingAllocation> StagingRingBuffer::allocate(
+        const uint64_t allocation_size, const uint64_t alignment
+        ) {
+        if(allocation_size > size) {
+            return eastl::nullopt;
+        }
+
+        auto start = align_up(head, alignment);
+
+        // Allocations can't wrap around the end of the buffer, skip to the start instead
+        if(start % size + allocation_size > size) {
+            start = align_up(start, size);
+        }
+
+        const auto end = start + allocation_size;
+        if(end - tail > size) {
+            return eastl::nullopt;
+        }
+
+        head = end;
+
+        return StagingAllocation{
+            .data = mapped_data + start % size,
+            .offset = start % size,
+            .size = allocation_size,
+        };
+    }
+
+    BufferHandle StagingRingBuffer::get_buffer() const {
+        return buffer;
+    }
+
+    uint64_t StagingRingBuffer::get_size() const {
+        return size;
+    }
+
+    uint64_t StagingRingBuffer::get_bytes_in_use() const {
+        return head - tail;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EASTL/array.h>
+#include <EASTL/optional.h>
+
+#include "render/backend/constants.hpp"
+#include "render/backend/handles.hpp"
+
+namespace render {
+    class ResourceAllocator;
+
+    /**
+     * Space in the staging ring buffer
+     */
+    struct StagingAllocation {
+        /**
+         * Mapped pointer to the allocation. Write the data to upload here
+         */
+        uint8_t* data = nullptr;
+
+        /**
+         * Offset of the allocation in the staging buffer. Use this as the source offset of the copy command
+         */
+        uint64_t offset = 0;
+
+        uint64_t size = 0;
+    };
+
+    /**
+     * A persistently-mapped staging buffer that's used as a ring
+     *
+     * Allocations are tagged with the frame they were made in. They're freed when that frame's fence is signalled,
+     * which the backend tells us about through begin_frame
+     */
+    class StagingRingBuffer {
+    public:
+        StagingRingBuffer(ResourceAllocator& allocator, uint64_t size_in);
+
+        /**
+         * Uses a buffer that's already persistently mapped. The ring covers the whole buffer
+         */
+        explicit StagingRingBuffer(BufferHandle buffer_in);
+
+        StagingRingBuffer(const StagingRingBuffer& other) = delete;
+        StagingRingBuffer& operator=(const StagingRingBuffer& other) = delete;
+
+        /**
+         * Frees the allocations from the last time this frame index was used. Call after waiting for the frame's fence
+         */
+        void begin_frame(uint32_t frame_index);
+
+        /**
+         * Allocates some space in the ring
+         *
+         * @return The allocation, or nullopt if the ring is too full. Try again next frame
+         */
+        eastl::optional<StagingAllocation> allocate(uint64_t allocation_size, uint64_t alignment);
+
+        BufferHandle get_buffer() const;
+
+        uint64_t get_size() const;
+
+        uint64_t get_bytes_in_use() const;
+
+    private:
+        BufferHandle buffer = nullptr;
+
+        uint8_t* mapped_data = nullptr;
+
+        uint64_t size = 0;
+
+        /**
+         * Where the next allocation goes. This and tail count up forever, the real offset is modulo the ring size
+         */
+        uint64_t head = 0;
+
+        /**
+         * Start of the oldest allocation that's still in use
+         */
+        uint64_t tail = 0;
+
+        uint32_t cur_frame_index = 0;
+
+        /**
+         * Value of head at the end of each frame
+         */
+        eastl::array<uint64_t, num_in_flight_frames> frame_heads = {};
+    };
+}
@@ -61,6 +61,8 @@ namespace render {
 
         available_handles.resize(sampled_image_count);
         std::iota(available_handles.begin(), available_handles.end(), 0);
+
+        srvs.resize(sampled_image_count);
     }
 
     TextureDescriptorPool::~TextureDescriptorPool() {
@@ -74,6 +76,37 @@ namespace render {
         const auto handle = available_handles.back();
         available_handles.pop_back();
 
+        srvs[handle] = {.texture = texture, .sampler = sampler};
+        srvs_by_texture.emplace(texture, handle);
+
+        write_descriptor(handle, texture, sampler);
+
+        return handle;
+    }
+
+    void TextureDescriptorPool::free_descriptor(const uint32_t handle) {
+        const auto [begin, end] = srvs_by_texture.equal_range(srvs[handle].texture);
+        for(auto itr = begin; itr != end; ++itr) {
+            if(itr->second == handle) {
+                srvs_by_texture.erase(itr);
+                break;
+            }
+        }
+        srvs[handle] = {};
+
+        available_handles.push_back(handle);
+    }
+
+    void TextureDescriptorPool::refresh_texture_srvs(const TextureHandle texture) {
+        const auto [begin, end] = srvs_by_texture.equal_range(texture);
+        for(auto itr = begin; itr != end; ++itr) {
+            write_descriptor(itr->second, texture, srvs[itr->second].sampler);
+        }
+    }
+
+    void TextureDescriptorPool::write_descriptor(
+        const uint32_t handle, const TextureHandle texture, const VkSampler sampler
+        ) {
         auto image_info = eastl::make_unique<VkDescriptorImageInfo>(
             VkDescriptorImageInfo{
                 .sampler = sampler,
@@ -94,12 +127,6 @@ namespace render {
 
         image_infos.emplace_back(std::move(image_info));
         pending_writes.push_back(write);
-
-        return handle;
-    }
-
-    void TextureDescriptorPool::free_descriptor(const uint32_t handle) {
-        available_handles.push_back(handle);
     }
 
     void TextureDescriptorPool::commit_descriptors() {
@@ -2,6 +2,7 @@
 
 #include <EASTL/vector.h>
 #include <EASTL/unique_ptr.h>
+#include <EASTL/unordered_map.h>
 
 #include "render/backend/descriptor_set_builder.hpp"
 #include "render/backend/handles.hpp"
@@ -22,6 +23,13 @@ namespace render {
 
         void free_descriptor(uint32_t handle);
 
+        /**
+         * \brief Rewrites every descriptor that points to the texture
+         *
+         * Use this after a texture's image or view changes, such as when the texture streamer swaps in new mips
+         */
+        void refresh_texture_srvs(TextureHandle texture);
+
         /**
          * \brief Commits pending descriptor writes
          *
@@ -40,6 +48,20 @@ namespace render {
 
         eastl::vector<uint32_t> available_handles;
 
+        struct TextureSrv {
+            TextureHandle texture = nullptr;
+            VkSampler sampler = VK_NULL_HANDLE;
+        };
+
+        /**
+         * What each descriptor points to, indexed by descriptor handle
+         */
+        eastl::vector<TextureSrv> srvs;
+
+        eastl::unordered_multimap<TextureHandle, uint32_t> srvs_by_texture;
+
+        void write_descriptor(uint32_t handle, TextureHandle texture, VkSampler sampler);
+
         eastl::vector<eastl::unique_ptr<VkDescriptorImageInfo>> image_infos;
         eastl::vector<VkWriteDescriptorSet> pending_writes;
     };
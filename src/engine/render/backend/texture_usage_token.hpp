@@ -15,7 +15,28 @@ namespace render {
         VkAccessFlags2 access;
 
         VkImageLayout layout;
+
+        /**
+         * Mips and array layers that the usage touches. The defaults cover the whole texture
+         */
+        uint32_t first_mip = 0;
+
+        uint32_t num_mips = VK_REMAINING_MIP_LEVELS;
+
+        uint32_t first_layer = 0;
+
+        uint32_t num_layers = VK_REMAINING_ARRAY_LAYERS;
+
+        /**
+         * Whether this usage and the other usage touch exactly the same mips and layers
+         */
+        bool has_same_subresources(const TextureUsageToken& other) const;
     };
 
+    inline bool TextureUsageToken::has_same_subresources(const TextureUsageToken& other) const {
+        return first_mip == other.first_mip && num_mips == other.num_mips && first_layer == other.first_layer &&
+            num_layers == other.num_layers;
+    }
+
     using TextureUsageList = eastl::fixed_vector<TextureUsageToken, 32>;
 }
@@ -0,0 +1,483 @@
+#include "transient_resource_pool.hpp"
+
+#include <EASTL/sort.h>
+#include <tracy/Tracy.hpp>
+
+#include "console/cvars.hpp"
+#include "core/math_utils.hpp"
+#include "core/system_interface.hpp"
+#include "render/backend/constants.hpp"
+#include "render/backend/render_backend.hpp"
+
+namespace render {
+    static std::shared_ptr<spdlog::logger> logger;
+
+    static auto cvar_alias_transients = AutoCVar_Int{
+        "r.RenderGraph.AliasTransients",
+        "Whether render graph transients share memory. When off, every transient gets its own memory",
+        1
+    };
+
+    constexpr auto BYTES_PER_MB = 1024.0 * 1024.0;
+
+    TransientHeapLayout alias_transient_resources(const eastl::span<const TransientAllocationRequest> requests) {
+        ZoneScoped;
+
+        auto layout = TransientHeapLayout{};
+        layout.offsets.resize(requests.size(), 0);
+
+        auto order = eastl::vector<uint32_t>{};
+        order.reserve(requests.size());
+        for (auto i = 0u; i < requests.size(); i++) {
+            order.push_back(i);
+        }
+        eastl::stable_sort(
+            order.begin(),
+            order.end(),
+            [&](const uint32_t a, const uint32_t b) {
+                return requests[a].size > requests[b].size;
+            });
+
+        struct MemoryRange {
+            VkDeviceSize begin;
+            VkDeviceSize end;
+        };
+
+        auto placed = eastl::vector<uint32_t>{};
+        placed.reserve(requests.size());
+        auto collisions = eastl::vector<MemoryRange>{};
+        for (const auto request_index : order) {
+            const auto& request = requests[request_index];
+
+            // Only resources that are alive at the same time as this one can collide with it
+            collisions.clear();
+            for (const auto other_index : placed) {
+                if (requests[other_index].lifetime.overlaps(request.lifetime)) {
+                    const auto begin = layout.offsets[other_index];
+                    collisions.push_back({begin, begin + requests[other_index].size});
+                }
+            }
+            eastl::sort(
+                collisions.begin(),
+                collisions.end(),
+                [](const MemoryRange& a, const MemoryRange& b) {
+                    return a.begin < b.begin;
+                });
+
+            // First fit. The offset is always past the end of every range we've looked at, so it only needs to clear
+            // the next one
+            auto offset = VkDeviceSize{0};
+            for (const auto& range : collisions) {
+                if (offset + request.size <= range.begin) {
+                    break;
+                }
+                offset = eastl::max(offset, round_up(range.end, request.alignment));
+            }
+
+            layout.offsets[request_index] = offset;
+            layout.size = eastl::max(layout.size, offset + request.size);
+            layout.alignment = eastl::max(layout.alignment, request.alignment);
+            placed.push_back(request_index);
+        }
+
+        return layout;
+    }
+
+    eastl::vector<uint32_t> find_aliasing_conflicts(const eastl::span<const TransientPlacement> placements) {
+        auto conflicts = eastl::vector<uint32_t>{};
+        auto is_moved = eastl::vector<bool>(placements.size(), false);
+        for (auto i = 0u; i < placements.size(); i++) {
+            const auto& placement = placements[i];
+            for (auto j = 0u; j < i; j++) {
+                const auto& other = placements[j];
+                if (is_moved[j]) {
+                    continue;
+                }
+
+                const auto shares_memory = placement.offset < other.offset + other.size &&
+                    other.offset < placement.offset + placement.size;
+                if (shares_memory && placement.lifetime.overlaps(other.lifetime)) {
+                    is_moved[i] = true;
+                    conflicts.push_back(i);
+                    break;
+                }
+            }
+        }
+
+        return conflicts;
+    }
+
+    static bool is_same_texture(const TextureCreateInfo& a, const TextureCreateInfo& b) {
+        return a.format == b.format &&
+            a.resolution == b.resolution &&
+            a.num_mips == b.num_mips &&
+            a.usage == b.usage &&
+            a.num_layers == b.num_layers &&
+            a.view_format == b.view_format &&
+            a.flags == b.flags &&
+            a.usage_flags == b.usage_flags;
+    }
+
+    bool TransientResourcePool::TransientResource::is_texture() const {
+        return buffer_size == 0;
+    }
+
+    TransientResourcePool::TransientResourcePool(RenderBackend& backend_in) :
+        backend{backend_in}, allocator{backend_in.get_global_allocator()} {
+        if (logger == nullptr) {
+            logger = SystemInterface::get().get_logger("TransientResourcePool");
+        }
+    }
+
+    TransientResourcePool::~TransientResourcePool() {
+        for (auto& resource : resources) {
+            destroy_resource(resource);
+        }
+
+        allocator.free_memory(texture_heap);
+        allocator.free_memory(buffer_heap);
+    }
+
+    TextureHandle TransientResourcePool::get_texture(
+        const eastl::string_view name, const TextureCreateInfo& create_info
+    ) {
+        auto* resource = find_resource(name);
+        if (resource != nullptr && resource->requested_this_frame) {
+            throw std::runtime_error{fmt::format("Transient {} was already created this frame", name)};
+        }
+
+        // The texture changed, probably because the render resolution changed. Start over
+        if (resource != nullptr && !(resource->is_texture() &&
+            is_same_texture(resource->texture_create_info, create_info))) {
+            destroy_resource(*resource);
+            *resource = TransientResource{};
+        }
+
+        if (resource == nullptr) {
+            resource = &resources.emplace_back();
+        }
+
+        if (resource->texture == nullptr) {
+            resource->name = name;
+            resource->texture_create_info = create_info;
+            create_standalone(*resource);
+        }
+
+        resource->requested_this_frame = true;
+
+        return resource->texture;
+    }
+
+    BufferHandle TransientResourcePool::get_buffer(
+        const eastl::string_view name, const size_t size, const BufferUsage usage
+    ) {
+        // The allocator rounds tiny buffers up anyways, and a size of 0 would make this look like a texture
+        const auto buffer_size = eastl::max(size, static_cast<size_t>(256));
+
+        auto* resource = find_resource(name);
+        if (resource != nullptr && resource->requested_this_frame) {
+            throw std::runtime_error{fmt::format("Transient {} was already created this frame", name)};
+        }
+
+        if (resource != nullptr && !(resource->buffer_size == buffer_size && resource->buffer_usage == usage)) {
+            destroy_resource(*resource);
+            *resource = TransientResource{};
+        }
+
+        if (resource == nullptr) {
+            resource = &resources.emplace_back();
+        }
+
+        if (resource->buffer == nullptr) {
+            resource->name = name;
+            resource->buffer_size = buffer_size;
+            resource->buffer_usage = usage;
+            create_standalone(*resource);
+        }
+
+        resource->requested_this_frame = true;
+
+        return resource->buffer;
+    }
+
+    RenderGraphTransients TransientResourcePool::resolve_aliasing_conflicts(const RenderGraphLifetimes& lifetimes) {
+        ZoneScoped;
+
+        for (auto& resource : resources) {
+            if (!resource.requested_this_frame) {
+                continue;
+            }
+
+            resource.frame_lifetime = {};
+            if (resource.is_texture()) {
+                if (const auto itr = lifetimes.textures.find(resource.texture); itr != lifetimes.textures.end()) {
+                    resource.frame_lifetime = itr->second;
+                }
+            } else {
+                if (const auto itr = lifetimes.buffers.find(resource.buffer); itr != lifetimes.buffers.end()) {
+                    resource.frame_lifetime = itr->second;
+                }
+            }
+        }
+
+        auto moved = RenderGraphTransients{};
+        move_conflicting_resources(true, moved);
+        move_conflicting_resources(false, moved);
+
+        has_conflict = !moved.textures.empty() || !moved.buffers.empty();
+        if (has_conflict) {
+            logger->debug(
+                "{} transient textures and {} transient buffers don't fit the current layout, moving them into their "
+                "own memory for this frame",
+                moved.textures.size(),
+                moved.buffers.size());
+        }
+
+        return moved;
+    }
+
+    void TransientResourcePool::end_frame() {
+        ZoneScoped;
+
+        frame_index++;
+
+        // A resource that hasn't been through a layout solve means the set of transients changed, so we throw away the
+        // lifetimes we've accumulated and start over from this frame
+        auto has_new_resources = false;
+        for (auto& resource : resources) {
+            if (!resource.requested_this_frame) {
+                continue;
+            }
+
+            resource.lifetime.merge(resource.frame_lifetime);
+            resource.last_requested_frame = frame_index;
+
+            has_new_resources |= !resource.is_laid_out;
+        }
+
+        // Keep resources around for a few frames after their last use, so that a resource that's only used every
+        // other frame doesn't get recreated over and over
+        const auto num_resources = resources.size();
+        for (auto itr = resources.begin(); itr != resources.end();) {
+            if (frame_index - itr->last_requested_frame > num_in_flight_frames) {
+                destroy_resource(*itr);
+                itr = resources.erase(itr);
+            } else {
+                ++itr;
+            }
+        }
+        const auto removed_resources = resources.size() != num_resources;
+
+        // When the graph changes shape, two resources that share memory may now be alive at the same time. Solve a new
+        // layout from every lifetime we've seen since the last solve, so graphs that alternate between two shapes
+        // settle on a layout that works for both
+        if (has_new_resources || removed_resources || has_conflict) {
+            if (has_new_resources || removed_resources) {
+                for (auto& resource : resources) {
+                    resource.lifetime = resource.frame_lifetime;
+                }
+            }
+
+            stats = {};
+
+            allocator.free_memory(texture_heap);
+            allocator.free_memory(buffer_heap);
+            texture_heap = solve_layout(true);
+            buffer_heap = solve_layout(false);
+
+            for (const auto& resource : resources) {
+                if (resource.is_texture()) {
+                    stats.num_textures++;
+                } else {
+                    stats.num_buffers++;
+                }
+
+                stats.requested_bytes += resource.size;
+                if (!resource.is_placed) {
+                    stats.allocated_bytes += resource.size;
+                }
+            }
+
+            report_memory_usage();
+        }
+
+        for (auto& resource : resources) {
+            resource.requested_this_frame = false;
+        }
+        has_conflict = false;
+    }
+
+    const TransientMemoryStats& TransientResourcePool::get_stats() const {
+        return stats;
+    }
+
+    void TransientResourcePool::report_memory_usage() const {
+        const auto requested_mb = static_cast<double>(stats.requested_bytes) / BYTES_PER_MB;
+        const auto allocated_mb = static_cast<double>(stats.allocated_bytes) / BYTES_PER_MB;
+        logger->info(
+            "{} transient textures and {} transient buffers need {:.1f} MB, aliased into {:.1f} MB. Saved {:.1f} MB",
+            stats.num_textures,
+            stats.num_buffers,
+            requested_mb,
+            allocated_mb,
+            requested_mb - allocated_mb);
+
+        for (const auto& resource : resources) {
+            if (resource.is_placed) {
+                logger->debug(
+                    "{:<24} | {:>10} bytes at offset {:>10} | batches {} to {}",
+                    resource.name,
+                    resource.size,
+                    resource.offset,
+                    resource.lifetime.first_batch,
+                    resource.lifetime.last_batch);
+            } else {
+                logger->debug("{:<24} | {:>10} bytes in its own memory", resource.name, resource.size);
+            }
+        }
+    }
+
+    TransientResourcePool::TransientResource* TransientResourcePool::find_resource(const eastl::string_view name) {
+        for (auto& resource : resources) {
+            if (resource.name == name) {
+                return &resource;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void TransientResourcePool::move_conflicting_resources(const bool textures, RenderGraphTransients& moved) {
+        auto placements = eastl::vector<TransientPlacement>{};
+        auto placed_resources = eastl::vector<TransientResource*>{};
+        for (auto& resource : resources) {
+            if (resource.is_placed && resource.requested_this_frame && resource.is_texture() == textures) {
+                placements.push_back({resource.offset, resource.size, resource.frame_lifetime});
+                placed_resources.push_back(&resource);
+            }
+        }
+
+        for (const auto index : find_aliasing_conflicts(placements)) {
+            auto& resource = *placed_resources[index];
+            move_to_own_memory(resource);
+            if (textures) {
+                moved.textures.insert(resource.texture);
+            } else {
+                moved.buffers.insert(resource.buffer);
+            }
+        }
+    }
+
+    void TransientResourcePool::move_to_own_memory(TransientResource& resource) {
+        // Swap the new resource into the handle that this frame's passes hold, and let the allocator destroy the placed
+        // resource once the GPU is done with it
+        if (resource.is_texture()) {
+            const auto texture = allocator.create_texture(resource.name, resource.texture_create_info);
+            eastl::swap(*resource.texture, *texture);
+            allocator.destroy_texture(texture);
+        } else {
+            const auto buffer = allocator.create_buffer(resource.name, resource.buffer_size, resource.buffer_usage);
+            eastl::swap(*resource.buffer, *buffer);
+            allocator.destroy_buffer(buffer);
+        }
+        resource.is_placed = false;
+    }
+
+    void TransientResourcePool::destroy_resource(TransientResource& resource) {
+        allocator.destroy_texture(resource.texture);
+        allocator.destroy_buffer(resource.buffer);
+        resource.texture = nullptr;
+        resource.buffer = nullptr;
+        resource.is_placed = false;
+    }
+
+    VmaAllocation TransientResourcePool::solve_layout(const bool textures) {
+        ZoneScoped;
+
+        auto requests = eastl::vector<TransientAllocationRequest>{};
+        auto placed_resources = eastl::vector<TransientResource*>{};
+        auto memory_type_bits = ~0u;
+
+        for (auto& resource : resources) {
+            if (resource.is_texture() != textures) {
+                continue;
+            }
+
+            const auto requirements = get_memory_requirements(resource);
+            resource.size = requirements.size;
+            resource.is_laid_out = true;
+
+            // Resources that can't live in the same memory type as the others get their own memory
+            if (cvar_alias_transients.get() == 0 || (memory_type_bits & requirements.memoryTypeBits) == 0) {
+                if (resource.is_placed) {
+                    destroy_resource(resource);
+                    create_standalone(resource);
+                }
+                continue;
+            }
+
+            memory_type_bits &= requirements.memoryTypeBits;
+            requests.push_back({requirements.size, requirements.alignment, resource.lifetime});
+            placed_resources.emplace_back(&resource);
+        }
+
+        if (placed_resources.empty()) {
+            return VK_NULL_HANDLE;
+        }
+
+        const auto layout = alias_transient_resources(requests);
+        const auto heap = allocator.allocate_memory(
+            VkMemoryRequirements{
+                .size = layout.size,
+                .alignment = layout.alignment,
+                .memoryTypeBits = memory_type_bits
+            });
+        stats.allocated_bytes += layout.size;
+
+        for (auto i = 0u; i < placed_resources.size(); i++) {
+            auto& resource = *placed_resources[i];
+            destroy_resource(resource);
+
+            resource.is_placed = true;
+            resource.offset = layout.offsets[i];
+            if (textures) {
+                resource.texture = allocator.create_placed_texture(
+                    resource.name,
+                    resource.texture_create_info,
+                    heap,
+                    resource.offset);
+            } else {
+                resource.buffer = allocator.create_placed_buffer(
+                    resource.name,
+                    resource.buffer_size,
+                    resource.buffer_usage,
+                    heap,
+                    resource.offset);
+            }
+        }
+
+        return heap;
+    }
+
+    VkMemoryRequirements TransientResourcePool::get_memory_requirements(const TransientResource& resource) const {
+        const auto& device = backend.get_device();
+
+        auto requirements = VkMemoryRequirements{};
+        if (resource.is_texture()) {
+            vkGetImageMemoryRequirements(device, resource.texture->image, &requirements);
+        } else {
+            vkGetBufferMemoryRequirements(device, resource.buffer->buffer, &requirements);
+        }
+
+        return requirements;
+    }
+
+    void TransientResourcePool::create_standalone(TransientResource& resource) {
+        if (resource.is_texture()) {
+            resource.texture = allocator.create_texture(resource.name, resource.texture_create_info);
+        } else {
+            resource.buffer = allocator.create_buffer(resource.name, resource.buffer_size, resource.buffer_usage);
+        }
+        resource.is_placed = false;
+    }
+}
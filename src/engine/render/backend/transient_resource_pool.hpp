@@ -0,0 +1,231 @@
+#pragma once
+
+#include <EASTL/span.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <vk_mem_alloc.h>
+
+#include "render/backend/handles.hpp"
+#include "render/backend/render_graph_compiler.hpp"
+#include "render/backend/resource_allocator.hpp"
+
+namespace render {
+    class RenderBackend;
+
+    /**
+     * A resource that needs a place in a transient heap
+     */
+    struct TransientAllocationRequest {
+        VkDeviceSize size = 0;
+
+        VkDeviceSize alignment = 1;
+
+        ResourceLifetime lifetime;
+    };
+
+    /**
+     * Where each resource lives in a transient heap
+     */
+    struct TransientHeapLayout {
+        /**
+         * Size of the whole heap
+         */
+        VkDeviceSize size = 0;
+
+        /**
+         * Largest alignment of any resource in the heap
+         */
+        VkDeviceSize alignment = 1;
+
+        /**
+         * Offset of each resource in the heap, in the same order as the requests
+         */
+        eastl::vector<VkDeviceSize> offsets;
+    };
+
+    /**
+     * Places resources in one heap, so that resources with overlapping lifetimes never overlap in memory
+     *
+     * Resources are placed largest first. Each goes at the lowest offset that doesn't collide with an already-placed
+     * resource that's alive at the same time. Not optimal, but close for the handful of render targets in a frame
+     *
+     * This does not touch the GPU, so it can run against made-up sizes and lifetimes
+     */
+    TransientHeapLayout alias_transient_resources(eastl::span<const TransientAllocationRequest> requests);
+
+    /**
+     * Where a resource sits in a transient heap, and the batches that use it this frame
+     */
+    struct TransientPlacement {
+        VkDeviceSize offset = 0;
+
+        VkDeviceSize size = 0;
+
+        ResourceLifetime lifetime;
+    };
+
+    /**
+     * Finds the resources that share memory with an earlier resource that's alive at the same time. Moving each of
+     * them into memory of its own leaves no conflicts
+     *
+     * Like alias_transient_resources, this does not touch the GPU
+     *
+     * @return Indices of the resources to move, in ascending order
+     */
+    eastl::vector<uint32_t> find_aliasing_conflicts(eastl::span<const TransientPlacement> placements);
+
+    struct TransientMemoryStats {
+        uint32_t num_textures = 0;
+
+        uint32_t num_buffers = 0;
+
+        /**
+         * Bytes the transient resources would need if each had its own memory
+         */
+        VkDeviceSize requested_bytes = 0;
+
+        /**
+         * Bytes actually allocated for the transient resources
+         */
+        VkDeviceSize allocated_bytes = 0;
+    };
+
+    /**
+     * Owns the memory behind render graph transients
+     *
+     * Descriptor sets reference a texture's views as soon as they're built, so a transient needs real memory when the
+     * graph hands it out - long before the graph knows its lifetime. The pool therefore keeps transients alive across
+     * frames, keyed by name. Once the graph is compiled, but before anything is recorded, the graph reports which
+     * batches use each transient, and the pool checks that against the current memory layout. When transients come or
+     * go, or their lifetimes change in a way the layout can't handle, the pool solves a new layout that the next frame
+     * uses. Transients that haven't been laid out yet get memory of their own
+     *
+     * When the graph changes shape (e.g. a feature gets toggled), two transients that share memory may be alive at the
+     * same time. The pool moves one of them into memory of its own for that frame, behind the same handle, and the
+     * graph rewrites the descriptor sets that reference it
+     */
+    class TransientResourcePool {
+    public:
+        explicit TransientResourcePool(RenderBackend& backend_in);
+
+        ~TransientResourcePool();
+
+        TransientResourcePool(const TransientResourcePool& other) = delete;
+        TransientResourcePool& operator=(const TransientResourcePool& other) = delete;
+
+        /**
+         * Gets the texture for this frame with the given name. Throws if the name was already used this frame
+         */
+        TextureHandle get_texture(eastl::string_view name, const TextureCreateInfo& create_info);
+
+        /**
+         * Gets the buffer for this frame with the given name. Throws if the name was already used this frame
+         */
+        BufferHandle get_buffer(eastl::string_view name, size_t size, BufferUsage usage);
+
+        /**
+         * Tells the pool which batches use each transient this frame. Transients that share memory with another
+         * transient that's alive at the same time are moved into memory of their own, behind the same handle. Call this
+         * before recording anything that uses the transients
+         *
+         * @return The transients that moved. Descriptors that reference them must be rewritten
+         */
+        RenderGraphTransients resolve_aliasing_conflicts(const RenderGraphLifetimes& lifetimes);
+
+        /**
+         * Solves a new layout if this frame's transients or lifetimes need one
+         */
+        void end_frame();
+
+        const TransientMemoryStats& get_stats() const;
+
+        void report_memory_usage() const;
+
+    private:
+        struct TransientResource {
+            eastl::string name;
+
+            TextureCreateInfo texture_create_info = {};
+
+            size_t buffer_size = 0;
+
+            BufferUsage buffer_usage = BufferUsage::StorageBuffer;
+
+            TextureHandle texture = nullptr;
+
+            BufferHandle buffer = nullptr;
+
+            /**
+             * Whether the resource lives in the shared heap. If not, it has its own memory
+             */
+            bool is_placed = false;
+
+            /**
+             * Whether the resource has been through a layout solve. False for resources we haven't seen before
+             */
+            bool is_laid_out = false;
+
+            VkDeviceSize offset = 0;
+
+            VkDeviceSize size = 0;
+
+            /**
+             * Every batch that used the resource since the layout was solved
+             */
+            ResourceLifetime lifetime;
+
+            /**
+             * The batches that used the resource this frame
+             */
+            ResourceLifetime frame_lifetime;
+
+            bool requested_this_frame = false;
+
+            uint64_t last_requested_frame = 0;
+
+            bool is_texture() const;
+        };
+
+        RenderBackend& backend;
+
+        ResourceAllocator& allocator;
+
+        eastl::vector<TransientResource> resources;
+
+        VmaAllocation texture_heap = VK_NULL_HANDLE;
+
+        VmaAllocation buffer_heap = VK_NULL_HANDLE;
+
+        uint64_t frame_index = 0;
+
+        /**
+         * Whether any transients had to move out of the shared heap this frame
+         */
+        bool has_conflict = false;
+
+        TransientMemoryStats stats;
+
+        TransientResource* find_resource(eastl::string_view name);
+
+        /**
+         * Moves the textures or the buffers that conflict with each other this frame into memory of their own
+         */
+        void move_conflicting_resources(bool textures, RenderGraphTransients& moved);
+
+        /**
+         * Swaps a resource with its own memory into the resource's handle
+         */
+        void move_to_own_memory(TransientResource& resource);
+
+        void destroy_resource(TransientResource& resource);
+
+        /**
+         * Lays out either the textures or the buffers, then recreates them in their new memory
+         */
+        VmaAllocation solve_layout(bool textures);
+
+        VkMemoryRequirements get_memory_requirements(const TransientResource& resource) const;
+
+        void create_standalone(TransientResource& resource);
+    };
+}
@@ -114,4 +114,24 @@ namespace render {
             format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
             format == VK_FORMAT_D32_SFLOAT_S8_UINT;
     }
+
+    bool is_write_access(const VkAccessFlags2 access) {
+        constexpr auto write_mask =
+            VK_ACCESS_2_SHADER_WRITE_BIT |
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_2_TRANSFER_WRITE_BIT |
+            VK_ACCESS_2_HOST_WRITE_BIT |
+            VK_ACCESS_2_MEMORY_WRITE_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+            VK_ACCESS_2_VIDEO_DECODE_WRITE_BIT_KHR |
+            VK_ACCESS_2_VIDEO_ENCODE_WRITE_BIT_KHR |
+            VK_ACCESS_2_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT |
+            VK_ACCESS_2_COMMAND_PREPROCESS_WRITE_BIT_NV |
+            VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR |
+            VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_NV |
+            VK_ACCESS_2_MICROMAP_WRITE_BIT_EXT |
+            VK_ACCESS_2_OPTICAL_FLOW_WRITE_BIT_NV;
+        return (access & write_mask) != 0;
+    }
 }
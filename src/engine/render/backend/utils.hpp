@@ -13,4 +13,9 @@ namespace render {
     VkPipelineStageFlags to_stage_flags(TextureState state);
 
     bool is_depth_format(VkFormat format);
+
+    /**
+     * Checks if an access mask includes any kind of write
+     */
+    bool is_write_access(VkAccessFlags2 access);
 }
@@ -185,6 +185,8 @@ namespace render {
                 }
             }
 
+            auto lock = std::lock_guard{mutex};
+
             auto it = layoutCache.find(layout_info);
             if(it != layoutCache.end()) {
                 return (*it).second;
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <mutex>
+
 #include <EASTL/vector.h>
 #include <EASTL/unordered_map.h>
 #include <EASTL/optional.h>
@@ -68,6 +70,11 @@ namespace render {
                 }
             };
 
+            /**
+             * Render graph passes may build descriptor sets while they're recorded on worker threads
+             */
+            std::mutex mutex;
+
             eastl::unordered_map<DescriptorLayoutInfo, VkDescriptorSetLayout, DescriptorLayoutHash> layoutCache;
             VkDevice device;
         };
@@ -40,9 +40,7 @@ namespace render {
     void Bloomer::fill_bloom_tex(RenderGraph& graph, const TextureHandle scene_color) {
         ZoneScoped;
 
-        if (bloom_tex == nullptr) {
-            create_bloom_tex(scene_color);
-        }
+        create_bloom_tex(graph, scene_color);
 
         auto& backend = RenderBackend::get();
         const auto bloom_0_set = backend.get_transient_descriptor_allocator().build_set(downsample_shader, 0)
@@ -58,92 +56,57 @@ namespace render {
             }
         );
 
-        graph.add_pass(
-            {
-                .name = "Bloom",
-                .execute = [&](CommandBuffer& commands) {
-                    auto dispatch_size = bloom_tex_resolution;
-
-                    commands.bind_pipeline(downsample_shader);
-
-                    // We gonna rock down to electric avenue
-                    for (auto pass = 0u; pass < cvar_num_bloom_mips.get() - 1; pass++) {
-                        dispatch_size /= glm::uvec2{2};
-
-                        logger->trace("Bloom downsample pass {}", pass);
-                        logger->trace(
-                            "Transitioning mip {} of bloom tex from layout VK_IMAGE_LAYOUT_GENERAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL",
-                            pass
-                        );
-                        logger->trace(
-                            "Transitioning mip {} of bloom tex from layout VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_GENERAL",
-                            pass + 1
-                        );
-                        commands.barrier(
-                            {},
-                            {},
-                            {
-                                VkImageMemoryBarrier2{
-                                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                                    .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                    .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                                    .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                    .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                                    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                    .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                    .image = bloom_tex->image,
-                                    .subresourceRange = {
-                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                        .baseMipLevel = pass,
-                                        .levelCount = 1,
-                                        .baseArrayLayer = 0,
-                                        .layerCount = 1
-                                    }
-                                },
-                                VkImageMemoryBarrier2{
-                                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                                    .srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                                    .srcAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
-                                    .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                    .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                                    .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                    .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                    .image = bloom_tex->image,
-                                    .subresourceRange = {
-                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                        .baseMipLevel = pass + 1,
-                                        .levelCount = 1,
-                                        .baseArrayLayer = 0,
-                                        .layerCount = 1
-                                    }
-                                }
-                            }
-                        );
-
-                        auto set = *vkutil::DescriptorBuilder::begin(
-                                        backend,
-                                        backend.get_transient_descriptor_allocator()
-                                    )
-                                    .bind_image(
-                                        0,
-                                        {
-                                            .sampler = bilinear_sampler, .image = bloom_tex,
-                                            .image_layout = VK_IMAGE_LAYOUT_GENERAL,
-                                            .mip_level = pass
-                                        },
-                                        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                        VK_SHADER_STAGE_COMPUTE_BIT
-                                    )
-                                    .bind_image(
-                                        1,
-                                        {
-                                            .image = bloom_tex, .image_layout = VK_IMAGE_LAYOUT_GENERAL,
-                                            .mip_level = pass + 1
-                                        },
-                                        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                                        VK_SHADER_STAGE_COMPUTE_BIT
-                                    )
-                                    .build();
+        // We gonna rock down to electric avenue. Each downsample only touches two mips, so the graph can barrier just
+        // those instead of the whole chain
+        auto dispatch_size = bloom_tex_resolution;
+        for (auto pass = 0u; pass < static_cast<uint32_t>(cvar_num_bloom_mips.get() - 1); pass++) {
+            dispatch_size /= glm::uvec2{2};
+
+            const auto set = *vkutil::DescriptorBuilder::begin(backend, backend.get_transient_descriptor_allocator())
+                              .bind_image(
+                                  0,
+                                  {
+                                      .sampler = bilinear_sampler, .image = bloom_tex,
+                                      .image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                      .mip_level = pass
+                                  },
+                                  VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                  VK_SHADER_STAGE_COMPUTE_BIT
+                              )
+                              .bind_image(
+                                  1,
+                                  {
+                                      .image = bloom_tex, .image_layout = VK_IMAGE_LAYOUT_GENERAL,
+                                      .mip_level = pass + 1
+                                  },
+                                  VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                  VK_SHADER_STAGE_COMPUTE_BIT
+                              )
+                              .build();
+
+            graph.add_pass(
+                {
+                    .name = fmt::format("Bloom {}", pass + 1),
+                    .textures = {
+                        {
+                            .texture = bloom_tex,
+                            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                            .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                            .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            .first_mip = pass,
+                            .num_mips = 1
+                        },
+                        {
+                            .texture = bloom_tex,
+                            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                            .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                            .layout = VK_IMAGE_LAYOUT_GENERAL,
+                            .first_mip = pass + 1,
+                            .num_mips = 1
+                        }
+                    },
+                    .execute = [shader = downsample_shader, set, dispatch_size](CommandBuffer& commands) {
+                        commands.bind_pipeline(shader);
 
                         commands.bind_descriptor_set(0, set);
 
@@ -151,114 +114,21 @@ namespace render {
 
                         commands.clear_descriptor_set(0);
                     }
-
-                    // And then we take it higher
-                    // commands.bind_shader(upsample_shader);
-                    // 
-                    // for (auto pass = static_cast<uint32_t>(cvar_num_bloom_mips.Get() - 1); pass > 0; pass--) {
-                    //     dispatch_size *= glm::uvec2{2};
-                    // 
-                    //     logger->trace("Bloom upsample pass {}", pass);
-                    //     logger->trace("Transitioning mip {} of bloom tex from layout VK_IMAGE_LAYOUT_GENERAL to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL", pass);
-                    //     logger->trace("Transitioning mip {} of bloom tex from layout VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL to VK_IMAGE_LAYOUT_GENERAL", pass - 1);
-                    //     commands.barrier(
-                    //         {}, {}, {
-                    //             VkImageMemoryBarrier2{
-                    //                 .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    //                 .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                    //                 .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                    //                 .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                    //                 .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                    //                 .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                 .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                 .image = bloom_texture_actual.image,
-                    //                 .subresourceRange = {
-                    //                     .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    //                     .baseMipLevel = pass,
-                    //                     .levelCount = 1,
-                    //                     .baseArrayLayer = 0,
-                    //                     .layerCount = 1
-                    //                 }
-                    //             },
-                    //             VkImageMemoryBarrier2{
-                    //                 .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    //                 .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                    //                 .srcAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                    //                 .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                    //                 .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                    //                 .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                 .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                 .image = bloom_texture_actual.image,
-                    //                 .subresourceRange = {
-                    //                     .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    //                     .baseMipLevel = pass - 1,
-                    //                     .levelCount = 1,
-                    //                     .baseArrayLayer = 0,
-                    //                     .layerCount = 1
-                    //                 }
-                    //             }
-                    //         }
-                    //     );
-                    // 
-                    // 
-                    //     backend.create_frame_descriptor_builder()
-                    //            .bind_image(
-                    //                0, {
-                    //                    .sampler = bilinear_sampler, .image = bloom_tex,
-                    //                    .image_layout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                    .mip_level = pass
-                    //                }, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT
-                    //            )
-                    //            .bind_image(
-                    //                1, {
-                    //                    .image = bloom_tex, .image_layout = VK_IMAGE_LAYOUT_GENERAL,
-                    //                    .mip_level = pass - 1
-                    //                },
-                    //                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT
-                    //            )
-                    //            .build(set);
-                    // 
-                    //     commands.bind_descriptor_set(0, set);
-                    // 
-                    //     commands.dispatch((dispatch_size.x + 7) / 8, (dispatch_size.y + 7) / 8, 1);
-                    // }
-
-                    commands.clear_descriptor_set(0);
-
-                    // Put the top mip in shader read
-                    commands.barrier(
-                        {},
-                        {},
-                        {
-                            VkImageMemoryBarrier2{
-                                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                                .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_READ_BIT,
-                                .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                                .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                                .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                                .image = bloom_tex->image,
-                                .subresourceRange = {
-                                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                    .baseMipLevel = 0,
-                                    .levelCount = 6,
-                                    .baseArrayLayer = 0,
-                                    .layerCount = 1
-                                }
-                            }
-                        }
-                    );
                 }
-            }
-        );
+            );
+        }
 
-        graph.set_resource_usage(
-            TextureUsageToken{
-                .texture = bloom_tex,
-                .stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                .access = VK_ACCESS_2_SHADER_READ_BIT,
-                .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        // Put the whole chain in shader read
+        graph.add_transition_pass(
+            {
+                .textures = {
+                    {
+                        .texture = bloom_tex,
+                        .stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                        .access = VK_ACCESS_2_SHADER_READ_BIT,
+                        .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                    }
+                }
             }
         );
     }
@@ -267,15 +137,12 @@ namespace render {
         return bloom_tex;
     }
 
-    void Bloomer::create_bloom_tex(const TextureHandle scene_color) {
-        auto& backend = RenderBackend::get();
-        auto& allocator = backend.get_global_allocator();
-
+    void Bloomer::create_bloom_tex(RenderGraph& graph, const TextureHandle scene_color) {
         const auto& create_info = scene_color->create_info;
 
         bloom_tex_resolution = glm::uvec2{ create_info.extent.width, create_info.extent.height } / glm::uvec2{ 2 };
 
-        bloom_tex = allocator.create_texture(
+        bloom_tex = graph.create_transient_texture(
             "Bloom texture",
             {
                 create_info.format,
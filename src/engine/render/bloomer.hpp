@@ -18,6 +18,9 @@ namespace render {
         TextureHandle get_bloom_tex() const;
 
     private:
+        /**
+         * Render graph transient, recreated every frame
+         */
         TextureHandle bloom_tex = nullptr;
 
         ComputePipelineHandle downsample_shader;
@@ -27,6 +30,6 @@ namespace render {
 
         glm::uvec2 bloom_tex_resolution = {};
 
-        void create_bloom_tex(TextureHandle scene_color);
+        void create_bloom_tex(RenderGraph& graph, TextureHandle scene_color);
     };
 }
@@ -394,13 +394,13 @@ namespace render {
                 .clear_value = {.depthStencil = {.depth = 1.f}}
             },
             .view_mask = 0x000F,
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [&world, solid_set, masked_set, shadow_pso, shadow_masked_pso](CommandBuffer& commands) {
                 commands.bind_descriptor_set(0, solid_set);
 
-                world.draw_opaque(commands, shadow_pso);
+                world.draw_opaque(commands, shadow_pso, MeshLodSelection::Shadow);
 
                 commands.bind_descriptor_set(0, masked_set);
-                world.draw_masked(commands, shadow_masked_pso);
+                world.draw_masked(commands, shadow_masked_pso, MeshLodSelection::Shadow);
 
                 commands.clear_descriptor_set(0);
             }
@@ -433,7 +433,7 @@ namespace render {
             .name = "sun_shadow_sampling",
             .descriptor_sets = {shadowmask_set},
             .color_attachments = {{.image = shadow_mask_texture}},
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [this, shadowmask_set](CommandBuffer& commands) {
                 commands.bind_pipeline(shadow_mask_shadowmap_pso);
                 commands.bind_descriptor_set(0, shadowmask_set);
 
@@ -466,7 +466,7 @@ namespace render {
                     .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
                 }
             },
-            .execute = [&](const CommandBuffer& commands) {
+            .execute = [this](const CommandBuffer& commands) {
                 commands.clear_texture(shadow_mask_texture);
             }
         });
@@ -493,7 +493,7 @@ namespace render {
                 }
             },
             .descriptor_sets = {set},
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [this, &backend, set](CommandBuffer& commands) {
                 commands.bind_pipeline(rt_shadow_pipeline);
 
                 commands.bind_descriptor_set(0, set);
@@ -340,7 +340,7 @@ namespace render {
         graph.add_pass({
             .name = "evaluate_nrd",
             .textures = texture_usages,
-            .execute = [&](const CommandBuffer& commands) {
+            .execute = [=, this](const CommandBuffer& commands) {
                 // Fill resource snapshot
                 nrd::ResourceSnapshot resource_snapshot = {};
                 // Common
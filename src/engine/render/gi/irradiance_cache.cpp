@@ -331,7 +331,7 @@ namespace render {
                 .descriptor_sets = {set},
                 .color_attachments = {{.image = lit_scene_texture}},
                 .depth_attachment = RenderingAttachmentInfo{.image = gbuffer.depth},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [set](CommandBuffer& commands) {
                     commands.bind_descriptor_set(0, set);
                     commands.bind_pipeline(probe_debug_pso);
 
@@ -636,7 +636,7 @@ namespace render {
                 {
                     .name = "probe_tracing",
                     .descriptor_sets = {set},
-                    .execute = [&](CommandBuffer& commands) {
+                    .execute = [&backend, set, num_probes_to_update](CommandBuffer& commands) {
                         commands.bind_pipeline(probe_tracing_pipeline);
 
                         commands.bind_descriptor_set(0, set);
@@ -201,10 +201,6 @@ namespace render {
         auto& backend = RenderBackend::get();
         auto& allocator = backend.get_global_allocator();
 
-        allocator.destroy_texture(rsm_flux_target);
-        allocator.destroy_texture(rsm_normals_target);
-        allocator.destroy_texture(rsm_depth_target);
-
         allocator.destroy_texture(lpv_a_red);
         allocator.destroy_texture(lpv_a_green);
         allocator.destroy_texture(lpv_a_blue);
@@ -220,6 +216,8 @@ namespace render {
     void LightPropagationVolume::pre_render(
         RenderGraph& graph, const SceneView& view, const RenderWorld& world, TextureHandle noise_tex
     ) {
+        create_rsm_targets(graph);
+
         clear_volume(graph);
 
         update_cascade_transforms(view, world.get_sun_light());
@@ -333,7 +331,7 @@ namespace render {
                 .name = "lpv_atmospherics",
                 .descriptor_sets = {set},
                 .color_attachments = {{.image = lit_scene_handle}},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [&world, set](CommandBuffer& commands) {
                     commands.bind_pipeline(fog_pipeline);
                     commands.bind_descriptor_set(0, set);
                     commands.set_push_constant(0, world.get_fog_strength());
@@ -460,9 +458,12 @@ namespace render {
             );
             cascade_index++;
         }
+    }
 
+    void LightPropagationVolume::create_rsm_targets(RenderGraph& graph) {
+        const auto num_cascades = static_cast<uint32_t>(cascades.size());
         const auto resolution = glm::uvec2{static_cast<uint32_t>(cvar_lpv_rsm_resolution.get())};
-        rsm_flux_target = allocator.create_texture(
+        rsm_flux_target = graph.create_transient_texture(
             "RSM Flux",
             {
                 .format = VK_FORMAT_R16G16B16A16_SFLOAT,
@@ -472,7 +473,7 @@ namespace render {
                 .num_layers = num_cascades,
             }
         );
-        rsm_normals_target = allocator.create_texture(
+        rsm_normals_target = graph.create_transient_texture(
             "RSM Normals",
             {
                 .format = VK_FORMAT_R8G8B8A8_UNORM,
@@ -482,7 +483,7 @@ namespace render {
                 .num_layers = num_cascades,
             }
         );
-        rsm_depth_target = allocator.create_texture(
+        rsm_depth_target = graph.create_transient_texture(
             "RSM Depth",
             {
                 .format = VK_FORMAT_D16_UNORM,
@@ -668,12 +669,12 @@ namespace render {
                     .clear_value = {.depthStencil = {.depth = 1.f}}
                 },
                 .view_mask = view_mask,
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [&world, set, rsm_pso, rsm_masked_pso](CommandBuffer& commands) {
                     commands.bind_descriptor_set(0, set);
 
-                    world.draw_opaque(commands, rsm_pso);
+                    world.draw_opaque(commands, rsm_pso, MeshLodSelection::Shadow);
 
-                    world.draw_masked(commands, rsm_masked_pso);
+                    world.draw_masked(commands, rsm_masked_pso, MeshLodSelection::Shadow);
 
                     commands.clear_descriptor_set(0);
                 }
@@ -885,7 +886,7 @@ namespace render {
                         .layout = VK_IMAGE_LAYOUT_GENERAL,
                     }
                 },
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, &backend](CommandBuffer& commands) {
                     auto descriptor_set = *vkutil::DescriptorBuilder::begin(
                                                backend,
                                                backend.get_transient_descriptor_allocator()
@@ -964,7 +965,7 @@ namespace render {
                 .name = "Inject scene depth into GV",
                 .descriptor_sets = {set},
                 .color_attachments = {{.image = geometry_volume_handle}},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, set, depth_buffer](CommandBuffer& commands) {
                     const auto effective_resolution = depth_buffer->get_resolution();
 
                     commands.bind_descriptor_set(0, set);
@@ -1102,7 +1103,7 @@ namespace render {
         graph.add_pass(
             ComputePass{
                 .name = "Update view buffer",
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [view_matrices, view](CommandBuffer& commands) {
                     commands.update_buffer_immediate(view_matrices, view);
                 }
             }
@@ -1123,7 +1124,7 @@ namespace render {
                 .name = "Inject RSM depth into GV",
                 .descriptor_sets = {set},
                 .color_attachments = {RenderingAttachmentInfo{.image = geometry_volume_handle}},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, set, cascade_index, rsm_resolution](CommandBuffer& commands) {
                     commands.bind_descriptor_set(0, set);
 
                     commands.set_push_constant(0, cascade_index);
@@ -1167,7 +1168,7 @@ namespace render {
                 .name = "gv_visualization",
                 .descriptor_sets = {set},
                 .color_attachments = {{.image = lit_scene_texture}},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [set](CommandBuffer& commands) {
                     commands.bind_pipeline(gv_visualization_pipeline);
 
                     commands.bind_descriptor_set(0, set);
@@ -1215,7 +1216,7 @@ namespace render {
                 .color_attachments = {{.image = lit_scene}},
                 .depth_attachment = RenderingAttachmentInfo{.image = depth_buffer},
                 .view_mask = {},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, view_descriptor_set](CommandBuffer& commands) {
                     commands.bind_pipeline(vpl_visualization_pipeline);
                     commands.bind_descriptor_set(0, view_descriptor_set);
                     for(const auto& cascade : cascades) {
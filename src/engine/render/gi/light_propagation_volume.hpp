@@ -97,7 +97,8 @@ namespace render {
         ) override;
 
     private:
-        // RSM render targets. Each is an array texture with one layer per cascade
+        // RSM render targets. Each is an array texture with one layer per cascade. They're render graph transients,
+        // recreated every frame in pre_render
         TextureHandle rsm_flux_target;
         TextureHandle rsm_normals_target;
         TextureHandle rsm_depth_target;
@@ -160,6 +161,8 @@ namespace render {
 
         void init_resources(ResourceAllocator& allocator);
 
+        void create_rsm_targets(RenderGraph& graph);
+
         void update_buffers() const;
 
         /**
@@ -213,7 +213,7 @@ namespace render {
         {
             .name = "ray_traced_global_illumination",
             .descriptor_sets = {set},
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [&backend, set, render_resolution](CommandBuffer& commands) {
                 commands.bind_pipeline(rtgi_pipeline);
 
                 commands.bind_descriptor_set(0, set);
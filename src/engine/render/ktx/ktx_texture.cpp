@@ -1 +1,72 @@
 #include "ktx_texture.hpp"
+
+#include <cstring>
+
+namespace render {
+    constexpr auto KTX2_IDENTIFIER = eastl::array<uint8_t, 12>{
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    static bool is_in_bounds(const eastl::span<const std::byte> data, const uint64_t offset, const uint64_t length) {
+        return offset <= data.size() && length <= data.size() - offset;
+    }
+
+    eastl::optional<KtxTexture> KtxTexture::parse(const eastl::span<const std::byte> data) {
+        auto texture = KtxTexture{.original_data = data};
+
+        if(data.size() < sizeof(KtxTextureHeader) + sizeof(KtxTextureIndex)) {
+            return eastl::nullopt;
+        }
+
+        std::memcpy(&texture.header, data.data(), sizeof(KtxTextureHeader));
+        if(texture.header.identifier != KTX2_IDENTIFIER) {
+            return eastl::nullopt;
+        }
+
+        std::memcpy(&texture.index, data.data() + sizeof(KtxTextureHeader), sizeof(KtxTextureIndex));
+
+        // A level count of 0 means that the loader should generate mips. There's still one level in the file
+        const auto num_levels = texture.header.level_count == 0 ? 1 : texture.header.level_count;
+        const auto level_index_offset = sizeof(KtxTextureHeader) + sizeof(KtxTextureIndex);
+        if(!is_in_bounds(data, level_index_offset, num_levels * sizeof(KtxTextureLevelIndex))) {
+            return eastl::nullopt;
+        }
+
+        texture.levels.resize(num_levels);
+        std::memcpy(texture.levels.data(), data.data() + level_index_offset, num_levels * sizeof(KtxTextureLevelIndex));
+
+        const auto& index = texture.index;
+        if(!is_in_bounds(data, index.dfd_byte_offset, index.dfd_byte_length) ||
+            !is_in_bounds(data, index.kvd_byte_offset, index.kvd_byte_length) ||
+            !is_in_bounds(data, index.sgd_byte_offset, index.sgd_byte_length)) {
+            return eastl::nullopt;
+        }
+
+        texture.data_format_descriptor = data.subspan(index.dfd_byte_offset, index.dfd_byte_length);
+        texture.key_value_data = data.subspan(index.kvd_byte_offset, index.kvd_byte_length);
+        texture.supercompression_global_data = data.subspan(index.sgd_byte_offset, index.sgd_byte_length);
+
+        texture.level_images.reserve(num_levels);
+        for(const auto& level : texture.levels) {
+            if(!is_in_bounds(data, level.byte_offset, level.byte_length)) {
+                return eastl::nullopt;
+            }
+
+            texture.level_images.emplace_back(data.subspan(level.byte_offset, level.byte_length));
+        }
+
+        return texture;
+    }
+
+    bool KtxTexture::is_basis() const {
+        // Basis textures don't have a Vulkan format, since they must be transcoded
+        return header.format == VK_FORMAT_UNDEFINED &&
+            (get_supercompression_scheme() == KtxSupercompressionScheme::BasisLZ ||
+                get_supercompression_scheme() == KtxSupercompressionScheme::None ||
+                get_supercompression_scheme() == KtxSupercompressionScheme::Zstandard);
+    }
+
+    KtxSupercompressionScheme KtxTexture::get_supercompression_scheme() const {
+        return static_cast<KtxSupercompressionScheme>(header.supercompression_scheme);
+    }
+}
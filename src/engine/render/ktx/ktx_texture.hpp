@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include <EASTL/array.h>
@@ -37,20 +38,27 @@ namespace render {
         uint64_t uncompressed_byte_length;
     };
 
-    struct KtxTextureDataFormatDescriptor {
-        uint32_t dfd_total_size;
-        // Then some data for the data format descriptor
-    };
-
-    struct KtxTextureKeyValueData {
-        uint32_t key_and_value_byte_length;
-        eastl::vector<uint8_t> key_and_value;
+    enum class KtxSupercompressionScheme : uint32_t {
+        None = 0,
+        BasisLZ = 1,
+        Zstandard = 2,
+        ZLIB = 3,
     };
 
     /**
-     * Represents a KTX Texture
+     * Represents a KTX2 Texture
+     *
+     * This struct views the file data that it was parsed from - it doesn't copy anything. The file data must outlive it
      */
     struct KtxTexture {
+        /**
+         * Parses a KTX2 file. Checks that the file is well-formed, but not that we can use its format
+         *
+         * @param data The KTX2 file data
+         * @return The parsed texture, or nullopt if the data isn't a valid KTX2 file
+         */
+        static eastl::optional<KtxTexture> parse(eastl::span<const std::byte> data);
+
         /**
          * Header data
          */
@@ -62,34 +70,42 @@ namespace render {
         KtxTextureIndex index;
 
         /**
-         * Information about each mip level's data
+         * Information about each mip level's data, finest first
          */
         eastl::vector<KtxTextureLevelIndex> levels;
 
         /**
-         * Information about the data format
+         * The data format descriptor. Views the original data
          */
-        KtxTextureDataFormatDescriptor data_format_descriptor;
+        eastl::span<const std::byte> data_format_descriptor;
 
         /**
-         * Some key/value data
+         * Some key/value data. Views the original data
          */
-        eastl::optional<KtxTextureKeyValueData> key_value_data;
+        eastl::span<const std::byte> key_value_data;
 
         /**
          * The original KTX file data
          */
-        eastl::vector<uint8_t> original_data;
+        eastl::span<const std::byte> original_data;
 
         /**
          * Global data about supercompression. May have size 0 if this file doesn't use supercompression. Views the
          * original data
          */
-        eastl::span<uint8_t> supercompression_global_data;
+        eastl::span<const std::byte> supercompression_global_data;
 
         /**
-         * The data for each mip level. Views into the original data
+         * The data for each mip level, finest first. Views into the original data
          */
-        eastl::vector<eastl::span<uint8_t>> level_images;
+        eastl::vector<eastl::span<const std::byte>> level_images;
+
+        /**
+         * Whether the image data is Basis Universal - either ETC1S with BasisLZ supercompression, or UASTC. Basis data
+         * must be transcoded before the GPU can use it
+         */
+        bool is_basis() const;
+
+        KtxSupercompressionScheme get_supercompression_scheme() const;
     };
 }
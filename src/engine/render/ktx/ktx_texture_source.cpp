@@ -0,0 +1,207 @@
+#include "ktx_texture_source.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+
+#include <basisu_transcoder.h>
+#include <spdlog/logger.h>
+#include <tracy/Tracy.hpp>
+
+#include "core/system_interface.hpp"
+#include "render/backend/render_backend.hpp"
+
+namespace render {
+    static std::shared_ptr<spdlog::logger> logger;
+
+    static std::once_flag basisu_init_flag;
+
+    /**
+     * Picks the format to transcode Basis textures into, based on what the GPU supports
+     */
+    static KtxTranscodeTarget get_best_transcode_target() {
+        const auto& backend = RenderBackend::get();
+
+        if(backend.supports_bc()) {
+            return KtxTranscodeTarget::BC7;
+        }
+        if(backend.supports_astc()) {
+            return KtxTranscodeTarget::ASTC_4x4;
+        }
+        if(backend.supports_etc2()) {
+            return KtxTranscodeTarget::ETC2;
+        }
+
+        return KtxTranscodeTarget::RGBA8;
+    }
+
+    static eastl::pair<basist::transcoder_texture_format, VkFormat> get_transcode_formats(
+        const KtxTranscodeTarget target, const TextureType type
+        ) {
+        const auto srgb = type == TextureType::Color;
+
+        switch(target) {
+        case KtxTranscodeTarget::BC7:
+            return {basist::transcoder_texture_format::cTFBC7_RGBA,
+                    srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK};
+        case KtxTranscodeTarget::ASTC_4x4:
+            return {basist::transcoder_texture_format::cTFASTC_4x4_RGBA,
+                    srgb ? VK_FORMAT_ASTC_4x4_SRGB_BLOCK : VK_FORMAT_ASTC_4x4_UNORM_BLOCK};
+        case KtxTranscodeTarget::ETC2:
+            return {basist::transcoder_texture_format::cTFETC2_RGBA,
+                    srgb ? VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK : VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK};
+        case KtxTranscodeTarget::RGBA8:
+            break;
+        }
+
+        return {basist::transcoder_texture_format::cTFRGBA32,
+                srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM};
+    }
+
+    static uint64_t get_transcoded_size(
+        const basist::ktx2_image_level_info& level_info, const basist::transcoder_texture_format target
+        ) {
+        const auto num_blocks_or_pixels = basist::basis_transcoder_format_is_uncompressed(target)
+                                              ? static_cast<uint64_t>(level_info.m_orig_width) * level_info.
+                                              m_orig_height
+                                              : static_cast<uint64_t>(level_info.m_total_blocks);
+        return num_blocks_or_pixels * basist::basis_get_bytes_per_block_or_pixel(target);
+    }
+
+    KtxTextureSource::KtxTextureSource(
+        const eastl::string_view name_in, eastl::vector<std::byte>&& file_data_in, const TextureType type
+        ) :
+        KtxTextureSource{name_in, eastl::move(file_data_in), type, get_best_transcode_target()} {}
+
+    KtxTextureSource::KtxTextureSource(
+        const eastl::string_view name_in, eastl::vector<std::byte>&& file_data_in, const TextureType type,
+        const KtxTranscodeTarget target_in
+        ) :
+        name{name_in}, file_data{eastl::move(file_data_in)} {
+        ZoneScoped;
+
+        if(logger == nullptr) {
+            logger = SystemInterface::get().get_logger("KtxTextureSource");
+        }
+
+        std::call_once(basisu_init_flag, [] { basist::basisu_transcoder_init(); });
+
+        auto parsed = KtxTexture::parse(file_data);
+        if(!parsed) {
+            throw std::runtime_error{"Not a valid KTX2 file"};
+        }
+        ktx = eastl::move(*parsed);
+
+        if(ktx.header.pixel_depth > 1 || ktx.header.layer_count > 1 || ktx.header.face_count > 1) {
+            throw std::runtime_error{"Only 2D KTX2 textures are supported"};
+        }
+
+        if(!ktx.is_basis()) {
+            if(ktx.get_supercompression_scheme() != KtxSupercompressionScheme::None) {
+                throw std::runtime_error{"Supercompressed KTX2 textures must use Basis Universal"};
+            }
+
+            format = ktx.header.format;
+            mip_sizes.reserve(ktx.levels.size());
+            for(const auto& level : ktx.level_images) {
+                mip_sizes.push_back(level.size());
+            }
+            return;
+        }
+
+        const auto [target, target_format] = get_transcode_formats(target_in, type);
+        transcode_target = static_cast<uint32_t>(target);
+        format = target_format;
+
+        // Initializing the transcoder only parses the level index, it doesn't decode anything
+        auto transcoder = basist::ktx2_transcoder{};
+        if(!transcoder.init(file_data.data(), static_cast<uint32_t>(file_data.size()))) {
+            throw std::runtime_error{"Could not initialize the Basis transcoder"};
+        }
+
+        mip_sizes.reserve(transcoder.get_levels());
+        for(auto mip = 0u; mip < transcoder.get_levels(); mip++) {
+            auto level_info = basist::ktx2_image_level_info{};
+            transcoder.get_image_level_info(level_info, mip, 0, 0);
+            mip_sizes.push_back(get_transcoded_size(level_info, target));
+        }
+    }
+
+    VkFormat KtxTextureSource::get_format() const {
+        return format;
+    }
+
+    glm::uvec2 KtxTextureSource::get_resolution() const {
+        return {ktx.header.pixel_width, ktx.header.pixel_height};
+    }
+
+    uint32_t KtxTextureSource::get_num_mips() const {
+        return static_cast<uint32_t>(mip_sizes.size());
+    }
+
+    uint64_t KtxTextureSource::get_mip_size(const uint32_t mip) const {
+        return mip_sizes[mip];
+    }
+
+    eastl::vector<eastl::vector<uint8_t>> KtxTextureSource::load_mips(const uint32_t first_mip) const {
+        ZoneScoped;
+
+        if(ktx.is_basis()) {
+            return transcode_mips(first_mip);
+        }
+
+        auto mips = eastl::vector<eastl::vector<uint8_t>>{};
+        mips.reserve(get_num_mips() - first_mip);
+        for(auto mip = first_mip; mip < get_num_mips(); mip++) {
+            const auto& level = ktx.level_images[mip];
+            const auto* level_data = reinterpret_cast<const uint8_t*>(level.data());
+            mips.emplace_back(level_data, level_data + level.size());
+        }
+
+        return mips;
+    }
+
+    eastl::vector<eastl::vector<uint8_t>> KtxTextureSource::transcode_mips(const uint32_t first_mip) const {
+        ZoneScoped;
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        const auto target = static_cast<basist::transcoder_texture_format>(transcode_target);
+
+        // The transcoder keeps per-texture state, so each load gets its own
+        auto transcoder = basist::ktx2_transcoder{};
+        if(!transcoder.init(file_data.data(), static_cast<uint32_t>(file_data.size())) ||
+            !transcoder.start_transcoding()) {
+            throw std::runtime_error{"Could not start transcoding"};
+        }
+
+        auto mips = eastl::vector<eastl::vector<uint8_t>>{};
+        mips.reserve(get_num_mips() - first_mip);
+        for(auto mip = first_mip; mip < get_num_mips(); mip++) {
+            auto level_info = basist::ktx2_image_level_info{};
+            transcoder.get_image_level_info(level_info, mip, 0, 0);
+
+            const auto num_blocks_or_pixels = basist::basis_transcoder_format_is_uncompressed(target)
+                                                  ? level_info.m_orig_width * level_info.m_orig_height
+                                                  : level_info.m_total_blocks;
+
+            auto& mip_data = mips.emplace_back(mip_sizes[mip]);
+            if(!transcoder.transcode_image_level(mip, 0, 0, mip_data.data(), num_blocks_or_pixels, target)) {
+                throw std::runtime_error{"Could not transcode mip " + std::to_string(mip)};
+            }
+        }
+
+        const auto transcode_time = std::chrono::duration<double, std::milli>{
+            std::chrono::steady_clock::now() - start_time
+        };
+        logger->debug(
+            "Transcoded mips {} through {} of {} to {} in {:.2f} ms",
+            first_mip,
+            get_num_mips() - 1,
+            name,
+            basist::basis_get_format_name(target),
+            transcode_time.count());
+
+        return mips;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+
+#include "render/texture_streaming_source.hpp"
+#include "render/texture_type.hpp"
+#include "render/ktx/ktx_texture.hpp"
+
+namespace render {
+    /**
+     * Formats that we can transcode Basis Universal textures to
+     */
+    enum class KtxTranscodeTarget {
+        BC7,
+        ASTC_4x4,
+        ETC2,
+        RGBA8,
+    };
+
+    /**
+     * Streams mips from a KTX2 file
+     *
+     * Basis Universal textures (UASTC or ETC1S) are transcoded to the best block-compressed format the GPU supports:
+     * BC7, then ASTC 4x4, then ETC2. If the GPU supports none of them, we fall back to uncompressed RGBA8. Textures
+     * that already have a Vulkan format are uploaded as-is
+     *
+     * Transcoding happens in load_mips, so it runs on the texture streamer's worker threads
+     */
+    class KtxTextureSource final : public ITextureStreamingSource {
+    public:
+        /**
+         * Parses the KTX2 file and picks the format to transcode to. Must be called on the main thread, because it
+         * checks which formats the GPU supports
+         *
+         * Throws std::runtime_error if the file isn't a KTX2 file that we can use
+         *
+         * @param name Name of the texture, for logging
+         * @param file_data_in Contents of the KTX2 file
+         * @param type The type of the texture. Color textures use sRGB formats
+         */
+        KtxTextureSource(eastl::string_view name, eastl::vector<std::byte>&& file_data_in, TextureType type);
+
+        /**
+         * Parses the KTX2 file. Basis textures get transcoded to target, whether or not the GPU supports it. This
+         * doesn't touch the render backend, so it may be called on any thread
+         *
+         * Throws std::runtime_error if the file isn't a KTX2 file that we can use
+         *
+         * @param name Name of the texture, for logging
+         * @param file_data_in Contents of the KTX2 file
+         * @param type The type of the texture. Color textures use sRGB formats
+         * @param target The format to transcode Basis textures to. Ignored for other textures
+         */
+        KtxTextureSource(
+            eastl::string_view name,
+            eastl::vector<std::byte>&& file_data_in,
+            TextureType type,
+            KtxTranscodeTarget target
+        );
+
+        VkFormat get_format() const override;
+
+        glm::uvec2 get_resolution() const override;
+
+        uint32_t get_num_mips() const override;
+
+        uint64_t get_mip_size(uint32_t mip) const override;
+
+        eastl::vector<eastl::vector<uint8_t>> load_mips(uint32_t first_mip) const override;
+
+    private:
+        eastl::string name;
+
+        /**
+         * Contents of the KTX2 file. ktx views this data
+         */
+        eastl::vector<std::byte> file_data;
+
+        KtxTexture ktx;
+
+        VkFormat format = VK_FORMAT_UNDEFINED;
+
+        /**
+         * basist::transcoder_texture_format to transcode to. Only meaningful for Basis textures
+         */
+        uint32_t transcode_target = 0;
+
+        eastl::vector<uint64_t> mip_sizes;
+
+        eastl::vector<eastl::vector<uint8_t>> transcode_mips(uint32_t first_mip) const;
+    };
+}
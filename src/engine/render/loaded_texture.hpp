@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+namespace render {
+    /**
+     * RGBA8 texture data that's been decoded on the CPU, but not yet uploaded to the GPU
+     */
+    struct LoadedTexture {
+        int width = 0;
+        int height = 0;
+        eastl::vector<uint8_t> data = {};
+    };
+}
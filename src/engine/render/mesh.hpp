@@ -3,10 +3,13 @@
 #include <cstdint>
 
 #include <vk_mem_alloc.h>
+#include <EASTL/fixed_vector.h>
 
 #include "backend/acceleration_structure.hpp"
 #include "core/box.hpp"
+#include "render/mesh_lod.hpp"
 #include "render/backend/handles.hpp"
+#include "shared/primitive_data.hpp"
 
 namespace render {
     struct Mesh {
@@ -16,12 +19,29 @@ namespace render {
 
         VkDeviceSize first_index = 0;
 
+        /**
+         * Number of indices in LOD 0. The index allocation also holds the coarser LODs, after LOD 0
+         */
         uint32_t num_indices = 0;
 
+        /**
+         * Levels of detail, finest first. Every mesh has at least one
+         */
+        eastl::fixed_vector<MeshLod, MESH_MAX_LODS, false> lods;
+
         VkDeviceSize first_vertex = 0;
 
         uint32_t num_vertices = 0;
 
+        /**
+         * Meshlets that cover this mesh's indices. Meshes imported without meshlets have none
+         */
+        VmaVirtualAllocation meshlet_allocation = {};
+
+        VkDeviceSize first_meshlet = 0;
+
+        uint32_t num_meshlets = 0;
+
         /**
          * Worldspace bounds of the mesh
          */
@@ -0,0 +1,33 @@
+#include "mesh_lod.hpp"
+
+#include <glm/common.hpp>
+#include <glm/trigonometric.hpp>
+
+namespace render {
+    /**
+     * Closest we'll treat anything as being to the camera. Keeps the projected error finite when the camera is inside
+     * a primitive's bounds
+     */
+    constexpr float MIN_LOD_DISTANCE = 0.01f;
+
+    float get_lod_pixels_per_unit(const float fov_degrees, const uint32_t resolution_y) {
+        return static_cast<float>(resolution_y) / (2.f * glm::tan(glm::radians(fov_degrees) * 0.5f));
+    }
+
+    uint32_t select_mesh_lod(
+        const eastl::span<const MeshLod> lods, const float world_scale, const float distance,
+        const float pixels_per_unit, const float max_pixel_error
+        ) {
+        const auto error_to_pixels = world_scale * pixels_per_unit / glm::max(distance, MIN_LOD_DISTANCE);
+
+        auto selected_lod = 0u;
+        for(auto i = 1u; i < lods.size(); i++) {
+            if(lods[i].error * error_to_pixels > max_pixel_error) {
+                break;
+            }
+            selected_lod = i;
+        }
+
+        return selected_lod;
+    }
+}
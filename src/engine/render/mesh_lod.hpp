@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EASTL/span.h>
+
+namespace render {
+    /**
+     * One level of detail of a mesh. All of a mesh's LODs share its vertices and live in its index allocation, LOD 0
+     * first
+     */
+    struct MeshLod {
+        /**
+         * Index of the LOD's first index, relative to the start of the mesh's indices
+         */
+        uint32_t first_index = 0;
+
+        uint32_t num_indices = 0;
+
+        /**
+         * How far, in mesh-space units, this LOD's surface may deviate from LOD 0. 0 for LOD 0
+         */
+        float error = 0;
+    };
+
+    /**
+     * Which LOD a view wants a primitive to use
+     */
+    enum class MeshLodSelection {
+        /**
+         * The LOD picked for the player's view
+         */
+        MainView,
+
+        /**
+         * The coarser LOD picked for shadow and other light views
+         */
+        Shadow,
+    };
+
+    /**
+     * Calculates how many pixels one world-space unit covers at a distance of one unit from a perspective camera
+     *
+     * \param fov_degrees Vertical field of view, in degrees
+     * \param resolution_y Vertical render resolution, in pixels
+     */
+    float get_lod_pixels_per_unit(float fov_degrees, uint32_t resolution_y);
+
+    /**
+     * Picks the coarsest LOD whose error projects to no more than max_pixel_error pixels on screen
+     *
+     * \param lods The mesh's LODs, from finest to coarsest. Errors must not decrease
+     * \param world_scale Largest axis scale of the primitive's model matrix
+     * \param distance Distance from the camera to the closest point of the primitive's bounds
+     * \param pixels_per_unit Result of get_lod_pixels_per_unit for the view
+     * \param max_pixel_error Largest error that we're willing to see, in pixels
+     * \return Index of the LOD to draw
+     */
+    uint32_t select_mesh_lod(
+        eastl::span<const MeshLod> lods, float world_scale, float distance, float pixels_per_unit,
+        float max_pixel_error
+    );
+}
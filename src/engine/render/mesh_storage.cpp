@@ -7,9 +7,11 @@
 #include "console/cvars.hpp"
 #include "core/system_interface.hpp"
 #include "render/raytracing_scene.hpp"
+#include "render/vertex_packing.hpp"
 #include "render/backend/render_graph.hpp"
 #include "render/backend/resource_allocator.hpp"
 #include "render/backend/resource_upload_queue.hpp"
+#include "shared/primitive_data.hpp"
 #include "shared/vertex_data.hpp"
 #include "spdlog/cfg/helpers-inl.h"
 
@@ -19,14 +21,36 @@ namespace render {
     constexpr uint32_t max_num_vertices = 10000000;
     constexpr uint32_t max_num_indices = 10000000;
 
+    // Enough for max_num_indices worth of full meshlets, with some slack for partial ones
+    constexpr uint32_t max_num_meshlets = max_num_indices / (MESHLET_MAX_TRIANGLES * 3) * 2;
+
+    static auto cvar_vertex_data_format = AutoCVar_Enum{
+        "r.MeshStorage.VertexDataFormat",
+        "Layout of vertex normals, tangents, texcoords, and colors on the GPU. 0 = Standard (40 bytes), 1 = Packed (16 bytes). Read when the renderer starts",
+        VertexDataFormat::Standard
+    };
+
     static std::shared_ptr<spdlog::logger> logger;
 
+    /**
+     * Splits interleaved vertices into the position and data streams that we store on the GPU
+     */
+    static void split_vertices(
+        eastl::span<const StandardVertex> vertices, eastl::vector<StandardVertexPosition>& positions,
+        eastl::vector<StandardVertexData>& data
+        );
+
     MeshStorage::MeshStorage() {
         if(logger == nullptr) {
             logger = SystemInterface::get().get_logger("MeshStorage");
             logger->set_level(spdlog::level::info);
         }
 
+        vertex_data_format = cvar_vertex_data_format.get();
+        logger->info(
+            "Using {} vertex data",
+            vertex_data_format == VertexDataFormat::Packed ? "packed" : "standard");
+
         const auto& backend = RenderBackend::get();
         auto& allocator = backend.get_global_allocator();
         vertex_position_buffer = allocator.create_buffer(
@@ -36,7 +60,7 @@ namespace render {
             );
         vertex_data_buffer = allocator.create_buffer(
             "Vertex data buffer",
-            max_num_vertices * sizeof(StandardVertexData),
+            max_num_vertices * get_vertex_data_stride(),
             BufferUsage::VertexBuffer
             );
         index_buffer = allocator.create_buffer(
@@ -54,9 +78,14 @@ namespace render {
             max_num_vertices * sizeof(float4),
             BufferUsage::StorageBuffer);
 
+        meshlet_buffer = allocator.create_buffer(
+            "Meshlet buffer",
+            max_num_meshlets * sizeof(MeshletGPU),
+            BufferUsage::StorageBuffer);
+
         mesh_draw_args_buffer = allocator.create_buffer(
             "Mesh draw args buffer",
-            sizeof(VkDrawIndexedIndirectCommand) * max_num_meshes,
+            sizeof(VkDrawIndexedIndirectCommand) * max_num_meshes * MESH_MAX_LODS,
             BufferUsage::StorageBuffer);
 
         constexpr auto vertex_block_create_info = VmaVirtualBlockCreateInfo{
@@ -70,6 +99,11 @@ namespace render {
             .size = max_num_indices,
         };
         vmaCreateVirtualBlock(&index_block_create_info, &index_block);
+
+        constexpr auto meshlet_block_create_info = VmaVirtualBlockCreateInfo{
+            .size = max_num_meshlets,
+        };
+        vmaCreateVirtualBlock(&meshlet_block_create_info, &meshlet_block);
     }
 
     MeshStorage::~MeshStorage() {
@@ -79,18 +113,33 @@ namespace render {
         allocator.destroy_buffer(vertex_data_buffer);
         allocator.destroy_buffer(index_buffer);
         allocator.destroy_buffer(mesh_draw_args_buffer);
+        allocator.destroy_buffer(meshlet_buffer);
 
         // Yeet all the meshes, even if not explicitly destroyed
         vmaClearVirtualBlock(vertex_block);
         vmaClearVirtualBlock(index_block);
+        vmaClearVirtualBlock(meshlet_block);
         vmaDestroyVirtualBlock(vertex_block);
         vmaDestroyVirtualBlock(index_block);
+        vmaDestroyVirtualBlock(meshlet_block);
     }
 
     eastl::optional<MeshHandle> MeshStorage::add_mesh(
         const eastl::span<const StandardVertex> vertices, const eastl::span<const uint32_t> indices, const Box& bounds
         ) {
-        return add_mesh_internal(vertices, indices, bounds, false)
+        auto positions = eastl::vector<StandardVertexPosition>{};
+        auto data = eastl::vector<StandardVertexData>{};
+        split_vertices(vertices, positions, data);
+
+        return add_mesh(positions, data, indices, bounds);
+    }
+
+    eastl::optional<MeshHandle> MeshStorage::add_mesh(
+        const eastl::span<const StandardVertexPosition> positions,
+        const eastl::span<const StandardVertexData> vertex_data, const eastl::span<const uint32_t> indices,
+        const Box& bounds, const eastl::span<const MeshletGPU> meshlets, const eastl::span<const MeshLod> lods
+        ) {
+        return add_mesh_internal(positions, vertex_data, indices, bounds, meshlets, lods, false)
             .and_then([&](Mesh mesh) {
                 const auto handle = meshes.emplace(eastl::move(mesh));
 
@@ -104,10 +153,23 @@ namespace render {
         const eastl::span<const StandardVertex> vertices, const eastl::span<const uint32_t> indices, const Box& bounds,
         const eastl::span<const u16vec4> bone_ids, const eastl::span<const float4> weights
         ) {
-        if(vertices.size() != bone_ids.size() || vertices.size() != weights.size()) {
+        auto positions = eastl::vector<StandardVertexPosition>{};
+        auto data = eastl::vector<StandardVertexData>{};
+        split_vertices(vertices, positions, data);
+
+        return add_skeletal_mesh(positions, data, indices, bounds, bone_ids, weights);
+    }
+
+    eastl::optional<MeshHandle> MeshStorage::add_skeletal_mesh(
+        const eastl::span<const StandardVertexPosition> positions,
+        const eastl::span<const StandardVertexData> vertex_data, const eastl::span<const uint32_t> indices,
+        const Box& bounds, const eastl::span<const u16vec4> bone_ids, const eastl::span<const float4> weights,
+        const eastl::span<const MeshletGPU> meshlets, const eastl::span<const MeshLod> lods
+        ) {
+        if(positions.size() != bone_ids.size() || positions.size() != weights.size()) {
             return eastl::nullopt;
         }
-        return add_mesh_internal(vertices, indices, bounds, true)
+        return add_mesh_internal(positions, vertex_data, indices, bounds, meshlets, lods, true)
             .and_then([&](Mesh mesh) -> eastl::optional<MeshHandle> {
                 const auto allocate_info = VmaVirtualAllocationCreateInfo{
                     .size = weights.size(),
@@ -144,6 +206,9 @@ namespace render {
     void MeshStorage::free_mesh(const MeshHandle mesh) {
         vmaVirtualFree(vertex_block, mesh->vertex_allocation);
         vmaVirtualFree(index_block, mesh->index_allocation);
+        if(mesh->num_meshlets > 0) {
+            vmaVirtualFree(meshlet_block, mesh->meshlet_allocation);
+        }
 
         meshes.free_object(mesh);
     }
@@ -162,6 +227,26 @@ namespace render {
         return vertex_data_buffer;
     }
 
+    VertexDataFormat MeshStorage::get_vertex_data_format() const {
+        return vertex_data_format;
+    }
+
+    uint32_t MeshStorage::get_vertex_data_stride() const {
+        switch(vertex_data_format) {
+        case VertexDataFormat::Packed:
+            return sizeof(PackedVertexData);
+
+        case VertexDataFormat::Standard:
+            [[fallthrough]];
+        default:
+            return sizeof(StandardVertexData);
+        }
+    }
+
+    uint32_t MeshStorage::get_vertex_data_type_flags() const {
+        return vertex_data_format == VertexDataFormat::Packed ? PRIMITIVE_TYPE_PACKED_VERTICES : 0;
+    }
+
     BufferHandle MeshStorage::get_weights_buffer() const {
         return weights_buffer;
     }
@@ -178,6 +263,10 @@ namespace render {
         return mesh_draw_args_buffer;
     }
 
+    BufferHandle MeshStorage::get_meshlet_buffer() const {
+        return meshlet_buffer;
+    }
+
     void MeshStorage::bind_to_commands(const CommandBuffer& commands) const {
         commands.bind_vertex_buffer(0, vertex_position_buffer);
         commands.bind_vertex_buffer(1, vertex_data_buffer);
@@ -185,13 +274,19 @@ namespace render {
     }
 
     eastl::optional<Mesh> MeshStorage::add_mesh_internal(
-        const eastl::span<const StandardVertex> vertices, const eastl::span<const uint32_t> indices, const Box& bounds,
+        const eastl::span<const StandardVertexPosition> positions,
+        const eastl::span<const StandardVertexData> vertex_data, const eastl::span<const uint32_t> indices,
+        const Box& bounds, const eastl::span<const MeshletGPU> meshlets, const eastl::span<const MeshLod> lods,
         const bool is_dynamic
         ) const {
+        if(positions.size() != vertex_data.size() || lods.size() > MESH_MAX_LODS) {
+            return eastl::nullopt;
+        }
+
         auto mesh = Mesh{};
 
         const auto vertex_allocate_info = VmaVirtualAllocationCreateInfo{
-            .size = vertices.size(),
+            .size = positions.size(),
         };
         auto result = vmaVirtualAllocate(vertex_block,
                                          &vertex_allocate_info,
@@ -210,24 +305,20 @@ namespace render {
             return eastl::nullopt;
         }
 
-        mesh.num_vertices = static_cast<uint32_t>(vertices.size());
-        mesh.num_indices = static_cast<uint32_t>(indices.size());
+        mesh.num_vertices = static_cast<uint32_t>(positions.size());
         mesh.bounds = bounds;
 
-        auto positions = eastl::vector<StandardVertexPosition>{};
-        auto data = eastl::vector<StandardVertexData>{};
-        positions.reserve(vertices.size());
-        data.reserve(vertices.size());
+        if(lods.empty()) {
+            mesh.lods.push_back({.first_index = 0, .num_indices = static_cast<uint32_t>(indices.size()), .error = 0});
+        } else {
+            mesh.lods.assign(lods.begin(), lods.end());
+        }
+        mesh.num_indices = mesh.lods[0].num_indices;
 
-        for(const auto& vertex : vertices) {
-            positions.push_back(vertex.position);
-            data.push_back(
-                StandardVertexData{
-                    .normal = vertex.normal,
-                    .tangent = vertex.tangent,
-                    .texcoord = vertex.texcoord,
-                    .color = vertex.color,
-                });
+        if(!upload_meshlets(mesh, meshlets)) {
+            vmaVirtualFree(vertex_block, mesh.vertex_allocation);
+            vmaVirtualFree(index_block, mesh.index_allocation);
+            return eastl::nullopt;
         }
 
         const auto& backend = RenderBackend::get();
@@ -237,11 +328,33 @@ namespace render {
             positions,
             static_cast<uint32_t>(mesh.first_vertex * sizeof(StandardVertexPosition))
             );
-        upload_queue.upload_to_buffer<StandardVertexData>(
-            vertex_data_buffer,
-            data,
-            static_cast<uint32_t>(mesh.first_vertex * sizeof(StandardVertexData))
-            );
+        if(vertex_data_format == VertexDataFormat::Packed) {
+            auto packed_vertex_data = eastl::vector<PackedVertexData>(vertex_data.size());
+            pack_vertex_data(vertex_data, packed_vertex_data);
+
+            if(logger->should_log(spdlog::level::debug)) {
+                const auto error = measure_vertex_packing_error(vertex_data, packed_vertex_data);
+                logger->debug(
+                    "Packed {} vertices. Max normal error: {} degrees, max tangent error: {} degrees, max texcoord error: {}, tangent sign errors: {}",
+                    vertex_data.size(),
+                    error.max_normal_error_degrees,
+                    error.max_tangent_error_degrees,
+                    error.max_texcoord_error,
+                    error.num_tangent_sign_errors);
+            }
+
+            upload_queue.upload_to_buffer<PackedVertexData>(
+                vertex_data_buffer,
+                eastl::span<const PackedVertexData>{packed_vertex_data},
+                static_cast<uint32_t>(mesh.first_vertex * sizeof(PackedVertexData))
+                );
+        } else {
+            upload_queue.upload_to_buffer<StandardVertexData>(
+                vertex_data_buffer,
+                vertex_data,
+                static_cast<uint32_t>(mesh.first_vertex * sizeof(StandardVertexData))
+                );
+        }
         upload_queue.upload_to_buffer(index_buffer,
                                       indices,
                                       static_cast<uint32_t>(mesh.first_index * sizeof(uint32_t)));
@@ -259,25 +372,57 @@ namespace render {
         return mesh;
     }
 
-    void MeshStorage::upload_mesh_draw_args(const MeshHandle handle) {
-        if(mesh_draw_args_upload_buffer.is_full()) {
-            auto& backend = RenderBackend::get();
-            auto graph = RenderGraph{backend};
-            flush_mesh_draw_arg_uploads(graph);
-            graph.finish();
-            backend.execute_graph(graph);
+    bool MeshStorage::upload_meshlets(Mesh& mesh, const eastl::span<const MeshletGPU> meshlets) const {
+        if(meshlets.empty()) {
+            return true;
         }
 
-        mesh_draw_args_upload_buffer.add_data(
-            handle.index,
-            {
-                .indexCount = handle->num_indices,
-                .instanceCount = 1,
-                .firstIndex = static_cast<uint32_t>(handle->first_index),
-                .vertexOffset = 0,
-                // We use BDA for vertices, the pointers point to the start of the vertex allocation
-                .firstInstance = 0
-            });
+        const auto allocate_info = VmaVirtualAllocationCreateInfo{
+            .size = meshlets.size(),
+        };
+        const auto result = vmaVirtualAllocate(
+            meshlet_block,
+            &allocate_info,
+            &mesh.meshlet_allocation,
+            &mesh.first_meshlet);
+        if(result != VK_SUCCESS) {
+            logger->error("Could not allocate {} meshlets", meshlets.size());
+            return false;
+        }
+
+        mesh.num_meshlets = static_cast<uint32_t>(meshlets.size());
+
+        // Cooked meshlets index into their own primitive. The GPU wants them to index into the global index buffer
+        auto rebased_meshlets = eastl::vector<MeshletGPU>{meshlets.begin(), meshlets.end()};
+        for(auto& meshlet : rebased_meshlets) {
+            meshlet.first_index += static_cast<uint32_t>(mesh.first_index);
+        }
+
+        auto& upload_queue = RenderBackend::get().get_upload_queue();
+        upload_queue.upload_to_buffer<MeshletGPU>(
+            meshlet_buffer,
+            eastl::span<const MeshletGPU>{rebased_meshlets},
+            static_cast<uint32_t>(mesh.first_meshlet * sizeof(MeshletGPU)));
+
+        return true;
+    }
+
+    void MeshStorage::upload_mesh_draw_args(const MeshHandle handle) {
+        for(auto lod_index = 0u; lod_index < MESH_MAX_LODS; lod_index++) {
+            // Repeat the coarsest LOD, so that shaders can index by any LOD without checking how many the mesh has
+            const auto& lod = handle->lods[eastl::min(lod_index, static_cast<uint32_t>(handle->lods.size()) - 1)];
+
+            mesh_draw_args_upload_buffer.add_data(
+                handle.index * MESH_MAX_LODS + lod_index,
+                {
+                    .indexCount = lod.num_indices,
+                    .instanceCount = 1,
+                    .firstIndex = static_cast<uint32_t>(handle->first_index) + lod.first_index,
+                    .vertexOffset = 0,
+                    // We use BDA for vertices, the pointers point to the start of the vertex allocation
+                    .firstInstance = 0
+                });
+        }
     }
 
     AccelerationStructureHandle MeshStorage::create_blas_for_mesh(
@@ -292,4 +437,23 @@ namespace render {
             is_dynamic
             );
     }
+
+    void split_vertices(
+        const eastl::span<const StandardVertex> vertices, eastl::vector<StandardVertexPosition>& positions,
+        eastl::vector<StandardVertexData>& data
+        ) {
+        positions.reserve(vertices.size());
+        data.reserve(vertices.size());
+
+        for(const auto& vertex : vertices) {
+            positions.push_back(vertex.position);
+            data.push_back(
+                StandardVertexData{
+                    .normal = vertex.normal,
+                    .tangent = vertex.tangent,
+                    .texcoord = vertex.texcoord,
+                    .color = vertex.color,
+                });
+        }
+    }
 }
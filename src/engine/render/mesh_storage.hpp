@@ -10,6 +10,9 @@
 #include "core/object_pool.hpp"
 #include "render/backend/handles.hpp"
 #include "render/mesh.hpp"
+#include "render/mesh_lod.hpp"
+#include "render/vertex_data_format.hpp"
+#include "shared/meshlet.hpp"
 #include "shared/vertex_data.hpp"
 #include "shared/mesh_point.hpp"
 
@@ -19,6 +22,10 @@ namespace render {
 
     /**
      * Stores meshes
+     *
+     * Vertices are stored as a stream of positions and a stream of everything else. The format of the second stream is
+     * chosen by r.MeshStorage.VertexDataFormat when the mesh storage is created. Shaders should read it with
+     * load_vertex_data from common/vertex_packing.slangi, so they handle either format
      */
     class MeshStorage {
     public:
@@ -30,12 +37,35 @@ namespace render {
                                              eastl::span<const uint32_t> indices, const Box& bounds
             );
 
+        /**
+         * Adds a mesh whose vertices are already split into the position and data streams. This lets callers upload
+         * cooked mesh data directly, without interleaving and then splitting it again
+         *
+         * @param meshlets Optional meshlets for the mesh. Their first_index is relative to the start of indices
+         * @param lods Optional levels of detail, relative to the start of indices. If empty, all the indices are LOD 0
+         */
+        eastl::optional<MeshHandle> add_mesh(eastl::span<const StandardVertexPosition> positions,
+                                             eastl::span<const StandardVertexData> vertex_data,
+                                             eastl::span<const uint32_t> indices, const Box& bounds,
+                                             eastl::span<const MeshletGPU> meshlets = {},
+                                             eastl::span<const MeshLod> lods = {}
+            );
+
         eastl::optional<MeshHandle> add_skeletal_mesh(eastl::span<const StandardVertex> vertices,
                                                       eastl::span<const uint32_t> indices, const Box& bounds,
                                                       eastl::span<const u16vec4> bone_ids,
                                                       eastl::span<const float4> weights
             );
 
+        eastl::optional<MeshHandle> add_skeletal_mesh(eastl::span<const StandardVertexPosition> positions,
+                                                      eastl::span<const StandardVertexData> vertex_data,
+                                                      eastl::span<const uint32_t> indices, const Box& bounds,
+                                                      eastl::span<const u16vec4> bone_ids,
+                                                      eastl::span<const float4> weights,
+                                                      eastl::span<const MeshletGPU> meshlets = {},
+                                                      eastl::span<const MeshLod> lods = {}
+            );
+
         void free_mesh(MeshHandle mesh);
 
         void flush_mesh_draw_arg_uploads(RenderGraph& graph);
@@ -44,14 +74,36 @@ namespace render {
 
         BufferHandle get_vertex_data_buffer() const;
 
+        VertexDataFormat get_vertex_data_format() const;
+
+        /**
+         * Size in bytes of one element of the vertex data buffer
+         */
+        uint32_t get_vertex_data_stride() const;
+
+        /**
+         * PRIMITIVE_TYPE_ flags that describe the vertex data format, for primitives that use this storage's meshes
+         */
+        uint32_t get_vertex_data_type_flags() const;
+
         BufferHandle get_weights_buffer() const;
 
         BufferHandle get_bone_ids_buffer() const;
 
         BufferHandle get_index_buffer() const;
 
+        /**
+         * Buffer of VkDrawIndexedIndirectCommand. Each mesh has MESH_MAX_LODS commands, starting at
+         * mesh_id * MESH_MAX_LODS. Meshes with fewer LODs repeat their coarsest LOD
+         */
         BufferHandle get_draw_args_buffer() const;
 
+        /**
+         * Buffer of MeshletGPU for every mesh. A mesh's meshlets are at [first_meshlet, first_meshlet + num_meshlets),
+         * and their first_index points into the global index buffer
+         */
+        BufferHandle get_meshlet_buffer() const;
+
         void bind_to_commands(const CommandBuffer& commands) const;
 
     private:
@@ -62,6 +114,8 @@ namespace render {
 
         // vertex_block and index_block measure vertices and indices, respectively
 
+        VertexDataFormat vertex_data_format = VertexDataFormat::Standard;
+
         VmaVirtualBlock vertex_block = {};
         BufferHandle vertex_position_buffer = {};
         BufferHandle vertex_data_buffer = {};
@@ -73,11 +127,22 @@ namespace render {
         BufferHandle weights_buffer = {};
         BufferHandle bone_ids_buffer = {};
 
+        // meshlet_block measures meshlets
+
+        VmaVirtualBlock meshlet_block = {};
+        BufferHandle meshlet_buffer = {};
+
         eastl::optional<Mesh> add_mesh_internal(
-            eastl::span<const StandardVertex> vertices, eastl::span<const uint32_t> indices, const Box& bounds,
-            bool is_dynamic
+            eastl::span<const StandardVertexPosition> positions, eastl::span<const StandardVertexData> vertex_data,
+            eastl::span<const uint32_t> indices, const Box& bounds, eastl::span<const MeshletGPU> meshlets,
+            eastl::span<const MeshLod> lods, bool is_dynamic
             ) const;
 
+        /**
+         * Allocates space for the mesh's meshlets and uploads them, rebased onto the mesh's index allocation
+         */
+        bool upload_meshlets(Mesh& mesh, eastl::span<const MeshletGPU> meshlets) const;
+
         void upload_mesh_draw_args(MeshHandle handle);
 
         AccelerationStructureHandle create_blas_for_mesh(
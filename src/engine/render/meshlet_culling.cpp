@@ -0,0 +1,69 @@
+#include "meshlet_culling.hpp"
+
+#include <glm/geometric.hpp>
+#include <tracy/Tracy.hpp>
+
+namespace render {
+    static bool is_sphere_in_frustum(const float3& center, const float radius, const ViewDataGPU& view) {
+        // Same as is_in_frustum in hi_z_culling.comp.slang. center is in view space
+        auto visible = true;
+        visible = visible && center.z * view.frustum[1] - glm::abs(center.x) * view.frustum[0] > -radius;
+        visible = visible && center.z * view.frustum[3] - glm::abs(center.y) * view.frustum[2] > -radius;
+        visible = visible && -center.z + radius > view.z_near;
+
+        return visible;
+    }
+
+    static bool is_cone_backfacing(
+        const float3& center, const float radius, const float3& cone_axis, const float cone_cutoff,
+        const float3& camera_position
+        ) {
+        // From meshopt_computeMeshletBounds. All values are in world space
+        const auto to_center = center - camera_position;
+        return glm::dot(to_center, cone_axis) >= cone_cutoff * glm::length(to_center) + radius;
+    }
+
+    bool is_meshlet_visible(const MeshletGPU& meshlet, const float4x4& model, const ViewDataGPU& view) {
+        const auto world_center = float3{model * float4{float3{meshlet.bounding_sphere}, 1.f}};
+
+        // Scale the radius by the largest axis scale, so the sphere still contains the meshlet
+        const auto max_scale = glm::max(
+            glm::length(float3{model[0]}),
+            glm::max(glm::length(float3{model[1]}), glm::length(float3{model[2]})));
+        const auto radius = meshlet.bounding_sphere.w * max_scale;
+
+        const auto view_center = float3{view.view * float4{world_center, 1.f}};
+        if(!is_sphere_in_frustum(view_center, radius, view)) {
+            return false;
+        }
+
+        // A cutoff of 1 means the cone can never cull
+        const auto cone_cutoff = meshlet.cone_axis_and_cutoff.w;
+        if(cone_cutoff >= 1.f) {
+            return true;
+        }
+
+        // Non-uniform scale skews normals, so this is approximate for such meshes. It's still conservative as long as
+        // the scale is close to uniform, which it is for everything we import
+        const auto cone_axis = glm::normalize(glm::mat3{model} * float3{meshlet.cone_axis_and_cutoff});
+        const auto camera_position = float3{view.inverse_view[3]};
+
+        return !is_cone_backfacing(world_center, radius, cone_axis, cone_cutoff, camera_position);
+    }
+
+    void cull_meshlets(
+        const eastl::span<const MeshletGPU> meshlets, const float4x4& model, const ViewDataGPU& view,
+        eastl::vector<uint32_t>& visible_meshlets
+        ) {
+        ZoneScoped;
+
+        visible_meshlets.clear();
+        visible_meshlets.reserve(meshlets.size());
+
+        for(auto i = 0u; i < meshlets.size(); i++) {
+            if(is_meshlet_visible(meshlets[i], model, view)) {
+                visible_meshlets.push_back(i);
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include "shared/meshlet.hpp"
+#include "shared/prelude.h"
+#include "shared/view_data.hpp"
+
+namespace render {
+    /**
+     * CPU reference implementation of meshlet culling. GPU cluster culling must make the same decisions as this, so it
+     * doubles as the thing to compare a shader's output against when debugging
+     *
+     * A meshlet is culled if its bounding sphere is outside the view frustum - using the same plane test as
+     * hi_z_culling.comp.slang - or if its normal cone faces entirely away from the camera
+     *
+     * \param meshlet Meshlet to test, in mesh space
+     * \param model Mesh-to-world matrix
+     * \param view View to test against
+     * \return True if any part of the meshlet may be visible
+     */
+    bool is_meshlet_visible(const MeshletGPU& meshlet, const float4x4& model, const ViewDataGPU& view);
+
+    /**
+     * Culls a list of meshlets
+     *
+     * \param meshlets Meshlets to test, in mesh space
+     * \param model Mesh-to-world matrix
+     * \param view View to test against
+     * \param visible_meshlets Receives the index of each visible meshlet. Cleared first
+     */
+    void cull_meshlets(
+        eastl::span<const MeshletGPU> meshlets, const float4x4& model, const ViewDataGPU& view,
+        eastl::vector<uint32_t>& visible_meshlets
+    );
+}
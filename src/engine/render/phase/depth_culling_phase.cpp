@@ -168,12 +168,15 @@ namespace render {
              {newly_visible_objects, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT},
              {this_frame_visible_objects, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT},
          },
-         .execute = [&](CommandBuffer& commands) {
+         // view.visible_objects changes right after this pass, so we capture the current visibility list by value
+         .execute = [
+             this, &backend, primitive_buffer, last_frame_visible_objects = view.visible_objects, newly_visible_objects,
+             this_frame_visible_objects, view_constant_buffer, num_primitives](CommandBuffer& commands) {
              const auto& texture_descriptor_pool = backend.get_texture_descriptor_pool();
              commands.bind_descriptor_set(0, texture_descriptor_pool.get_descriptor_set());
 
              commands.bind_buffer_reference(0, primitive_buffer);
-             commands.bind_buffer_reference(2, view.visible_objects);
+             commands.bind_buffer_reference(2, last_frame_visible_objects);
              commands.bind_buffer_reference(4, newly_visible_objects);
              commands.bind_buffer_reference(6, this_frame_visible_objects);
 
@@ -333,7 +336,9 @@ namespace render {
                 .image = depth_buffer,
                 .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
                 .clear_value = {.depthStencil = {.depth = 0.0}}},
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [
+                &world, view_descriptor, masked_view_descriptor, solid_drawcalls, cutout_drawcalls, skinned_drawcalls,
+                depth_pso, masked_pso](CommandBuffer& commands) {
                 if(solid_drawcalls != nullptr) {
                     commands.bind_descriptor_set(0, view_descriptor);
                     world.draw_opaque(commands, solid_drawcalls, depth_pso);
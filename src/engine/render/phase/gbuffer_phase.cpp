@@ -72,7 +72,7 @@ namespace render {
                 },
                 .depth_attachment = RenderingAttachmentInfo{.image = gbuffer.depth},
                 .shading_rate_image = shading_rate,
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [&world, &view, gbuffer_set, solid_pso, masked_pso](CommandBuffer& commands) {
                     commands.bind_descriptor_set(0, gbuffer_set);
 
                     world.draw_opaque(commands, view.solid_drawcalls, solid_pso);
@@ -128,7 +128,9 @@ namespace render {
             .color_attachments = {
                 RenderingAttachmentInfo{.image = lit_scene_texture, .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR}
             },
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [
+                this, &world, &view, &sun, &gbuffer, gi, gbuffers_descriptor_set, point_lights_descriptor_set,
+                ao_texture, noise_2d](CommandBuffer& commands) {
                 commands.bind_descriptor_set(0, gbuffers_descriptor_set);
 
                 sun.render(commands, view);
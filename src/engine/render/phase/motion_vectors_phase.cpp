@@ -194,7 +194,7 @@ namespace render {
                     }
                 },
                 .depth_attachment = RenderingAttachmentInfo{.image = depth_buffer},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, &world, &view, set, masked_set, skinned_set, skinned_draws](CommandBuffer& commands) {
                     commands.bind_descriptor_set(0, set);
                     world.draw_opaque(commands, view.solid_drawcalls, motion_vectors_opaque_pso);
 
@@ -50,7 +50,7 @@ namespace render {
             {
                 .name = "rt_debug",
                 .descriptor_sets = {set},
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, &backend, set, output_texture](CommandBuffer& commands) {
                     commands.bind_pipeline(pipeline);
 
                     commands.bind_descriptor_set(0, set);
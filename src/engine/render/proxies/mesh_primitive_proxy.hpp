@@ -21,6 +21,16 @@ namespace render {
 
         size_t placed_blas_index = eastl::numeric_limits<size_t>::max();
 
+        /**
+         * LOD to draw in shadow views. The main view's LOD is in data.lod, since the GPU needs it
+         */
+        uint32_t shadow_lod = 0;
+
+        /**
+         * Whether the primitive is in RenderWorld's list of primitives whose LODs need to be picked again
+         */
+        bool needs_lod_selection = false;
+
         void calculate_worldspace_bounds();
     };
 
@@ -10,6 +10,12 @@ namespace render {
         "r.Raytracing.Enable", "Whether or not to enable raytracing", 1
     };
 
+    static auto cvar_max_tlas_refits = AutoCVar_Int{
+        "r.Raytracing.MaxTLASRefits",
+        "How many times in a row to refit the TLAS before fully rebuilding it. 0 always rebuilds",
+        60
+    };
+
     RaytracingScene::RaytracingScene(RenderWorld& world_in)
         : world{ world_in } {
         placed_blases.reserve(4096);
@@ -23,8 +29,6 @@ namespace render {
             placed_blases.emplace_back();
         }
 
-        active_blases.emplace_back(primitive->placed_blas_index);
-
         update_primitive(primitive);
     }
 
@@ -53,7 +57,13 @@ namespace render {
             .accelerationStructureReference = primitive->blas->as_address
         };
 
-        placed_blases[primitive->placed_blas_index] = instance;
+        auto& placed_blas = placed_blases[primitive->placed_blas_index];
+        if(placed_blas.accelerationStructureReference != instance.accelerationStructureReference) {
+            needs_rebuild = true;
+        }
+        placed_blas = instance;
+
+        instance_uploads.add_data(static_cast<uint32_t>(primitive->placed_blas_index), instance);
 
         set_dirty();
     }
@@ -61,8 +71,12 @@ namespace render {
     void RaytracingScene::remove_primitive(const MeshPrimitiveProxyHandle primitive) {
         if (primitive->placed_blas_index != eastl::numeric_limits<size_t>::max()) {
             inactive_blases.emplace_back(primitive->placed_blas_index);
-            active_blases.erase_first_unsorted(primitive->placed_blas_index);
 
+            // An instance with no BLAS is inactive
+            placed_blases[primitive->placed_blas_index] = {};
+            instance_uploads.add_data(static_cast<uint32_t>(primitive->placed_blas_index), {});
+
+            needs_rebuild = true;
             set_dirty();
         }
     }
@@ -203,31 +217,31 @@ namespace render {
         const auto& backend = RenderBackend::get();
         auto& allocator = backend.get_global_allocator();
 
-        const auto instances_buffer = allocator.create_buffer(
-            "RT instances buffer",
-            sizeof(VkAccelerationStructureInstanceKHR) * active_blases.size(),
-            BufferUsage::StagingBuffer);
-        allocator.destroy_buffer(instances_buffer);
+        const auto count_instance = static_cast<uint32_t>(placed_blases.size());
+        if(count_instance > instances_buffer_capacity || instances_buffer == nullptr) {
+            // Passes from earlier frames may still read the old buffer. Destruction waits for them
+            allocator.destroy_buffer(instances_buffer);
 
-        eastl::vector<VkAccelerationStructureInstanceKHR> instances;
-        instances.reserve(active_blases.size());
-        for (const auto& index : active_blases) {
-            instances.emplace_back(placed_blases[index]);
+            instances_buffer_capacity = eastl::max(eastl::max(count_instance, instances_buffer_capacity * 2), 1024u);
+            instances_buffer = allocator.create_buffer(
+                "RT instances buffer",
+                sizeof(VkAccelerationStructureInstanceKHR) * instances_buffer_capacity,
+                BufferUsage::AccelerationStructureInstances);
+
+            // The new buffer is empty, so every instance needs to go in it
+            for(auto slot = 0u; slot < count_instance; slot++) {
+                instance_uploads.add_data(slot, placed_blases[slot]);
+            }
+            needs_rebuild = true;
         }
 
-        auto* write_ptr = allocator.map_buffer(instances_buffer);
-        std::memcpy(write_ptr, instances.data(), instances.size() * sizeof(VkAccelerationStructureInstanceKHR));
+        instance_uploads.flush_to_buffer(graph, instances_buffer);
 
-        graph.add_transition_pass(
-            {
-                .buffers = {
-                    {
-                        .buffer = instances_buffer,
-                        .stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                        .access = VK_ACCESS_2_MEMORY_WRITE_BIT
-                    }
-                }
-            });
+        const auto max_refits = static_cast<uint32_t>(cvar_max_tlas_refits.get());
+        const auto should_refit = !needs_rebuild &&
+                                  acceleration_structure != nullptr &&
+                                  count_instance == num_built_instances &&
+                                  num_refits_since_build < max_refits;
 
         // Put the above into a VkAccelerationStructureGeometryKHR. We need to put the instances struct in a union and label it as instance data.
         const auto tlas_geometry = VkAccelerationStructureGeometryKHR{
@@ -245,13 +259,13 @@ namespace render {
         auto build_info = VkAccelerationStructureBuildGeometryInfoKHR{
             .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
             .type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-            .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
+            .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+                     VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
             .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
             .geometryCount = 1,
             .pGeometries = &tlas_geometry
         };
 
-        const auto count_instance = static_cast<uint32_t>(instances.size());
         auto size_info = VkAccelerationStructureBuildSizesInfoKHR{
             .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR
         };
@@ -262,33 +276,52 @@ namespace render {
             &count_instance,
             &size_info);
 
-        if(acceleration_structure) {
-            allocator.destroy_acceleration_structure(acceleration_structure);
-            acceleration_structure = nullptr;
+        if(should_refit) {
+            build_info.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+            build_info.srcAccelerationStructure = acceleration_structure->acceleration_structure;
+            num_refits_since_build++;
+
+        } else {
+            // Keep the old TLAS if the new one fits in it
+            if(size_info.accelerationStructureSize > acceleration_structure_size) {
+                if(acceleration_structure) {
+                    allocator.destroy_acceleration_structure(acceleration_structure);
+                    acceleration_structure = nullptr;
+                }
+                acceleration_structure = allocator.create_acceleration_structure(
+                    size_info.accelerationStructureSize,
+                    VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR);
+                acceleration_structure_size = size_info.accelerationStructureSize;
+            }
+
+            build_info.srcAccelerationStructure = VK_NULL_HANDLE;
+            num_built_instances = count_instance;
+            num_refits_since_build = 0;
+            needs_rebuild = false;
         }
-        acceleration_structure = allocator.create_acceleration_structure(
-            size_info.accelerationStructureSize,
-            VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR);
 
-        const auto scratch_buffer = allocator.create_buffer(
-            "TLAS build scratch buffer",
-            size_info.buildScratchSize,
-            BufferUsage::AccelerationStructure);
-        allocator.destroy_buffer(scratch_buffer);
+        const auto scratch_size = should_refit ? size_info.updateScratchSize : size_info.buildScratchSize;
+        if(scratch_size > scratch_buffer_size) {
+            allocator.destroy_buffer(scratch_buffer);
+            scratch_buffer_size = eastl::max(size_info.buildScratchSize, size_info.updateScratchSize);
+            scratch_buffer = allocator.create_buffer(
+                "TLAS build scratch buffer",
+                scratch_buffer_size,
+                BufferUsage::AccelerationStructure);
+        }
 
         // Update build information
-        build_info.srcAccelerationStructure = VK_NULL_HANDLE;
         build_info.dstAccelerationStructure = acceleration_structure->acceleration_structure;
         build_info.scratchData.deviceAddress = scratch_buffer->address;
 
         graph.add_pass(
             {
-                .name = "Build TLAS",
+                .name = should_refit ? "Refit TLAS" : "Build TLAS",
                 .buffers = {
                     {
                         .buffer = instances_buffer,
                         .stage = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-                        .access = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR
+                        .access = VK_ACCESS_SHADER_READ_BIT
                     },
                     {
                         .buffer = scratch_buffer,
@@ -302,12 +335,21 @@ namespace render {
                     }
                 },
                 .execute = [=](const CommandBuffer& commands) {
+                // The pass runs after this function returns, so point the build info at the lambda's copy of the
+                // geometry
+                auto pass_build_info = build_info;
+                pass_build_info.pGeometries = &tlas_geometry;
+
                 // Build Offsets info: n instances
                 const VkAccelerationStructureBuildRangeInfoKHR build_offset_info{count_instance, 0, 0, 0};
                 const VkAccelerationStructureBuildRangeInfoKHR* p_build_offset_info = &build_offset_info;
 
                 // Build the TLAS
-                vkCmdBuildAccelerationStructuresKHR(commands.get_vk_commands(), 1, &build_info, &p_build_offset_info);
+                vkCmdBuildAccelerationStructuresKHR(
+                    commands.get_vk_commands(),
+                    1,
+                    &pass_build_info,
+                    &p_build_offset_info);
             }
             });
 
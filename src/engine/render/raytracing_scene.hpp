@@ -1,11 +1,21 @@
 #pragma once
 
 #include "proxies/mesh_primitive_proxy.hpp"
+#include "render/backend/scatter_upload_buffer.hpp"
 
 namespace render {
     class RenderGraph;
     class RenderWorld;
 
+    /**
+     * The TLAS and the instances in it
+     *
+     * Each primitive owns a slot in a persistent instance buffer. Slots of removed primitives hold an inactive instance
+     * until a new primitive reuses them. Only instances that changed get written to the GPU
+     *
+     * When only instance transforms changed, the TLAS is refit in place. Adding, removing, or changing the BLAS of an
+     * instance needs a full build, as does refitting too many times in a row - each refit makes the TLAS a little worse
+     */
     class RaytracingScene {
     public:
         explicit RaytracingScene(RenderWorld& world_in);
@@ -43,22 +53,49 @@ namespace render {
         RenderWorld& world;
 
         /**
-         * List of all the placed blasses from all primitives
+         * Instance for each slot. Inactive slots have an instance with no BLAS, which the GPU skips
          */
         eastl::vector<VkAccelerationStructureInstanceKHR> placed_blases;
-        /**
-         * List of the blases that are active and should be added to the tlas
-         */
-        eastl::vector<size_t> active_blases;
 
         /**
          * List of blases which are inactive, and thus may be reused
          */
         eastl::vector<size_t> inactive_blases;
 
+        /**
+         * Instances that changed since the last build, waiting to be written to the instance buffer
+         */
+        ScatterUploadBuffer<VkAccelerationStructureInstanceKHR> instance_uploads;
+
+        BufferHandle instances_buffer = nullptr;
+
+        uint32_t instances_buffer_capacity = 0;
+
+        /**
+         * Used by every build and refit. Grows when a build needs more
+         */
+        BufferHandle scratch_buffer = nullptr;
+
+        VkDeviceSize scratch_buffer_size = 0;
+
         bool is_dirty = true;
+
+        /**
+         * Whether the next build can't be a refit
+         */
+        bool needs_rebuild = true;
+
+        /**
+         * Number of instances in the last full build. Refits must use the same number
+         */
+        uint32_t num_built_instances = 0;
+
+        uint32_t num_refits_since_build = 0;
+
         AccelerationStructureHandle acceleration_structure = {};
 
+        VkDeviceSize acceleration_structure_size = 0;
+
         /**
          * \brief Finishes the raytracing scene by committing pending TLAS builds. Called by finalize()
          */
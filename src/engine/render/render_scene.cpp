@@ -11,6 +11,7 @@
 #include "render/mesh_storage.hpp"
 #include "render/raytracing_scene.hpp"
 #include "render/scene_view.hpp"
+#include "render/texture_streamer.hpp"
 #include "render/backend/pipeline_cache.hpp"
 #include "render/backend/render_backend.hpp"
 #include "render/backend/resource_allocator.hpp"
@@ -23,8 +24,28 @@ namespace render {
     constexpr uint32_t MAX_NUM_PRIMITIVES = 65536;
     constexpr uint32_t MAX_NUM_POINT_LIGHTS = 8192;
 
-    RenderWorld::RenderWorld(MeshStorage& meshes_in, MaterialStorage& materials_in) :
-        meshes{meshes_in}, materials{materials_in} {
+    /**
+     * Most frames that select_lods may go without looking at every primitive. The texture streamer forgets a
+     * texture's request after WANTED_MIP_GRACE_UPDATES frames, so we ask again well before that
+     */
+    constexpr uint32_t MAX_FRAMES_BETWEEN_FULL_LOD_SELECTIONS = TextureResidencyManager::WANTED_MIP_GRACE_UPDATES / 2;
+
+    static auto cvar_lod_max_pixel_error = AutoCVar_Float{
+        "r.LOD.MaxPixelError",
+        "Largest error, in pixels, that a mesh LOD may have in the main view. 0 always draws the full-detail mesh",
+        1.0
+    };
+
+    static auto cvar_lod_shadow_error_scale = AutoCVar_Float{
+        "r.LOD.ShadowErrorScale",
+        "How much more LOD error we accept in shadow views than in the main view",
+        4.0
+    };
+
+    RenderWorld::RenderWorld(
+        MeshStorage& meshes_in, MaterialStorage& materials_in, TextureStreamer& texture_streamer_in
+        ) :
+        meshes{meshes_in}, materials{materials_in}, texture_streamer{texture_streamer_in} {
         const auto& backend = RenderBackend::get();
         auto& allocator = backend.get_global_allocator();
         primitive_data_buffer = allocator.create_buffer(
@@ -75,14 +96,19 @@ namespace render {
 
         registry.on_construct<DirectionalLightComponent>().connect<&RenderWorld::on_construct_light>(this);
         registry.on_destroy<DirectionalLightComponent>().connect<&RenderWorld::on_destroy_light>(this);
-
-        registry.on_update<TransformComponent>().connect<&RenderWorld::on_transform_update>(this);
     }
 
     void RenderWorld::tick(World& world) {
         ZoneScopedN("RenderWorld::tick");
         auto& registry = world.get_registry();
 
+        // Move the proxies of everything that moved this frame
+        const auto changed_entities = world.get_changed_transforms();
+        const auto changed_matrices = world.get_changed_local_to_world();
+        for(auto i = 0u; i < changed_entities.size(); i++) {
+            update_entity_transform(registry, changed_entities[i], changed_matrices[i]);
+        }
+
         // Set the camera's location to the location of the camera entity (if any)
         registry.view<TransformComponent, CameraComponent>().each(
             [this](const TransformComponent& transform) {
@@ -100,15 +126,6 @@ namespace render {
     }
 
     void RenderWorld::update_mesh_proxy(const MeshPrimitiveProxyHandle handle) {
-        if(primitive_upload_buffer.is_full()) {
-            auto graph = RenderGraph{RenderBackend::get()};
-
-            primitive_upload_buffer.flush_to_buffer(graph, primitive_data_buffer);
-
-            graph.finish();
-            RenderBackend::get().execute_graph(graph);
-        }
-
         handle->calculate_worldspace_bounds();
         handle->data.inverse_model = glm::inverse(handle->data.model);
         primitive_upload_buffer.add_data(handle.index, handle->data);
@@ -117,15 +134,6 @@ namespace render {
     void RenderWorld::update_mesh_proxy(const SkeletalMeshPrimitiveProxyHandle handle) {
         update_mesh_proxy(handle->mesh_proxy);
 
-        if(skeletal_data_upload_buffer.is_full()) {
-            auto graph = RenderGraph{RenderBackend::get()};
-
-            skeletal_data_upload_buffer.flush_to_buffer(graph, skeletal_data_buffer);
-
-            graph.finish();
-            RenderBackend::get().execute_graph(graph);
-        }
-
         handle->skeletal_data.bone_transforms = handle->bone_transforms->address;
 
         skeletal_data_upload_buffer.add_data(handle.index, handle->skeletal_data);
@@ -152,7 +160,8 @@ namespace render {
         primitive.data.material = material_buffer_address + primitive.material.index * sizeof(BasicPbrMaterialGpu);
         primitive.data.mesh_id = primitive.mesh.index;
         const auto transparency_mode_bit = static_cast<uint32_t>(primitive.material->first.transparency_mode);
-        primitive.data.type_flags = 1 << transparency_mode_bit;
+        primitive.data.type_flags = static_cast<uint16_t>(
+            (1 << transparency_mode_bit) | meshes.get_vertex_data_type_flags());
         primitive.data.runtime_flags = PRIMITIVE_RUNTIME_FLAG_ENABLED;
 
         const auto index_buffer_address = meshes.get_index_buffer()->address;
@@ -163,9 +172,11 @@ namespace render {
                                               StandardVertexPosition);
 
         const auto data_buffer_address = meshes.get_vertex_data_buffer()->address;
-        primitive.data.vertex_data = data_buffer_address + primitive.mesh->first_vertex * sizeof(StandardVertexData);
+        primitive.data.vertex_data = data_buffer_address + primitive.mesh->first_vertex * meshes.
+                                     get_vertex_data_stride();
 
         const auto handle = static_mesh_primitives.emplace(std::move(primitive));
+        mark_lods_dirty(handle);
 
         switch(handle->material->first.transparency_mode) {
         case TransparencyMode::Solid:
@@ -231,7 +242,7 @@ namespace render {
 
         proxy.skinned_data = allocator.create_buffer(
             "transformed_vertex_data",
-            primitive.mesh->num_vertices * sizeof(StandardVertexData),
+            primitive.mesh->num_vertices * meshes.get_vertex_data_stride(),
             BufferUsage::VertexBuffer);
         proxy.mesh_proxy->data.vertex_data = proxy.skinned_data->address;
 
@@ -284,6 +295,10 @@ namespace render {
             raytracing_world->remove_primitive(primitive);
         }
 
+        if(primitive->needs_lod_selection) {
+            lod_dirty_primitives.erase_first_unsorted(primitive);
+        }
+
         mark_proxy_inactive(primitive);
 
         static_mesh_primitives.free_object(primitive);
@@ -316,26 +331,10 @@ namespace render {
     }
 
     void RenderWorld::update_light_proxy(const PointLightProxyHandle handle) {
-        if(point_light_uploads.is_full()) {
-            auto graph = RenderGraph{RenderBackend::get()};
-
-            point_light_uploads.flush_to_buffer(graph, point_light_data_buffer);
-
-            graph.finish();
-            RenderBackend::get().execute_graph(graph);
-        }
         point_light_uploads.add_data(handle.index, handle->gpu_data);
     }
 
     void RenderWorld::update_light_proxy(const SpotLightProxyHandle handle) {
-        if(spot_light_uploads.is_full()) {
-            auto graph = RenderGraph{RenderBackend::get()};
-
-            spot_light_uploads.flush_to_buffer(graph, spot_light_data_buffer);
-
-            graph.finish();
-            RenderBackend::get().execute_graph(graph);
-        }
         spot_light_uploads.add_data(handle.index, handle->gpu_data);
     }
 
@@ -350,6 +349,8 @@ namespace render {
     void RenderWorld::begin_frame(RenderGraph& graph) {
         graph.begin_label("RenderScene::begin_frame");
 
+        select_lods();
+
         primitive_upload_buffer.flush_to_buffer(graph, primitive_data_buffer);
 
         skeletal_data_upload_buffer.flush_to_buffer(graph, skeletal_data_buffer);
@@ -396,7 +397,7 @@ namespace render {
             .name = "deform_skinned_meshes",
             .buffers = barriers,
             .descriptor_sets = {set},
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [this, set](CommandBuffer& commands) {
                 commands.bind_pipeline(vertex_deformer);
 
                 commands.bind_descriptor_set(0, set);
@@ -510,12 +511,16 @@ namespace render {
         return output;
     }
 
-    void RenderWorld::draw_opaque(CommandBuffer& commands, const GraphicsPipelineHandle pso) const {
-        draw_primitives(commands, pso, solid_primitives);
+    void RenderWorld::draw_opaque(
+        CommandBuffer& commands, const GraphicsPipelineHandle pso, const MeshLodSelection lod_selection
+        ) const {
+        draw_primitives(commands, pso, solid_primitives, lod_selection);
     }
 
-    void RenderWorld::draw_masked(CommandBuffer& commands, const GraphicsPipelineHandle pso) const {
-        draw_primitives(commands, pso, masked_primitives);
+    void RenderWorld::draw_masked(
+        CommandBuffer& commands, const GraphicsPipelineHandle pso, const MeshLodSelection lod_selection
+        ) const {
+        draw_primitives(commands, pso, masked_primitives, lod_selection);
     }
 
     void RenderWorld::draw_opaque(
@@ -565,7 +570,7 @@ namespace render {
     }
 
     void RenderWorld::draw_transparent(CommandBuffer& commands, const GraphicsPipelineHandle pso) const {
-        draw_primitives(commands, pso, translucent_primitives);
+        draw_primitives(commands, pso, translucent_primitives, MeshLodSelection::MainView);
     }
 
     const MeshStorage& RenderWorld::get_meshes() const {
@@ -594,7 +599,7 @@ namespace render {
 
     void RenderWorld::draw_primitives(
         CommandBuffer& commands, const GraphicsPipelineHandle pso,
-        const eastl::span<const MeshPrimitiveProxyHandle> primitives
+        const eastl::span<const MeshPrimitiveProxyHandle> primitives, const MeshLodSelection lod_selection
         ) const {
         commands.bind_index_buffer(meshes.get_index_buffer());
 
@@ -603,25 +608,38 @@ namespace render {
         }
 
         commands.bind_pipeline(pso);
+
+        // Most neighboring primitives share their raster state, so only set it when it changes
+        auto cull_mode = VK_CULL_MODE_FLAG_BITS_MAX_ENUM;
+        auto front_face = VK_FRONT_FACE_MAX_ENUM;
         for(const auto& primitive : primitives) {
             const auto& mesh = primitive->mesh;
 
-            if(primitive->material->first.double_sided) {
-                commands.set_cull_mode(VK_CULL_MODE_NONE);
-            } else {
-                commands.set_cull_mode(VK_CULL_MODE_BACK_BIT);
+            const auto primitive_cull_mode = primitive->material->first.double_sided
+                                                 ? VK_CULL_MODE_NONE
+                                                 : VK_CULL_MODE_BACK_BIT;
+            if(primitive_cull_mode != cull_mode) {
+                commands.set_cull_mode(primitive_cull_mode);
+                cull_mode = primitive_cull_mode;
             }
 
-            if(primitive->material->first.front_face_ccw) {
-                commands.set_front_face(VK_FRONT_FACE_COUNTER_CLOCKWISE);
-            } else {
-                commands.set_front_face(VK_FRONT_FACE_CLOCKWISE);
+            const auto primitive_front_face = primitive->material->first.front_face_ccw
+                                                  ? VK_FRONT_FACE_COUNTER_CLOCKWISE
+                                                  : VK_FRONT_FACE_CLOCKWISE;
+            if(primitive_front_face != front_face) {
+                commands.set_front_face(primitive_front_face);
+                front_face = primitive_front_face;
             }
 
+            const auto lod_index = lod_selection == MeshLodSelection::Shadow
+                                       ? primitive->shadow_lod
+                                       : primitive->data.lod;
+            const auto& lod = mesh->lods[lod_index];
+
             commands.draw_indexed(
-                mesh->num_indices,
+                lod.num_indices,
                 1,
-                static_cast<uint32_t>(mesh->first_index),
+                static_cast<uint32_t>(mesh->first_index) + lod.first_index,
                 0,
                 primitive.index);
         }
@@ -631,6 +649,92 @@ namespace render {
         }
     }
 
+    void RenderWorld::select_lods() {
+        ZoneScoped;
+
+        const auto resolution = player_view.get_render_resolution();
+        if(resolution.y == 0) {
+            return;
+        }
+
+        const auto max_pixel_error = static_cast<float>(cvar_lod_max_pixel_error.get());
+        const auto view = LodView{
+            .camera_position = player_view.get_position(),
+            .pixels_per_unit = get_lod_pixels_per_unit(player_view.get_fov(), resolution.y),
+            .max_pixel_error = max_pixel_error,
+            .shadow_max_pixel_error = max_pixel_error * static_cast<float>(cvar_lod_shadow_error_scale.get()),
+        };
+
+        frames_since_full_lod_selection++;
+        if(view != lod_view || frames_since_full_lod_selection >= MAX_FRAMES_BETWEEN_FULL_LOD_SELECTIONS) {
+            lod_view = view;
+            frames_since_full_lod_selection = 0;
+
+            select_lods(solid_primitives);
+            select_lods(masked_primitives);
+            select_lods(translucent_primitives);
+        } else {
+            select_lods(lod_dirty_primitives);
+        }
+
+        for(const auto& primitive : lod_dirty_primitives) {
+            primitive->needs_lod_selection = false;
+        }
+        lod_dirty_primitives.clear();
+    }
+
+    void RenderWorld::select_lods(const eastl::span<const MeshPrimitiveProxyHandle> primitives) {
+        const auto& [camera_position, pixels_per_unit, max_pixel_error, shadow_max_pixel_error] = lod_view;
+
+        for(const auto& primitive : primitives) {
+            const auto& model = primitive->data.model;
+            const auto world_scale = glm::max(
+                glm::length(float3{model[0]}),
+                glm::max(glm::length(float3{model[1]}), glm::length(float3{model[2]})));
+
+            // Distance to the primitive's bounding sphere
+            const auto bounds_min = float3{primitive->data.bounds_min_and_radius};
+            const auto bounds_max = float3{primitive->data.bounds_max};
+            const auto center = (bounds_min + bounds_max) * 0.5f;
+            const auto radius = glm::length(bounds_max - bounds_min) * 0.5f;
+            const auto distance = glm::length(center - camera_position) - radius;
+
+            // Rough on-screen size of the primitive. Assumes the textures cover the primitive about once. The bounds
+            // are already in world space, so the model's scale is in the radius
+            const auto screen_size = 2.f * radius * pixels_per_unit / glm::max(distance, 0.01f);
+            const auto& material = primitive->material->first;
+            texture_streamer.request_screen_size(material.base_color_texture, screen_size);
+            texture_streamer.request_screen_size(material.normal_texture, screen_size);
+            texture_streamer.request_screen_size(material.metallic_roughness_texture, screen_size);
+            texture_streamer.request_screen_size(material.emission_texture, screen_size);
+
+            const auto& lods = primitive->mesh->lods;
+            if(lods.size() < 2) {
+                continue;
+            }
+
+            const auto lod = select_mesh_lod(lods, world_scale, distance, pixels_per_unit, max_pixel_error);
+            primitive->shadow_lod = select_mesh_lod(
+                lods,
+                world_scale,
+                distance,
+                pixels_per_unit,
+                shadow_max_pixel_error);
+
+            if(lod != primitive->data.lod) {
+                primitive->data.lod = lod;
+                update_mesh_proxy(primitive);
+            }
+        }
+    }
+
+    void RenderWorld::mark_lods_dirty(const MeshPrimitiveProxyHandle primitive) {
+        if(!primitive->needs_lod_selection) {
+            primitive->needs_lod_selection = true;
+            lod_dirty_primitives.push_back(primitive);
+        }
+    }
+
     void RenderWorld::on_construct_static_mesh(entt::registry& registry, const entt::entity entity) {
         auto [transform, mesh] = registry.get<TransformComponent, StaticMeshComponent>(entity);
         for(auto& primitive : mesh.primitives) {
@@ -724,21 +828,21 @@ namespace render {
         }
     }
 
-    void RenderWorld::on_transform_update(entt::registry& registry, const entt::entity entity) {
+    void RenderWorld::update_entity_transform(
+        entt::registry& registry, const entt::entity entity, const float4x4& matrix
+    ) {
         if(!registry.any_of<SkeletalMeshComponent, StaticMeshComponent, PointLightComponent, SpotLightComponent,
                             DirectionalLightComponent>(entity)) {
             return;
         }
 
-        const auto& transform = registry.get<TransformComponent>(entity);
-        const auto matrix = transform.get_local_to_world();
-
         if(const auto* mesh = registry.try_get<StaticMeshComponent>(entity)) {
             ZoneScopedN("update_static_mesh_location");
 
             for(const auto& primitive : mesh->primitives) {
                 primitive.proxy->data.model = matrix;
                 update_mesh_proxy(primitive.proxy);
+                mark_lods_dirty(primitive.proxy);
 
                 if(raytracing_world && primitive.visible_to_ray_tracing) {
                     raytracing_world->update_primitive(primitive.proxy);
@@ -752,6 +856,7 @@ namespace render {
             for(const auto& primitive : mesh->primitives) {
                 primitive.proxy->mesh_proxy->data.model = matrix;
                 update_mesh_proxy(primitive.proxy);
+                mark_lods_dirty(primitive.proxy->mesh_proxy);
 
                 if(raytracing_world && primitive.visible_to_ray_tracing) {
                     raytracing_world->update_primitive(primitive.proxy->mesh_proxy);
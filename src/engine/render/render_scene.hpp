@@ -12,6 +12,7 @@
 #include "proxies/mesh_primitive_proxy.hpp"
 #include "render/backend/scatter_upload_buffer.hpp"
 #include "render/directional_light.hpp"
+#include "render/mesh_lod.hpp"
 #include "proxies/skeletal_mesh_primitive_proxy.hpp"
 #include "shared/lights.hpp"
 
@@ -24,6 +25,7 @@ class World;
 namespace render {
     class MaterialStorage;
     class MeshStorage;
+    class TextureStreamer;
     class GltfModel;
     class RenderBackend;
 
@@ -34,7 +36,9 @@ namespace render {
      */
     class RenderWorld {
     public:
-        explicit RenderWorld(MeshStorage& meshes_in, MaterialStorage& materials_in);
+        explicit RenderWorld(
+            MeshStorage& meshes_in, MaterialStorage& materials_in, TextureStreamer& texture_streamer_in
+            );
 
         /**
          * Sets up various observers for a scene, e.g. mesh creation and destruction listeners
@@ -91,6 +95,9 @@ namespace render {
 
         void destroy_light(SpotLightProxyHandle proxy);
 
+        /**
+         * Selects LODs for the current player view, then uploads any pending scene changes
+         */
         void begin_frame(RenderGraph& graph);
 
         void deform_skinned_meshes(RenderGraph& graph);
@@ -130,9 +137,15 @@ namespace render {
             const glm::vec3& min_bounds, const glm::vec3& max_bounds
             ) const;
 
-        void draw_opaque(CommandBuffer& commands, GraphicsPipelineHandle pso) const;
+        void draw_opaque(
+            CommandBuffer& commands, GraphicsPipelineHandle pso,
+            MeshLodSelection lod_selection = MeshLodSelection::MainView
+            ) const;
 
-        void draw_masked(CommandBuffer& commands, GraphicsPipelineHandle pso) const;
+        void draw_masked(
+            CommandBuffer& commands, GraphicsPipelineHandle pso,
+            MeshLodSelection lod_selection = MeshLodSelection::MainView
+            ) const;
 
         /**
          * Draws the commands in the BufferHandle with the provided opaque PSO
@@ -164,6 +177,8 @@ namespace render {
 
         MaterialStorage& materials;
 
+        TextureStreamer& texture_streamer;
+
         eastl::optional<RaytracingScene> raytracing_world = eastl::nullopt;
 
         SceneView player_view;
@@ -212,9 +227,50 @@ namespace render {
 
         void draw_primitives(
             CommandBuffer& commands, GraphicsPipelineHandle pso,
-            eastl::span<const MeshPrimitiveProxyHandle> primitives
+            eastl::span<const MeshPrimitiveProxyHandle> primitives, MeshLodSelection lod_selection
             ) const;
 
+        /**
+         * Everything about the player's view that LOD selection depends on
+         */
+        struct LodView {
+            float3 camera_position = {};
+
+            float pixels_per_unit = 0;
+
+            float max_pixel_error = 0;
+
+            float shadow_max_pixel_error = 0;
+
+            bool operator==(const LodView& other) const = default;
+        };
+
+        /**
+         * The view that the primitives' LODs were last picked for
+         */
+        LodView lod_view;
+
+        uint32_t frames_since_full_lod_selection = 0;
+
+        /**
+         * Primitives that were added or moved since the last select_lods
+         */
+        eastl::vector<MeshPrimitiveProxyHandle> lod_dirty_primitives;
+
+        /**
+         * Picks the main view and shadow LODs of primitives, based on how large they are on screen. Shadows accept
+         * more error than the main view, since shadowmap texels are larger than screen pixels
+         *
+         * Only the primitives in lod_dirty_primitives are looked at, unless the view changed. Every primitive is
+         * looked at every so often anyways, since this also asks the texture streamer for enough mips of each
+         * primitive's textures to cover it on screen, and the streamer forgets requests that aren't repeated
+         */
+        void select_lods();
+
+        void select_lods(eastl::span<const MeshPrimitiveProxyHandle> primitives);
+
+        void mark_lods_dirty(MeshPrimitiveProxyHandle primitive);
+
         // scene observers
         void on_construct_static_mesh(entt::registry& registry, entt::entity entity);
 
@@ -228,6 +284,6 @@ namespace render {
 
         void on_destroy_light(entt::registry& registry, entt::entity entity);
 
-        void on_transform_update(entt::registry& registry, entt::entity entity);
+        void update_entity_transform(entt::registry& registry, entt::entity entity, const float4x4& matrix);
     };
 }
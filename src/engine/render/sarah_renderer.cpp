@@ -277,6 +277,8 @@ namespace render {
 
         gbuffer.depth = depth_culling_phase.get_depth_buffer();
 
+        texture_loader.tick();
+
         backend.get_texture_descriptor_pool().commit_descriptors();
 
         update_jitter();
@@ -288,6 +290,8 @@ namespace render {
 
         auto render_graph = RenderGraph{backend};
 
+        create_transient_render_targets(render_graph);
+
         render_graph.add_pass(
             {
                 .name = "Tracy Collect",
@@ -654,7 +658,7 @@ namespace render {
                         .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE
                     }
                 },
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, set](CommandBuffer& commands) {
                     commands.set_push_constant(0, 1.f / static_cast<float>(output_resolution.x));
                     commands.set_push_constant(1, 1.f / static_cast<float>(output_resolution.y));
                     commands.bind_descriptor_set(0, set);
@@ -680,40 +684,60 @@ namespace render {
         auto& backend = RenderBackend::get();
         auto& allocator = backend.get_global_allocator();
 
-        if(gbuffer.color != nullptr) {
-            allocator.destroy_texture(gbuffer.color);
-        }
-
-        if(gbuffer.normals != nullptr) {
-            allocator.destroy_texture(gbuffer.normals);
+        if(antialiased_scene_handle != nullptr) {
+            allocator.destroy_texture(antialiased_scene_handle);
         }
 
-        if(gbuffer.data != nullptr) {
-            allocator.destroy_texture(gbuffer.data);
-        }
+        depth_culling_phase.set_render_resolution(render_resolution);
 
-        if(gbuffer.emission != nullptr) {
-            allocator.destroy_texture(gbuffer.emission);
-        }
+        motion_vectors_phase.set_render_resolution(render_resolution, output_resolution);
 
-        if(ao_handle != nullptr) {
-            allocator.destroy_texture(ao_handle);
-        }
+        antialiased_scene_handle = allocator.create_texture(
+            "antialiased_scene",
+            {
+                .format = VK_FORMAT_R16G16B16A16_SFLOAT,
+                .resolution = output_resolution,
+                .usage = TextureUsage::RenderTarget,
+                .usage_flags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT
+            });
 
-        if(lit_scene_handle != nullptr) {
-            allocator.destroy_texture(lit_scene_handle);
-        }
+        auto& swapchain = backend.get_swapchain();
+        const auto& images = swapchain.get_images();
+        const auto& image_views = swapchain.get_image_views();
+        for(auto swapchain_image_index = 0u; swapchain_image_index < swapchain.image_count;
+            swapchain_image_index++) {
+            const auto swapchain_image_name = fmt::format("Swapchain image {}", swapchain_image_index);
+            const auto swapchain_image = allocator.emplace_texture(
+                GpuTexture{
+                    .name = swapchain_image_name.c_str(),
+                    .create_info = {
+                        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                        .imageType = VK_IMAGE_TYPE_2D,
+                        .format = swapchain.image_format,
+                        .extent = VkExtent3D{swapchain.extent.width, swapchain.extent.height, 1},
+                        .mipLevels = 1,
+                        .arrayLayers = 1,
+                        .samples = VK_SAMPLE_COUNT_1_BIT,
+                        .tiling = VK_IMAGE_TILING_OPTIMAL,
+                        .usage = swapchain.image_usage_flags,
+                    },
+                    .image = images->at(swapchain_image_index),
+                    .image_view = image_views->at(swapchain_image_index),
+                    .type = TextureAllocationType::Swapchain,
+                }
+                );
 
-        if(antialiased_scene_handle != nullptr) {
-            allocator.destroy_texture(antialiased_scene_handle);
+            swapchain_images.push_back(swapchain_image);
         }
 
-        depth_culling_phase.set_render_resolution(render_resolution);
-
-        motion_vectors_phase.set_render_resolution(render_resolution, output_resolution);
+        ui_phase.set_resources(
+            antialiased_scene_handle,
+            glm::uvec2{swapchain.extent.width, swapchain.extent.height});
+    }
 
+    void SarahRenderer::create_transient_render_targets(RenderGraph& render_graph) {
         // gbuffer and lighting render targets
-        gbuffer.color = allocator.create_texture(
+        gbuffer.color = render_graph.create_transient_texture(
             "gbuffer_color",
             {
                 VK_FORMAT_R8G8B8A8_SRGB,
@@ -723,7 +747,7 @@ namespace render {
             }
             );
 
-        gbuffer.normals = allocator.create_texture(
+        gbuffer.normals = render_graph.create_transient_texture(
             "gbuffer_normals",
             {
                 VK_FORMAT_R16G16B16A16_SFLOAT,
@@ -733,7 +757,7 @@ namespace render {
             }
             );
 
-        gbuffer.data = allocator.create_texture(
+        gbuffer.data = render_graph.create_transient_texture(
             "gbuffer_data",
             {
                 VK_FORMAT_R8G8B8A8_UNORM,
@@ -743,7 +767,7 @@ namespace render {
             }
             );
 
-        gbuffer.emission = allocator.create_texture(
+        gbuffer.emission = render_graph.create_transient_texture(
             "gbuffer_emission",
             {
                 VK_FORMAT_R8G8B8A8_SRGB,
@@ -753,7 +777,7 @@ namespace render {
             }
             );
 
-        ao_handle = allocator.create_texture(
+        ao_handle = render_graph.create_transient_texture(
             "AO",
             TextureCreateInfo{
                 .format = VK_FORMAT_R32_SFLOAT,
@@ -764,7 +788,7 @@ namespace render {
             }
             );
 
-        lit_scene_handle = allocator.create_texture(
+        lit_scene_handle = render_graph.create_transient_texture(
             "lit_scene",
             {
                 .format = VK_FORMAT_R16G16B16A16_SFLOAT,
@@ -773,48 +797,6 @@ namespace render {
                 .usage_flags = VK_IMAGE_USAGE_STORAGE_BIT
             }
             );
-
-        antialiased_scene_handle = allocator.create_texture(
-            "antialiased_scene",
-            {
-                .format = VK_FORMAT_R16G16B16A16_SFLOAT,
-                .resolution = output_resolution,
-                .usage = TextureUsage::RenderTarget,
-                .usage_flags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT
-            });
-
-        auto& swapchain = backend.get_swapchain();
-        const auto& images = swapchain.get_images();
-        const auto& image_views = swapchain.get_image_views();
-        for(auto swapchain_image_index = 0u; swapchain_image_index < swapchain.image_count;
-            swapchain_image_index++) {
-            const auto swapchain_image_name = fmt::format("Swapchain image {}", swapchain_image_index);
-            const auto swapchain_image = allocator.emplace_texture(
-                GpuTexture{
-                    .name = swapchain_image_name.c_str(),
-                    .create_info = {
-                        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-                        .imageType = VK_IMAGE_TYPE_2D,
-                        .format = swapchain.image_format,
-                        .extent = VkExtent3D{swapchain.extent.width, swapchain.extent.height, 1},
-                        .mipLevels = 1,
-                        .arrayLayers = 1,
-                        .samples = VK_SAMPLE_COUNT_1_BIT,
-                        .tiling = VK_IMAGE_TILING_OPTIMAL,
-                        .usage = swapchain.image_usage_flags,
-                    },
-                    .image = images->at(swapchain_image_index),
-                    .image_view = image_views->at(swapchain_image_index),
-                    .type = TextureAllocationType::Swapchain,
-                }
-                );
-
-            swapchain_images.push_back(swapchain_image);
-        }
-
-        ui_phase.set_resources(
-            antialiased_scene_handle,
-            glm::uvec2{swapchain.extent.width, swapchain.extent.height});
     }
 
     void SarahRenderer::update_jitter() {
@@ -120,6 +120,10 @@ namespace render {
 
         eastl::unique_ptr<IGlobalIlluminator> gi;
 
+        /**
+         * The gbuffer's color targets, AO, and lit scene are render graph transients. They're recreated every frame by
+         * create_transient_render_targets
+         */
         GBuffer gbuffer = {};
 
         TextureHandle ao_handle = nullptr;
@@ -164,6 +168,12 @@ namespace render {
 
         void create_scene_render_targets();
 
+        /**
+         * Creates the render targets that don't need to survive between frames. Their memory is shared with other
+         * transients that aren't used at the same time
+         */
+        void create_transient_render_targets(RenderGraph& render_graph);
+
         void update_jitter();
 
 #ifdef JPH_DEBUG_RENDERER
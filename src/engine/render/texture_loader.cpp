@@ -5,17 +5,19 @@
 
 #include "core/system_interface.hpp"
 #include "render/backend/render_backend.hpp"
+#include "render/texture_mips.hpp"
+#include "render/texture_streaming_source.hpp"
+#include "render/ktx/ktx_texture_source.hpp"
 #include "render/backend/resource_upload_queue.hpp"
 
 namespace render {
-    struct LoadedTexture {
-        int width = 0;
-        int height = 0;
-        eastl::vector<uint8_t> data = {};
-    };
+    static std::shared_ptr<spdlog::logger> decode_logger;
 
     TextureLoader::TextureLoader() {
         logger = SystemInterface::get().get_logger("TextureLoader");
+        if(decode_logger == nullptr) {
+            decode_logger = logger;
+        }
     }
 
     eastl::optional<TextureHandle> TextureLoader::load_texture(const ResourcePath& filepath, const TextureType type,
@@ -36,13 +38,47 @@ namespace render {
                    });
     }
 
+    eastl::optional<TextureHandle> TextureLoader::upload_texture_ktx(
+        const ResourcePath& filepath, eastl::vector<std::byte>&& data, const TextureType type
+        ) {
+        ZoneScoped;
+
+        if(const auto itr = loaded_textures.find(filepath); itr != loaded_textures.end()) {
+            return itr->second;
+        }
+
+        auto source = eastl::shared_ptr<KtxTextureSource>{};
+        try {
+            source = eastl::make_shared<KtxTextureSource>(filepath.to_string(), eastl::move(data), type);
+        } catch(const std::exception& e) {
+            logger->error("Cannot load KTX texture {}: {}", filepath, e.what());
+            return eastl::nullopt;
+        }
+
+        const auto handle = streamer.add_texture(filepath.to_string(), eastl::move(source));
+        loaded_textures.emplace(filepath, handle);
+
+        return handle;
+    }
+
     eastl::optional<TextureHandle> TextureLoader::upload_texture_stbi(
         const ResourcePath& filepath, const eastl::vector<std::byte>& data, const TextureType type,
         const VkImageUsageFlags usage_flags
         ) {
         ZoneScoped;
 
-        auto& backend = RenderBackend::get();
+        return decode_texture_stbi(filepath, data)
+            .and_then(
+                [&](LoadedTexture&& loaded_texture) {
+                    return eastl::make_optional(
+                        upload_decoded_texture(filepath, eastl::move(loaded_texture), type, usage_flags));
+                });
+    }
+
+    eastl::optional<LoadedTexture> TextureLoader::decode_texture_stbi(
+        const ResourcePath& filepath, const eastl::vector<std::byte>& data
+        ) {
+        ZoneScoped;
 
         LoadedTexture loaded_texture;
         int num_components;
@@ -55,7 +91,7 @@ namespace render {
             4
             );
         if(decoded_data == nullptr) {
-            logger->error("Cannot decode texture {}: {}", filepath, stbi_failure_reason());
+            decode_logger->error("Cannot decode texture {}: {}", filepath, stbi_failure_reason());
             return eastl::nullopt;
         }
 
@@ -67,6 +103,17 @@ namespace render {
 
         stbi_image_free(decoded_data);
 
+        return loaded_texture;
+    }
+
+    TextureHandle TextureLoader::upload_decoded_texture(
+        const ResourcePath& filepath, LoadedTexture&& loaded_texture, const TextureType type,
+        const VkImageUsageFlags usage_flags
+        ) {
+        ZoneScoped;
+
+        auto& backend = RenderBackend::get();
+
         const auto format = [&] {
             switch(type) {
             case TextureType::Color:
@@ -78,13 +125,22 @@ namespace render {
 
             return VK_FORMAT_R8G8B8A8_UNORM;
         }();
+        // Storage images are read texel-by-texel and need single-mip views
+        auto mips = eastl::vector<eastl::vector<uint8_t>>{};
+        if((usage_flags & VK_IMAGE_USAGE_STORAGE_BIT) != 0) {
+            mips.emplace_back(eastl::move(loaded_texture.data));
+        } else {
+            mips = generate_mips(loaded_texture, type, 0);
+        }
+        const auto num_mips = static_cast<uint32_t>(mips.size());
+
         auto& allocator = backend.get_global_allocator();
         const auto handle = allocator.create_texture(
             filepath.to_string(),
             {
                 .format = format,
                 .resolution = glm::uvec2{loaded_texture.width, loaded_texture.height},
-                .num_mips = 1,
+                .num_mips = num_mips,
                 .usage = TextureUsage::StaticImage,
                 .usage_flags = usage_flags
             }
@@ -92,43 +148,42 @@ namespace render {
         loaded_textures.emplace(filepath, handle);
 
         auto& upload_queue = backend.get_upload_queue();
-        upload_queue.enqueue(
-            TextureUploadJob{
-                .destination = handle,
-                .mip = 0,
-                .data = loaded_texture.data,
-            }
-            );
-
-        if(backend.has_separate_transfer_queue()) {
-            backend.add_transfer_barrier(
-                VkImageMemoryBarrier2{
-                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                    .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                    .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-                    .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .srcQueueFamilyIndex = backend.get_transfer_queue_family_index(),
-                    .dstQueueFamilyIndex = backend.get_graphics_queue_family_index(),
-                    .image = handle->image,
-                    .subresourceRange = {
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .baseMipLevel = 0,
-                        .levelCount = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = 1
-                    }
+        for(auto mip = 0u; mip < num_mips; mip++) {
+            upload_queue.enqueue(
+                TextureUploadJob{
+                    .destination = handle,
+                    .mip = mip,
+                    .data = eastl::move(mips[mip]),
                 }
                 );
+        }
+
+        return handle;
+    }
 
-            logger->info(
-                "Added queue transfer barrier for image {} (Vulkan handle {})",
-                filepath,
-                static_cast<void*>(handle->image));
+    TextureHandle TextureLoader::create_streamed_texture(
+        const ResourcePath& filepath, LoadedTexture&& loaded_texture, const TextureType type,
+        const eastl::optional<float> alpha_cutoff
+        ) {
+        ZoneScoped;
+
+        if(const auto itr = loaded_textures.find(filepath); itr != loaded_textures.end()) {
+            return itr->second;
         }
 
+        const auto handle = streamer.add_texture(
+            filepath.to_string(),
+            eastl::make_shared<DecodedTextureSource>(eastl::move(loaded_texture), type, alpha_cutoff));
+        loaded_textures.emplace(filepath, handle);
+
         return handle;
     }
+
+    void TextureLoader::tick() {
+        streamer.tick();
+    }
+
+    TextureStreamer& TextureLoader::get_streamer() {
+        return streamer;
+    }
 }
@@ -4,6 +4,8 @@
 
 #include <EASTL/optional.h>
 
+#include "render/loaded_texture.hpp"
+#include "render/texture_streamer.hpp"
 #include "render/texture_type.hpp"
 #include "render/backend/handles.hpp"
 #include "render/backend/resource_allocator.hpp"
@@ -30,13 +32,15 @@ namespace render {
             );
 
         /**
-         * Uploads a KTX texture from memory
+         * Creates a streamed texture from a KTX2 file in memory. Basis Universal textures are transcoded to a format
+         * the GPU supports as their mips stream in. Must be called on the main thread
          *
          * @param filepath The filepath the texture data came from. Useful for logging and naming
-         * @param data The raw data for the texture
+         * @param data The raw data for the texture. The texture keeps it until the texture is destroyed
+         * @param type The type of the texture
          */
         eastl::optional<TextureHandle> upload_texture_ktx(
-            const ResourcePath& filepath, const eastl::vector<std::byte>& data
+            const ResourcePath& filepath, eastl::vector<std::byte>&& data, TextureType type
             );
 
         /**
@@ -51,9 +55,56 @@ namespace render {
             VkImageUsageFlags usage_flags = 0
             );
 
+        /**
+         * Decodes a PNG or JPEG file from memory into RGBA8 data. Does not touch the GPU, so this may be called from
+         * any thread
+         *
+         * @param filepath The filepath the texture data came from. Useful for logging
+         * @param data The raw data for the image
+         */
+        static eastl::optional<LoadedTexture> decode_texture_stbi(
+            const ResourcePath& filepath, const eastl::vector<std::byte>& data
+            );
+
+        /**
+         * Creates a texture for some already-decoded data and enqueues its upload. Generates a full mip chain, unless
+         * the texture is a storage image. Must be called on the main thread
+         *
+         * @param filepath The filepath the texture data came from. Useful for logging and naming
+         * @param loaded_texture The decoded texture data
+         * @param type The type of the texture
+         */
+        TextureHandle upload_decoded_texture(
+            const ResourcePath& filepath, LoadedTexture&& loaded_texture, TextureType type,
+            VkImageUsageFlags usage_flags = 0
+            );
+
+        /**
+         * Creates a streamed texture for some already-decoded data. The texture's mips are generated and uploaded as
+         * the texture streamer wants them. Must be called on the main thread
+         *
+         * @param filepath The filepath the texture data came from. Useful for logging and naming
+         * @param loaded_texture The decoded texture data
+         * @param type The type of the texture
+         * @param alpha_cutoff Alpha cutoff of the material that uses this texture, if it's alpha tested
+         */
+        TextureHandle create_streamed_texture(
+            const ResourcePath& filepath, LoadedTexture&& loaded_texture, TextureType type,
+            eastl::optional<float> alpha_cutoff = eastl::nullopt
+            );
+
+        /**
+         * Ticks the texture streamer. Must be called before committing texture descriptors
+         */
+        void tick();
+
+        TextureStreamer& get_streamer();
+
     private:
         std::shared_ptr<spdlog::logger> logger;
 
+        TextureStreamer streamer;
+
         eastl::unordered_map<ResourcePath, TextureHandle> loaded_textures;
     };
 }
@@ -0,0 +1,279 @@
+#include "texture_mips.hpp"
+
+#include <bit>
+#include <cmath>
+
+#include <glm/common.hpp>
+#include <glm/vec4.hpp>
+#include <tracy/Tracy.hpp>
+#include <EASTL/array.h>
+
+#include "core/thread_pool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define SAH_MIPS_SSE2 1
+#include <emmintrin.h>
+#else
+#define SAH_MIPS_SSE2 0
+#endif
+
+namespace render {
+    /**
+     * Number of entries in the linear -> sRGB table. Needs to be large enough that dark values still map to distinct
+     * sRGB values
+     */
+    constexpr uint32_t LINEAR_TO_SRGB_TABLE_SIZE = 16384;
+
+    /**
+     * Images with fewer texels than this are downsampled on the calling thread
+     */
+    constexpr uint32_t MIN_TEXELS_FOR_PARALLEL_DOWNSAMPLE = 256 * 256;
+
+    constexpr uint32_t ROWS_PER_DOWNSAMPLE_TASK = 32;
+
+    struct SrgbTables {
+        eastl::array<float, 256> srgb_to_linear;
+
+        eastl::array<float, 256> unorm_to_float;
+
+        eastl::array<uint8_t, LINEAR_TO_SRGB_TABLE_SIZE> linear_to_srgb;
+    };
+
+    static const SrgbTables& get_srgb_tables() {
+        static const auto tables = [] {
+            auto result = SrgbTables{};
+            for(auto i = 0u; i < 256; i++) {
+                const auto value = static_cast<float>(i) / 255.f;
+                result.srgb_to_linear[i] = value <= 0.04045f
+                                               ? value / 12.92f
+                                               : std::pow((value + 0.055f) / 1.055f, 2.4f);
+                result.unorm_to_float[i] = value;
+            }
+            for(auto i = 0u; i < LINEAR_TO_SRGB_TABLE_SIZE; i++) {
+                const auto value = static_cast<float>(i) / static_cast<float>(LINEAR_TO_SRGB_TABLE_SIZE - 1);
+                const auto srgb = value <= 0.0031308f
+                                      ? value * 12.92f
+                                      : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+                result.linear_to_srgb[i] = static_cast<uint8_t>(glm::clamp(srgb * 255.f + 0.5f, 0.f, 255.f));
+            }
+            return result;
+        }();
+
+        return tables;
+    }
+
+    static uint8_t encode_linear(const float value, const bool srgb, const SrgbTables& tables) {
+        const auto clamped = glm::clamp(value, 0.f, 1.f);
+        if(srgb) {
+            return tables.linear_to_srgb[static_cast<uint32_t>(
+                clamped * static_cast<float>(LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f)];
+        }
+
+        return static_cast<uint8_t>(clamped * 255.f + 0.5f);
+    }
+
+    static void downsample_rows(
+        const LoadedTexture& source, LoadedTexture& destination, const uint32_t first_row, const uint32_t last_row,
+        const TextureType type
+        ) {
+        const auto& tables = get_srgb_tables();
+        const auto srgb = type == TextureType::Color;
+        const auto premultiply = type == TextureType::Color;
+        const auto& to_linear = srgb ? tables.srgb_to_linear : tables.unorm_to_float;
+
+        const auto source_width = static_cast<uint32_t>(source.width);
+        const auto source_height = static_cast<uint32_t>(source.height);
+        const auto destination_width = static_cast<uint32_t>(destination.width);
+
+        for(auto y = first_row; y < last_row; y++) {
+            const auto y0 = glm::min(y * 2, source_height - 1);
+            const auto y1 = glm::min(y * 2 + 1, source_height - 1);
+            for(auto x = 0u; x < destination_width; x++) {
+                const auto x0 = glm::min(x * 2, source_width - 1);
+                const auto x1 = glm::min(x * 2 + 1, source_width - 1);
+
+                const eastl::array<const uint8_t*, 4> texels = {
+                    &source.data[(y0 * source_width + x0) * 4],
+                    &source.data[(y0 * source_width + x1) * 4],
+                    &source.data[(y1 * source_width + x0) * 4],
+                    &source.data[(y1 * source_width + x1) * 4],
+                };
+
+                // Sum both the premultiplied and the straight color. If every texel is fully transparent, the
+                // premultiplied color is meaningless and we fall back to the straight color
+#if SAH_MIPS_SSE2
+                auto premultiplied_sum = _mm_setzero_ps();
+                auto straight_sum = _mm_setzero_ps();
+                for(const auto* texel : texels) {
+                    const auto alpha = tables.unorm_to_float[texel[3]];
+                    const auto value = _mm_set_ps(alpha, to_linear[texel[2]], to_linear[texel[1]], to_linear[texel[0]]);
+                    straight_sum = _mm_add_ps(straight_sum, value);
+                    premultiplied_sum = _mm_add_ps(
+                        premultiplied_sum,
+                        _mm_mul_ps(value, _mm_set_ps(1.f, alpha, alpha, alpha)));
+                }
+
+                alignas(16) auto average = eastl::array<float, 4>{};
+                const auto alpha_sum = _mm_cvtss_f32(_mm_shuffle_ps(straight_sum, straight_sum, _MM_SHUFFLE(3, 3, 3, 3)));
+                if(premultiply && alpha_sum > 0.f) {
+                    // Dividing by the summed alpha undoes both the premultiply and the average
+                    const auto inverse_alpha = 1.f / alpha_sum;
+                    _mm_store_ps(
+                        average.data(),
+                        _mm_mul_ps(premultiplied_sum, _mm_set_ps(0.f, inverse_alpha, inverse_alpha, inverse_alpha)));
+                } else {
+                    _mm_store_ps(average.data(), _mm_mul_ps(straight_sum, _mm_set1_ps(0.25f)));
+                }
+                average[3] = alpha_sum * 0.25f;
+#else
+                auto premultiplied_sum = glm::vec4{0};
+                auto straight_sum = glm::vec4{0};
+                for(const auto* texel : texels) {
+                    const auto alpha = tables.unorm_to_float[texel[3]];
+                    const auto value = glm::vec4{to_linear[texel[0]], to_linear[texel[1]], to_linear[texel[2]], alpha};
+                    straight_sum += value;
+                    premultiplied_sum += value * glm::vec4{alpha, alpha, alpha, 1.f};
+                }
+
+                auto average = glm::vec4{};
+                if(premultiply && straight_sum.w > 0.f) {
+                    average = premultiplied_sum / straight_sum.w;
+                } else {
+                    average = straight_sum * 0.25f;
+                }
+                average.w = straight_sum.w * 0.25f;
+#endif
+
+                auto* destination_texel = &destination.data[(y * destination_width + x) * 4];
+                destination_texel[0] = encode_linear(average[0], srgb, tables);
+                destination_texel[1] = encode_linear(average[1], srgb, tables);
+                destination_texel[2] = encode_linear(average[2], srgb, tables);
+                destination_texel[3] = encode_linear(average[3], false, tables);
+            }
+        }
+    }
+
+    uint32_t get_num_mips(const glm::uvec2 resolution) {
+        return static_cast<uint32_t>(std::bit_width(glm::max(resolution.x, resolution.y)));
+    }
+
+    glm::uvec2 get_mip_resolution(const glm::uvec2 resolution, const uint32_t mip) {
+        return glm::max(resolution >> mip, glm::uvec2{1});
+    }
+
+    LoadedTexture downsample_rgba8(const LoadedTexture& texture, const TextureType type) {
+        ZoneScoped;
+
+        const auto resolution = get_mip_resolution(
+            {static_cast<uint32_t>(texture.width), static_cast<uint32_t>(texture.height)},
+            1);
+
+        auto result = LoadedTexture{
+            .width = static_cast<int>(resolution.x),
+            .height = static_cast<int>(resolution.y),
+            .data = eastl::vector<uint8_t>(resolution.x * resolution.y * 4),
+        };
+
+        if(resolution.x * resolution.y < MIN_TEXELS_FOR_PARALLEL_DOWNSAMPLE) {
+            downsample_rows(texture, result, 0, resolution.y, type);
+            return result;
+        }
+
+        const auto num_tasks = (resolution.y + ROWS_PER_DOWNSAMPLE_TASK - 1) / ROWS_PER_DOWNSAMPLE_TASK;
+        ThreadPool::get().parallel_for(
+            num_tasks,
+            [&](const size_t task_index) {
+                const auto first_row = static_cast<uint32_t>(task_index) * ROWS_PER_DOWNSAMPLE_TASK;
+                const auto last_row = glm::min(first_row + ROWS_PER_DOWNSAMPLE_TASK, resolution.y);
+                downsample_rows(texture, result, first_row, last_row, type);
+            });
+
+        return result;
+    }
+
+    float compute_alpha_coverage(const LoadedTexture& texture, const float alpha_cutoff, const float alpha_scale) {
+        const auto num_texels = texture.data.size() / 4;
+        if(num_texels == 0) {
+            return 0.f;
+        }
+
+        const auto scaled_cutoff = alpha_cutoff * 255.f;
+        auto num_covered = size_t{0};
+        for(auto i = size_t{0}; i < num_texels; i++) {
+            if(static_cast<float>(texture.data[i * 4 + 3]) * alpha_scale > scaled_cutoff) {
+                num_covered++;
+            }
+        }
+
+        return static_cast<float>(num_covered) / static_cast<float>(num_texels);
+    }
+
+    void scale_alpha_to_coverage(LoadedTexture& texture, const float alpha_cutoff, const float coverage) {
+        ZoneScoped;
+
+        // Binary search for the scale that best matches the coverage. Coverage only grows with the scale
+        auto min_scale = 0.f;
+        auto max_scale = 4.f;
+        auto best_scale = 1.f;
+        auto best_error = glm::abs(compute_alpha_coverage(texture, alpha_cutoff) - coverage);
+        for(auto i = 0; i < 10; i++) {
+            const auto scale = (min_scale + max_scale) * 0.5f;
+            const auto scaled_coverage = compute_alpha_coverage(texture, alpha_cutoff, scale);
+            const auto error = glm::abs(scaled_coverage - coverage);
+            if(error < best_error) {
+                best_error = error;
+                best_scale = scale;
+            }
+
+            if(scaled_coverage < coverage) {
+                min_scale = scale;
+            } else if(scaled_coverage > coverage) {
+                max_scale = scale;
+            } else {
+                break;
+            }
+        }
+
+        if(best_scale == 1.f) {
+            return;
+        }
+
+        for(auto i = size_t{3}; i < texture.data.size(); i += 4) {
+            texture.data[i] = static_cast<uint8_t>(
+                glm::min(static_cast<float>(texture.data[i]) * best_scale + 0.5f, 255.f));
+        }
+    }
+
+    eastl::vector<eastl::vector<uint8_t>> generate_mips(
+        const LoadedTexture& texture, const TextureType type, const uint32_t first_mip,
+        const eastl::optional<float> alpha_cutoff
+        ) {
+        ZoneScoped;
+
+        const auto num_mips = get_num_mips({static_cast<uint32_t>(texture.width), static_cast<uint32_t>(texture.height)});
+
+        auto mips = eastl::vector<eastl::vector<uint8_t>>{};
+        mips.reserve(num_mips - first_mip);
+
+        if(first_mip == 0) {
+            mips.push_back(texture.data);
+        }
+
+        const auto coverage = alpha_cutoff ? compute_alpha_coverage(texture, *alpha_cutoff) : 0.f;
+
+        // Each mip is filtered from the previous mip before its alpha is scaled, so scaling errors don't accumulate
+        auto previous_mip = downsample_rgba8(texture, type);
+        for(auto mip = 1u; mip < num_mips; mip++) {
+            auto next_mip = mip + 1 < num_mips ? downsample_rgba8(previous_mip, type) : LoadedTexture{};
+            if(mip >= first_mip) {
+                if(alpha_cutoff) {
+                    scale_alpha_to_coverage(previous_mip, *alpha_cutoff, coverage);
+                }
+                mips.push_back(eastl::move(previous_mip.data));
+            }
+            previous_mip = eastl::move(next_mip);
+        }
+
+        return mips;
+    }
+}
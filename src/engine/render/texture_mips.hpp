@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <EASTL/optional.h>
+#include <EASTL/vector.h>
+
+#include "render/loaded_texture.hpp"
+#include "render/texture_type.hpp"
+
+namespace render {
+    /**
+     * Number of mips in a full mip chain for a texture of the given resolution
+     */
+    uint32_t get_num_mips(glm::uvec2 resolution);
+
+    /**
+     * Resolution of one mip of a texture. Never less than 1x1
+     */
+    glm::uvec2 get_mip_resolution(glm::uvec2 resolution, uint32_t mip);
+
+    /**
+     * Halves the resolution of an RGBA8 image with a 2x2 box filter. Odd rows and columns are clamped to the edge
+     *
+     * Color textures are filtered in linear space with premultiplied alpha, so that dark or transparent texels don't
+     * bleed into their neighbors. Data textures are filtered as-is
+     *
+     * Large images are split into bands of rows that are filtered on the thread pool
+     */
+    LoadedTexture downsample_rgba8(const LoadedTexture& texture, TextureType type);
+
+    /**
+     * Fraction of the texels in an image whose alpha is above the cutoff, after scaling alpha by alpha_scale
+     */
+    float compute_alpha_coverage(const LoadedTexture& texture, float alpha_cutoff, float alpha_scale = 1.f);
+
+    /**
+     * Scales the image's alpha so that its alpha coverage matches the given coverage. Keeps alpha-tested foliage and
+     * fences from thinning out in smaller mips
+     */
+    void scale_alpha_to_coverage(LoadedTexture& texture, float alpha_cutoff, float coverage);
+
+    /**
+     * Generates mips [first_mip, get_num_mips) of an RGBA8 image. Mip 0 is a copy of the image
+     *
+     * @param texture The full-resolution image
+     * @param type The type of the texture. Controls how the mips are filtered
+     * @param first_mip The first mip to return. Coarser mips are still generated from mip 0
+     * @param alpha_cutoff If set, each mip's alpha is scaled to keep mip 0's coverage at this alpha cutoff
+     */
+    eastl::vector<eastl::vector<uint8_t>> generate_mips(
+        const LoadedTexture& texture, TextureType type, uint32_t first_mip,
+        eastl::optional<float> alpha_cutoff = eastl::nullopt
+        );
+}
@@ -0,0 +1,248 @@
+#include "texture_residency_manager.hpp"
+
+#include <cmath>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/priority_queue.h>
+#include <EASTL/sort.h>
+#include <tracy/Tracy.hpp>
+
+namespace render {
+    uint32_t get_mip_for_screen_size(const uint32_t texture_size, const float screen_size_pixels) {
+        const auto texels_per_pixel = static_cast<float>(texture_size) / eastl::max(screen_size_pixels, 1.f);
+        return static_cast<uint32_t>(eastl::max(std::log2(texels_per_pixel), 0.f));
+    }
+
+    TextureResidencyManager::TextureResidencyManager(const uint64_t budget_bytes_in) : budget_bytes{budget_bytes_in} {}
+
+    void TextureResidencyManager::set_budget(const uint64_t budget_bytes_in) {
+        budget_bytes = budget_bytes_in;
+    }
+
+    uint64_t TextureResidencyManager::get_budget() const {
+        return budget_bytes;
+    }
+
+    StreamedTextureId TextureResidencyManager::add_texture(
+        const eastl::span<const uint64_t> mip_sizes, const uint32_t first_tail_mip
+        ) {
+        auto id = StreamedTextureId{};
+        if(!free_ids.empty()) {
+            id = free_ids.back();
+            free_ids.pop_back();
+        } else {
+            id = static_cast<StreamedTextureId>(textures.size());
+            textures.emplace_back();
+        }
+
+        const auto num_mips = static_cast<uint32_t>(mip_sizes.size());
+        const auto tail_mip = eastl::min(first_tail_mip, num_mips - 1);
+
+        auto& texture = textures[id];
+        texture = TextureResidency{
+            .mip_sizes = {mip_sizes.begin(), mip_sizes.end()},
+            .first_tail_mip = tail_mip,
+            .first_resident_mip = num_mips,
+            .requested_mip = tail_mip,
+            .wanted_mip = tail_mip,
+            .target_mip = tail_mip,
+            .last_request_update = update_count,
+            .is_active = true,
+        };
+
+        return id;
+    }
+
+    void TextureResidencyManager::remove_texture(const StreamedTextureId texture_id) {
+        auto& texture = textures[texture_id];
+        resident_bytes -= get_size_from_mip(texture, texture.first_resident_mip);
+        texture = {};
+        free_ids.push_back(texture_id);
+    }
+
+    void TextureResidencyManager::request_mip(const StreamedTextureId texture_id, const uint32_t mip) {
+        auto& texture = textures[texture_id];
+        const auto clamped_mip = eastl::min(mip, texture.first_tail_mip);
+        if(texture.last_request_update != update_count) {
+            // First request since the last update
+            texture.requested_mip = clamped_mip;
+            texture.last_request_update = update_count;
+        } else {
+            texture.requested_mip = eastl::min(texture.requested_mip, clamped_mip);
+        }
+    }
+
+    void TextureResidencyManager::on_change_finished(const StreamedTextureId texture_id, const uint32_t first_mip) {
+        auto& texture = textures[texture_id];
+        if(!texture.is_active) {
+            return;
+        }
+
+        resident_bytes -= get_size_from_mip(texture, texture.first_resident_mip);
+        texture.first_resident_mip = first_mip;
+        resident_bytes += get_size_from_mip(texture, texture.first_resident_mip);
+
+        texture.has_pending_change = false;
+    }
+
+    void TextureResidencyManager::on_change_failed(const StreamedTextureId texture_id) {
+        textures[texture_id].has_pending_change = false;
+    }
+
+    eastl::vector<ResidencyChange> TextureResidencyManager::update(const uint32_t max_changes) {
+        ZoneScoped;
+
+        update_count++;
+
+        for(auto& texture : textures) {
+            if(!texture.is_active) {
+                continue;
+            }
+
+            if(update_count - texture.last_request_update <= WANTED_MIP_GRACE_UPDATES) {
+                texture.wanted_mip = texture.requested_mip;
+            } else {
+                // Nobody has looked at this texture in a while
+                texture.wanted_mip = texture.first_tail_mip;
+            }
+        }
+
+        apply_budget();
+
+        auto initial_loads = eastl::vector<ResidencyChange>{};
+        auto evictions = eastl::vector<ResidencyChange>{};
+        auto loads = eastl::vector<ResidencyChange>{};
+        for(auto id = 0u; id < textures.size(); id++) {
+            const auto& texture = textures[id];
+            if(!texture.is_active || texture.has_pending_change) {
+                continue;
+            }
+
+            if(texture.first_resident_mip == texture.mip_sizes.size()) {
+                initial_loads.push_back({.texture = id, .first_mip = texture.first_tail_mip});
+            } else if(texture.target_mip > texture.first_resident_mip) {
+                evictions.push_back({.texture = id, .first_mip = texture.target_mip});
+            } else if(texture.target_mip < texture.first_resident_mip) {
+                loads.push_back({.texture = id, .first_mip = texture.target_mip});
+            }
+        }
+
+        eastl::sort(
+            loads.begin(),
+            loads.end(),
+            [&](const ResidencyChange& a, const ResidencyChange& b) {
+                return textures[a.texture].first_resident_mip - a.first_mip >
+                       textures[b.texture].first_resident_mip - b.first_mip;
+            });
+
+        auto changes = eastl::vector<ResidencyChange>{};
+        changes.reserve(
+            eastl::min(static_cast<size_t>(max_changes), initial_loads.size() + evictions.size() + loads.size()));
+
+        // Memory that's resident once the changes we return have finished
+        auto projected_bytes = resident_bytes;
+
+        for(const auto& initial_load : initial_loads) {
+            if(changes.size() >= max_changes) {
+                break;
+            }
+
+            auto& texture = textures[initial_load.texture];
+            projected_bytes += get_size_from_mip(texture, initial_load.first_mip);
+            texture.has_pending_change = true;
+            changes.push_back(initial_load);
+        }
+
+        for(const auto& eviction : evictions) {
+            if(changes.size() >= max_changes) {
+                break;
+            }
+
+            auto& texture = textures[eviction.texture];
+            projected_bytes -= get_size_from_mip(texture, texture.first_resident_mip) -
+                get_size_from_mip(texture, eviction.first_mip);
+            texture.has_pending_change = true;
+            changes.push_back(eviction);
+        }
+
+        for(const auto& load : loads) {
+            if(changes.size() >= max_changes) {
+                break;
+            }
+
+            auto& texture = textures[load.texture];
+            const auto added_bytes = get_size_from_mip(texture, load.first_mip) -
+                get_size_from_mip(texture, texture.first_resident_mip);
+            if(projected_bytes + added_bytes > budget_bytes) {
+                continue;
+            }
+
+            projected_bytes += added_bytes;
+            texture.has_pending_change = true;
+            changes.push_back(load);
+        }
+
+        return changes;
+    }
+
+    uint64_t TextureResidencyManager::get_resident_bytes() const {
+        return resident_bytes;
+    }
+
+    uint32_t TextureResidencyManager::get_first_resident_mip(const StreamedTextureId texture) const {
+        return textures[texture].first_resident_mip;
+    }
+
+    uint32_t TextureResidencyManager::get_target_mip(const StreamedTextureId texture) const {
+        return textures[texture].target_mip;
+    }
+
+    bool TextureResidencyManager::is_change_pending(const StreamedTextureId texture) const {
+        return textures[texture].has_pending_change;
+    }
+
+    uint64_t TextureResidencyManager::get_size_from_mip(const TextureResidency& texture, const uint32_t first_mip) {
+        auto size = uint64_t{0};
+        for(auto mip = first_mip; mip < texture.mip_sizes.size(); mip++) {
+            size += texture.mip_sizes[mip];
+        }
+
+        return size;
+    }
+
+    void TextureResidencyManager::apply_budget() {
+        // Largest finest mip first
+        auto droppable_mips = eastl::priority_queue<eastl::pair<uint64_t, StreamedTextureId>>{};
+
+        auto total_bytes = uint64_t{0};
+        for(auto id = 0u; id < textures.size(); id++) {
+            auto& texture = textures[id];
+            if(!texture.is_active) {
+                continue;
+            }
+
+            texture.target_mip = texture.wanted_mip;
+            total_bytes += get_size_from_mip(texture, texture.target_mip);
+
+            if(texture.target_mip < texture.first_tail_mip) {
+                droppable_mips.emplace(texture.mip_sizes[texture.target_mip], id);
+            }
+        }
+
+        // Drop the finest wanted mip of the texture where that frees the most memory, until we fit. This evens out
+        // resolution across textures rather than starving a few of them. If everything is down to its tail, we can't
+        // go any lower
+        while(total_bytes > budget_bytes && !droppable_mips.empty()) {
+            const auto [size, id] = droppable_mips.top();
+            droppable_mips.pop();
+
+            auto& texture = textures[id];
+            texture.target_mip++;
+            total_bytes -= size;
+
+            if(texture.target_mip < texture.first_tail_mip) {
+                droppable_mips.emplace(texture.mip_sizes[texture.target_mip], id);
+            }
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+namespace render {
+    using StreamedTextureId = uint32_t;
+
+    /**
+     * Finds the coarsest mip that still has at least one texel per pixel
+     *
+     * \param texture_size Resolution of mip 0 along the texture's largest axis
+     * \param screen_size_pixels How many pixels the texture covers on screen, along its largest axis
+     */
+    uint32_t get_mip_for_screen_size(uint32_t texture_size, float screen_size_pixels);
+
+    /**
+     * A change that the residency manager wants to make to one texture: make mips [first_mip, num_mips) resident and
+     * free everything finer
+     */
+    struct ResidencyChange {
+        StreamedTextureId texture;
+
+        uint32_t first_mip;
+    };
+
+    /**
+     * Decides which mips of each streamed texture should be in GPU memory
+     *
+     * This class only does bookkeeping - it doesn't know about Vulkan. Callers tell it about textures, tell it which mip
+     * each texture wants, ask it what to change, and tell it when a change has finished
+     *
+     * Each texture has a tail of small mips that are always resident. Finer mips are loaded when a texture asks for
+     * them, as long as they fit in the budget. When the wanted mips don't fit, every texture's wanted mip is made
+     * coarser, biggest textures first, until they do. Textures that stop asking for mips fall back to their tail after
+     * a grace period
+     */
+    class TextureResidencyManager {
+    public:
+        /**
+         * Number of updates that a texture keeps its wanted mip after its last request
+         */
+        static constexpr uint32_t WANTED_MIP_GRACE_UPDATES = 120;
+
+        explicit TextureResidencyManager(uint64_t budget_bytes_in);
+
+        void set_budget(uint64_t budget_bytes_in);
+
+        uint64_t get_budget() const;
+
+        /**
+         * Adds a texture. Nothing is resident at first, the next update asks for the texture's tail
+         *
+         * \param mip_sizes Size in bytes of each mip, finest first
+         * \param first_tail_mip First mip that is always resident
+         */
+        StreamedTextureId add_texture(eastl::span<const uint64_t> mip_sizes, uint32_t first_tail_mip);
+
+        void remove_texture(StreamedTextureId texture);
+
+        /**
+         * Asks for a texture to have the given mip resident. If a texture gets multiple requests before the next
+         * update, the finest one wins
+         */
+        void request_mip(StreamedTextureId texture, uint32_t mip);
+
+        /**
+         * Tells the manager that a change returned by update has finished. The texture now has mips [first_mip,
+         * num_mips) resident
+         */
+        void on_change_finished(StreamedTextureId texture, uint32_t first_mip);
+
+        /**
+         * Tells the manager that a change returned by update failed. The texture's residency is unchanged
+         */
+        void on_change_failed(StreamedTextureId texture);
+
+        /**
+         * Decides what to load and what to evict
+         *
+         * Textures that have nothing resident get their tail first, even if that goes over budget - they have nothing
+         * to draw with otherwise. Evictions come next, since they free memory. Other loads are sorted by how many mips
+         * they add, most first, and only returned if they fit in the budget. Textures with a change in flight are left
+         * alone until the change finishes
+         *
+         * \param max_changes Maximum number of changes to return
+         */
+        eastl::vector<ResidencyChange> update(uint32_t max_changes);
+
+        /**
+         * Bytes of resident mips, not counting changes that are in flight
+         */
+        uint64_t get_resident_bytes() const;
+
+        uint32_t get_first_resident_mip(StreamedTextureId texture) const;
+
+        /**
+         * The mip that the texture wanted in the last update, after the budget was applied
+         */
+        uint32_t get_target_mip(StreamedTextureId texture) const;
+
+        bool is_change_pending(StreamedTextureId texture) const;
+
+    private:
+        struct TextureResidency {
+            eastl::vector<uint64_t> mip_sizes;
+
+            uint32_t first_tail_mip = 0;
+
+            uint32_t first_resident_mip = 0;
+
+            uint32_t requested_mip = 0;
+
+            uint32_t wanted_mip = 0;
+
+            uint32_t target_mip = 0;
+
+            uint32_t last_request_update = 0;
+
+            bool is_active = false;
+
+            bool has_pending_change = false;
+        };
+
+        uint64_t budget_bytes = 0;
+
+        uint64_t resident_bytes = 0;
+
+        uint32_t update_count = 0;
+
+        eastl::vector<TextureResidency> textures;
+
+        eastl::vector<StreamedTextureId> free_ids;
+
+        /**
+         * Size of mips [first_mip, num_mips)
+         */
+        static uint64_t get_size_from_mip(const TextureResidency& texture, uint32_t first_mip);
+
+        /**
+         * Picks each texture's target mip, making them coarser until everything fits in the budget
+         */
+        void apply_budget();
+    };
+}
@@ -0,0 +1,253 @@
+#include "texture_streamer.hpp"
+
+#include <chrono>
+
+#include <glm/exponential.hpp>
+#include <spdlog/logger.h>
+#include <tracy/Tracy.hpp>
+
+#include "console/cvars.hpp"
+#include "core/system_interface.hpp"
+#include "core/thread_pool.hpp"
+#include "render/texture_mips.hpp"
+#include "render/backend/constants.hpp"
+#include "render/backend/render_backend.hpp"
+#include "render/backend/resource_upload_queue.hpp"
+#include "render/backend/texture_descriptor_pool.hpp"
+
+namespace render {
+    static std::shared_ptr<spdlog::logger> logger;
+
+    static auto cvar_pool_size = AutoCVar_Int{
+        "r.TextureStreaming.PoolSizeMB",
+        "How much GPU memory streamed textures may use, in megabytes. Finer mips are evicted when we go over",
+        1024
+    };
+
+    static auto cvar_max_changes_per_frame = AutoCVar_Int{
+        "r.TextureStreaming.MaxChangesPerFrame",
+        "Maximum number of textures that may start loading or evicting mips each frame",
+        16
+    };
+
+    /**
+     * Mips at or below this size are the texture's tail, and are always resident
+     */
+    constexpr uint32_t TAIL_MIP_SIZE = 64;
+
+    static uint64_t get_pool_size_bytes() {
+        return static_cast<uint64_t>(cvar_pool_size.get()) * 1024 * 1024;
+    }
+
+    /**
+     * Enqueues uploads for every mip of a texture
+     */
+    static void upload_mips(const TextureHandle texture, eastl::vector<eastl::vector<uint8_t>>&& mips) {
+        auto& upload_queue = RenderBackend::get().get_upload_queue();
+        for(auto mip = 0u; mip < mips.size(); mip++) {
+            upload_queue.enqueue(
+                TextureUploadJob{
+                    .destination = texture,
+                    .mip = mip,
+                    .data = eastl::move(mips[mip]),
+                });
+        }
+    }
+
+    TextureStreamer::TextureStreamer() : residency{get_pool_size_bytes()} {
+        if(logger == nullptr) {
+            logger = SystemInterface::get().get_logger("TextureStreamer");
+        }
+    }
+
+    TextureHandle TextureStreamer::add_texture(
+        const eastl::string_view name, eastl::shared_ptr<const ITextureStreamingSource> source,
+        const VkImageUsageFlags usage_flags
+        ) {
+        ZoneScoped;
+
+        // Neutral gray until the tail loads. We only see this for a frame or two
+        const auto handle = RenderBackend::get().get_global_allocator().create_texture(
+            name,
+            {
+                .format = VK_FORMAT_R8G8B8A8_UNORM,
+                .resolution = glm::uvec2{1},
+                .num_mips = 1,
+                .usage = TextureUsage::StaticImage,
+                .usage_flags = usage_flags,
+            });
+        auto placeholder = eastl::vector<eastl::vector<uint8_t>>{};
+        placeholder.emplace_back(eastl::vector<uint8_t>{128, 128, 128, 255});
+        upload_mips(handle, eastl::move(placeholder));
+
+        const auto num_mips = source->get_num_mips();
+        auto mip_sizes = eastl::vector<uint64_t>{};
+        mip_sizes.reserve(num_mips);
+        auto first_tail_mip = num_mips - 1;
+        for(auto mip = 0u; mip < num_mips; mip++) {
+            mip_sizes.push_back(source->get_mip_size(mip));
+
+            const auto resolution = get_mip_resolution(source->get_resolution(), mip);
+            if(mip < first_tail_mip && glm::max(resolution.x, resolution.y) <= TAIL_MIP_SIZE) {
+                first_tail_mip = mip;
+            }
+        }
+
+        const auto id = residency.add_texture(mip_sizes, first_tail_mip);
+        if(id >= handles_by_id.size()) {
+            handles_by_id.resize(id + 1);
+        }
+        handles_by_id[id] = handle;
+
+        textures.emplace(
+            handle,
+            StreamedTexture{
+                .id = id,
+                .name = eastl::string{name},
+                .source = eastl::move(source),
+                .usage_flags = usage_flags,
+            });
+
+        return handle;
+    }
+
+    bool TextureStreamer::is_streamed(const TextureHandle texture) const {
+        return textures.find(texture) != textures.end();
+    }
+
+    void TextureStreamer::request_screen_size(const TextureHandle texture, const float screen_size_pixels) {
+        const auto itr = textures.find(texture);
+        if(itr == textures.end()) {
+            return;
+        }
+
+        const auto resolution = itr->second.source->get_resolution();
+        const auto mip = get_mip_for_screen_size(glm::max(resolution.x, resolution.y), screen_size_pixels);
+        residency.request_mip(itr->second.id, mip);
+    }
+
+    void TextureStreamer::tick() {
+        ZoneScoped;
+
+        frame_count++;
+
+        // The upload queue may push uploads to a later frame, so we count from the last frame that still had some.
+        // advance_frame waits for that frame's fence num_in_flight_frames frames later, which is after our tick for
+        // that frame, so we wait one more
+        const auto& upload_queue = RenderBackend::get().get_upload_queue();
+        for(auto& change : uploading_changes) {
+            if(upload_queue.has_pending_uploads(change.new_texture)) {
+                change.upload_frame = frame_count;
+            } else if(frame_count - change.upload_frame > num_in_flight_frames) {
+                swap_in_texture(change);
+                change.texture = nullptr;
+            }
+        }
+        eastl::erase_if(uploading_changes, [](const UploadingChange& change) { return change.texture == nullptr; });
+
+        for(auto& change : pending_changes) {
+            if(change.mips.wait_for(std::chrono::seconds{0}) == std::future_status::ready) {
+                finish_change(change);
+                change.texture = nullptr;
+            }
+        }
+        eastl::erase_if(pending_changes, [](const PendingChange& change) { return change.texture == nullptr; });
+
+        residency.set_budget(get_pool_size_bytes());
+
+        const auto max_changes = static_cast<uint32_t>(cvar_max_changes_per_frame.get());
+        const auto changes = residency.update(max_changes);
+        if(changes.empty()) {
+            return;
+        }
+
+        for(const auto& change : changes) {
+            start_change(handles_by_id[change.texture], change.first_mip);
+        }
+
+        TracyPlot("Streamed texture memory", static_cast<int64_t>(residency.get_resident_bytes()));
+    }
+
+    uint64_t TextureStreamer::get_resident_bytes() const {
+        return residency.get_resident_bytes();
+    }
+
+    void TextureStreamer::start_change(const TextureHandle texture, const uint32_t first_mip) {
+        const auto& streamed_texture = textures.at(texture);
+
+        pending_changes.emplace_back(
+            PendingChange{
+                .texture = texture,
+                .first_mip = first_mip,
+                .mips = ThreadPool::get().enqueue(
+                    [source = streamed_texture.source, first_mip] {
+                        return source->load_mips(first_mip);
+                    }),
+            });
+    }
+
+    void TextureStreamer::finish_change(PendingChange& change) {
+        ZoneScoped;
+
+        const auto& streamed_texture = textures.at(change.texture);
+
+        auto mips = eastl::vector<eastl::vector<uint8_t>>{};
+        try {
+            mips = change.mips.get();
+        } catch(const std::exception& e) {
+            logger->error("Could not load mips for texture {}: {}", streamed_texture.name, e.what());
+            residency.on_change_failed(streamed_texture.id);
+            return;
+        }
+
+        const auto& source = *streamed_texture.source;
+        const auto num_mips = static_cast<uint32_t>(mips.size());
+
+        auto& backend = RenderBackend::get();
+        auto& allocator = backend.get_global_allocator();
+        const auto new_texture = allocator.create_texture(
+            streamed_texture.name,
+            {
+                .format = source.get_format(),
+                .resolution = get_mip_resolution(source.get_resolution(), change.first_mip),
+                .num_mips = num_mips,
+                .usage = TextureUsage::StaticImage,
+                .usage_flags = streamed_texture.usage_flags,
+            });
+
+        // In-flight frames still sample the old image through its descriptors, so we keep the new image separate until
+        // the GPU has finished uploading to it
+        upload_mips(new_texture, eastl::move(mips));
+
+        uploading_changes.emplace_back(
+            UploadingChange{
+                .texture = change.texture,
+                .new_texture = new_texture,
+                .first_mip = change.first_mip,
+                .upload_frame = frame_count,
+            });
+    }
+
+    void TextureStreamer::swap_in_texture(const UploadingChange& change) {
+        ZoneScoped;
+
+        const auto& streamed_texture = textures.at(change.texture);
+
+        auto& backend = RenderBackend::get();
+
+        // Swap the new image into the handle that everyone holds, and let the allocator destroy the old image once the
+        // GPU is done with it
+        eastl::swap(*change.texture, *change.new_texture);
+        backend.get_global_allocator().destroy_texture(change.new_texture);
+
+        backend.get_texture_descriptor_pool().refresh_texture_srvs(change.texture);
+
+        residency.on_change_finished(streamed_texture.id, change.first_mip);
+
+        logger->trace(
+            "Texture {} now has mips {} through {} resident",
+            streamed_texture.name,
+            change.first_mip,
+            streamed_texture.source->get_num_mips() - 1);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <future>
+
+#include <EASTL/shared_ptr.h>
+#include <EASTL/string.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+#include "render/texture_residency_manager.hpp"
+#include "render/texture_streaming_source.hpp"
+#include "render/backend/handles.hpp"
+
+namespace render {
+    /**
+     * Streams texture mips in and out of GPU memory
+     *
+     * A streamed texture starts as a 1x1 placeholder. Its tail mips load first, then finer mips load as the renderer
+     * asks for them. The TextureResidencyManager decides what should be resident within r.TextureStreaming.PoolSizeMB
+     *
+     * Mips are loaded on the thread pool. When a load finishes, we create a new image with exactly the resident mips and
+     * upload the mips to it. Once the frame that uploaded them has finished on the GPU, we swap the new image into the
+     * existing GpuTexture. This keeps TextureHandles stable, so materials never notice. We then point the texture's
+     * descriptors at the new image. Evicting mips works the same way, with a smaller image
+     */
+    class TextureStreamer {
+    public:
+        explicit TextureStreamer();
+
+        TextureStreamer(const TextureStreamer& other) = delete;
+        TextureStreamer& operator=(const TextureStreamer& other) = delete;
+
+        /**
+         * Adds a texture to the streamer. The returned handle is usable immediately
+         *
+         * @param name Name of the texture, for debugging
+         * @param source Where to load the texture's mips from
+         * @param usage_flags Extra usage flags for the texture
+         */
+        TextureHandle add_texture(
+            eastl::string_view name, eastl::shared_ptr<const ITextureStreamingSource> source,
+            VkImageUsageFlags usage_flags = 0
+            );
+
+        bool is_streamed(TextureHandle texture) const;
+
+        /**
+         * Asks for enough mips to draw the texture at the given size on screen. Does nothing for textures that aren't
+         * streamed
+         *
+         * @param texture The texture to request mips for
+         * @param screen_size_pixels How many pixels the texture covers on screen, along its largest axis
+         */
+        void request_screen_size(TextureHandle texture, float screen_size_pixels);
+
+        /**
+         * Finishes mip loads that are ready, then starts new loads and evictions. Call once per frame, before the
+         * texture descriptors are committed
+         */
+        void tick();
+
+        uint64_t get_resident_bytes() const;
+
+    private:
+        struct StreamedTexture {
+            StreamedTextureId id;
+
+            eastl::string name;
+
+            eastl::shared_ptr<const ITextureStreamingSource> source;
+
+            VkImageUsageFlags usage_flags = 0;
+        };
+
+        struct PendingChange {
+            TextureHandle texture;
+
+            uint32_t first_mip;
+
+            std::future<eastl::vector<eastl::vector<uint8_t>>> mips;
+        };
+
+        struct UploadingChange {
+            TextureHandle texture;
+
+            /**
+             * Image with the new mips. Swapped into texture once the GPU has finished uploading to it
+             */
+            TextureHandle new_texture;
+
+            uint32_t first_mip;
+
+            /**
+             * Value of frame_count when the last of the uploads was submitted
+             */
+            uint32_t upload_frame;
+        };
+
+        TextureResidencyManager residency;
+
+        eastl::unordered_map<TextureHandle, StreamedTexture> textures;
+
+        /**
+         * Handle of each streamed texture, indexed by its StreamedTextureId
+         */
+        eastl::vector<TextureHandle> handles_by_id;
+
+        eastl::vector<PendingChange> pending_changes;
+
+        eastl::vector<UploadingChange> uploading_changes;
+
+        /**
+         * Number of times tick has been called
+         */
+        uint32_t frame_count = 0;
+
+        void start_change(TextureHandle texture, uint32_t first_mip);
+
+        /**
+         * Creates an image with the new mips, and uploads the mips to it
+         */
+        void finish_change(PendingChange& change);
+
+        void swap_in_texture(const UploadingChange& change);
+    };
+}
@@ -0,0 +1,38 @@
+#include "texture_streaming_source.hpp"
+
+#include <tracy/Tracy.hpp>
+
+#include "render/texture_mips.hpp"
+
+namespace render {
+    DecodedTextureSource::DecodedTextureSource(
+        LoadedTexture&& texture_in, const TextureType type_in, const eastl::optional<float> alpha_cutoff_in
+        ) :
+        texture{eastl::move(texture_in)},
+        type{type_in},
+        alpha_cutoff{alpha_cutoff_in},
+        format{type == TextureType::Color ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM} {}
+
+    VkFormat DecodedTextureSource::get_format() const {
+        return format;
+    }
+
+    glm::uvec2 DecodedTextureSource::get_resolution() const {
+        return {texture.width, texture.height};
+    }
+
+    uint32_t DecodedTextureSource::get_num_mips() const {
+        return render::get_num_mips(get_resolution());
+    }
+
+    uint64_t DecodedTextureSource::get_mip_size(const uint32_t mip) const {
+        const auto resolution = get_mip_resolution(get_resolution(), mip);
+        return static_cast<uint64_t>(resolution.x) * resolution.y * 4;
+    }
+
+    eastl::vector<eastl::vector<uint8_t>> DecodedTextureSource::load_mips(const uint32_t first_mip) const {
+        ZoneScoped;
+
+        return generate_mips(texture, type, first_mip, alpha_cutoff);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <volk.h>
+#include <EASTL/optional.h>
+#include <EASTL/vector.h>
+
+#include "render/loaded_texture.hpp"
+#include "render/texture_type.hpp"
+
+namespace render {
+    /**
+     * Somewhere that the texture streamer can get a texture's mips from
+     */
+    class ITextureStreamingSource {
+    public:
+        virtual ~ITextureStreamingSource() = default;
+
+        virtual VkFormat get_format() const = 0;
+
+        virtual glm::uvec2 get_resolution() const = 0;
+
+        virtual uint32_t get_num_mips() const = 0;
+
+        /**
+         * Size in bytes of one mip
+         */
+        virtual uint64_t get_mip_size(uint32_t mip) const = 0;
+
+        /**
+         * Loads mips [first_mip, get_num_mips()). Called on worker threads, possibly several at once
+         */
+        virtual eastl::vector<eastl::vector<uint8_t>> load_mips(uint32_t first_mip) const = 0;
+    };
+
+    /**
+     * Streams mips from an RGBA8 image that's already been decoded. Mips are generated on demand, so only the full
+     * resolution image stays in memory
+     */
+    class DecodedTextureSource final : public ITextureStreamingSource {
+    public:
+        /**
+         * @param texture_in The decoded image
+         * @param type_in The type of the texture. Controls the format and how mips are filtered
+         * @param alpha_cutoff_in Alpha cutoff of the material that uses this texture, if it's alpha tested. Mips
+         * preserve the image's alpha coverage at this cutoff
+         */
+        DecodedTextureSource(
+            LoadedTexture&& texture_in, TextureType type_in, eastl::optional<float> alpha_cutoff_in = eastl::nullopt
+            );
+
+        VkFormat get_format() const override;
+
+        glm::uvec2 get_resolution() const override;
+
+        uint32_t get_num_mips() const override;
+
+        uint64_t get_mip_size(uint32_t mip) const override;
+
+        eastl::vector<eastl::vector<uint8_t>> load_mips(uint32_t first_mip) const override;
+
+    private:
+        LoadedTexture texture;
+
+        TextureType type;
+
+        eastl::optional<float> alpha_cutoff;
+
+        VkFormat format;
+    };
+}
@@ -201,7 +201,7 @@ namespace render {
         {
             .name = "dlss",
             .textures = textures,
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [=, this, &view](CommandBuffer& commands) {
                 auto color_in_res = wrap_resource(color_in, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
                 auto color_out_res = wrap_resource(color_out, VK_IMAGE_LAYOUT_GENERAL);
                 auto depth_in_res = wrap_resource(gbuffer.depth, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -355,7 +355,7 @@ namespace render {
                     .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE
                 }
             },
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [set](CommandBuffer& commands) {
                 commands.bind_descriptor_set(0, set);
                 commands.bind_pipeline(dlss_rr_packing_pipeline);
                 commands.draw_triangle();
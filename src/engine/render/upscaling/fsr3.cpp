@@ -180,7 +180,7 @@ namespace render {
                         .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
                     },
                 },
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [=, this](CommandBuffer& commands) {
                     const auto color_in_res = FfxApiResource{
                         .resource = color_in->image,
                         .description = ffxApiGetImageResourceDescriptionVK(color_in->image, color_in->create_info, 0),
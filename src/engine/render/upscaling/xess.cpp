@@ -217,7 +217,7 @@ namespace render {
                     .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
                 },
             },
-            .execute = [&](CommandBuffer& commands) {
+            .execute = [=, this](CommandBuffer& commands) {
                 params.colorTexture = wrap_image(color_in);
                 params.velocityTexture = wrap_image(motion_vectors_in);
                 params.depthTexture = wrap_image(gbuffer.depth);
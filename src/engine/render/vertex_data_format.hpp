@@ -0,0 +1,19 @@
+#pragma once
+
+namespace render {
+    /**
+     * Layout of the vertex data stream in MeshStorage. Positions are always float3, since ray tracing and skinning
+     * consume them directly
+     */
+    enum class VertexDataFormat {
+        /**
+         * StandardVertexData, 40 bytes per vertex
+         */
+        Standard,
+
+        /**
+         * PackedVertexData, 16 bytes per vertex. Octahedral normals and tangents, half-float texcoords
+         */
+        Packed,
+    };
+}
@@ -0,0 +1,257 @@
+#include "vertex_packing.hpp"
+
+#include <cmath>
+
+#include <glm/gtc/packing.hpp>
+#include <tracy/Tracy.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAH_VERTEX_PACKING_SSE2 1
+#else
+#define SAH_VERTEX_PACKING_SSE2 0
+#endif
+
+#if SAH_VERTEX_PACKING_SSE2 && defined(__F16C__)
+#include <immintrin.h>
+#define SAH_VERTEX_PACKING_F16C 1
+#else
+#define SAH_VERTEX_PACKING_F16C 0
+#endif
+
+namespace render {
+    static float2 sign_not_zero(const float2 value) {
+        return {value.x >= 0.f ? 1.f : -1.f, value.y >= 0.f ? 1.f : -1.f};
+    }
+
+    /**
+     * Maps a direction to the [-1, 1] square. Must match get_octahedral_coordinates in common/octahedral.slangi
+     */
+    static float2 octahedral_encode(const float3 direction) {
+        const auto l1_norm = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+        if(l1_norm <= 0.f) {
+            // Degenerate vectors encode to +Z
+            return float2{0};
+        }
+
+        auto uv = float2{direction.x, direction.y} / l1_norm;
+        if(direction.z < 0.f) {
+            uv = (1.f - glm::abs(float2{uv.y, uv.x})) * sign_not_zero(uv);
+        }
+
+        return uv;
+    }
+
+    static float3 octahedral_decode(const float2 uv) {
+        auto direction = float3{uv.x, uv.y, 1.f - glm::abs(uv.x) - glm::abs(uv.y)};
+        if(direction.z < 0.f) {
+            const auto folded = (1.f - glm::abs(float2{direction.y, direction.x})) * sign_not_zero(float2{direction});
+            direction.x = folded.x;
+            direction.y = folded.y;
+        }
+
+        return glm::normalize(direction);
+    }
+
+    /**
+     * Like glm::packSnorm2x16, but rounds ties to even like _mm_cvtps_epi32 does. glm rounds them away from zero, which
+     * would make a vertex's bits depend on whether it went down the SIMD path
+     */
+    static uint32_t pack_snorm16x2(const float2 value) {
+        const auto quantized = glm::clamp(value, -1.f, 1.f) * 32767.f;
+        const auto u = static_cast<int32_t>(std::nearbyint(quantized.x));
+        const auto v = static_cast<int32_t>(std::nearbyint(quantized.y));
+        return (static_cast<uint32_t>(u) & 0xFFFFu) | static_cast<uint32_t>(v) << 16;
+    }
+
+    static PackedVertexData pack_vertex(const StandardVertexData& vertex) {
+        const auto tangent_sign_bit = vertex.tangent.w < 0.f ? 1u : 0u;
+        return PackedVertexData{
+            .normal = pack_snorm16x2(octahedral_encode(vertex.normal)),
+            .tangent = (pack_snorm16x2(octahedral_encode(float3{vertex.tangent})) & ~1u) | tangent_sign_bit,
+            .texcoord = glm::packHalf2x16(vertex.texcoord),
+            .color = vertex.color,
+        };
+    }
+
+    static StandardVertexData unpack_vertex(const PackedVertexData& packed) {
+        return StandardVertexData{
+            .normal = octahedral_decode(glm::unpackSnorm2x16(packed.normal)),
+            .tangent = float4{
+                octahedral_decode(glm::unpackSnorm2x16(packed.tangent & ~1u)),
+                (packed.tangent & 1u) != 0 ? -1.f : 1.f
+            },
+            .texcoord = glm::unpackHalf2x16(packed.texcoord),
+            .color = packed.color,
+        };
+    }
+
+#if SAH_VERTEX_PACKING_SSE2
+    static __m128 abs_sse2(const __m128 value) {
+        return _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+    }
+
+    static __m128 sign_not_zero_sse2(const __m128 value) {
+        const auto is_negative = _mm_cmplt_ps(value, _mm_setzero_ps());
+        return _mm_or_ps(
+            _mm_and_ps(is_negative, _mm_set1_ps(-1.f)),
+            _mm_andnot_ps(is_negative, _mm_set1_ps(1.f)));
+    }
+
+    static __m128 select_sse2(const __m128 mask, const __m128 if_true, const __m128 if_false) {
+        return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+    }
+
+    /**
+     * Octahedral-encodes four directions, given as separate x, y, and z lanes, and packs each into two snorm16s
+     */
+    static __m128i octahedral_encode_snorm16_sse2(const __m128 x, const __m128 y, const __m128 z) {
+        const auto zero = _mm_setzero_ps();
+        const auto one = _mm_set1_ps(1.f);
+
+        const auto l1_norm = _mm_add_ps(_mm_add_ps(abs_sse2(x), abs_sse2(y)), abs_sse2(z));
+
+        // Divide rather than multiply by the reciprocal, so we get the same bits as the scalar path. Degenerate vectors
+        // are masked to 0, so they encode to +Z like the scalar path
+        const auto is_valid = _mm_cmpgt_ps(l1_norm, zero);
+        const auto u = _mm_and_ps(_mm_div_ps(x, l1_norm), is_valid);
+        const auto v = _mm_and_ps(_mm_div_ps(y, l1_norm), is_valid);
+
+        // Fold the lower hemisphere over the diagonals
+        const auto folded_u = _mm_mul_ps(_mm_sub_ps(one, abs_sse2(v)), sign_not_zero_sse2(u));
+        const auto folded_v = _mm_mul_ps(_mm_sub_ps(one, abs_sse2(u)), sign_not_zero_sse2(v));
+        const auto is_lower = _mm_cmplt_ps(z, zero);
+        const auto final_u = _mm_max_ps(_mm_min_ps(select_sse2(is_lower, folded_u, u), one), _mm_set1_ps(-1.f));
+        const auto final_v = _mm_max_ps(_mm_min_ps(select_sse2(is_lower, folded_v, v), one), _mm_set1_ps(-1.f));
+
+        // Rounds ties to even, with the default MXCSR. pack_snorm16x2 does the same
+        const auto scale = _mm_set1_ps(32767.f);
+        const auto quantized_u = _mm_cvtps_epi32(_mm_mul_ps(final_u, scale));
+        const auto quantized_v = _mm_cvtps_epi32(_mm_mul_ps(final_v, scale));
+
+        return _mm_or_si128(_mm_and_si128(quantized_u, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(quantized_v, 16));
+    }
+#endif
+
+    void pack_vertex_data(
+        const eastl::span<const StandardVertexData> vertices, const eastl::span<PackedVertexData> packed_vertices
+        ) {
+        ZoneScoped;
+
+        assert(vertices.size() == packed_vertices.size());
+
+        auto i = size_t{0};
+
+#if SAH_VERTEX_PACKING_SSE2
+        for(; i + 4 <= vertices.size(); i += 4) {
+            const auto& v0 = vertices[i];
+            const auto& v1 = vertices[i + 1];
+            const auto& v2 = vertices[i + 2];
+            const auto& v3 = vertices[i + 3];
+
+            // The vertices are AoS, transpose them into lanes
+            const auto normals = octahedral_encode_snorm16_sse2(
+                _mm_setr_ps(v0.normal.x, v1.normal.x, v2.normal.x, v3.normal.x),
+                _mm_setr_ps(v0.normal.y, v1.normal.y, v2.normal.y, v3.normal.y),
+                _mm_setr_ps(v0.normal.z, v1.normal.z, v2.normal.z, v3.normal.z));
+            const auto tangents = octahedral_encode_snorm16_sse2(
+                _mm_setr_ps(v0.tangent.x, v1.tangent.x, v2.tangent.x, v3.tangent.x),
+                _mm_setr_ps(v0.tangent.y, v1.tangent.y, v2.tangent.y, v3.tangent.y),
+                _mm_setr_ps(v0.tangent.z, v1.tangent.z, v2.tangent.z, v3.tangent.z));
+
+            const auto tangent_signs = _mm_setr_ps(v0.tangent.w, v1.tangent.w, v2.tangent.w, v3.tangent.w);
+            const auto sign_bit = _mm_set1_epi32(1);
+            const auto tangent_sign_bits = _mm_and_si128(
+                _mm_castps_si128(_mm_cmplt_ps(tangent_signs, _mm_setzero_ps())),
+                sign_bit);
+            const auto tangents_with_sign = _mm_or_si128(_mm_andnot_si128(sign_bit, tangents), tangent_sign_bits);
+
+            alignas(16) uint32_t packed_normals[4];
+            alignas(16) uint32_t packed_tangents[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(packed_normals), normals);
+            _mm_store_si128(reinterpret_cast<__m128i*>(packed_tangents), tangents_with_sign);
+
+            alignas(16) uint32_t packed_texcoords[4];
+#if SAH_VERTEX_PACKING_F16C
+            const auto texcoords_01 = _mm_cvtps_ph(
+                _mm_setr_ps(v0.texcoord.x, v0.texcoord.y, v1.texcoord.x, v1.texcoord.y),
+                _MM_FROUND_TO_NEAREST_INT);
+            const auto texcoords_23 = _mm_cvtps_ph(
+                _mm_setr_ps(v2.texcoord.x, v2.texcoord.y, v3.texcoord.x, v3.texcoord.y),
+                _MM_FROUND_TO_NEAREST_INT);
+            _mm_store_si128(reinterpret_cast<__m128i*>(packed_texcoords), _mm_unpacklo_epi64(texcoords_01, texcoords_23));
+#else
+            packed_texcoords[0] = glm::packHalf2x16(v0.texcoord);
+            packed_texcoords[1] = glm::packHalf2x16(v1.texcoord);
+            packed_texcoords[2] = glm::packHalf2x16(v2.texcoord);
+            packed_texcoords[3] = glm::packHalf2x16(v3.texcoord);
+#endif
+
+            for(auto lane = 0u; lane < 4; lane++) {
+                packed_vertices[i + lane] = PackedVertexData{
+                    .normal = packed_normals[lane],
+                    .tangent = packed_tangents[lane],
+                    .texcoord = packed_texcoords[lane],
+                    .color = vertices[i + lane].color,
+                };
+            }
+        }
+#endif
+
+        for(; i < vertices.size(); i++) {
+            packed_vertices[i] = pack_vertex(vertices[i]);
+        }
+    }
+
+    void unpack_vertex_data(
+        const eastl::span<const PackedVertexData> packed_vertices, const eastl::span<StandardVertexData> vertices
+        ) {
+        ZoneScoped;
+
+        assert(vertices.size() == packed_vertices.size());
+
+        for(auto i = 0u; i < packed_vertices.size(); i++) {
+            vertices[i] = unpack_vertex(packed_vertices[i]);
+        }
+    }
+
+    VertexPackingError measure_vertex_packing_error(
+        const eastl::span<const StandardVertexData> vertices, const eastl::span<const PackedVertexData> packed_vertices
+        ) {
+        ZoneScoped;
+
+        assert(vertices.size() == packed_vertices.size());
+
+        const auto angle_between = [](const float3 a, const float3 b) {
+            const auto length_a = glm::length(a);
+            if(length_a <= 0.f) {
+                return 0.f;
+            }
+            return glm::degrees(glm::acos(glm::clamp(glm::dot(a / length_a, b), -1.f, 1.f)));
+        };
+
+        auto error = VertexPackingError{};
+        for(auto i = 0u; i < vertices.size(); i++) {
+            const auto& original = vertices[i];
+            const auto unpacked = unpack_vertex(packed_vertices[i]);
+
+            error.max_normal_error_degrees = glm::max(
+                error.max_normal_error_degrees,
+                angle_between(original.normal, unpacked.normal));
+            error.max_tangent_error_degrees = glm::max(
+                error.max_tangent_error_degrees,
+                angle_between(float3{original.tangent}, float3{unpacked.tangent}));
+
+            const auto texcoord_error = glm::abs(original.texcoord - unpacked.texcoord);
+            error.max_texcoord_error = glm::max(
+                error.max_texcoord_error,
+                glm::max(texcoord_error.x, texcoord_error.y));
+
+            if((original.tangent.w < 0.f) != (unpacked.tangent.w < 0.f)) {
+                error.num_tangent_sign_errors++;
+            }
+        }
+
+        return error;
+    }
+}
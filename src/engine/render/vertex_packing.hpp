@@ -0,0 +1,42 @@
+#pragma once
+
+#include <EASTL/span.h>
+
+#include "shared/vertex_data.hpp"
+
+namespace render {
+    /**
+     * Largest round-trip error from packing some vertices
+     */
+    struct VertexPackingError {
+        float max_normal_error_degrees = 0;
+
+        float max_tangent_error_degrees = 0;
+
+        float max_texcoord_error = 0;
+
+        uint32_t num_tangent_sign_errors = 0;
+    };
+
+    /**
+     * Packs vertex data into the compressed layout. Uses SSE2 on x64, and a scalar path elsewhere
+     *
+     * @param vertices Vertices to pack
+     * @param packed_vertices Where to write the packed vertices. Must be the same size as vertices
+     */
+    void pack_vertex_data(eastl::span<const StandardVertexData> vertices, eastl::span<PackedVertexData> packed_vertices);
+
+    /**
+     * Unpacks vertex data. This matches what the shaders in common/vertex_packing.slangi do
+     */
+    void unpack_vertex_data(
+        eastl::span<const PackedVertexData> packed_vertices, eastl::span<StandardVertexData> vertices
+    );
+
+    /**
+     * Unpacks the packed vertices and compares them with the originals
+     */
+    VertexPackingError measure_vertex_packing_error(
+        eastl::span<const StandardVertexData> vertices, eastl::span<const PackedVertexData> packed_vertices
+    );
+}
@@ -130,7 +130,7 @@ namespace render {
                     .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
                     .clear_value = {.depthStencil = {.depth = 0.f}}
                 },
-                .execute = [&](CommandBuffer& commands) {
+                .execute = [this, &view, &sun](CommandBuffer& commands) {
                     commands.bind_buffer_reference(0, view.get_constant_buffer());
                     commands.bind_buffer_reference(2, sun.get_constant_buffer());
 
@@ -308,7 +308,8 @@ namespace render {
                 .vertex_position_buffer = mesh_storage.get_vertex_position_buffer()->address + batch->mesh->first_vertex *
                 sizeof(StandardVertexPosition),
                 .vertex_data_buffer = mesh_storage.get_vertex_data_buffer()->address + batch->mesh->first_vertex *
-                sizeof(StandardVertexData),
+                mesh_storage.get_vertex_data_stride(),
+                .type_flags = mesh_storage.get_vertex_data_type_flags(),
             });
     }
 
@@ -94,6 +94,8 @@ namespace render {
             float4 tint_color;
             DeviceAddress vertex_position_buffer;
             DeviceAddress vertex_data_buffer;
+            uint32_t type_flags;
+            uint32_t padding;
         };
 
         struct Drawcall {
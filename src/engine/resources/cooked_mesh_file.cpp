@@ -0,0 +1,303 @@
+#include "cooked_mesh_file.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include <spdlog/logger.h>
+#include <tracy/Tracy.hpp>
+
+#include "core/system_interface.hpp"
+#include "shared/primitive_data.hpp"
+
+static std::shared_ptr<spdlog::logger> logger;
+
+static std::once_flag logger_init_flag;
+
+static void init_logger() {
+    std::call_once(
+        logger_init_flag,
+        [] {
+            logger = SystemInterface::get().get_logger("CookedMeshFile");
+        });
+}
+
+/**
+ * 'SMSH'
+ */
+constexpr uint32_t COOKED_MESH_MAGIC = 0x48534D53;
+
+constexpr uint32_t PRIMITIVE_HAS_WINDING_BIT = 1 << 0;
+constexpr uint32_t PRIMITIVE_WINDING_CCW_BIT = 1 << 1;
+
+/**
+ * Streams are aligned so they can be read in place, and so the upload code can copy them with wide loads
+ */
+constexpr size_t STREAM_ALIGNMENT = 16;
+
+struct CookedMeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_meshes;
+    uint32_t num_primitives;
+};
+
+struct CookedPrimitiveRecord {
+    uint32_t mesh_index;
+    uint32_t flags;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+    uint32_t num_weights;
+    uint32_t num_meshlets;
+    uint32_t num_lods;
+    uint32_t padding;
+    float3 bounds_min;
+    float3 bounds_max;
+    uint64_t positions_offset;
+    uint64_t vertex_data_offset;
+    uint64_t indices_offset;
+    uint64_t bone_ids_offset;
+    uint64_t weights_offset;
+    uint64_t meshlets_offset;
+    uint64_t lods_offset;
+};
+
+static size_t align_offset(const size_t offset) {
+    return (offset + STREAM_ALIGNMENT - 1) & ~(STREAM_ALIGNMENT - 1);
+}
+
+template<typename DataType>
+static uint64_t append_stream(eastl::vector<std::byte>& data, const eastl::vector<DataType>& stream) {
+    const auto offset = align_offset(data.size());
+    data.resize(offset + stream.size() * sizeof(DataType));
+    if(!stream.empty()) {
+        std::memcpy(data.data() + offset, stream.data(), stream.size() * sizeof(DataType));
+    }
+
+    return offset;
+}
+
+template<typename DataType>
+static eastl::optional<eastl::span<const DataType>> get_stream(
+    const eastl::span<const std::byte> data, const uint64_t offset, const uint32_t count
+    ) {
+    if(offset % alignof(DataType) != 0 || offset + count * sizeof(DataType) > data.size()) {
+        return eastl::nullopt;
+    }
+
+    return eastl::span{reinterpret_cast<const DataType*>(data.data() + offset), count};
+}
+
+eastl::optional<CookedMeshFile> CookedMeshFile::load(const std::filesystem::path& filepath) {
+    ZoneScoped;
+
+    init_logger();
+
+    auto mapped_file = MappedFile::open(filepath);
+    if(!mapped_file) {
+        return eastl::nullopt;
+    }
+
+    auto file = CookedMeshFile{};
+    file.mapped_file = eastl::move(*mapped_file);
+
+    if(!file.parse()) {
+        logger->warn("Cooked mesh file {} is stale or malformed, it will be rebuilt", filepath.string());
+        return eastl::nullopt;
+    }
+
+    return file;
+}
+
+CookedMeshFile CookedMeshFile::build(const eastl::span<const eastl::vector<MeshPrimitiveData>> meshes) {
+    ZoneScoped;
+
+    auto num_primitives = 0u;
+    for(const auto& mesh : meshes) {
+        num_primitives += static_cast<uint32_t>(mesh.size());
+    }
+
+    const auto header = CookedMeshHeader{
+        .magic = COOKED_MESH_MAGIC,
+        .version = VERSION,
+        .num_meshes = static_cast<uint32_t>(meshes.size()),
+        .num_primitives = num_primitives,
+    };
+
+    auto file = CookedMeshFile{};
+    auto& data = file.owned_data;
+    data.resize(sizeof(CookedMeshHeader) + sizeof(CookedPrimitiveRecord) * num_primitives);
+    std::memcpy(data.data(), &header, sizeof(CookedMeshHeader));
+
+    auto records = eastl::vector<CookedPrimitiveRecord>{};
+    records.reserve(num_primitives);
+
+    for(auto mesh_index = 0u; mesh_index < meshes.size(); mesh_index++) {
+        for(const auto& primitive : meshes[mesh_index]) {
+            auto flags = 0u;
+            if(primitive.front_face_ccw) {
+                flags |= PRIMITIVE_HAS_WINDING_BIT;
+                if(*primitive.front_face_ccw) {
+                    flags |= PRIMITIVE_WINDING_CCW_BIT;
+                }
+            }
+
+            records.emplace_back(
+                CookedPrimitiveRecord{
+                    .mesh_index = mesh_index,
+                    .flags = flags,
+                    .num_vertices = static_cast<uint32_t>(primitive.positions.size()),
+                    .num_indices = static_cast<uint32_t>(primitive.indices.size()),
+                    .num_weights = static_cast<uint32_t>(primitive.weights.size()),
+                    .num_meshlets = static_cast<uint32_t>(primitive.meshlets.size()),
+                    .num_lods = static_cast<uint32_t>(primitive.lods.size()),
+                    .padding = 0,
+                    .bounds_min = primitive.bounds.min,
+                    .bounds_max = primitive.bounds.max,
+                    .positions_offset = append_stream(data, primitive.positions),
+                    .vertex_data_offset = append_stream(data, primitive.vertex_data),
+                    .indices_offset = append_stream(data, primitive.indices),
+                    .bone_ids_offset = append_stream(data, primitive.bone_ids),
+                    .weights_offset = append_stream(data, primitive.weights),
+                    .meshlets_offset = append_stream(data, primitive.meshlets),
+                    .lods_offset = append_stream(data, primitive.lods),
+                });
+        }
+    }
+
+    std::memcpy(
+        data.data() + sizeof(CookedMeshHeader),
+        records.data(),
+        records.size() * sizeof(CookedPrimitiveRecord));
+
+    [[maybe_unused]] const auto parsed = file.parse();
+    assert(parsed);
+
+    return file;
+}
+
+void CookedMeshFile::save(const std::filesystem::path& filepath) const {
+    ZoneScoped;
+
+    init_logger();
+
+    if(!std::filesystem::exists(filepath.parent_path())) {
+        std::filesystem::create_directories(filepath.parent_path());
+    }
+
+    const auto bytes = get_bytes();
+
+    // Write to a temporary file and then move it into place, so that an interrupted write never leaves a half-written
+    // file that looks valid
+    auto temp_path = filepath;
+    temp_path += ".tmp";
+    {
+        auto stream = std::ofstream{temp_path, std::ios::binary};
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if(!stream) {
+            logger->error("Could not write cooked mesh file {}", filepath.string());
+            return;
+        }
+    }
+
+    auto error = std::error_code{};
+    std::filesystem::rename(temp_path, filepath, error);
+    if(error) {
+        logger->error("Could not write cooked mesh file {}: {}", filepath.string(), error.message());
+    }
+}
+
+size_t CookedMeshFile::get_num_meshes() const {
+    return meshes.size();
+}
+
+eastl::span<const CookedPrimitive> CookedMeshFile::get_primitives(const size_t mesh_index) const {
+    return meshes.at(mesh_index);
+}
+
+eastl::span<const std::byte> CookedMeshFile::get_bytes() const {
+    if(!owned_data.empty()) {
+        return owned_data;
+    }
+
+    return mapped_file.get_data();
+}
+
+bool CookedMeshFile::parse() {
+    const auto data = get_bytes();
+    if(data.size() < sizeof(CookedMeshHeader)) {
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const CookedMeshHeader*>(data.data());
+    if(header->magic != COOKED_MESH_MAGIC || header->version != VERSION) {
+        return false;
+    }
+
+    const auto records_size = sizeof(CookedPrimitiveRecord) * header->num_primitives;
+    if(data.size() < sizeof(CookedMeshHeader) + records_size) {
+        return false;
+    }
+
+    const auto records = eastl::span{
+        reinterpret_cast<const CookedPrimitiveRecord*>(data.data() + sizeof(CookedMeshHeader)),
+        header->num_primitives
+    };
+
+    meshes.clear();
+    meshes.resize(header->num_meshes);
+
+    for(const auto& record : records) {
+        if(record.mesh_index >= header->num_meshes) {
+            return false;
+        }
+
+        const auto positions = get_stream<StandardVertexPosition>(data, record.positions_offset, record.num_vertices);
+        const auto vertex_data = get_stream<StandardVertexData>(data, record.vertex_data_offset, record.num_vertices);
+        const auto indices = get_stream<uint32_t>(data, record.indices_offset, record.num_indices);
+        const auto bone_ids = get_stream<u16vec4>(data, record.bone_ids_offset, record.num_weights);
+        const auto weights = get_stream<float4>(data, record.weights_offset, record.num_weights);
+        const auto meshlets = get_stream<MeshletGPU>(data, record.meshlets_offset, record.num_meshlets);
+        const auto lods = get_stream<render::MeshLod>(data, record.lods_offset, record.num_lods);
+        if(!positions || !vertex_data || !indices || !bone_ids || !weights || !meshlets || !lods) {
+            return false;
+        }
+
+        if(lods->size() > MESH_MAX_LODS) {
+            return false;
+        }
+
+        for(const auto& lod : *lods) {
+            if(static_cast<uint64_t>(lod.first_index) + lod.num_indices > record.num_indices) {
+                return false;
+            }
+        }
+
+        for(const auto& meshlet : *meshlets) {
+            if(static_cast<uint64_t>(meshlet.first_index) + meshlet.num_triangles * 3ull > record.num_indices) {
+                return false;
+            }
+        }
+
+        auto front_face_ccw = eastl::optional<bool>{};
+        if((record.flags & PRIMITIVE_HAS_WINDING_BIT) != 0) {
+            front_face_ccw = (record.flags & PRIMITIVE_WINDING_CCW_BIT) != 0;
+        }
+
+        meshes[record.mesh_index].emplace_back(
+            CookedPrimitive{
+                .positions = *positions,
+                .vertex_data = *vertex_data,
+                .indices = *indices,
+                .bone_ids = *bone_ids,
+                .weights = *weights,
+                .meshlets = *meshlets,
+                .lods = *lods,
+                .bounds = {.min = record.bounds_min, .max = record.bounds_max},
+                .front_face_ccw = front_face_ccw,
+            });
+    }
+
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <filesystem>
+
+#include <EASTL/optional.h>
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+#include "core/box.hpp"
+#include "core/mapped_file.hpp"
+#include "render/mesh_lod.hpp"
+#include "shared/meshlet.hpp"
+#include "shared/vertex_data.hpp"
+
+/**
+ * Mesh data for a single primitive, already split into the streams that MeshStorage wants
+ */
+struct MeshPrimitiveData {
+    eastl::vector<StandardVertexPosition> positions;
+
+    eastl::vector<StandardVertexData> vertex_data;
+
+    eastl::vector<uint32_t> indices;
+
+    /**
+     * Skinning data. Empty for primitives without skinning
+     */
+    eastl::vector<u16vec4> bone_ids;
+    eastl::vector<float4> weights;
+
+    /**
+     * Meshlets that cover the index buffer. first_index is relative to this primitive's indices. May be empty, in
+     * which case the primitive is only drawn as a whole
+     */
+    eastl::vector<MeshletGPU> meshlets;
+
+    /**
+     * Levels of detail, finest first. LOD 0 covers the indices that the meshlets use, coarser LODs follow it in the
+     * index buffer. May be empty, in which case all the indices are one LOD
+     */
+    eastl::vector<render::MeshLod> lods;
+
+    Box bounds = {};
+
+    /**
+     * Winding order derived from the primitive's tangents, if it has any
+     */
+    eastl::optional<bool> front_face_ccw;
+};
+
+/**
+ * View of a single primitive inside a CookedMeshFile. The spans point into the file's memory
+ */
+struct CookedPrimitive {
+    eastl::span<const StandardVertexPosition> positions;
+
+    eastl::span<const StandardVertexData> vertex_data;
+
+    eastl::span<const uint32_t> indices;
+
+    eastl::span<const u16vec4> bone_ids;
+    eastl::span<const float4> weights;
+
+    eastl::span<const MeshletGPU> meshlets;
+
+    eastl::span<const render::MeshLod> lods;
+
+    Box bounds = {};
+
+    eastl::optional<bool> front_face_ccw;
+};
+
+/**
+ * Binary blob with all the meshes of a model, cooked into the layout that MeshStorage uploads. We write one of these
+ * to the cache folder the first time we import a model. Later loads memory-map the file and hand spans straight to the
+ * mesh storage, so we don't have to touch the glTF accessors at all
+ */
+class CookedMeshFile {
+public:
+    /**
+     * Bump this whenever the layout changes, so that stale files get rebuilt
+     */
+    static constexpr uint32_t VERSION = 5;
+
+    /**
+     * Memory-maps a cooked mesh file. Returns an empty optional if the file doesn't exist, is from a different
+     * version, or is malformed
+     */
+    static eastl::optional<CookedMeshFile> load(const std::filesystem::path& filepath);
+
+    /**
+     * Cooks some meshes into an in-memory file
+     *
+     * @param meshes Outer span is the mesh, inner vector is the primitives in that mesh
+     */
+    static CookedMeshFile build(eastl::span<const eastl::vector<MeshPrimitiveData>> meshes);
+
+    CookedMeshFile() = default;
+
+    CookedMeshFile(const CookedMeshFile& other) = delete;
+    CookedMeshFile& operator=(const CookedMeshFile& other) = delete;
+
+    CookedMeshFile(CookedMeshFile&& old) noexcept = default;
+    CookedMeshFile& operator=(CookedMeshFile&& old) noexcept = default;
+
+    /**
+     * Writes the file to disk, creating parent folders as needed
+     */
+    void save(const std::filesystem::path& filepath) const;
+
+    size_t get_num_meshes() const;
+
+    eastl::span<const CookedPrimitive> get_primitives(size_t mesh_index) const;
+
+private:
+    MappedFile mapped_file;
+
+    eastl::vector<std::byte> owned_data;
+
+    eastl::vector<eastl::vector<CookedPrimitive>> meshes;
+
+    eastl::span<const std::byte> get_bytes() const;
+
+    /**
+     * Builds the CookedPrimitive views from the raw file data
+     */
+    bool parse();
+};
@@ -1,5 +1,6 @@
 #include "gltf_model.hpp"
 
+#include <mutex>
 #include <numbers>
 
 #include <Jolt/Jolt.h>
@@ -25,12 +26,14 @@
 #include "core/box.hpp"
 #include "core/engine.hpp"
 #include "core/generated_entity_component.hpp"
+#include "core/thread_pool.hpp"
 #include "core/visitor.hpp"
 #include "physics/collider_component.hpp"
 #include "player/player_parent_component.hpp"
 #include "render/basic_pbr_material.hpp"
 #include "render/sarah_renderer.hpp"
 #include "render/texture_loader.hpp"
+#include "resources/mesh_optimization.hpp"
 #include "render/components/light_component.hpp"
 #include "render/components/skeletal_mesh_component.hpp"
 #include "render/components/static_mesh_component.hpp"
@@ -46,9 +49,39 @@ struct fastgltf::ElementTraits<glm::quat> : fastgltf::ElementTraits<fastgltf::ma
 
 static std::shared_ptr<spdlog::logger> logger;
 
+static std::once_flag logger_init_flag;
+
+/**
+ * Models may be read on worker threads, so the logger gets created exactly once by whoever gets there first
+ */
+static void init_logger() {
+    std::call_once(
+        logger_init_flag,
+        [] {
+            logger = SystemInterface::get().get_logger("GltfModel");
+        });
+}
+
 static bool front_face_ccw = false;
 
-static eastl::vector<StandardVertex> read_vertex_data(const fastgltf::Primitive& primitive, const fastgltf::Asset& model
+static MeshPrimitiveData read_primitive_data(const fastgltf::Primitive& primitive, const fastgltf::Asset& model);
+
+static bool cooked_meshes_match_asset(const CookedMeshFile& cooked_meshes, const fastgltf::Asset& asset);
+
+/**
+ * Logs the vertex cache stats for each mesh, and a summary for the whole model
+ */
+static void log_optimization_stats(
+    const ResourcePath& filepath, const fastgltf::Asset& asset,
+    eastl::span<const eastl::pair<size_t, size_t>> primitive_ids, eastl::span<const MeshOptimizationStats> stats
+    );
+
+static GltfImageData load_image_data(
+    size_t image_index, const fastgltf::Asset& asset, const std::filesystem::path& model_folder
+    );
+
+static eastl::vector<StandardVertex> read_vertex_data(
+    const fastgltf::Primitive& primitive, const fastgltf::Asset& model, eastl::optional<bool>& front_face_ccw_out
     );
 
 static eastl::vector<uint32_t> read_index_data(const fastgltf::Primitive& primitive, const fastgltf::Asset& model);
@@ -59,7 +92,11 @@ static eastl::tuple<eastl::vector<u16vec4>, eastl::vector<float4> > read_skinnin
 
 static Box read_mesh_bounds(const fastgltf::Primitive& primitive, const fastgltf::Asset& model);
 
-static void copy_vertex_data_to_vector(
+/**
+ * Copies the primitive's vertex attributes into the vertex array. Returns the winding order implied by the primitive's
+ * tangents, if it has any
+ */
+static eastl::optional<bool> copy_vertex_data_to_vector(
     const fastgltf::Primitive& primitive,
     const fastgltf::Asset& model,
     StandardVertex* vertices
@@ -101,23 +138,109 @@ GltfModel::~GltfModel() {
     animations.destroy_skeleton(skeleton_handle);
 }
 
+std::filesystem::path GltfModel::get_cached_data_path(const ResourcePath& filepath) {
+    auto cached_data_path = SystemInterface::get().get_cache_folder() / filepath.get_path();
+    cached_data_path.replace_extension();
+    return cached_data_path;
+}
+
+std::filesystem::path GltfModel::get_cooked_meshes_path(const ResourcePath& filepath) {
+    return get_cached_data_path(filepath) / "meshes.smesh";
+}
+
+GltfImportData GltfModel::read_import_data(
+    const ResourcePath& filepath, const fastgltf::Asset& asset, const bool load_images
+    ) {
+    ZoneScoped;
+
+    init_logger();
+
+    auto import_data = GltfImportData{};
+
+    // Use the cooked meshes if they're newer than the model. Otherwise, we read the meshes from the glTF buffers and
+    // cook them for next time
+    const auto cooked_meshes_path = get_cooked_meshes_path(filepath);
+    if(exists(cooked_meshes_path) && last_write_time(cooked_meshes_path) > last_write_time(filepath.to_filepath())) {
+        auto cooked_meshes = CookedMeshFile::load(cooked_meshes_path);
+        if(cooked_meshes && cooked_meshes_match_asset(*cooked_meshes, asset)) {
+            import_data.meshes = eastl::move(*cooked_meshes);
+        }
+    }
+
+    const auto needs_cook = import_data.meshes.get_num_meshes() != asset.meshes.size();
+
+    // Flatten the primitives into one list, so the thread pool can balance big meshes against small ones
+    auto primitive_ids = eastl::vector<eastl::pair<size_t, size_t>>{};
+    auto primitives = eastl::vector<eastl::vector<MeshPrimitiveData>>{};
+    if(needs_cook) {
+        primitives.resize(asset.meshes.size());
+        for(auto mesh_idx = 0u; mesh_idx < asset.meshes.size(); mesh_idx++) {
+            const auto& mesh = asset.meshes[mesh_idx];
+            primitives[mesh_idx].resize(mesh.primitives.size());
+            for(auto primitive_idx = 0u; primitive_idx < mesh.primitives.size(); primitive_idx++) {
+                primitive_ids.emplace_back(mesh_idx, primitive_idx);
+            }
+        }
+    }
+    auto optimization_stats = eastl::vector<MeshOptimizationStats>(primitive_ids.size());
+
+    // Only load the images that a texture refers to
+    auto image_ids = eastl::vector<size_t>{};
+    import_data.images.resize(asset.images.size());
+    if(load_images) {
+        for(const auto& gltf_texture : asset.textures) {
+            const auto image_index = gltf_texture.basisuImageIndex
+                                         ? *gltf_texture.basisuImageIndex
+                                         : *gltf_texture.imageIndex;
+            if(eastl::find(image_ids.begin(), image_ids.end(), image_index) == image_ids.end()) {
+                image_ids.emplace_back(image_index);
+            }
+        }
+    }
+
+    const auto model_folder = filepath.to_filepath().parent_path();
+
+    ThreadPool::get().parallel_for(
+        primitive_ids.size() + image_ids.size(),
+        [&](const size_t i) {
+            if(i < primitive_ids.size()) {
+                const auto& [mesh_idx, primitive_idx] = primitive_ids[i];
+                const auto& primitive = asset.meshes[mesh_idx].primitives[primitive_idx];
+                primitives[mesh_idx][primitive_idx] = read_primitive_data(primitive, asset);
+                optimization_stats[i] = optimize_mesh(primitives[mesh_idx][primitive_idx]);
+            } else {
+                const auto image_index = image_ids[i - primitive_ids.size()];
+                import_data.images[image_index] = load_image_data(image_index, asset, model_folder);
+            }
+        });
+
+    if(needs_cook) {
+        log_optimization_stats(filepath, asset, primitive_ids, optimization_stats);
+
+        logger->info("Cooking meshes for model {}", filepath);
+        import_data.meshes = CookedMeshFile::build(primitives);
+        import_data.meshes.save(cooked_meshes_path);
+    }
+
+    return import_data;
+}
+
 GltfModel::GltfModel(
     ResourcePath filepath_in,
     fastgltf::Asset&& model,
+    GltfImportData&& import_data_in,
     render::SarahRenderer& renderer,
     ExtrasData extras_in
     ) :
     filepath{std::move(filepath_in)},
-    cached_data_path{SystemInterface::get().get_cache_folder() / filepath.get_path()},
+    cached_data_path{get_cached_data_path(filepath)},
     asset{std::move(model)},
-    extras{eastl::move(extras_in)} {
-    if(logger == nullptr) {
-        logger = SystemInterface::get().get_logger("GltfModel");
-    }
+    extras{eastl::move(extras_in)},
+    import_data{eastl::move(import_data_in)} {
+    init_logger();
 
     ZoneScoped;
 
-    cached_data_path.replace_extension();
     if(!exists(cached_data_path)) {
         std::filesystem::create_directories(cached_data_path);
     }
@@ -128,6 +251,8 @@ GltfModel::GltfModel(
 
     import_resources_for_model(renderer);
 
+    import_data = {};
+
     calculate_bounding_sphere_and_footprint();
 
     logger->info("Loaded model {}", filepath);
@@ -625,10 +750,20 @@ void GltfModel::import_materials(
         }
 
         if(gltf_material.pbrData.baseColorTexture) {
+            // The shader tests the texture's alpha times the base color factor's alpha, so move the cutoff into
+            // texture space
+            auto alpha_cutoff = eastl::optional<float>{};
+            if(gltf_material.alphaMode == fastgltf::AlphaMode::Mask) {
+                alpha_cutoff = glm::min(
+                    gltf_material.alphaCutoff / glm::max(gltf_material.pbrData.baseColorFactor[3], 0.001f),
+                    1.f);
+            }
+
             material.base_color_texture = get_texture(
                 gltf_material.pbrData.baseColorTexture->textureIndex,
                 render::TextureType::Color,
-                texture_loader
+                texture_loader,
+                alpha_cutoff
                 );
 
             const auto& texture = asset.textures[gltf_material.pbrData.baseColorTexture->textureIndex];
@@ -711,28 +846,40 @@ void GltfModel::import_meshes(render::SarahRenderer& renderer) {
 
     gltf_primitive_to_mesh.reserve(asset.meshes.size());
 
-    for(const auto& mesh : asset.meshes) {
-        // Copy the vertex and index data into the appropriate buffers
-        // Interleave the vertex data, because it's easier for me to handle conceptually
-        // Maybe eventually profile splitting out positions for separate use
+    for(auto mesh_idx = 0u; mesh_idx < asset.meshes.size(); mesh_idx++) {
+        const auto& mesh = asset.meshes[mesh_idx];
+
+        // The vertex and index data was read by read_import_data, we just need to hand it to the mesh storage
 
         auto imported_primitives = eastl::vector<render::MeshHandle>{};
         imported_primitives.reserve(mesh.primitives.size());
 
         auto primitive_idx = 0u;
-        for(const auto& primitive : mesh.primitives) {
-            const auto vertices = read_vertex_data(primitive, asset);
-            const auto indices = read_index_data(primitive, asset);
-
-            const auto mesh_bounds = read_mesh_bounds(primitive, asset);
+        for(const auto& primitive_data : import_data.meshes.get_primitives(mesh_idx)) {
+            if(primitive_data.front_face_ccw) {
+                front_face_ccw = *primitive_data.front_face_ccw;
+            }
 
             auto mesh_maybe = eastl::optional<render::MeshHandle>{};
 
-            if(primitive.findAttribute("WEIGHTS_0") != primitive.attributes.end()) {
-                const auto& [bone_ids, weights] = read_skinning_data(primitive, asset);
-                mesh_maybe = mesh_storage.add_skeletal_mesh(vertices, indices, mesh_bounds, bone_ids, weights);
+            if(!primitive_data.weights.empty()) {
+                mesh_maybe = mesh_storage.add_skeletal_mesh(
+                    primitive_data.positions,
+                    primitive_data.vertex_data,
+                    primitive_data.indices,
+                    primitive_data.bounds,
+                    primitive_data.bone_ids,
+                    primitive_data.weights,
+                    primitive_data.meshlets,
+                    primitive_data.lods);
             } else {
-                mesh_maybe = mesh_storage.add_mesh(vertices, indices, mesh_bounds);
+                mesh_maybe = mesh_storage.add_mesh(
+                    primitive_data.positions,
+                    primitive_data.vertex_data,
+                    primitive_data.indices,
+                    primitive_data.bounds,
+                    primitive_data.meshlets,
+                    primitive_data.lods);
             }
 
             if(mesh_maybe) {
@@ -907,10 +1054,10 @@ void GltfModel::calculate_bounding_sphere_and_footprint() {
 
 render::TextureHandle GltfModel::get_texture(
     const size_t gltf_texture_index, const render::TextureType type,
-    render::TextureLoader& texture_storage
+    render::TextureLoader& texture_storage, const eastl::optional<float> alpha_cutoff
     ) {
     if(gltf_texture_to_texture_handle.find(gltf_texture_index) == gltf_texture_to_texture_handle.end()) {
-        import_single_texture(gltf_texture_index, type, texture_storage);
+        import_single_texture(gltf_texture_index, type, texture_storage, alpha_cutoff);
     }
 
     return gltf_texture_to_texture_handle[gltf_texture_index];
@@ -918,7 +1065,7 @@ render::TextureHandle GltfModel::get_texture(
 
 void GltfModel::import_single_texture(
     const size_t gltf_texture_index, const render::TextureType type,
-    render::TextureLoader& texture_storage
+    render::TextureLoader& texture_storage, const eastl::optional<float> alpha_cutoff
     ) {
     ZoneScoped;
 
@@ -930,78 +1077,26 @@ void GltfModel::import_single_texture(
         image_index = *gltf_texture.imageIndex;
     }
 
-    const auto& image = asset.images[image_index];
-
-    auto image_data = eastl::vector<std::byte>{};
-    auto image_name = ResourcePath{ResourcePath::Scope::File, image.name};
-    auto mime_type = fastgltf::MimeType::None;
-
-    std::visit(
-        Visitor{
-            [&](const auto&) {
-                /* I'm just here so I don't get a compiler error */
-            },
-            [&](const fastgltf::sources::BufferView& buffer_view) {
-                const auto& real_buffer_view = asset.bufferViews[buffer_view.bufferViewIndex];
-                const auto& buffer = asset.buffers[real_buffer_view.bufferIndex];
-                const auto* buffer_vector = std::get_if<fastgltf::sources::Array>(&buffer.data);
-                auto* data_pointer = buffer_vector->bytes.data();
-                data_pointer += real_buffer_view.byteOffset;
-                image_data = {data_pointer, data_pointer + real_buffer_view.byteLength};
-                mime_type = buffer_view.mimeType;
-            },
-            [&](const fastgltf::sources::URI& file_path) {
-                const auto uri = file_path.uri.string();
-
-                logger->info("Loading texture {}", uri);
-
-                // Try to load a KTX version of the texture
-                const auto texture_filepath = filepath.to_filepath().parent_path() / std::filesystem::path{uri};
-                auto ktx_texture_filepath = texture_filepath;
-                ktx_texture_filepath.replace_extension("ktx2");
-                const auto ktx_resource_path = ResourcePath{ResourcePath::Scope::File, ktx_texture_filepath.string()};
-                auto data_maybe = SystemInterface::get().load_file(ktx_resource_path);
-                if(data_maybe) {
-                    image_data = std::move(*data_maybe);
-                    image_name = ktx_resource_path;
-                    mime_type = fastgltf::MimeType::KTX2;
-                    return;
-                }
-
-                const auto texture_resource_path = ResourcePath{ResourcePath::Scope::File, texture_filepath.string()};
-                data_maybe = SystemInterface::get().load_file(texture_resource_path);
-                if(data_maybe) {
-                    image_data = std::move(*data_maybe);
-                    image_name = texture_resource_path;
-                    const auto& extension = texture_filepath.extension();
-                    if(extension == ".png") {
-                        mime_type = fastgltf::MimeType::PNG;
-                    } else if(extension == ".jpg" || extension == ".jpeg") {
-                        mime_type = fastgltf::MimeType::JPEG;
-                    }
-                    return;
-                }
-
-                throw std::runtime_error{fmt::format("Could not load image {}", texture_filepath.string())};
-            },
-            [&](const fastgltf::sources::Array& vector_data) {
-                image_data.resize(vector_data.bytes.size());
-                std::memcpy(image_data.data(), vector_data.bytes.data(), vector_data.bytes.size() * sizeof(std::byte));
-                mime_type = vector_data.mimeType;
-            }
-        },
-        image.data
-        );
+    auto& image_data = import_data.images.at(image_index);
 
     auto handle = eastl::optional<render::TextureHandle>{};
-    if(mime_type == fastgltf::MimeType::PNG || mime_type == fastgltf::MimeType::JPEG) {
-        handle = texture_storage.upload_texture_stbi(image_name, image_data, type);
+    if(image_data.mime_type == fastgltf::MimeType::KTX2) {
+        // The texture loader caches by name, so only the first texture to use this image takes its data
+        handle = texture_storage.upload_texture_ktx(image_data.name, eastl::move(image_data.data), type);
+    } else if(image_data.decoded) {
+        // Copy the decoded data - multiple glTF textures may refer to the same image
+        auto loaded_texture = *image_data.decoded;
+        handle = texture_storage.create_streamed_texture(
+            image_data.name,
+            eastl::move(loaded_texture),
+            type,
+            alpha_cutoff);
     }
 
     if(handle) {
         gltf_texture_to_texture_handle.emplace(gltf_texture_index, *handle);
     } else {
-        throw std::runtime_error{fmt::format("Could not load image {}", image_name)};
+        throw std::runtime_error{fmt::format("Could not load image {}", image_data.name)};
     }
 }
 
@@ -1154,7 +1249,209 @@ eastl::pair<JPH::VertexList, JPH::IndexedTriangleList> GltfModel::read_collision
     return {vertex_positions, indices};
 }
 
-eastl::vector<StandardVertex> read_vertex_data(const fastgltf::Primitive& primitive, const fastgltf::Asset& model) {
+MeshPrimitiveData read_primitive_data(const fastgltf::Primitive& primitive, const fastgltf::Asset& model) {
+    ZoneScoped;
+
+    auto front_face_ccw_maybe = eastl::optional<bool>{};
+    const auto vertices = read_vertex_data(primitive, model, front_face_ccw_maybe);
+
+    // Split the vertices into the streams that the mesh storage uploads, so the cooked file can be uploaded as-is
+    auto primitive_data = MeshPrimitiveData{
+        .indices = read_index_data(primitive, model),
+        .bounds = read_mesh_bounds(primitive, model),
+        .front_face_ccw = front_face_ccw_maybe,
+    };
+    primitive_data.positions.reserve(vertices.size());
+    primitive_data.vertex_data.reserve(vertices.size());
+    for(const auto& vertex : vertices) {
+        primitive_data.positions.emplace_back(vertex.position);
+        primitive_data.vertex_data.emplace_back(
+            StandardVertexData{
+                .normal = vertex.normal,
+                .tangent = vertex.tangent,
+                .texcoord = vertex.texcoord,
+                .color = vertex.color,
+            });
+    }
+
+    if(primitive.findAttribute("WEIGHTS_0") != primitive.attributes.end()) {
+        auto [bone_ids, weights] = read_skinning_data(primitive, model);
+        primitive_data.bone_ids = eastl::move(bone_ids);
+        primitive_data.weights = eastl::move(weights);
+    }
+
+    return primitive_data;
+}
+
+bool cooked_meshes_match_asset(const CookedMeshFile& cooked_meshes, const fastgltf::Asset& asset) {
+    if(cooked_meshes.get_num_meshes() != asset.meshes.size()) {
+        return false;
+    }
+
+    for(auto mesh_idx = 0u; mesh_idx < asset.meshes.size(); mesh_idx++) {
+        if(cooked_meshes.get_primitives(mesh_idx).size() != asset.meshes[mesh_idx].primitives.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void log_optimization_stats(
+    const ResourcePath& filepath, const fastgltf::Asset& asset,
+    const eastl::span<const eastl::pair<size_t, size_t>> primitive_ids,
+    const eastl::span<const MeshOptimizationStats> stats
+    ) {
+    // Weight each primitive's ratios by its size, so the totals are the ratios for all the model's triangles and
+    // vertices together
+    struct Totals {
+        uint32_t num_vertices_before = 0;
+        uint32_t num_vertices_after = 0;
+        double transformed_before = 0;
+        double transformed_after = 0;
+        uint32_t num_triangles = 0;
+    };
+
+    const auto log_totals = [&](const Totals& totals, const std::string_view name) {
+        if(totals.num_triangles == 0 || totals.num_vertices_after == 0) {
+            return;
+        }
+        logger->debug(
+            "{}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+            name,
+            totals.num_vertices_before,
+            totals.num_vertices_after,
+            totals.transformed_before / totals.num_triangles,
+            totals.transformed_after / totals.num_triangles,
+            totals.transformed_before / totals.num_vertices_before,
+            totals.transformed_after / totals.num_vertices_after);
+    };
+
+    const auto add_to_totals = [](Totals& totals, const MeshOptimizationStats& primitive_stats) {
+        const auto num_triangles = primitive_stats.num_indices / 3;
+        totals.num_vertices_before += primitive_stats.num_vertices_before;
+        totals.num_vertices_after += primitive_stats.num_vertices_after;
+        totals.transformed_before += primitive_stats.before.acmr * num_triangles;
+        totals.transformed_after += primitive_stats.after.acmr * num_triangles;
+        totals.num_triangles += num_triangles;
+    };
+
+    auto model_totals = Totals{};
+    auto mesh_totals = Totals{};
+    for(auto i = 0u; i < primitive_ids.size(); i++) {
+        add_to_totals(mesh_totals, stats[i]);
+        add_to_totals(model_totals, stats[i]);
+
+        const auto mesh_index = primitive_ids[i].first;
+        if(i + 1 == primitive_ids.size() || primitive_ids[i + 1].first != mesh_index) {
+            const auto& mesh_name = asset.meshes[mesh_index].name;
+            log_totals(mesh_totals, mesh_name.empty() ? "Unnamed mesh" : std::string_view{mesh_name});
+            mesh_totals = {};
+        }
+    }
+
+    if(model_totals.num_triangles > 0 && model_totals.num_vertices_after > 0) {
+        logger->info(
+            "Optimized meshes for {}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+            filepath,
+            model_totals.num_vertices_before,
+            model_totals.num_vertices_after,
+            model_totals.transformed_before / model_totals.num_triangles,
+            model_totals.transformed_after / model_totals.num_triangles,
+            model_totals.transformed_before / model_totals.num_vertices_before,
+            model_totals.transformed_after / model_totals.num_vertices_after);
+    }
+}
+
+GltfImageData load_image_data(
+    const size_t image_index, const fastgltf::Asset& asset, const std::filesystem::path& model_folder
+    ) {
+    ZoneScoped;
+
+    const auto& image = asset.images[image_index];
+
+    auto image_data = eastl::vector<std::byte>{};
+    auto image_name = ResourcePath{ResourcePath::Scope::File, image.name};
+    auto mime_type = fastgltf::MimeType::None;
+
+    std::visit(
+        Visitor{
+            [&](const auto&) {
+                /* I'm just here so I don't get a compiler error */
+            },
+            [&](const fastgltf::sources::BufferView& buffer_view) {
+                const auto& real_buffer_view = asset.bufferViews[buffer_view.bufferViewIndex];
+                const auto& buffer = asset.buffers[real_buffer_view.bufferIndex];
+                const auto* buffer_vector = std::get_if<fastgltf::sources::Array>(&buffer.data);
+                auto* data_pointer = buffer_vector->bytes.data();
+                data_pointer += real_buffer_view.byteOffset;
+                image_data = {data_pointer, data_pointer + real_buffer_view.byteLength};
+                mime_type = buffer_view.mimeType;
+            },
+            [&](const fastgltf::sources::URI& file_path) {
+                const auto uri = file_path.uri.string();
+
+                logger->info("Loading texture {}", uri);
+
+                // Try to load a KTX version of the texture
+                const auto texture_filepath = model_folder / std::filesystem::path{uri};
+                auto ktx_texture_filepath = texture_filepath;
+                ktx_texture_filepath.replace_extension("ktx2");
+                const auto ktx_resource_path = ResourcePath{ResourcePath::Scope::File, ktx_texture_filepath.string()};
+                auto data_maybe = SystemInterface::get().load_file(ktx_resource_path);
+                if(data_maybe) {
+                    image_data = std::move(*data_maybe);
+                    image_name = ktx_resource_path;
+                    mime_type = fastgltf::MimeType::KTX2;
+                    return;
+                }
+
+                const auto texture_resource_path = ResourcePath{ResourcePath::Scope::File, texture_filepath.string()};
+                data_maybe = SystemInterface::get().load_file(texture_resource_path);
+                if(data_maybe) {
+                    image_data = std::move(*data_maybe);
+                    image_name = texture_resource_path;
+                    const auto& extension = texture_filepath.extension();
+                    if(extension == ".png") {
+                        mime_type = fastgltf::MimeType::PNG;
+                    } else if(extension == ".jpg" || extension == ".jpeg") {
+                        mime_type = fastgltf::MimeType::JPEG;
+                    }
+                    return;
+                }
+
+                logger->error("Could not load image {}", texture_filepath.string());
+            },
+            [&](const fastgltf::sources::Array& vector_data) {
+                image_data.resize(vector_data.bytes.size());
+                std::memcpy(image_data.data(), vector_data.bytes.data(), vector_data.bytes.size() * sizeof(std::byte));
+                mime_type = vector_data.mimeType;
+            }
+        },
+        image.data
+        );
+
+    if(mime_type == fastgltf::MimeType::PNG || mime_type == fastgltf::MimeType::JPEG) {
+        auto decoded = render::TextureLoader::decode_texture_stbi(image_name, image_data);
+        if(decoded) {
+            // We don't need the encoded data anymore
+            image_data = {};
+        }
+
+        return {
+            .name = eastl::move(image_name),
+            .mime_type = mime_type,
+            .data = eastl::move(image_data),
+            .decoded = eastl::move(decoded)
+        };
+    }
+
+    return {.name = eastl::move(image_name), .mime_type = mime_type, .data = eastl::move(image_data)};
+}
+
+eastl::vector<StandardVertex> read_vertex_data(
+    const fastgltf::Primitive& primitive, const fastgltf::Asset& model, eastl::optional<bool>& front_face_ccw_out
+    ) {
     // Get the first attribute's index_count. All the attributes must have the same number of elements, no need to get all their counts
     const auto positions_index = primitive.findAttribute("POSITION")->accessorIndex;
     const auto& positions_accessor = model.accessors[positions_index];
@@ -1172,7 +1469,7 @@ eastl::vector<StandardVertex> read_vertex_data(const fastgltf::Primitive& primit
         }
         );
 
-    copy_vertex_data_to_vector(primitive, model, vertices.data());
+    front_face_ccw_out = copy_vertex_data_to_vector(primitive, model, vertices.data());
 
     return vertices;
 }
@@ -1235,13 +1532,15 @@ eastl::tuple<eastl::vector<u16vec4>, eastl::vector<float4> > read_skinning_data(
     return {bone_ids, weights};
 }
 
-void copy_vertex_data_to_vector(
+eastl::optional<bool> copy_vertex_data_to_vector(
     const fastgltf::Primitive& primitive,
     const fastgltf::Asset& model,
     StandardVertex* vertices
     ) {
     ZoneScoped;
 
+    auto front_face_ccw_maybe = eastl::optional<bool>{};
+
     if(const auto position_attribute = primitive.findAttribute("POSITION");
         position_attribute != primitive.attributes.end()) {
         const auto& attribute_accessor = model.accessors[position_attribute->accessorIndex];
@@ -1275,7 +1574,7 @@ void copy_vertex_data_to_vector(
             attribute_accessor,
             [&](const glm::vec4& tangent, const size_t idx) {
                 vertices[idx].tangent = tangent;
-                front_face_ccw = tangent.w > 0;
+                front_face_ccw_maybe = tangent.w > 0;
             });
     }
 
@@ -1305,6 +1604,8 @@ void copy_vertex_data_to_vector(
     }
 
     // TODO: Other texcoord channels
+
+    return front_face_ccw_maybe;
 }
 
 template<typename DataType>
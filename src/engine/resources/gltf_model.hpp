@@ -15,7 +15,9 @@
 #include "render/material_storage.hpp"
 #include "../render/proxies/mesh_primitive_proxy.hpp"
 #include "render/mesh_storage.hpp"
+#include "render/texture_loader.hpp"
 #include "render/texture_type.hpp"
+#include "resources/cooked_mesh_file.hpp"
 #include "resources/gltf_animations.hpp"
 #include "resources/imodel.hpp"
 
@@ -35,6 +37,34 @@ struct ExtrasData {
     size_t player_parent_node = std::numeric_limits<size_t>::max();
 };
 
+/**
+ * CPU-side data for a single glTF image. The image is decoded if we know how to, otherwise we just keep the file data
+ */
+struct GltfImageData {
+    ResourcePath name;
+
+    fastgltf::MimeType mime_type = fastgltf::MimeType::None;
+
+    eastl::vector<std::byte> data;
+
+    eastl::optional<render::LoadedTexture> decoded;
+};
+
+/**
+ * All the data we can read from a glTF file without touching the renderer. This gets read on worker threads, then
+ * GltfModel uploads it on the main thread
+ */
+struct GltfImportData {
+    /**
+     * Vertex and index data for every mesh. Either loaded from the model's cooked mesh file, or read from the glTF
+     * buffers and then cooked
+     */
+    CookedMeshFile meshes;
+
+    // Indexed by glTF image index. Images that no texture refers to are left empty
+    eastl::vector<GltfImageData> images;
+};
+
 /**
  * Class for a glTF model
  *
@@ -43,9 +73,35 @@ struct ExtrasData {
  */
 class GltfModel : public IModel {
 public:
+    /**
+     * Gets the folder where we cache data derived from the model at the given path
+     */
+    static std::filesystem::path get_cached_data_path(const ResourcePath& filepath);
+
+    /**
+     * Gets the path to the cooked mesh file for the model at the given path
+     */
+    static std::filesystem::path get_cooked_meshes_path(const ResourcePath& filepath);
+
+    /**
+     * Reads the vertex, index, and image data for a glTF asset. Work is spread across the engine's thread pool. This
+     * does not touch the renderer, so it may be called from any thread
+     *
+     * Mesh data comes from the model's cooked mesh file if it's newer than the model. Otherwise we read the glTF
+     * buffers, optimize each primitive for rasterization, and write a new cooked mesh file
+     *
+     * @param load_images Whether to load and decode the model's images. The cooker doesn't need them
+     */
+    static GltfImportData read_import_data(
+        const ResourcePath& filepath, const fastgltf::Asset& asset, bool load_images = true
+    );
+
+    /**
+     * Imports the model into the renderer. Must be called on the main thread
+     */
     GltfModel(
-        ResourcePath filepath_in, fastgltf::Asset&& model, render::SarahRenderer& renderer,
-        ExtrasData extras_in
+        ResourcePath filepath_in, fastgltf::Asset&& model, GltfImportData&& import_data_in,
+        render::SarahRenderer& renderer, ExtrasData extras_in
     );
 
     ~GltfModel() override;
@@ -110,6 +166,11 @@ private:
 
     ExtrasData extras;
 
+    /**
+     * Data read by read_import_data. Cleared once the model is imported
+     */
+    GltfImportData import_data;
+
     void validate_model();
 
     void import_resources_for_model(render::SarahRenderer& renderer);
@@ -151,12 +212,19 @@ private:
         const float4x4& parent_to_world
     ) const;
 
+    /**
+     * Gets the texture for a glTF texture, importing it if needed
+     *
+     * @param alpha_cutoff Alpha cutoff of the material, if the texture is the base color of an alpha-tested material
+     */
     render::TextureHandle get_texture(
-        size_t gltf_texture_index, render::TextureType type, render::TextureLoader& texture_storage
+        size_t gltf_texture_index, render::TextureType type, render::TextureLoader& texture_storage,
+        eastl::optional<float> alpha_cutoff = eastl::nullopt
     );
 
     void import_single_texture(
-        size_t gltf_texture_index, render::TextureType type, render::TextureLoader& texture_storage
+        size_t gltf_texture_index, render::TextureType type, render::TextureLoader& texture_storage,
+        eastl::optional<float> alpha_cutoff
     );
 
     static VkSampler to_vk_sampler(const fastgltf::Sampler& sampler, const render::RenderBackend& backend);
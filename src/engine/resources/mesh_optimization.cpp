@@ -0,0 +1,271 @@
+#include "mesh_optimization.hpp"
+
+#include <EASTL/array.h>
+#include <EASTL/fixed_vector.h>
+#include <meshoptimizer.h>
+#include <tracy/Tracy.hpp>
+
+#include "resources/cooked_mesh_file.hpp"
+#include "shared/primitive_data.hpp"
+
+/**
+ * Cache size to simulate when measuring the vertex cache. 16 entries is a conservative match for modern GPUs
+ */
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+/**
+ * How much worse than the vertex-cache-optimal order we let the overdraw optimizer make the vertex cache, in exchange
+ * for less overdraw
+ */
+constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+/**
+ * Each LOD aims for this fraction of the previous LOD's triangles
+ */
+constexpr float LOD_TRIANGLE_RATIO = 0.5f;
+
+/**
+ * If simplification can't get a LOD below this fraction of the previous LOD's triangles, the mesh is as simple as it's
+ * going to get and we stop generating LODs
+ */
+constexpr float LOD_MIN_REDUCTION = 0.85f;
+
+/**
+ * Largest error that one simplification step may introduce, relative to the mesh's extents
+ */
+constexpr float LOD_MAX_RELATIVE_ERROR = 0.05f;
+
+/**
+ * How much the simplifier cares about normals, relative to positions. Keeps silhouettes and hard edges intact
+ */
+constexpr float LOD_NORMAL_WEIGHT = 0.5f;
+
+static VertexCacheStats analyze_vertex_cache(const MeshPrimitiveData& primitive) {
+    const auto stats = meshopt_analyzeVertexCache(
+        primitive.indices.data(),
+        primitive.indices.size(),
+        primitive.positions.size(),
+        VERTEX_CACHE_SIZE,
+        0,
+        0);
+
+    return {.acmr = stats.acmr, .atvr = stats.atvr};
+}
+
+template<typename DataType>
+static void remap_stream(eastl::vector<DataType>& stream, const eastl::vector<uint32_t>& remap, const size_t num_vertices) {
+    if(stream.empty()) {
+        return;
+    }
+
+    auto remapped = eastl::vector<DataType>(num_vertices);
+    meshopt_remapVertexBuffer(remapped.data(), stream.data(), stream.size(), sizeof(DataType), remap.data());
+    stream = eastl::move(remapped);
+}
+
+/**
+ * Splits the primitive's triangles into meshlets. The meshlets are consecutive runs of the index buffer, so the
+ * triangle order from the vertex cache and overdraw optimizers survives
+ */
+static void build_meshlets(MeshPrimitiveData& primitive) {
+    ZoneScoped;
+
+    const auto max_meshlets = meshopt_buildMeshletsBound(
+        primitive.indices.size(),
+        MESHLET_MAX_VERTICES,
+        MESHLET_MAX_TRIANGLES);
+
+    auto meshlets = eastl::vector<meshopt_Meshlet>(max_meshlets);
+    auto meshlet_vertices = eastl::vector<uint32_t>(max_meshlets * MESHLET_MAX_VERTICES);
+    auto meshlet_triangles = eastl::vector<uint8_t>(max_meshlets * MESHLET_MAX_TRIANGLES * 3);
+
+    // The scan builder starts a new meshlet whenever the next triangle doesn't fit, and never reorders triangles
+    const auto num_meshlets = meshopt_buildMeshletsScan(
+        meshlets.data(),
+        meshlet_vertices.data(),
+        meshlet_triangles.data(),
+        primitive.indices.data(),
+        primitive.indices.size(),
+        primitive.positions.size(),
+        MESHLET_MAX_VERTICES,
+        MESHLET_MAX_TRIANGLES);
+    meshlets.resize(num_meshlets);
+
+    primitive.meshlets.clear();
+    primitive.meshlets.reserve(num_meshlets);
+
+    auto first_index = 0u;
+    for(const auto& meshlet : meshlets) {
+        const auto bounds = meshopt_computeClusterBounds(
+            &primitive.indices[first_index],
+            meshlet.triangle_count * 3,
+            &primitive.positions[0].x,
+            primitive.positions.size(),
+            sizeof(StandardVertexPosition));
+
+        primitive.meshlets.emplace_back(
+            MeshletGPU{
+                .bounding_sphere = float4{bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius},
+                .cone_axis_and_cutoff = float4{
+                    bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff
+                },
+                .first_index = first_index,
+                .num_triangles = meshlet.triangle_count,
+            });
+
+        first_index += meshlet.triangle_count * 3;
+    }
+}
+
+/**
+ * Generates a chain of simplified LODs from the primitive's indices. Each LOD is simplified from the previous one, so
+ * the error of each LOD is the sum of the errors of every step before it
+ */
+static void generate_lods(MeshPrimitiveData& primitive) {
+    ZoneScoped;
+
+    const auto num_lod0_indices = static_cast<uint32_t>(primitive.indices.size());
+
+    primitive.lods.clear();
+    primitive.lods.push_back({.first_index = 0, .num_indices = num_lod0_indices, .error = 0});
+
+    const auto mesh_scale = meshopt_simplifyScale(
+        &primitive.positions[0].x,
+        primitive.positions.size(),
+        sizeof(StandardVertexPosition));
+
+    const auto attribute_weights = eastl::array{LOD_NORMAL_WEIGHT, LOD_NORMAL_WEIGHT, LOD_NORMAL_WEIGHT};
+
+    auto previous_indices = eastl::vector<uint32_t>{primitive.indices.begin(), primitive.indices.end()};
+    auto lod_indices = eastl::vector<uint32_t>{};
+    auto accumulated_error = 0.f;
+
+    while(primitive.lods.size() < MESH_MAX_LODS) {
+        const auto target_num_indices = static_cast<size_t>(
+            static_cast<float>(previous_indices.size()) * LOD_TRIANGLE_RATIO) / 3 * 3;
+        if(target_num_indices < 3) {
+            break;
+        }
+
+        lod_indices.resize(previous_indices.size());
+        auto step_error = 0.f;
+        const auto num_indices = meshopt_simplifyWithAttributes(
+            lod_indices.data(),
+            previous_indices.data(),
+            previous_indices.size(),
+            &primitive.positions[0].x,
+            primitive.positions.size(),
+            sizeof(StandardVertexPosition),
+            &primitive.vertex_data[0].normal.x,
+            sizeof(StandardVertexData),
+            attribute_weights.data(),
+            attribute_weights.size(),
+            nullptr,
+            target_num_indices,
+            LOD_MAX_RELATIVE_ERROR,
+            0,
+            &step_error);
+
+        if(num_indices == 0 ||
+            static_cast<float>(num_indices) > static_cast<float>(previous_indices.size()) * LOD_MIN_REDUCTION) {
+            break;
+        }
+        lod_indices.resize(num_indices);
+
+        meshopt_optimizeVertexCache(lod_indices.data(), lod_indices.data(), num_indices, primitive.positions.size());
+
+        accumulated_error += step_error * mesh_scale;
+        primitive.lods.push_back(
+            {
+                .first_index = static_cast<uint32_t>(primitive.indices.size()),
+                .num_indices = static_cast<uint32_t>(num_indices),
+                .error = accumulated_error,
+            });
+        primitive.indices.insert(primitive.indices.end(), lod_indices.begin(), lod_indices.end());
+
+        eastl::swap(previous_indices, lod_indices);
+    }
+}
+
+MeshOptimizationStats optimize_mesh(MeshPrimitiveData& primitive) {
+    ZoneScoped;
+
+    auto stats = MeshOptimizationStats{
+        .num_vertices_before = static_cast<uint32_t>(primitive.positions.size()),
+        .num_indices = static_cast<uint32_t>(primitive.indices.size()),
+    };
+
+    if(primitive.indices.empty() || primitive.positions.empty()) {
+        stats.num_vertices_after = stats.num_vertices_before;
+        return stats;
+    }
+
+    stats.before = analyze_vertex_cache(primitive);
+
+    // Deduplicate vertices. Two vertices are only the same if every stream matches
+    auto streams = eastl::fixed_vector<meshopt_Stream, 4>{};
+    streams.push_back({primitive.positions.data(), sizeof(StandardVertexPosition), sizeof(StandardVertexPosition)});
+    streams.push_back({primitive.vertex_data.data(), sizeof(StandardVertexData), sizeof(StandardVertexData)});
+    if(!primitive.weights.empty()) {
+        streams.push_back({primitive.bone_ids.data(), sizeof(u16vec4), sizeof(u16vec4)});
+        streams.push_back({primitive.weights.data(), sizeof(float4), sizeof(float4)});
+    }
+
+    auto remap = eastl::vector<uint32_t>(primitive.positions.size());
+    const auto num_unique_vertices = meshopt_generateVertexRemapMulti(
+        remap.data(),
+        primitive.indices.data(),
+        primitive.indices.size(),
+        primitive.positions.size(),
+        streams.data(),
+        streams.size());
+
+    meshopt_remapIndexBuffer(primitive.indices.data(), primitive.indices.data(), primitive.indices.size(), remap.data());
+    remap_stream(primitive.positions, remap, num_unique_vertices);
+    remap_stream(primitive.vertex_data, remap, num_unique_vertices);
+    remap_stream(primitive.bone_ids, remap, num_unique_vertices);
+    remap_stream(primitive.weights, remap, num_unique_vertices);
+
+    // Reorder triangles for the vertex cache, then let the overdraw optimizer trade a little of that for less overdraw
+    meshopt_optimizeVertexCache(
+        primitive.indices.data(),
+        primitive.indices.data(),
+        primitive.indices.size(),
+        primitive.positions.size());
+
+    meshopt_optimizeOverdraw(
+        primitive.indices.data(),
+        primitive.indices.data(),
+        primitive.indices.size(),
+        &primitive.positions[0].x,
+        primitive.positions.size(),
+        sizeof(StandardVertexPosition),
+        OVERDRAW_THRESHOLD);
+
+    // Put the vertices in the order that the index buffer first uses them
+    remap.resize(primitive.positions.size());
+    const auto num_fetched_vertices = meshopt_optimizeVertexFetchRemap(
+        remap.data(),
+        primitive.indices.data(),
+        primitive.indices.size(),
+        primitive.positions.size());
+
+    meshopt_remapIndexBuffer(primitive.indices.data(), primitive.indices.data(), primitive.indices.size(), remap.data());
+    remap_stream(primitive.positions, remap, num_fetched_vertices);
+    remap_stream(primitive.vertex_data, remap, num_fetched_vertices);
+    remap_stream(primitive.bone_ids, remap, num_fetched_vertices);
+    remap_stream(primitive.weights, remap, num_fetched_vertices);
+
+    build_meshlets(primitive);
+
+    // LOD 0's indices are final now, measure them before the LODs get appended
+    stats.num_vertices_after = static_cast<uint32_t>(primitive.positions.size());
+    stats.after = analyze_vertex_cache(primitive);
+
+    generate_lods(primitive);
+
+    stats.num_meshlets = static_cast<uint32_t>(primitive.meshlets.size());
+    stats.num_lods = static_cast<uint32_t>(primitive.lods.size());
+
+    return stats;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+struct MeshPrimitiveData;
+
+/**
+ * Vertex cache statistics for an index buffer, as reported by meshoptimizer
+ */
+struct VertexCacheStats {
+    /**
+     * Average cache miss ratio - transformed vertices per triangle. 0.5 is the theoretical best, 3 is the worst
+     */
+    float acmr = 0;
+
+    /**
+     * Average transformed vertex ratio - transformed vertices per vertex. 1 is the best
+     */
+    float atvr = 0;
+};
+
+struct MeshOptimizationStats {
+    uint32_t num_vertices_before = 0;
+
+    uint32_t num_vertices_after = 0;
+
+    uint32_t num_indices = 0;
+
+    uint32_t num_meshlets = 0;
+
+    uint32_t num_lods = 0;
+
+    VertexCacheStats before = {};
+
+    VertexCacheStats after = {};
+};
+
+/**
+ * Optimizes a primitive for rasterization. This deduplicates vertices, reorders triangles for the post-transform
+ * vertex cache and then for overdraw, and finally reorders vertices into the order the index buffer fetches them
+ *
+ * After that, the triangles are split into meshlets of at most MESHLET_MAX_VERTICES vertices and
+ * MESHLET_MAX_TRIANGLES triangles. Each meshlet is a consecutive run of the optimized index buffer, and gets a bounding
+ * sphere and normal cone for culling
+ *
+ * Finally, we simplify the mesh into up to MESH_MAX_LODS levels of detail. The coarser LODs are appended to the index
+ * buffer after LOD 0, and reuse the primitive's vertices
+ *
+ * All the primitive's vertex streams are remapped together, so skinning data stays in sync
+ */
+MeshOptimizationStats optimize_mesh(MeshPrimitiveData& primitive);
@@ -1,6 +1,7 @@
 #include "prefab_loader.hpp"
 
 #include <simdjson.h>
+#include <tracy/Tracy.hpp>
 
 #include "core/engine.hpp"
 #include "core/system_interface.hpp"
@@ -14,63 +15,161 @@ using namespace entt::literals;
 
 entt::handle PrefabLoader::load_prefab(const ResourcePath& prefab_file, World& world,
                                        const float4x4& transform) {
+    return spawn_prefabs(prefab_file, world, eastl::span<const float4x4>{&transform, 1}).front();
+}
+
+eastl::vector<entt::handle> PrefabLoader::spawn_prefabs(const ResourcePath& prefab_file, World& world,
+                                                        const eastl::span<const float4x4> transforms) {
+    ZoneScoped;
+
+    const auto& prefab = get_template(prefab_file);
+
+    auto& registry = world.get_registry();
+
+    auto instances = eastl::vector<entt::handle>{};
+    instances.reserve(transforms.size());
+    if(prefab.root_model) {
+        const auto& model = Engine::get().get_resource_loader().get_model(*prefab.root_model);
+        for(auto i = 0u; i < transforms.size(); i++) {
+            instances.emplace_back(model->add_to_world(world, eastl::nullopt));
+        }
+    } else {
+        auto entities = eastl::vector<entt::entity>(transforms.size());
+        registry.create(entities.begin(), entities.end());
+        registry.insert<TransformComponent>(entities.begin(), entities.end());
+        for(const auto entity : entities) {
+            instances.emplace_back(registry, entity);
+        }
+    }
+
+    for(const auto& component : prefab.components) {
+        for(const auto& instance : instances) {
+            add_component(instance, component);
+        }
+    }
+
+    for(auto i = 0u; i < instances.size(); i++) {
+        instances[i].patch<TransformComponent>([&](auto& transform_comp) {
+            transform_comp.set_local_transform(transforms[i]);
+        });
+    }
+
+    world.add_top_level_entities(instances);
+
+    return instances;
+}
+
+void PrefabLoader::register_component_creator(const eastl::string& component_name, ComponentFactory&& creator) {
+    component_creators.emplace(component_name, eastl::forward<ComponentFactory>(creator));
+}
+
+const PrefabLoader::PrefabTemplate& PrefabLoader::get_template(const ResourcePath& prefab_file) {
+    if(const auto itr = prefab_templates.find(prefab_file); itr != prefab_templates.end()) {
+        return itr->second;
+    }
+
+    return prefab_templates.emplace(prefab_file, compile_prefab(prefab_file)).first->second;
+}
+
+PrefabLoader::PrefabTemplate PrefabLoader::compile_prefab(const ResourcePath& prefab_file) const {
+    ZoneScoped;
+
     if(logger == nullptr) {
         logger = SystemInterface::get().get_logger("PrefabLoader");
     }
 
+    auto prefab_template = PrefabTemplate{};
+
     simdjson::ondemand::parser parser;
     const auto absolute_prefab_path = prefab_file.to_filepath();
     const auto json = simdjson::padded_string::load(absolute_prefab_path.string());
     auto prefab = parser.iterate(json);
     if(prefab.error() != simdjson::error_code::SUCCESS) {
-        logger->error("Could not load file {}: {}", prefab_file, simdjson::error_message(prefab.error()));
+        throw std::runtime_error{
+            fmt::format("Could not load prefab {}: {}", prefab_file, simdjson::error_message(prefab.error()))
+        };
     }
 
-    auto& resource_loader = Engine::get().get_resource_loader();
-
-    entt::handle entity;
     std::string_view root_entity_name;
     if(prefab["root_entity"].get_string(root_entity_name) == simdjson::SUCCESS) {
-        const auto& model = resource_loader.get_model(ResourcePath{root_entity_name});
-        entity = model->add_to_world(world, eastl::nullopt);
-    } else {
-        entity = world.create_entity();
-        entity.emplace<TransformComponent>();
+        prefab_template.root_model = ResourcePath{root_entity_name};
     }
 
     auto components = prefab["components"];
     for(auto component_definition : components) {
-        auto type = component_definition["type"];
+        // Copy the component's JSON out so that we can parse it on its own, now and maybe at spawn time
+        std::string_view component_json;
+        if(component_definition.raw_json().get(component_json) != simdjson::SUCCESS) {
+            throw std::runtime_error{fmt::format("Could not read a component in prefab {}", prefab_file)};
+        }
+
+        auto& component = prefab_template.components.emplace_back(
+            PrefabComponent{.json = simdjson::padded_string{component_json}});
+
+        simdjson::ondemand::parser component_parser;
+        auto component_document = component_parser.iterate(component.json);
+        auto component_value = component_document.get_value();
+
         std::string_view type_name_view;
-        type.get_string(type_name_view);
+        if(component_value["type"].get_string(type_name_view) != simdjson::SUCCESS) {
+            throw std::runtime_error{fmt::format("A component in prefab {} has no type", prefab_file)};
+        }
+        component.type_name = eastl::string{type_name_view.data(), type_name_view.size()};
 
-        const auto type_name = eastl::string{type_name_view.data(), type_name_view.size()};
+        if(component_creators.find(component.type_name) != component_creators.end()) {
+            continue;
+        }
 
-        if(auto itr = component_creators.find(type_name); itr != component_creators.end()) {
-            itr->second(entity, component_definition);
-        } else {
-            const auto component_type_id = entt::id_type{entt::hashed_string{type_name.c_str()}};
-            auto meta = entt::resolve(component_type_id);
-            auto value = meta.construct();
-            assert(value && "Component does not have a default constructor!");
+        const auto component_type_id = entt::id_type{entt::hashed_string{component.type_name.c_str()}};
+        auto meta = entt::resolve(component_type_id);
+        auto value = meta.construct();
+        if(!value) {
+            throw std::runtime_error{
+                fmt::format(
+                    "Component {} in prefab {} isn't reflected or has no default constructor",
+                    component.type_name,
+                    prefab_file)
+            };
+        }
 
-            serialization::from_json(component_definition, value.as_ref());
+        serialization::from_json(component_value, value.as_ref());
 
-            if(auto emplace_move = meta.func("emplace_move"_hs)) {
-                emplace_move.invoke({}, entity.registry(), entity.entity(), value.as_ref());
-            }
+        // Copying an entt::meta_any of a type that can't be copied gives an empty meta_any
+        if(const auto copy = value; copy) {
+            component.prototype = eastl::move(value);
+            component.json = {};
         }
     }
 
-    entity.patch<TransformComponent>([&](auto& transform_comp) {
-        transform_comp.set_local_transform(transform);
-    });
-
-    world.add_top_level_entities(eastl::array{entity});
+    logger->info("Compiled prefab {} with {} components", prefab_file, prefab_template.components.size());
 
-    return entity;
+    return prefab_template;
 }
 
-void PrefabLoader::register_component_creator(const eastl::string& component_name, ComponentFactory&& creator) {
-    component_creators.emplace(component_name, eastl::forward<ComponentFactory>(creator));
+void PrefabLoader::add_component(const entt::handle entity, const PrefabComponent& component) const {
+    if(component.prototype) {
+        auto value = component.prototype;
+        if(auto emplace_move = value.type().func("emplace_move"_hs)) {
+            emplace_move.invoke({}, entity.registry(), entity.entity(), value.as_ref());
+        }
+        return;
+    }
+
+    simdjson::ondemand::parser parser;
+    auto document = parser.iterate(component.json);
+    auto component_definition = document.get_value();
+
+    if(const auto itr = component_creators.find(component.type_name); itr != component_creators.end()) {
+        itr->second(entity, component_definition);
+    } else {
+        const auto component_type_id = entt::id_type{entt::hashed_string{component.type_name.c_str()}};
+        auto meta = entt::resolve(component_type_id);
+        auto value = meta.construct();
+
+        serialization::from_json(component_definition, value.as_ref());
+
+        if(auto emplace_move = meta.func("emplace_move"_hs)) {
+            emplace_move.invoke({}, entity.registry(), entity.entity(), value.as_ref());
+        }
+    }
 }
@@ -2,10 +2,14 @@
 
 #include <filesystem>
 
+#include <EASTL/optional.h>
+#include <EASTL/span.h>
 #include <EASTL/string.h>
 #include <EASTL/string_view.h>
 #include <EASTL/functional.h>
+#include <EASTL/vector.h>
 #include <entt/entity/registry.hpp>
+#include <entt/meta/meta.hpp>
 #include <EASTL/unordered_map.h>
 #include <simdjson.h>
 
@@ -21,6 +25,10 @@ class World;
  *
  * Prefabs have a root entity. This may be a glTF or Godot model, or it may just be an empty entity. Either way, the
  * prefab file describes which components to add to that root entity
+ *
+ * Each prefab file is read and parsed once, the first time it's spawned. Its components are deserialized into
+ * prototype values, and every spawn copies the prototypes. Components with a registered creator, and components that
+ * can't be copied, keep their JSON and get parsed again for each spawn
  */
 class PrefabLoader {
 public:
@@ -29,6 +37,8 @@ public:
     /**
      * Loads a prefab from disk and places it into the scene, using the provided transform for its initial position
      *
+     * Throws if the prefab can't be compiled. Failed prefabs aren't cached, the next call tries again
+     *
      * @param prefab_file The JSON file which describes the prefab
      * @param world The scene to add the prefab to
      * @param transform Initial transformation matrix
@@ -36,6 +46,21 @@ public:
     entt::handle load_prefab(const ResourcePath& prefab_file, World& world,
                              const float4x4& transform = float4x4{1.f});
 
+    /**
+     * Places one instance of a prefab into the scene for each transform. Cheaper than calling load_prefab for each
+     * instance, since each component type gets added to all the instances at once
+     *
+     * Throws if the prefab can't be compiled, without spawning anything. Failed prefabs aren't cached, the next call
+     * tries again
+     *
+     * @param prefab_file The JSON file which describes the prefab
+     * @param world The scene to add the prefabs to
+     * @param transforms Initial transformation matrix of each instance
+     * @return The root entity of each instance, in the same order as the transforms
+     */
+    eastl::vector<entt::handle> spawn_prefabs(const ResourcePath& prefab_file, World& world,
+                                              eastl::span<const float4x4> transforms);
+
     /**
      * Registers a function used to initialize a component from JSON. A basic creator might simply deserialize the JSON
      * into fields directly, a more advanced on might do... well, more advanced things
@@ -49,5 +74,41 @@ public:
     void register_component_creator(const eastl::string& component_name, ComponentFactory&& creator);
 
 private:
+    struct PrefabComponent {
+        eastl::string type_name;
+
+        /**
+         * The component's value, deserialized when the prefab was loaded. Empty if the component has a creator or
+         * can't be copied
+         */
+        entt::meta_any prototype;
+
+        /**
+         * The component's JSON. Only kept for components without a prototype
+         */
+        simdjson::padded_string json;
+    };
+
+    /**
+     * A parsed prefab file
+     */
+    struct PrefabTemplate {
+        eastl::optional<ResourcePath> root_model;
+
+        eastl::vector<PrefabComponent> components;
+    };
+
     eastl::unordered_map<eastl::string, ComponentFactory> component_creators;
+
+    eastl::unordered_map<ResourcePath, PrefabTemplate> prefab_templates;
+
+    const PrefabTemplate& get_template(const ResourcePath& prefab_file);
+
+    /**
+     * Reads a prefab file and deserializes its components. Throws if the file can't be read, or if any of its
+     * components can't be
+     */
+    PrefabTemplate compile_prefab(const ResourcePath& prefab_file) const;
+
+    void add_component(entt::handle entity, const PrefabComponent& component) const;
 };
@@ -1,29 +1,82 @@
 #include "resource_loader.hpp"
 
+#include <chrono>
+
 #include <simdjson.h>
 
 #include "core/engine.hpp"
+#include "core/thread_pool.hpp"
 #include "resources/godot_scene.hpp"
 #include "resources/gltf_model.hpp"
 
 static std::shared_ptr<spdlog::logger> logger;
 
-ResourceLoader::ResourceLoader() : parser{
-    fastgltf::Extensions::KHR_texture_basisu | fastgltf::Extensions::KHR_lights_punctual |
-    fastgltf::Extensions::KHR_implicit_shapes |
-    fastgltf::Extensions::KHR_physics_rigid_bodies
-} {
+static constexpr auto gltf_extensions = fastgltf::Extensions::KHR_texture_basisu |
+                                        fastgltf::Extensions::KHR_lights_punctual |
+                                        fastgltf::Extensions::KHR_implicit_shapes |
+                                        fastgltf::Extensions::KHR_physics_rigid_bodies;
+
+/**
+ * Everything we can read from a glTF file before touching the renderer
+ */
+struct ParsedGltfModel {
+    fastgltf::Asset asset;
+
+    ExtrasData extras;
+
+    GltfImportData import_data;
+};
+
+struct ResourceLoader::PendingModelLoad {
+    /**
+     * Result of the background work. Only the main thread may turn this into a GltfModel
+     */
+    std::future<ParsedGltfModel> parsed;
+
+    std::promise<eastl::shared_ptr<IModel>> promise;
+
+    std::shared_future<eastl::shared_ptr<IModel>> result;
+};
+
+/**
+ * Parses a glTF file and reads all its mesh and image data. Safe to call from any thread
+ *
+ * @param load_images Whether to load the model's images. The cooker only cares about meshes
+ */
+static ParsedGltfModel parse_gltf_model(const ResourcePath& model_path, bool load_images = true);
+
+static void init_logger() {
     if(logger == nullptr) {
         logger = SystemInterface::get().get_logger("ResourceLoader");
     }
 }
 
+ResourceLoader::ResourceLoader() {
+    init_logger();
+}
+
+ResourceLoader::~ResourceLoader() {
+    // Let any in-flight loads finish before we go away. Their results are thrown out
+    for(auto& [path, load] : pending_models) {
+        load->parsed.wait();
+    }
+}
+
 eastl::shared_ptr<IModel> ResourceLoader::get_model(const ResourcePath& model_path) {
     // If the model is already loaded, return it
     if(const auto itr = loaded_models.find(model_path); itr != loaded_models.end()) {
         return itr->second;
     }
 
+    // If the model is being loaded in the background, wait for that to finish
+    if(auto itr = pending_models.find(model_path); itr != pending_models.end()) {
+        auto load = eastl::move(itr->second);
+        pending_models.erase(itr);
+        finish_gltf_load(model_path, *load);
+
+        return loaded_models.at(model_path);
+    }
+
     if(model_path.ends_with(".tscn")) {
         load_godot_scene(model_path);
     } else if(model_path.ends_with(".glb") || model_path.ends_with(".gltf")) {
@@ -33,9 +86,149 @@ eastl::shared_ptr<IModel> ResourceLoader::get_model(const ResourcePath& model_pa
     return loaded_models.at(model_path);
 }
 
+std::shared_future<eastl::shared_ptr<IModel>> ResourceLoader::get_model_async(const ResourcePath& model_path) {
+    if(const auto itr = pending_models.find(model_path); itr != pending_models.end()) {
+        return itr->second->result;
+    }
+
+    if(!(model_path.ends_with(".glb") || model_path.ends_with(".gltf")) ||
+       loaded_models.find(model_path) != loaded_models.end()) {
+        auto promise = std::promise<eastl::shared_ptr<IModel>>{};
+        try {
+            promise.set_value(get_model(model_path));
+        } catch(...) {
+            promise.set_exception(std::current_exception());
+        }
+        return promise.get_future().share();
+    }
+
+    logger->info("Beginning async load of model {}", model_path);
+
+    auto load = eastl::make_unique<PendingModelLoad>();
+    load->parsed = ThreadPool::get().enqueue([model_path] { return parse_gltf_model(model_path); });
+    load->result = load->promise.get_future().share();
+
+    auto result = load->result;
+    pending_models.emplace(model_path, eastl::move(load));
+
+    return result;
+}
+
+void ResourceLoader::tick() {
+    ZoneScoped;
+
+    for(auto itr = pending_models.begin(); itr != pending_models.end();) {
+        if(itr->second->parsed.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+            ++itr;
+            continue;
+        }
+
+        const auto model_path = itr->first;
+        auto load = eastl::move(itr->second);
+        itr = pending_models.erase(itr);
+
+        try {
+            finish_gltf_load(model_path, *load);
+        } catch(const std::exception& e) {
+            logger->error("Could not load model {}: {}", model_path, e.what());
+        }
+    }
+}
+
+void ResourceLoader::cook_models(const bool force) {
+    ZoneScoped;
+
+    init_logger();
+
+    const auto game_folder = SystemInterface::get().get_data_folder() / "game";
+    if(!exists(game_folder)) {
+        logger->warn("Game data folder {} does not exist, nothing to cook", game_folder.string());
+        return;
+    }
+
+    auto model_paths = eastl::vector<ResourcePath>{};
+    for(const auto& entry : std::filesystem::recursive_directory_iterator{game_folder}) {
+        if(!entry.is_regular_file()) {
+            continue;
+        }
+
+        const auto extension = entry.path().extension();
+        if(extension == ".glb" || extension == ".gltf") {
+            model_paths.emplace_back(ResourcePath::game(relative(entry.path(), game_folder)));
+        }
+    }
+
+    logger->info("Cooking {} models", model_paths.size());
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    ThreadPool::get().parallel_for(
+        model_paths.size(),
+        [&](const size_t i) {
+            try {
+                if(force) {
+                    std::filesystem::remove(GltfModel::get_cooked_meshes_path(model_paths[i]));
+                }
+
+                // Reading the import data writes the cooked mesh file if needed
+                parse_gltf_model(model_paths[i], false);
+            } catch(const std::exception& e) {
+                logger->error("Could not cook model {}: {}", model_paths[i], e.what());
+            }
+        });
+
+    const auto duration = std::chrono::duration<double>{std::chrono::steady_clock::now() - start_time};
+    logger->info("Finished cooking models in {:.2f} seconds", duration.count());
+}
+
 void ResourceLoader::load_gltf_model(const ResourcePath& model_path) {
     ZoneScoped;
 
+    auto parsed = parse_gltf_model(model_path);
+
+    auto& renderer = Engine::get().get_renderer();
+    auto imported_model = eastl::make_shared<GltfModel>(
+        model_path,
+        std::move(parsed.asset),
+        eastl::move(parsed.import_data),
+        renderer,
+        eastl::move(parsed.extras));
+    loaded_models.emplace(model_path, eastl::move(imported_model));
+}
+
+void ResourceLoader::finish_gltf_load(const ResourcePath& model_path, PendingModelLoad& load) {
+    ZoneScoped;
+
+    try {
+        auto parsed = load.parsed.get();
+
+        auto& renderer = Engine::get().get_renderer();
+        auto imported_model = eastl::make_shared<GltfModel>(
+            model_path,
+            std::move(parsed.asset),
+            eastl::move(parsed.import_data),
+            renderer,
+            eastl::move(parsed.extras));
+        loaded_models.emplace(model_path, imported_model);
+
+        load.promise.set_value(eastl::move(imported_model));
+
+    } catch(...) {
+        load.promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+void ResourceLoader::load_godot_scene(const ResourcePath& scene_path) {
+    ZoneScoped;
+
+    auto scene = godot::GodotScene::load(scene_path);
+    loaded_models.emplace(scene_path, eastl::make_shared<godot::GodotScene>(scene));
+}
+
+ParsedGltfModel parse_gltf_model(const ResourcePath& model_path, const bool load_images) {
+    ZoneScoped;
+
     logger->info("Beginning load of model {}", model_path);
 
     const auto full_model_path = model_path.to_filepath();
@@ -51,6 +244,9 @@ void ResourceLoader::load_gltf_model(const ResourcePath& model_path) {
 
     auto data = fastgltf::GltfDataBuffer::FromPath(full_model_path);
 
+    // Parsers aren't thread-safe, so each load gets its own
+    auto parser = fastgltf::Parser{gltf_extensions};
+
     ExtrasData extras_data;
     parser.setExtrasParseCallback(
         [](
@@ -86,18 +282,11 @@ void ResourceLoader::load_gltf_model(const ResourcePath& model_path) {
         throw std::runtime_error{"Invalid glTF!"};
     }
 
-    auto& renderer = Engine::get().get_renderer();
-    auto imported_model = eastl::make_shared<GltfModel>(
-        model_path,
-        std::move(gltf.get()),
-        renderer,
-        eastl::move(extras_data));
-    loaded_models.emplace(model_path, eastl::move(imported_model));
-}
+    auto import_data = GltfModel::read_import_data(model_path, gltf.get(), load_images);
 
-void ResourceLoader::load_godot_scene(const ResourcePath& scene_path) {
-    ZoneScoped;
-
-    auto scene = godot::GodotScene::load(scene_path);
-    loaded_models.emplace(scene_path, eastl::make_shared<godot::GodotScene>(scene));
+    return ParsedGltfModel{
+        .asset = std::move(gltf.get()),
+        .extras = eastl::move(extras_data),
+        .import_data = eastl::move(import_data),
+    };
 }
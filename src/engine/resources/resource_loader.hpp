@@ -1,6 +1,9 @@
 #pragma once
 
+#include <future>
+
 #include <EASTL/shared_ptr.h>
+#include <EASTL/unique_ptr.h>
 #include <EASTL/unordered_map.h>
 #include <fastgltf/core.hpp>
 
@@ -12,22 +15,61 @@ class IModel;
  * Allows one to load all kinds of resources. Caches resources that have already been loaded
  *
  * Uses shared pointers for references to resources
+ *
+ * glTF models may be loaded asynchronously. Parsing the file and reading its meshes and images happens on the thread
+ * pool, then the model gets imported into the renderer on the main thread in tick()
  */
 class ResourceLoader {
 public:
     ResourceLoader();
 
+    ~ResourceLoader();
+
+    /**
+     * Gets a model, loading it if needed. If the model is being loaded asynchronously, this waits for the background
+     * work to finish and then imports the model immediately
+     */
     eastl::shared_ptr<IModel> get_model(const ResourcePath& model_path);
 
+    /**
+     * Starts loading a model in the background, and returns a future that's fulfilled once the model is fully
+     * imported. That happens in tick(), on the main thread
+     *
+     * Godot scenes are loaded synchronously. The returned future is ready immediately
+     */
+    std::shared_future<eastl::shared_ptr<IModel>> get_model_async(const ResourcePath& model_path);
+
+    /**
+     * Imports any models whose background work has finished. Must be called on the main thread
+     */
+    void tick();
+
+    /**
+     * Cooks the mesh data for every glTF model in the game's data folder, so that runtime loads can memory-map it
+     * instead of reading the glTF buffers. Models whose cooked data is already up-to-date are skipped
+     *
+     * This does not need the renderer, so offline tools may call it without creating an Engine
+     *
+     * @param force Whether to re-cook models that are already up-to-date. Useful for measuring the mesh optimizer
+     */
+    static void cook_models(bool force = false);
+
 private:
-    fastgltf::Parser parser;
+    struct PendingModelLoad;
 
     eastl::unordered_map<ResourcePath, eastl::shared_ptr<IModel>> loaded_models;
 
+    eastl::unordered_map<ResourcePath, eastl::unique_ptr<PendingModelLoad>> pending_models;
+
     /**
      * Loads a glTF model, and returns a pointer to that model
      */
     void load_gltf_model(const ResourcePath& model_path);
 
+    /**
+     * Imports a model that was read on the thread pool into the renderer, and fulfills the load's promise
+     */
+    void finish_gltf_load(const ResourcePath& model_path, PendingModelLoad& load);
+
     void load_godot_scene(const ResourcePath& scene_path);
 };
@@ -6,5 +6,8 @@
  * Component with basic info about an entity
  */
 struct EntityInfoComponent {
+    /**
+     * Change this with patch or replace, so that World's name index sees the new name
+     */
     eastl::string name;
 };
@@ -8,6 +8,7 @@
 #include <tracy/Tracy.hpp>
 
 #include "core/engine.hpp"
+#include "scene/scene_object_component.hpp"
 #include "scene/transform_component.hpp"
 #include "reflection/serialization/glm.hpp"
 
@@ -33,6 +34,8 @@ Scene::Scene() {
 Scene::Scene(Scene&& old) noexcept :
     scene_objects{eastl::move(old.scene_objects)} {
     old.scene_objects.clear();
+
+    link_objects();
 }
 
 Scene& Scene::operator=(Scene&& old) noexcept {
@@ -41,6 +44,8 @@ Scene& Scene::operator=(Scene&& old) noexcept {
     scene_objects = eastl::move(old.scene_objects);
     old.scene_objects = {};
 
+    link_objects();
+
     return *this;
 }
 
@@ -63,8 +68,18 @@ void Scene::write_to_file(const ResourcePath& path) {
 }
 
 void Scene::add_new_objects_to_world() {
-    for(auto& object : scene_objects) {
-        add_object_to_world(object);
+    ZoneScoped;
+
+    // Kick off background loads for all our models, so that they load in parallel while we add them one at a time
+    auto& resource_loader = Engine::get().get_resource_loader();
+    for(const auto& object : scene_objects) {
+        if(!object.entity.valid() && (object.filepath.ends_with(".glb") || object.filepath.ends_with(".gltf"))) {
+            resource_loader.get_model_async(object.filepath);
+        }
+    }
+
+    for(auto i = 0u; i < scene_objects.size(); i++) {
+        add_object_to_world(i);
     }
 }
 
@@ -77,7 +92,7 @@ SceneObject& Scene::add_object(const ResourcePath& filepath, const float3 locati
     });
 
     if(add_to_world) {
-        add_object_to_world(obj);
+        add_object_to_world(static_cast<uint32_t>(scene_objects.size() - 1));
     }
 
     dirty = true;
@@ -90,15 +105,22 @@ const eastl::vector<SceneObject>& Scene::get_objects() const {
 }
 
 void Scene::delete_object_by_entity(const entt::handle entity) {
-    const auto itr = eastl::remove_if(
-        scene_objects.begin(),
-        scene_objects.end(),
-        [&](const SceneObject& obj) {
-            return obj.entity == entity;
-        });
-    if(itr != scene_objects.end()) {
-        scene_objects.erase(itr);
+    const auto* link = entity.try_get<SceneObjectComponent>();
+    if(link == nullptr || link->scene != this) {
+        return;
     }
+
+    const auto index = link->index;
+    if(index + 1 != scene_objects.size()) {
+        auto& moved_object = scene_objects[index];
+        moved_object = eastl::move(scene_objects.back());
+        if(auto* moved_link = moved_object.entity.try_get<SceneObjectComponent>()) {
+            moved_link->index = index;
+        }
+    }
+    scene_objects.pop_back();
+
+    entity.remove<SceneObjectComponent>();
 }
 
 SceneObject* Scene::find_object(const ResourcePath& name) {
@@ -121,12 +143,22 @@ void Scene::remove_from_world() {
     auto& world = Engine::get().get_world();
     for(auto& obj : scene_objects) {
         if(obj.entity) {
+            // Unlink first, so that destroying the entity doesn't delete the object
+            obj.entity.remove<SceneObjectComponent>();
             world.destroy_entity(obj.entity);
             obj.entity = {};
         }
     }
 }
 
+void Scene::link_objects() {
+    for(auto i = 0u; i < scene_objects.size(); i++) {
+        if(scene_objects[i].entity) {
+            scene_objects[i].entity.emplace_or_replace<SceneObjectComponent>(this, i);
+        }
+    }
+}
+
 void Scene::sync_transforms_from_world() {
     for(auto& obj : scene_objects) {
         if(obj.entity) {
@@ -139,9 +171,10 @@ void Scene::sync_transforms_from_world() {
     }
 }
 
-void Scene::add_object_to_world(SceneObject& object) {
+void Scene::add_object_to_world(const uint32_t index) {
     ZoneScoped;
 
+    auto& object = scene_objects[index];
     if(object.entity.valid()) {
         return;
     }
@@ -166,4 +199,8 @@ void Scene::add_object_to_world(SceneObject& object) {
                                    glm::scale(object.scale);
         object.entity = engine.add_prefab_to_world(object.filepath, transform_mat);
     }
+
+    if(object.entity) {
+        object.entity.emplace_or_replace<SceneObjectComponent>(this, index);
+    }
 }
@@ -78,7 +78,10 @@ public:
     const eastl::vector<SceneObject>& get_objects() const;
 
     /**
-     * Deletes the scene object with the specified entity. No-op if no scene objects have this entity
+     * Deletes the scene object with the specified entity. No-op if the entity isn't one of this scene's objects
+     *
+     * The entity's SceneObjectComponent says where its object is, so this doesn't search. The last object takes the
+     * deleted object's place
      *
      * Does NOT remove the entity from the world!
      *
@@ -114,7 +117,7 @@ public:
     }
 
     /**
-     * Deletes all the entities that represent the SceneObjects
+     * Deletes all the entities that represent the SceneObjects. The SceneObjects stay in the scene
      */
     void remove_from_world();
 
@@ -138,5 +141,10 @@ private:
      */
     void sync_transforms_from_world();
 
-    static void add_object_to_world(SceneObject& object);
+    void add_object_to_world(uint32_t index);
+
+    /**
+     * Points the SceneObjectComponent of each object's entity at this scene and the object's index
+     */
+    void link_objects();
 };
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+class Scene;
+
+/**
+ * Links the root entity of a SceneObject back to its scene, so that destroying the entity can remove the SceneObject
+ * without searching every scene
+ */
+struct SceneObjectComponent {
+    Scene* scene = nullptr;
+
+    /**
+     * Index of the SceneObject in the scene's object list. The scene updates this when it moves objects around
+     */
+    uint32_t index = 0;
+};
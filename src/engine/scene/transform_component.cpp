@@ -2,12 +2,49 @@
 
 #include <glm/gtx/matrix_decompose.hpp>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAH_TRANSFORM_SSE2 1
+#else
+#define SAH_TRANSFORM_SSE2 0
+#endif
+
+float4x4 multiply_transforms(const float4x4& a, const float4x4& b) {
+#if SAH_TRANSFORM_SSE2
+    const auto a0 = _mm_loadu_ps(&a[0][0]);
+    const auto a1 = _mm_loadu_ps(&a[1][0]);
+    const auto a2 = _mm_loadu_ps(&a[2][0]);
+    const auto a3 = _mm_loadu_ps(&a[3][0]);
+
+    auto result = float4x4{};
+    for(auto column = 0; column < 4; column++) {
+        const auto& b_column = b[column];
+        auto sum = _mm_mul_ps(a0, _mm_set1_ps(b_column.x));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b_column.y)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b_column.z)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(b_column.w)));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+
+    return result;
+#else
+    return a * b;
+#endif
+}
+
 float4x4 TransformComponent::get_local_to_world() const {
-    return cached_parent_to_world * get_local_to_parent();
+    return multiply_transforms(cached_parent_to_world, get_local_to_parent());
 }
 
 float4x4 TransformComponent::get_local_to_parent() const {
-    return glm::translate(float4x4{1.f}, location) * glm::mat4{rotation} * glm::scale(scale);
+    // Same result as translate * rotate * scale, without the two matrix multiplies
+    auto matrix = glm::mat4_cast(rotation);
+    matrix[0] *= scale.x;
+    matrix[1] *= scale.y;
+    matrix[2] *= scale.z;
+    matrix[3] = float4{location, 1.f};
+
+    return matrix;
 }
 
 void TransformComponent::set_local_transform(const float4x4& transform) {
@@ -6,6 +6,12 @@
 #include "simdjson.h"
 #include "shared/prelude.h"
 
+/**
+ * Multiplies two matrices. Uses SSE2 on x64, and glm elsewhere. Both paths add the products in the same order as glm,
+ * so every path gets the same result
+ */
+float4x4 multiply_transforms(const float4x4& a, const float4x4& b);
+
 struct TransformComponent {
     float3 location{};
 
@@ -14,10 +20,21 @@ struct TransformComponent {
     float3 scale{1.f};
 
     /**
-     * Cached parent-to-world model matrix. Updated at the start of every frame
+     * Cached parent-to-world model matrix. Updated by World::tick
      */
     float4x4 cached_parent_to_world = float4x4{ 1.f };
 
+    /**
+     * Whether the transform was patched since the last World::tick. Managed by World
+     */
+    bool is_dirty = false;
+
+    /**
+     * Whether the last change to the transform was PhysicsWorld copying its body's position back. Those changes don't
+     * need to be sent back to the body. Any other change clears this, including the entity's parent moving
+     */
+    bool is_moved_by_physics = false;
+
     entt::entity parent = entt::null;
 
     eastl::fixed_vector<entt::entity, 16> children;
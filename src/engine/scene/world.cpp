@@ -1,23 +1,45 @@
 #include "world.hpp"
 
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
 #include <simdjson.h>
 
 #include "core/engine.hpp"
 #include "tracy/Tracy.hpp"
 
+#include "console/cvars.hpp"
 #include "core/issue_breakpoint.hpp"
 #include "core/system_interface.hpp"
+#include "core/thread_pool.hpp"
+#include "extern/cityhash/city_hash.hpp"
 #include "scene/entity_info_component.hpp"
+#include "scene/scene_object_component.hpp"
 #include "scene/transform_component.hpp"
 
 static std::shared_ptr<spdlog::logger> logger;
 
-World::World() {
+static auto cvar_transform_chunk_size = AutoCVar_Int{
+    "s.Transforms.ChunkSize",
+    "Number of entities per thread pool task when updating transforms. Smaller levels are updated on the main thread",
+    256
+};
+
+World::World() : World{ThreadPool::get()} {}
+
+World::World(ThreadPool& thread_pool_in) : thread_pool{thread_pool_in} {
     if(logger == nullptr) {
         logger = SystemInterface::get().get_logger("World");
     }
 
     registry.on_update<TransformComponent>().connect<&World::on_transform_update>(this);
+
+    registry.on_construct<EntityInfoComponent>().connect<&World::on_construct_entity_info>(this);
+    registry.on_update<EntityInfoComponent>().connect<&World::on_update_entity_info>(this);
+    registry.on_destroy<EntityInfoComponent>().connect<&World::on_destroy_entity_info>(this);
+}
+
+static uint64_t hash_name(const eastl::string_view name) {
+    return CityHash64(name.data(), name.size());
 }
 
 entt::handle World::make_handle(const entt::entity entity) {
@@ -29,24 +51,26 @@ entt::handle World::create_entity() {
 }
 
 entt::handle World::find_entity(const eastl::string_view name) {
-    // Search the top-level entities first, to avoid delving into deep node trees for e.g. skeletons
-    for(const auto& entity : top_level_entities) {
-        if(const auto* info = registry.try_get<EntityInfoComponent>(entity); info) {
-            if(info->name == name) {
-                return entt::handle{registry, entity};
-            }
+    auto found_entity = entt::handle{};
+
+    const auto [begin, end] = entities_by_name.equal_range(hash_name(name));
+    for(auto itr = begin; itr != end; ++itr) {
+        const auto entity = itr->second;
+        if(registry.get<EntityInfoComponent>(entity).name != name) {
+            // Hash collision
+            continue;
         }
-    }
 
-    // Search through children
-    for(const auto& entity : top_level_entities) {
-        if(const auto result = find_child(entt::handle{registry, entity}, name)) {
-            return result;
+        if(top_level_entities.find(entity) != top_level_entities.end()) {
+            return entt::handle{registry, entity};
+        }
+
+        if(!found_entity) {
+            found_entity = entt::handle{registry, entity};
         }
     }
 
-    // Didn't find it? rip
-    return {};
+    return found_entity;
 }
 
 void World::destroy_entity(const entt::entity entity) {
@@ -54,23 +78,70 @@ void World::destroy_entity(const entt::entity entity) {
         return;
     }
 
-    if(auto* transform = registry.try_get<TransformComponent>(entity)) {
-        for(const auto child_entity : transform->children) {
-            destroy_entity(child_entity);
+    entities_to_destroy.emplace_back(entity);
+}
+
+void World::tick(float delta_time) {
+    ZoneScopedN("World::tick");
+
+    destroy_queued_entities();
+
+    update_transforms();
+}
+
+void World::destroy_queued_entities() {
+    if(entities_to_destroy.empty()) {
+        return;
+    }
+
+    ZoneScoped;
+
+    // Collect every entity in the queued subtrees. The list is its own work queue - each entity's children get
+    // appended after it
+    auto entities = eastl::vector<entt::entity>{};
+    entities.reserve(entities_to_destroy.size());
+    for(const auto entity : entities_to_destroy) {
+        if(registry.valid(entity)) {
+            entities.emplace_back(entity);
         }
     }
+    entities_to_destroy.clear();
 
-    auto& scenes = Engine::get().get_loaded_scenes();
-    for(auto& [name, scene] : scenes) {
-        scene.delete_object_by_entity(entt::handle{registry, entity});
+    for(auto i = size_t{0}; i < entities.size(); i++) {
+        if(const auto* transform = registry.try_get<TransformComponent>(entities[i])) {
+            for(const auto child : transform->children) {
+                if(registry.valid(child)) {
+                    entities.emplace_back(child);
+                }
+            }
+        }
     }
 
-    top_level_entities.erase(entity);
+    // An entity may have been queued more than once, or queued along with one of its ancestors
+    eastl::sort(entities.begin(), entities.end());
+    entities.erase(eastl::unique(entities.begin(), entities.end()), entities.end());
 
-    registry.destroy(entity);
-}
+    for(const auto entity : entities) {
+        // Only the root entity of a SceneObject has a link to its scene
+        if(const auto* link = registry.try_get<SceneObjectComponent>(entity)) {
+            link->scene->delete_object_by_entity(entt::handle{registry, entity});
+        }
 
-void World::tick(float delta_time) {
+        top_level_entities.erase(entity);
+
+        // Children of destroyed parents are going away too, so only a surviving parent needs to forget its child
+        if(const auto* transform = registry.try_get<TransformComponent>(entity)) {
+            const auto parent = transform->parent;
+            if(parent != entt::null && registry.valid(parent) &&
+                !eastl::binary_search(entities.begin(), entities.end(), parent)) {
+                if(auto* parent_transform = registry.try_get<TransformComponent>(parent)) {
+                    parent_transform->children.erase_first(entity);
+                }
+            }
+        }
+    }
+
+    registry.destroy(entities.begin(), entities.end());
 }
 
 entt::registry& World::get_registry() {
@@ -121,56 +192,236 @@ const eastl::unordered_set<entt::entity>& World::get_top_level_entities() const
     return top_level_entities;
 }
 
-entt::handle World::find_child(const entt::handle entity, const eastl::string_view child_name) {
-    // Search the entity and all its children for a node with the specified name
+eastl::span<const entt::entity> World::get_changed_transforms() const {
+    return changed_transforms;
+}
 
-    if(const auto* transform = entity.try_get<TransformComponent>()) {
-        for(const auto& child : transform->children) {
-            if(const auto* info = entity.registry()->try_get<EntityInfoComponent>(child)) {
-                if(info->name == child_name) {
-                    return entt::handle{*entity.registry(), child};
-                }
-            }
+eastl::span<const float4x4> World::get_changed_local_to_world() const {
+    return changed_local_to_world;
+}
+
+entt::handle World::find_child(const entt::handle entity, const eastl::string_view child_name) const {
+    auto found_child = entt::handle{};
+    auto found_depth = eastl::numeric_limits<uint32_t>::max();
+
+    const auto [begin, end] = entities_by_name.equal_range(hash_name(child_name));
+    for(auto itr = begin; itr != end; ++itr) {
+        const auto candidate = itr->second;
+        if(registry.get<EntityInfoComponent>(candidate).name != child_name) {
+            continue;
         }
 
-        for(const auto& child : transform->children) {
-            if(const auto child_maybe = find_child(entt::handle{*entity.registry(), child}, child_name)) {
-                return child_maybe;
-            }
+        const auto depth = get_depth_below(registry, candidate, entity.entity());
+        if(depth == 0 || depth > found_depth) {
+            continue;
+        }
+
+        if(depth < found_depth || is_earlier_child(registry, candidate, found_child.entity())) {
+            found_child = entt::handle{*entity.registry(), candidate};
+            found_depth = depth;
+        }
+    }
+
+    return found_child;
+}
+
+uint32_t World::get_depth_below(const entt::registry& registry, entt::entity entity, const entt::entity ancestor) {
+    auto depth = 0u;
+    while(registry.valid(entity)) {
+        const auto* transform = registry.try_get<TransformComponent>(entity);
+        if(transform == nullptr) {
+            return 0;
+        }
+
+        depth++;
+        if(transform->parent == ancestor) {
+            return depth;
+        }
+
+        entity = transform->parent;
+    }
+
+    return 0;
+}
+
+bool World::is_earlier_child(const entt::registry& registry, entt::entity a, entt::entity b) {
+    // Walk up until a and b are siblings, then compare their places under their parent
+    auto a_parent = registry.get<TransformComponent>(a).parent;
+    auto b_parent = registry.get<TransformComponent>(b).parent;
+    while(a_parent != b_parent) {
+        a = a_parent;
+        b = b_parent;
+        a_parent = registry.get<TransformComponent>(a).parent;
+        b_parent = registry.get<TransformComponent>(b).parent;
+    }
+
+    const auto& siblings = registry.get<TransformComponent>(a_parent).children;
+    return eastl::find(siblings.begin(), siblings.end(), a) < eastl::find(siblings.begin(), siblings.end(), b);
+}
+
+void World::on_construct_entity_info(entt::registry& registry, const entt::entity entity) {
+    const auto name_hash = hash_name(registry.get<EntityInfoComponent>(entity).name);
+    entities_by_name.emplace(name_hash, entity);
+    entity_name_hashes[entity] = name_hash;
+}
+
+void World::on_update_entity_info(entt::registry& registry, const entt::entity entity) {
+    remove_from_name_index(entity);
+    on_construct_entity_info(registry, entity);
+}
+
+void World::on_destroy_entity_info(entt::registry& registry, const entt::entity entity) {
+    remove_from_name_index(entity);
+}
+
+void World::remove_from_name_index(const entt::entity entity) {
+    const auto hash_itr = entity_name_hashes.find(entity);
+    if(hash_itr == entity_name_hashes.end()) {
+        return;
+    }
+
+    const auto [begin, end] = entities_by_name.equal_range(hash_itr->second);
+    for(auto itr = begin; itr != end; ++itr) {
+        if(itr->second == entity) {
+            entities_by_name.erase(itr);
+            break;
         }
     }
 
-    return {};
+    entity_name_hashes.erase(hash_itr);
 }
 
 void World::on_transform_update(entt::registry& registry, const entt::entity entity) {
-    propagate_transform(entity);
+    auto& transform = registry.get<TransformComponent>(entity);
+    transform.is_moved_by_physics = false;
+    if(!transform.is_dirty) {
+        transform.is_dirty = true;
+        dirty_transforms.emplace_back(entity);
+    }
 }
 
-void World::propagate_transform(const entt::entity entity) {
-    const auto& transform = registry.get<TransformComponent>(entity);
-    const auto local_to_world = transform.get_local_to_world();
+void World::update_transforms() {
+    ZoneScoped;
 
-    eastl::fixed_vector<entt::entity, 4> invalid_entities;
-    for(const auto child : transform.children) {
-        if(registry.valid(child)) {
-            registry.patch<TransformComponent>(
-                child,
-                [&](TransformComponent& trans) {
-                    trans.cached_parent_to_world = local_to_world;
-                });
+    changed_transforms.clear();
+    changed_local_to_world.clear();
+
+    // The first level is the dirty entities without dirty ancestors
+    for(const auto dirty_entity : dirty_transforms) {
+        if(!registry.valid(dirty_entity)) {
+            continue;
+        }
+
+        auto* transform = registry.try_get<TransformComponent>(dirty_entity);
+        if(transform == nullptr || has_dirty_ancestor(*transform)) {
+            // The dirty ancestor will update this entity when it updates its children
+            continue;
+        }
+
+        // The parent isn't dirty, so its transform is up to date
+        if(transform->parent != entt::null && registry.valid(transform->parent)) {
+            if(const auto* parent_transform = registry.try_get<TransformComponent>(transform->parent)) {
+                transform->cached_parent_to_world = parent_transform->get_local_to_world();
+            }
+        }
+
+        changed_transforms.emplace_back(dirty_entity);
+    }
+
+    // Each level's children become the next level. The levels are appended to the changed list in order, so parents
+    // always come before their children
+    auto level_start = size_t{0};
+    while(level_start < changed_transforms.size()) {
+        const auto level_size = changed_transforms.size() - level_start;
+        changed_local_to_world.resize(changed_transforms.size());
+
+        const auto chunk_size = static_cast<size_t>(eastl::max(cvar_transform_chunk_size.get(), 1));
+        const auto num_chunks = (level_size + chunk_size - 1) / chunk_size;
+        if(chunk_children.size() < num_chunks) {
+            chunk_children.resize(num_chunks);
+        }
+
+        // Writes to changed_transforms would invalidate the spans, so children go to per-chunk lists until the level
+        // is done
+        const auto level_entities = eastl::span<const entt::entity>{&changed_transforms[level_start], level_size};
+        const auto level_matrices = eastl::span<float4x4>{&changed_local_to_world[level_start], level_size};
+        const auto update_chunk = [&](const size_t chunk_index) {
+            const auto first = chunk_index * chunk_size;
+            const auto count = eastl::min(chunk_size, level_size - first);
+            update_transform_chunk(
+                level_entities.subspan(first, count),
+                level_matrices.subspan(first, count),
+                chunk_children[chunk_index]);
+        };
+
+        if(num_chunks > 1) {
+            thread_pool.parallel_for(num_chunks, update_chunk);
         } else {
-            invalid_entities.emplace_back(child);
+            update_chunk(0);
+        }
+
+        level_start = changed_transforms.size();
+        for(auto chunk_index = 0u; chunk_index < num_chunks; chunk_index++) {
+            auto& children = chunk_children[chunk_index];
+            changed_transforms.insert(changed_transforms.end(), children.begin(), children.end());
+            children.clear();
         }
     }
 
-    if(!invalid_entities.empty()) {
-        registry.patch<TransformComponent>(
-            entity,
-            [&](TransformComponent& transform_to_modify) {
-                for(auto invalid_child : invalid_entities) {
-                    transform_to_modify.children.erase_first(invalid_child);
-                }
-            });
+    // Clear the flags last, has_dirty_ancestor needs them while we walk
+    for(const auto dirty_entity : dirty_transforms) {
+        if(registry.valid(dirty_entity)) {
+            if(auto* transform = registry.try_get<TransformComponent>(dirty_entity)) {
+                transform->is_dirty = false;
+            }
+        }
+    }
+    dirty_transforms.clear();
+}
+
+void World::update_transform_chunk(
+    const eastl::span<const entt::entity> entities, const eastl::span<float4x4> local_to_worlds,
+    eastl::vector<entt::entity>& children
+) {
+    ZoneScoped;
+
+    // Each entity is in exactly one chunk, and only touches its own transform and its children's. That makes it safe
+    // for chunks to run in parallel
+    for(auto i = 0u; i < entities.size(); i++) {
+        auto& transform = registry.get<TransformComponent>(entities[i]);
+        const auto local_to_world = transform.get_local_to_world();
+        local_to_worlds[i] = local_to_world;
+
+        eastl::fixed_vector<entt::entity, 4> invalid_entities;
+        for(const auto child : transform.children) {
+            auto* child_transform = registry.valid(child) ? registry.try_get<TransformComponent>(child) : nullptr;
+            if(child_transform != nullptr) {
+                child_transform->cached_parent_to_world = local_to_world;
+                child_transform->is_moved_by_physics = false;
+                children.emplace_back(child);
+            } else {
+                invalid_entities.emplace_back(child);
+            }
+        }
+
+        for(const auto invalid_child : invalid_entities) {
+            transform.children.erase_first(invalid_child);
+        }
     }
 }
+
+bool World::has_dirty_ancestor(const TransformComponent& transform) const {
+    auto parent = transform.parent;
+    while(parent != entt::null && registry.valid(parent)) {
+        const auto* parent_transform = registry.try_get<TransformComponent>(parent);
+        if(parent_transform == nullptr) {
+            return false;
+        }
+        if(parent_transform->is_dirty) {
+            return true;
+        }
+        parent = parent_transform->parent;
+    }
+
+    return false;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <EASTL/numeric_limits.h>
 #include <EASTL/optional.h>
+#include <EASTL/unordered_map.h>
 #include <EASTL/unordered_set.h>
 #include <EASTL/span.h>
 #include <EASTL/string_view.h>
@@ -14,6 +16,8 @@
 #include "scene/game_object_component.hpp"
 #include "shared/prelude.h"
 
+class ThreadPool;
+
 /**
  * Represents the scene of the game world
  *
@@ -27,17 +31,32 @@ public:
      *
      * Does NOT check the given entity. If that's the one you want - well, you already have it!
      *
+     * Looks the name up in the name index, then walks up from each match to see if it's under the entity. If several
+     * children have the name, returns the one closest to the entity, then the first one in child order
+     *
      * @param entity Entity to search the children of
      * @param child_name Name to search for. Must match exactly
      * @return Handle to the found entity, or an empty handle if the child can't be found
      */
-    static entt::handle find_child(entt::handle entity, eastl::string_view child_name);
+    entt::handle find_child(entt::handle entity, eastl::string_view child_name) const;
 
+    /**
+     * Finds the child of the entity with the given component that's closest to the entity. Does NOT check the given
+     * entity. If several children are equally close, returns the first one in child order
+     *
+     * Walks down the tree one level at a time. If the tree turns out to have more entities than there are entities with
+     * the component, walks up from each of those instead
+     */
     template<typename ComponentType>
     static entt::handle find_component_in_children(entt::handle entity);
 
+    /**
+     * Creates a world that updates transforms on the engine's thread pool
+     */
     World();
 
+    explicit World(ThreadPool& thread_pool_in);
+
     entt::handle make_handle(entt::entity entity);
 
     /**
@@ -54,12 +73,17 @@ public:
         );
 
     /**
-     * Attempts to find an entity with the provided name in the world
+     * Attempts to find an entity with the provided name in the world. Prefers top-level entities if several entities
+     * have the name
      *
-     * This is relatively expensive, it should be called sparingly
+     * This is a hash lookup, plus a string comparison for each entity with the same name hash
      */
     entt::handle find_entity(eastl::string_view name);
 
+    /**
+     * Queues the entity and all its children for destruction. They're destroyed together at the start of the next
+     * tick, so observers see one batch of destroys per frame
+     */
     void destroy_entity(entt::entity entity);
 
     /**
@@ -80,43 +104,160 @@ public:
 
     const eastl::unordered_set<entt::entity>& get_top_level_entities() const;
 
+    /**
+     * Entities whose local-to-world transform changed in the last tick, parents before children. Each entity is listed
+     * once
+     */
+    eastl::span<const entt::entity> get_changed_transforms() const;
+
+    /**
+     * Local-to-world matrix of each entity in get_changed_transforms(), in the same order
+     */
+    eastl::span<const float4x4> get_changed_local_to_world() const;
+
 private:
+    /**
+     * Entities by the hash of their EntityInfoComponent name. Declared before the registry so that it outlives the
+     * registry's destroy signals
+     */
+    eastl::unordered_multimap<uint64_t, entt::entity> entities_by_name;
+
+    /**
+     * The name hash each entity is indexed under, so we can find its index entry after its name changes
+     */
+    eastl::unordered_map<entt::entity, uint64_t> entity_name_hashes;
+
     entt::registry registry;
 
+    ThreadPool& thread_pool;
+
     /**
      * List of all the top-level entities from each model we load. The transform update logic starts at these and
      * propagates transforms down the child chain
      */
     eastl::unordered_set<entt::entity> top_level_entities;
 
+    /**
+     * Entities that destroy_entity was called on since the last tick
+     */
+    eastl::vector<entt::entity> entities_to_destroy;
+
+    /**
+     * Entities whose transform was patched since the last tick
+     */
+    eastl::vector<entt::entity> dirty_transforms;
+
+    eastl::vector<entt::entity> changed_transforms;
+
+    eastl::vector<float4x4> changed_local_to_world;
+
+    /**
+     * Children found by each chunk of the level being updated. Kept around to reuse their memory
+     */
+    eastl::vector<eastl::vector<entt::entity>> chunk_children;
+
+    /**
+     * Marks the entity's transform as dirty. Patching a transform does nothing else, no matter how many children the
+     * entity has
+     */
     void on_transform_update(entt::registry& registry,  entt::entity entity);
 
     /**
-     * Propagates the entity's transform to its children
+     * Destroys the queued entities and their children, unlinking them from their scenes and parents first
      */
-    void propagate_transform(entt::entity entity);
+    void destroy_queued_entities();
+
+    /**
+     * Recomputes the transforms of every dirty entity and its children, and fills in the list of changed transforms
+     *
+     * Works one hierarchy level at a time, starting from the dirty entities that have no dirty ancestors. Large levels
+     * are split into chunks that run on the thread pool. Each entity's matrix only depends on its parent's, so the
+     * results don't depend on the number of threads
+     */
+    void update_transforms();
+
+    /**
+     * Updates the entities in one chunk of a level, and collects their children
+     */
+    void update_transform_chunk(
+        eastl::span<const entt::entity> entities, eastl::span<float4x4> local_to_worlds,
+        eastl::vector<entt::entity>& children
+    );
+
+    bool has_dirty_ancestor(const TransformComponent& transform) const;
+
+    void on_construct_entity_info(entt::registry& registry, entt::entity entity);
+
+    void on_update_entity_info(entt::registry& registry, entt::entity entity);
+
+    void on_destroy_entity_info(entt::registry& registry, entt::entity entity);
+
+    void remove_from_name_index(entt::entity entity);
+
+    /**
+     * How many levels below the ancestor the entity is. 0 if the entity isn't below the ancestor
+     */
+    static uint32_t get_depth_below(const entt::registry& registry, entt::entity entity, entt::entity ancestor);
+
+    /**
+     * Whether a comes before b in child order, like in a depth-first walk. a and b must be the same number of levels
+     * below a common ancestor
+     */
+    static bool is_earlier_child(const entt::registry& registry, entt::entity a, entt::entity b);
 };
 
 template<typename ComponentType>
 entt::handle World::find_component_in_children(const entt::handle entity) {
-    if(const auto* trans = entity.try_get<TransformComponent>(); trans != nullptr) {
-        for(const auto child : trans->children) {
-            auto child_handle = entt::handle{*entity.registry(), child};
-            if(child_handle.try_get<ComponentType>() != nullptr) {
-                return child_handle;
+    auto& registry = *entity.registry();
+    const auto candidates = registry.view<ComponentType>();
+
+    auto level = eastl::vector<entt::entity>{entity.entity()};
+    auto next_level = eastl::vector<entt::entity>{};
+    auto num_visited = size_t{0};
+    while(!level.empty() && num_visited < candidates.size()) {
+        // Each level is in child order, so the first match is the one we want
+        for(const auto parent : level) {
+            const auto* transform = registry.try_get<TransformComponent>(parent);
+            if(transform == nullptr) {
+                continue;
             }
-        }
 
-        for(const auto child : trans->children) {
-            auto child_handle = entt::handle{*entity.registry(), child};
-            const auto found_child = find_component_in_children<ComponentType>(child_handle);
-            if(found_child.valid()) {
-                return found_child;
+            for(const auto child : transform->children) {
+                if(!registry.valid(child)) {
+                    continue;
+                }
+
+                if(candidates.contains(child)) {
+                    return entt::handle{registry, child};
+                }
+                num_visited++;
+                next_level.emplace_back(child);
             }
         }
+
+        eastl::swap(level, next_level);
+        next_level.clear();
+    }
+
+    if(level.empty()) {
+        return {};
+    }
+
+    auto found_child = entt::entity{entt::null};
+    auto found_depth = eastl::numeric_limits<uint32_t>::max();
+    for(const auto candidate : candidates) {
+        const auto depth = get_depth_below(registry, candidate, entity.entity());
+        if(depth == 0 || depth > found_depth) {
+            continue;
+        }
+
+        if(depth < found_depth || is_earlier_child(registry, candidate, found_child)) {
+            found_child = candidate;
+            found_depth = depth;
+        }
     }
 
-    return {};
+    return found_child != entt::null ? entt::handle{registry, found_child} : entt::handle{};
 }
 
 template<typename GameObjectType>
@@ -0,0 +1,36 @@
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+#include "shared/prelude.h"
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+/**
+ * A cluster of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles. A meshlet's triangles are a
+ * contiguous range of its mesh's index buffer, so a visible meshlet can be drawn with a normal indexed draw
+ */
+struct MeshletGPU {
+    // Mesh-space bounding sphere. xyz is the center, w is the radius
+    float4 bounding_sphere;
+
+    // Mesh-space normal cone. xyz is the cone's axis, w is the cosine of the cone's cutoff angle. The meshlet is
+    // back-facing if dot(normalize(center - camera), axis) >= cutoff + radius / distance(center, camera). A cutoff of 1
+    // means the cone is too wide to ever cull
+    float4 cone_axis_and_cutoff;
+
+    // Index of the meshlet's first index. In cooked data this is relative to the primitive's index buffer, in
+    // MeshStorage's meshlet buffer it's relative to the start of the global index buffer
+    uint first_index;
+
+    uint num_triangles;
+
+    uint padding0;
+    uint padding1;
+};
+
+#if defined(__cplusplus)
+static_assert(sizeof(MeshletGPU) == 48);
+#endif
+
+#endif
@@ -19,6 +19,13 @@
 // This primitive is a skinned mesh
 #define PRIMITIVE_TYPE_SKINNED          1 << 4
 
+// This primitive's vertex data is PackedVertexData, not StandardVertexData
+#define PRIMITIVE_TYPE_PACKED_VERTICES  1 << 5
+
+// Number of LODs that MeshStorage keeps draw arguments for. A mesh's draw arguments are at
+// mesh_id * MESH_MAX_LODS + lod
+#define MESH_MAX_LODS 4
+
 /**
  * Runtime primitive flags - these may change when various things happen
  */
@@ -61,7 +68,7 @@ using BoneTransformsPointer = uint64_t;
 #define BoneTransformsPointer float4x4*
 #endif
 
-// Size 200
+// Size 208
 struct PrimitiveDataGPU {
     float4x4 model;
     float4x4 inverse_model;
@@ -79,6 +86,10 @@ struct PrimitiveDataGPU {
     IndexPointer indices;
     VertexPositionPointer vertex_positions;
     VertexDataPointer vertex_data;
+
+    // LOD to draw in the main view. Picked on the CPU by RenderWorld
+    uint lod;
+    uint padding;
 };
 
 struct SkeletalPrimitiveDataGPU {
@@ -96,8 +107,8 @@ struct SkeletalPrimitiveDataGPU {
 };
 
 #if defined(__cplusplus)
-static_assert(sizeof(PrimitiveDataGPU) == 200);
-static_assert(200 % alignof(PrimitiveDataGPU) == 0);
+static_assert(sizeof(PrimitiveDataGPU) == 208);
+static_assert(208 % alignof(PrimitiveDataGPU) == 0);
 #endif
 
 #endif
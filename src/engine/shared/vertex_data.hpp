@@ -3,8 +3,8 @@
 
 #include "shared/prelude.h"
 
-// TODO: Compress down to 20 bytes
-// We're at 52 now :(
+// Interleaved vertex that importers produce. MeshStorage splits this into a position stream and a data stream, and may
+// pack the data stream into PackedVertexData
 struct StandardVertex {
     float3 position;
     float3 normal;
@@ -24,6 +24,28 @@ struct StandardVertexData {
     unorm4 color;
 };
 
+/**
+ * Compressed version of StandardVertexData. 16 bytes instead of 40
+ *
+ * See render/vertex_packing.hpp for the CPU encoders, and shaders/common/vertex_packing.slangi for the GPU decoders
+ */
+struct PackedVertexData {
+    // Octahedral-encoded normal, two snorm16s
+    uint normal;
+
+    // Octahedral-encoded tangent, two snorm16s. The lowest bit is the bitangent sign - 1 means the sign is negative
+    uint tangent;
+
+    // Two halfs
+    uint texcoord;
+
+    unorm4 color;
+};
+
+#if defined(__cplusplus)
+static_assert(sizeof(PackedVertexData) == 16);
+#endif
+
 struct JoltDebugVertex {
     float3 position;
     unorm4 color;
@@ -3,6 +3,7 @@
 #include <core/system_interface.hpp>
 
 #include <core/engine.hpp>
+#include <resources/resource_loader.hpp>
 #include <tracy/Tracy.hpp>
 
 #include "game_instance/mesannapada_game_instance.hpp"
@@ -15,6 +16,14 @@ int main(const int argc, const char** argv) {
 
     SystemInterface::initialize(exe_folder);
 
+    // --cook cooks the game's models for fast loading, then exits without starting the engine. --cook --force re-cooks
+    // everything, which doubles as a benchmark for the mesh optimizer
+    if(argc > 1 && std::string_view{argv[1]} == "--cook") {
+        const auto force = argc > 2 && std::string_view{argv[2]} == "--force";
+        ResourceLoader::cook_models(force);
+        return 0;
+    }
+
     Engine engine;
 
     engine.initialize_game_instance<MesannepadaGameInstance>();
@@ -0,0 +1,17 @@
+# Tests and benchmarks for SahCore
+#
+# Everything in here runs on the CPU. Benchmarks are hidden from the default run. Run them with `SahTests [benchmark]`
+
+file(GLOB_RECURSE TEST_SOURCES CONFIGURE_DEPENDS ${CMAKE_CURRENT_LIST_DIR}/*.cpp ${CMAKE_CURRENT_LIST_DIR}/*.hpp)
+
+add_executable(SahTests ${TEST_SOURCES})
+target_include_directories(SahTests PRIVATE
+        "${CMAKE_CURRENT_LIST_DIR}"
+        )
+
+target_link_libraries(SahTests PRIVATE
+        SahCore
+        Catch2::Catch2WithMain
+        )
+
+add_test(NAME SahTests COMMAND SahTests)
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/system_interface.hpp"
+
+/**
+ * Creates the system interface, once. Engine classes ask it for their loggers when they're created. Nothing else about
+ * it gets used, so we don't create a window
+ */
+inline void initialize_system_interface() {
+    static const auto initialized = [] {
+        SystemInterface::initialize(std::filesystem::current_path());
+        return true;
+    }();
+    (void)initialized;
+}
@@ -0,0 +1,159 @@
+#include <cstring>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/backend/pipeline_cache_file.hpp"
+
+namespace render {
+    /**
+     * Byte offsets of the header fields we tamper with. See PipelineCacheFileHeader
+     */
+    constexpr size_t VERSION_OFFSET = 4;
+    constexpr size_t DATA_HASH_OFFSET = 48;
+    constexpr size_t HEADER_SIZE = 56;
+
+    static PipelineCacheDeviceInfo make_device() {
+        auto device = PipelineCacheDeviceInfo{
+            .vendor_id = 0x10DE,
+            .device_id = 0x2684,
+            .driver_version = 0x8A4A4000,
+        };
+        for (auto i = 0u; i < device.pipeline_cache_uuid.size(); i++) {
+            device.pipeline_cache_uuid[i] = static_cast<uint8_t>(i * 7);
+        }
+        return device;
+    }
+
+    static eastl::vector<std::byte> make_cache_data() {
+        auto data = eastl::vector<std::byte>(300);
+        for (auto i = 0u; i < data.size(); i++) {
+            data[i] = static_cast<std::byte>(i * 31);
+        }
+        return data;
+    }
+
+    template <typename ValueType>
+    static void overwrite(eastl::vector<std::byte>& file, const size_t offset, const ValueType value) {
+        std::memcpy(file.data() + offset, &value, sizeof(ValueType));
+    }
+
+    TEST_CASE("Pipeline cache files round trip", "[pipeline_cache]") {
+        const auto device = make_device();
+        const auto data = make_cache_data();
+
+        const auto file = write_pipeline_cache_file(device, data);
+        REQUIRE(file.size() == HEADER_SIZE + data.size());
+
+        const auto contents = read_pipeline_cache_file(file, device);
+        REQUIRE(contents.status == PipelineCacheFileStatus::Valid);
+        REQUIRE(contents.cache_data.size() == data.size());
+        CHECK(std::memcmp(contents.cache_data.data(), data.data(), data.size()) == 0);
+
+        const auto empty_file = write_pipeline_cache_file(device, {});
+        const auto empty_contents = read_pipeline_cache_file(empty_file, device);
+        CHECK(empty_contents.status == PipelineCacheFileStatus::Valid);
+        CHECK(empty_contents.cache_data.empty());
+    }
+
+    TEST_CASE("Pipeline cache files from another device are rejected", "[pipeline_cache]") {
+        const auto device = make_device();
+        const auto file = write_pipeline_cache_file(device, make_cache_data());
+
+        auto other_device = device;
+        SECTION("Vendor") {
+            other_device.vendor_id = 0x1002;
+        }
+        SECTION("Device") {
+            other_device.device_id++;
+        }
+        SECTION("Driver version") {
+            other_device.driver_version++;
+        }
+        SECTION("Pipeline cache UUID") {
+            other_device.pipeline_cache_uuid.back() ^= 1;
+        }
+
+        const auto contents = read_pipeline_cache_file(file, other_device);
+        CHECK(contents.status == PipelineCacheFileStatus::WrongDevice);
+        CHECK(contents.cache_data.empty());
+    }
+
+    TEST_CASE("Damaged pipeline cache files are rejected", "[pipeline_cache]") {
+        const auto device = make_device();
+        auto file = write_pipeline_cache_file(device, make_cache_data());
+
+        auto expected_status = PipelineCacheFileStatus::Valid;
+        SECTION("Wrong magic") {
+            overwrite(file, 0, uint32_t{0x46464952});
+            expected_status = PipelineCacheFileStatus::WrongMagic;
+        }
+        SECTION("Older version") {
+            overwrite(file, VERSION_OFFSET, PIPELINE_CACHE_FILE_VERSION - 1);
+            expected_status = PipelineCacheFileStatus::WrongVersion;
+        }
+        SECTION("Newer version") {
+            overwrite(file, VERSION_OFFSET, PIPELINE_CACHE_FILE_VERSION + 1);
+            expected_status = PipelineCacheFileStatus::WrongVersion;
+        }
+        SECTION("Header cut short") {
+            file.resize(HEADER_SIZE - 1);
+            expected_status = PipelineCacheFileStatus::Truncated;
+        }
+        SECTION("Data cut short") {
+            file.pop_back();
+            expected_status = PipelineCacheFileStatus::Truncated;
+        }
+        SECTION("Data changed") {
+            file[HEADER_SIZE + 10] ^= std::byte{0x20};
+            expected_status = PipelineCacheFileStatus::Corrupt;
+        }
+        SECTION("Hash changed") {
+            overwrite(file, DATA_HASH_OFFSET, uint64_t{0x0123456789ABCDEF});
+            expected_status = PipelineCacheFileStatus::Corrupt;
+        }
+
+        const auto contents = read_pipeline_cache_file(file, device);
+        CHECK(contents.status == expected_status);
+        CHECK(contents.cache_data.empty());
+    }
+
+    TEST_CASE("Pipeline manifests round trip", "[pipeline_cache]") {
+        auto entries = eastl::vector<PipelineManifestEntry>{
+            {
+                .pipeline_name = "Opaque gbuffer",
+                .variant = {
+                    .depth_format = VK_FORMAT_D32_SFLOAT,
+                    .view_mask = 0x3,
+                    .use_fragment_shading_rate_attachment = true,
+                }
+            },
+            {
+                .pipeline_name = "Shadow",
+                .variant = {.depth_format = VK_FORMAT_D16_UNORM}
+            },
+        };
+        entries[0].variant.color_formats = {VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_A2B10G10R10_UNORM_PACK32};
+
+        const auto manifest = write_pipeline_manifest(entries);
+        CHECK(read_pipeline_manifest({manifest.data(), manifest.size()}) == entries);
+    }
+
+    TEST_CASE("Pipeline manifests skip what they can't read", "[pipeline_cache]") {
+        CHECK(read_pipeline_manifest("pipeline-manifest 0\nShadow\t0\t0\t124\t\n").empty());
+        CHECK(read_pipeline_manifest("").empty());
+
+        const auto entries = read_pipeline_manifest(
+            "pipeline-manifest 1\n"
+            "Shadow\t0\t0\t124\t\n"
+            "Broken\tnot a number\t0\t124\t\n"
+            "\t0\t0\t124\t\n"
+            "Bad color\t0\t0\t0\t37,x\n"
+            "Lit\t0\t0\t126\t37\n");
+        REQUIRE(entries.size() == 2);
+        CHECK(entries[0].pipeline_name == "Shadow");
+        CHECK(entries[0].variant.color_formats.empty());
+        CHECK(entries[1].pipeline_name == "Lit");
+        CHECK(entries[1].variant.depth_format == VK_FORMAT_D32_SFLOAT);
+        CHECK(entries[1].variant.color_formats.size() == 1);
+    }
+}
@@ -0,0 +1,222 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/backend/render_graph_compiler.hpp"
+
+namespace render {
+    /**
+     * Builds passes that touch made-up resources. The compiler only compares handles, so they never get dereferenced
+     */
+    class TestGraph {
+    public:
+        static TextureHandle texture(const uintptr_t id) {
+            return reinterpret_cast<TextureHandle>(id * 16);
+        }
+
+        static BufferHandle buffer(const uintptr_t id) {
+            return reinterpret_cast<BufferHandle>(id * 16);
+        }
+
+        TestGraph& pass(const std::string& name) {
+            passes.emplace_back(RenderGraphPass{.name = name, .record = [](CommandBuffer&) {}});
+            return *this;
+        }
+
+        TestGraph& reads(const TextureHandle texture) {
+            passes.back().textures.emplace_back(
+                TextureUsageToken{
+                    .texture = texture,
+                    .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                    .layout = VK_IMAGE_LAYOUT_GENERAL
+                });
+            return *this;
+        }
+
+        TestGraph& writes(const TextureHandle texture) {
+            passes.back().textures.emplace_back(
+                TextureUsageToken{
+                    .texture = texture,
+                    .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                    .layout = VK_IMAGE_LAYOUT_GENERAL
+                });
+            return *this;
+        }
+
+        TestGraph& reads(const BufferHandle buffer) {
+            passes.back().buffers.emplace_back(
+                BufferUsageToken{
+                    .buffer = buffer,
+                    .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+                });
+            return *this;
+        }
+
+        TestGraph& writes(const BufferHandle buffer) {
+            passes.back().buffers.emplace_back(
+                BufferUsageToken{
+                    .buffer = buffer,
+                    .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+                });
+            return *this;
+        }
+
+        TestGraph& no_side_effects() {
+            passes.back().has_side_effects = false;
+            return *this;
+        }
+
+        TestGraph& fence() {
+            passes.back().is_fence = true;
+            return *this;
+        }
+
+        TestGraph& transient(const TextureHandle texture) {
+            transients.textures.insert(texture);
+            return *this;
+        }
+
+        TestGraph& transient(const BufferHandle buffer) {
+            transients.buffers.insert(buffer);
+            return *this;
+        }
+
+        RenderGraphSchedule compile(const RenderGraphCompileOptions& options = {}) const {
+            return compile_render_graph(passes, transients, options);
+        }
+
+        eastl::vector<RenderGraphPass> passes;
+
+        RenderGraphTransients transients;
+    };
+
+    using Batches = eastl::vector<eastl::vector<uint32_t>>;
+
+    /**
+     * Flattens a schedule to the pass indices in each batch
+     */
+    static Batches to_batches(const RenderGraphSchedule& schedule) {
+        auto batches = Batches{};
+        for (const auto& batch : schedule.batches) {
+            batches.emplace_back(batch.passes.begin(), batch.passes.end());
+        }
+        return batches;
+    }
+
+    TEST_CASE("compile_render_graph batches passes that don't depend on each other", "[render_graph]") {
+        const auto shadows = TestGraph::texture(1);
+        const auto ao = TestGraph::texture(2);
+        const auto lighting = TestGraph::texture(3);
+
+        auto graph = TestGraph{};
+        graph.pass("shadows").writes(shadows).no_side_effects()
+             .pass("ao").writes(ao).no_side_effects()
+             .pass("lighting").reads(shadows).reads(ao).writes(lighting).no_side_effects();
+
+        const auto schedule = graph.compile();
+        CHECK(to_batches(schedule) == Batches{{0, 1}, {2}});
+        CHECK(schedule.culled_passes.empty());
+    }
+
+    TEST_CASE("compile_render_graph orders writes after earlier reads", "[render_graph]") {
+        const auto history = TestGraph::buffer(1);
+        const auto output = TestGraph::buffer(2);
+
+        auto graph = TestGraph{};
+        graph.pass("read history").reads(history).writes(output).no_side_effects()
+             .pass("update history").writes(history).no_side_effects()
+             .pass("unrelated").writes(TestGraph::buffer(3)).no_side_effects();
+
+        CHECK(to_batches(graph.compile()) == Batches{{0, 2}, {1}});
+    }
+
+    TEST_CASE("compile_render_graph treats layout changes as writes", "[render_graph]") {
+        const auto texture = TestGraph::texture(1);
+
+        auto graph = TestGraph{};
+        graph.pass("sample").reads(texture).writes(TestGraph::texture(2)).no_side_effects()
+             .pass("sample again").reads(texture).writes(TestGraph::texture(3)).no_side_effects();
+        graph.passes[1].textures[0].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        CHECK(to_batches(graph.compile()) == Batches{{0}, {1}});
+    }
+
+    TEST_CASE("compile_render_graph never moves passes across a fence", "[render_graph]") {
+        auto graph = TestGraph{};
+        graph.pass("a").writes(TestGraph::texture(1)).no_side_effects()
+             .pass("fence").writes(TestGraph::texture(2)).fence().no_side_effects()
+             .pass("b").writes(TestGraph::texture(3)).no_side_effects()
+             .pass("label")
+             .pass("c").writes(TestGraph::texture(4)).no_side_effects();
+
+        CHECK(to_batches(graph.compile()) == Batches{{0}, {1}, {2}, {3}, {4}});
+    }
+
+    TEST_CASE("compile_render_graph never moves passes across a pass with side effects", "[render_graph]") {
+        // The passes with side effects share a buffer through its device address, which neither of them declares
+        auto graph = TestGraph{};
+        graph.pass("a").writes(TestGraph::texture(1)).no_side_effects()
+             .pass("write through BDA").writes(TestGraph::texture(2))
+             .pass("read through BDA").writes(TestGraph::texture(3))
+             .pass("b").writes(TestGraph::texture(4)).no_side_effects();
+
+        CHECK(to_batches(graph.compile()) == Batches{{0}, {1}, {2}, {3}});
+    }
+
+    TEST_CASE("compile_render_graph keeps the order passes were added when reordering is off", "[render_graph]") {
+        auto graph = TestGraph{};
+        graph.pass("a").writes(TestGraph::texture(1)).no_side_effects()
+             .pass("b").writes(TestGraph::texture(2)).no_side_effects();
+
+        CHECK(to_batches(graph.compile({.reorder_passes = false})) == Batches{{0}, {1}});
+    }
+
+    TEST_CASE("compile_render_graph only culls passes without side effects", "[render_graph]") {
+        const auto depth = TestGraph::texture(1);
+        const auto unused_output = TestGraph::texture(2);
+        const auto bda_output = TestGraph::texture(3);
+        const auto scratch = TestGraph::buffer(4);
+
+        auto graph = TestGraph{};
+        graph.transient(depth).transient(unused_output).transient(bda_output).transient(scratch)
+             .pass("depth prepass").writes(depth).no_side_effects()
+             .pass("nobody reads this").reads(depth).writes(unused_output).no_side_effects()
+             .pass("writes through BDA").reads(depth).writes(bda_output)
+             .pass("clear scratch").writes(scratch).no_side_effects();
+
+        SECTION("Keeps passes with side effects, and the passes that feed them") {
+            const auto schedule = graph.compile();
+            CHECK(schedule.culled_passes == eastl::vector<uint32_t>{1, 3});
+            CHECK(to_batches(schedule) == Batches{{0}, {2}});
+        }
+
+        SECTION("Culls every pass that opted in when nothing needs their outputs") {
+            graph.passes[2].has_side_effects = false;
+            const auto schedule = graph.compile();
+            CHECK(schedule.culled_passes == eastl::vector<uint32_t>{0, 1, 2, 3});
+            CHECK(schedule.batches.empty());
+        }
+
+        SECTION("Keeps everything when culling is off") {
+            const auto schedule = graph.compile({.cull_passes = false});
+            CHECK(schedule.culled_passes.empty());
+            CHECK(to_batches(schedule) == Batches{{0}, {1}, {2}, {3}});
+        }
+    }
+
+    TEST_CASE("compile_render_graph keeps passes that write persistent resources", "[render_graph]") {
+        const auto transient = TestGraph::texture(1);
+        const auto persistent = TestGraph::buffer(2);
+
+        auto graph = TestGraph{};
+        graph.transient(transient)
+             .pass("produce").writes(transient).no_side_effects()
+             .pass("consume").reads(transient).writes(persistent).no_side_effects();
+
+        const auto schedule = graph.compile();
+        CHECK(schedule.culled_passes.empty());
+        CHECK(to_batches(schedule) == Batches{{0}, {1}});
+    }
+}
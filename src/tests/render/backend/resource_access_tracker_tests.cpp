@@ -0,0 +1,166 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/test_system_interface.hpp"
+#include "render/backend/buffer.hpp"
+#include "render/backend/gpu_texture.hpp"
+#include "render/backend/resource_access_synchronizer.hpp"
+
+namespace render {
+    /**
+     * Resources that only exist on the CPU. The tracker never touches their Vulkan handles, it only copies them into
+     * barriers
+     */
+    static eastl::vector<GpuTexture> make_textures(const uint32_t count, const uint32_t num_mips) {
+        auto textures = eastl::vector<GpuTexture>(count);
+        for(auto& texture : textures) {
+            // The tracker breaks into the debugger when a nameless texture leaves the undefined layout after its
+            // first use
+            texture.name = "Test texture";
+            texture.create_info = VkImageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = VK_FORMAT_R16G16B16A16_SFLOAT,
+                .extent = {1024, 1024, 1},
+                .mipLevels = num_mips,
+                .arrayLayers = 1,
+            };
+        }
+        return textures;
+    }
+
+    static eastl::vector<GpuBuffer> make_buffers(const uint32_t count) {
+        auto buffers = eastl::vector<GpuBuffer>(count);
+        for(auto& buffer : buffers) {
+            buffer.create_info = VkBufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, .size = 65536};
+        }
+        return buffers;
+    }
+
+    static TextureUsageToken compute_write(const TextureHandle texture) {
+        return {
+            .texture = texture,
+            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            .layout = VK_IMAGE_LAYOUT_GENERAL
+        };
+    }
+
+    static TextureUsageToken compute_read(const TextureHandle texture) {
+        return {
+            .texture = texture,
+            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+    }
+
+    static BufferUsageToken compute_write(const BufferHandle buffer) {
+        return {
+            .buffer = buffer,
+            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+        };
+    }
+
+    static BufferUsageToken compute_read(const BufferHandle buffer) {
+        return {
+            .buffer = buffer,
+            .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+        };
+    }
+
+    TEST_CASE("ResourceAccessTracker only adds the barriers that are needed", "[access_tracker]") {
+        initialize_system_interface();
+        auto tracker = ResourceAccessTracker{};
+
+        auto buffers = make_buffers(1);
+        const auto buffer = &buffers[0];
+        tracker.set_resource_usage(compute_read(buffer));
+        tracker.set_resource_usage(compute_read(buffer));
+        CHECK(tracker.take_barriers().is_empty());
+
+        tracker.set_resource_usage(compute_write(buffer));
+        CHECK(tracker.take_barriers().buffer_barriers.size() == 1);
+
+        auto textures = make_textures(1, 4);
+        const auto texture = &textures[0];
+        tracker.set_resource_usage(compute_write(texture));
+        const auto first_use = tracker.take_barriers();
+        REQUIRE(first_use.image_barriers.size() == 1);
+        CHECK(first_use.image_barriers[0].oldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+
+        // Read mip 1, then the whole texture. Only mip 1 is already in the read state
+        auto read_mip_1 = compute_read(texture);
+        read_mip_1.first_mip = 1;
+        read_mip_1.num_mips = 1;
+        tracker.set_resource_usage(read_mip_1);
+        CHECK(tracker.take_barriers().image_barriers.size() == 1);
+
+        tracker.set_resource_usage(compute_read(texture));
+        const auto whole_texture = tracker.take_barriers();
+        REQUIRE(whole_texture.image_barriers.size() == 2);
+        CHECK(whole_texture.image_barriers[0].subresourceRange.baseMipLevel == 0);
+        CHECK(whole_texture.image_barriers[0].subresourceRange.levelCount == 1);
+        CHECK(whole_texture.image_barriers[1].subresourceRange.baseMipLevel == 2);
+        CHECK(whole_texture.image_barriers[1].subresourceRange.levelCount == 2);
+
+        tracker.set_resource_usage(compute_read(texture));
+        CHECK(tracker.take_barriers().is_empty());
+
+        tracker.release(texture);
+        tracker.release(buffer);
+        CHECK(texture->access_tracker_slot == UINT32_MAX);
+        CHECK(buffer->access_tracker_slot == UINT32_MAX);
+    }
+
+    TEST_CASE("ResourceAccessTracker with thousands of resources", "[.benchmark]") {
+        initialize_system_interface();
+        auto tracker = ResourceAccessTracker{};
+
+        // A frame's worth of usage tokens: each resource gets written, then read
+        auto textures = make_textures(4096, 1);
+        auto buffers = make_buffers(4096);
+        const auto run_frame = [&] {
+            for(auto& texture : textures) {
+                tracker.set_resource_usage(compute_write(&texture));
+            }
+            for(auto& buffer : buffers) {
+                tracker.set_resource_usage(compute_write(&buffer));
+            }
+            for(auto& texture : textures) {
+                tracker.set_resource_usage(compute_read(&texture));
+            }
+            for(auto& buffer : buffers) {
+                tracker.set_resource_usage(compute_read(&buffer));
+            }
+
+            const auto barriers = tracker.take_barriers();
+            return barriers.image_barriers.size() + barriers.buffer_barriers.size();
+        };
+
+        run_frame();
+
+        BENCHMARK("16k usage tokens") {
+            return run_frame();
+        };
+
+        // Mip chains need the per-subresource state
+        auto mip_chains = make_textures(1024, 11);
+        BENCHMARK("1024 mip chains, one mip at a time") {
+            for(auto& texture : mip_chains) {
+                for(auto mip = 0u; mip < 11; mip++) {
+                    auto usage = compute_write(&texture);
+                    usage.first_mip = mip;
+                    usage.num_mips = 1;
+                    tracker.set_resource_usage(usage);
+                }
+                tracker.set_resource_usage(compute_read(&texture));
+            }
+
+            const auto barriers = tracker.take_barriers();
+            return barriers.image_barriers.size();
+        };
+    }
+}
@@ -0,0 +1,88 @@
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/backend/scatter_upload_buffer.hpp"
+#include "shared/primitive_data.hpp"
+
+namespace render {
+    /**
+     * Checks that the staged writes are exactly the given ones, in order
+     */
+    static void check_staged(
+        const ScatterUploadBuffer<uint32_t>& uploads, const eastl::vector<uint32_t>& destination_indices,
+        const eastl::vector<uint32_t>& data
+        ) {
+        REQUIRE(uploads.get_size() == destination_indices.size());
+        REQUIRE(uploads.get_destination_indices().size() == destination_indices.size());
+        REQUIRE(uploads.get_staged_data().size() == data.size());
+        for(auto i = 0u; i < destination_indices.size(); i++) {
+            CHECK(uploads.get_destination_indices()[i] == destination_indices[i]);
+            CHECK(uploads.get_staged_data()[i] == data[i]);
+        }
+    }
+
+    TEST_CASE("ScatterUploadBuffer keeps the last write to each element", "[scatter_upload]") {
+        auto uploads = ScatterUploadBuffer<uint32_t>{};
+        CHECK(uploads.get_size() == 0);
+
+        uploads.add_data(7, 1);
+        uploads.add_data(100000, 2);
+        uploads.add_data(7, 3);
+        uploads.add_data(0, 4);
+        uploads.add_data(100000, 5);
+
+        // Later writes replace the data in place, so the element keeps the place of its first write
+        check_staged(uploads, {7, 100000, 0}, {3, 5, 4});
+    }
+
+    TEST_CASE("ScatterUploadBuffer starts over after a flush", "[scatter_upload]") {
+        auto uploads = ScatterUploadBuffer<uint32_t>{};
+        uploads.add_data(7, 1);
+        uploads.add_data(100000, 2);
+
+        // What flush_to_buffer does once the writes are in the arena
+        uploads.clear();
+        check_staged(uploads, {}, {});
+
+        // If the elements still had their old slots, these writes would go to slots that no longer exist instead of
+        // staging new ones
+        uploads.add_data(100000, 3);
+        uploads.add_data(7, 4);
+        uploads.add_data(100000, 5);
+        check_staged(uploads, {100000, 7}, {5, 4});
+
+        uploads.clear();
+        uploads.add_data(7, 6);
+        check_staged(uploads, {7}, {6});
+    }
+
+    /**
+     * Scatters count writes over twice as many elements, so about a fifth of them land on an element that already
+     * has a write
+     */
+    static uint32_t stage_scattered_writes(ScatterUploadBuffer<PrimitiveDataGPU>& uploads, const uint32_t count) {
+        auto state = uint32_t{12345};
+        const auto data = PrimitiveDataGPU{};
+        for(auto i = 0u; i < count; i++) {
+            state = state * 1664525u + 1013904223u;
+            uploads.add_data((state >> 8) % (count * 2), data);
+        }
+
+        return uploads.get_size();
+    }
+
+    TEST_CASE("ScatterUploadBuffer staging", "[.benchmark]") {
+        // Each run stages into a new buffer, so this includes growing the staging. Buffers that live across frames
+        // keep their capacity after a flush, so later frames cost less. The flush itself needs a GPU
+        for(const auto count : {10000u, 30000u, 100000u}) {
+            BENCHMARK_ADVANCED(fmt::format("{} writes", count))(Catch::Benchmark::Chronometer meter) {
+                auto runs = std::vector<ScatterUploadBuffer<PrimitiveDataGPU>>(meter.runs());
+                meter.measure([&](const int run) {
+                    return stage_scattered_writes(runs[run], count);
+                });
+            };
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#include <cstring>
+#include <memory>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <spdlog/fmt/bundled/format.h>
+
+#include "render/backend/buffer.hpp"
+#include "render/backend/staging_ring_buffer.hpp"
+
+namespace render {
+    /**
+     * A staging buffer that only exists on the CPU. The ring only needs its size and mapped pointer
+     */
+    struct TestStagingBuffer {
+        eastl::vector<uint8_t> memory;
+
+        GpuBuffer buffer;
+
+        explicit TestStagingBuffer(const uint64_t size) : memory(size) {
+            buffer.create_info = VkBufferCreateInfo{.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, .size = size};
+            buffer.allocation_info.pMappedData = memory.data();
+        }
+    };
+
+    TEST_CASE("StagingRingBuffer allocations are aligned and inside the buffer", "[staging_ring]") {
+        auto staging = TestStagingBuffer{1024};
+        auto ring = StagingRingBuffer{&staging.buffer};
+        CHECK(ring.get_size() == 1024);
+
+        const auto first = ring.allocate(10, 16);
+        REQUIRE(first.has_value());
+        CHECK(first->offset == 0);
+        CHECK(first->data == staging.memory.data());
+
+        const auto second = ring.allocate(100, 64);
+        REQUIRE(second.has_value());
+        CHECK(second->offset == 64);
+        CHECK(second->data == staging.memory.data() + 64);
+        CHECK(ring.get_bytes_in_use() == 164);
+
+        CHECK(!ring.allocate(2048, 16).has_value());
+    }
+
+    TEST_CASE("StagingRingBuffer frees a frame's allocations when the frame index comes around", "[staging_ring]") {
+        auto staging = TestStagingBuffer{1024};
+        auto ring = StagingRingBuffer{&staging.buffer};
+
+        ring.begin_frame(0);
+        REQUIRE(ring.allocate(512, 16).has_value());
+
+        ring.begin_frame(1);
+        REQUIRE(ring.allocate(256, 16).has_value());
+        CHECK(!ring.allocate(512, 16).has_value());
+
+        // Frame 0's fence has been waited on, so its 512 bytes are free. Frame 1's are still in use
+        ring.begin_frame(0);
+        CHECK(ring.get_bytes_in_use() == 256);
+
+        // There are 256 bytes left at the end, so this skips to the start of the buffer
+        const auto wrapped = ring.allocate(400, 16);
+        REQUIRE(wrapped.has_value());
+        CHECK(wrapped->offset == 0);
+        CHECK(!ring.allocate(200, 16).has_value());
+
+        ring.begin_frame(1);
+        ring.begin_frame(0);
+        CHECK(ring.get_bytes_in_use() == 0);
+        CHECK(ring.allocate(512, 16).has_value());
+    }
+
+    TEST_CASE("StagingRingBuffer allocation", "[.benchmark]") {
+        // The default size of r.RHI.StagingBufferSizeMB
+        auto staging = std::make_unique<TestStagingBuffer>(128ull << 20);
+        auto ring = StagingRingBuffer{&staging->buffer};
+        auto frame_index = 0u;
+        const auto next_frame = [&] {
+            frame_index = (frame_index + 1) % num_in_flight_frames;
+            ring.begin_frame(frame_index);
+        };
+
+        // Lots of small buffer uploads, like the scene's scatter uploads
+        for(const auto count : {1000u, 10000u}) {
+            BENCHMARK(fmt::format("{} allocations of 256 bytes", count)) {
+                next_frame();
+                auto total_offset = uint64_t{0};
+                for(auto i = 0u; i < count; i++) {
+                    total_offset += ring.allocate(256, 16)->offset;
+                }
+                return total_offset;
+            };
+        }
+
+        // A frame of texture streaming: the mip chains of six 2k BC7 textures, copied into the ring
+        const auto mip_data = eastl::vector<uint8_t>(4 << 20, 0x5A);
+        BENCHMARK("Staging 32 MB of mips") {
+            next_frame();
+            auto num_staged = 0u;
+            for(auto i = 0u; i < 6; i++) {
+                for(auto mip_size = mip_data.size(); mip_size >= 16; mip_size /= 4) {
+                    const auto allocation = ring.allocate(mip_size, 16);
+                    std::memcpy(allocation->data, mip_data.data(), mip_size);
+                    num_staged++;
+                }
+            }
+            return num_staged;
+        };
+    }
+}
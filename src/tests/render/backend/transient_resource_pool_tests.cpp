@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/backend/render_graph_compiler.hpp"
+#include "render/backend/transient_resource_pool.hpp"
+
+namespace render {
+    static TextureHandle fake_texture(const uintptr_t id) {
+        return reinterpret_cast<TextureHandle>(id * 16);
+    }
+
+    static ResourceLifetime batches(const uint32_t first, const uint32_t last) {
+        return {.first_batch = first, .last_batch = last};
+    }
+
+    static RenderGraphPass make_pass(const TextureHandle read, const TextureHandle write) {
+        auto pass = RenderGraphPass{.name = "test pass"};
+        if (read != nullptr) {
+            pass.textures.emplace_back(
+                TextureUsageToken{
+                    .texture = read,
+                    .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    .access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                    .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                });
+        }
+        pass.textures.emplace_back(
+            TextureUsageToken{
+                .texture = write,
+                .stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                .layout = VK_IMAGE_LAYOUT_GENERAL
+            });
+        pass.record = [](CommandBuffer&) {};
+        return pass;
+    }
+
+    /**
+     * Checks that no two requests that are alive at the same time share memory
+     */
+    static bool is_valid_layout(
+        const eastl::span<const TransientAllocationRequest> requests, const TransientHeapLayout& layout
+    ) {
+        for (auto i = 0u; i < requests.size(); i++) {
+            if (layout.offsets[i] % requests[i].alignment != 0 || layout.offsets[i] + requests[i].size > layout.size) {
+                return false;
+            }
+
+            for (auto j = i + 1; j < requests.size(); j++) {
+                const auto shares_memory = layout.offsets[i] < layout.offsets[j] + requests[j].size &&
+                    layout.offsets[j] < layout.offsets[i] + requests[i].size;
+                if (shares_memory && requests[i].lifetime.overlaps(requests[j].lifetime)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE("ResourceLifetime overlaps only when batches are shared", "[render_graph]") {
+        CHECK(batches(0, 2).overlaps(batches(2, 4)));
+        CHECK(batches(3, 3).overlaps(batches(0, 5)));
+        CHECK_FALSE(batches(0, 1).overlaps(batches(2, 3)));
+        CHECK_FALSE(ResourceLifetime{}.overlaps(batches(0, 10)));
+
+        auto lifetime = ResourceLifetime{};
+        CHECK(lifetime.is_empty());
+        lifetime.merge(batches(4, 5));
+        lifetime.merge(ResourceLifetime{});
+        lifetime.merge(batches(1, 2));
+        CHECK(lifetime == batches(1, 5));
+    }
+
+    TEST_CASE("compute_transient_lifetimes covers the batches that use each transient", "[render_graph]") {
+        const auto gbuffer = fake_texture(1);
+        const auto lighting = fake_texture(2);
+        const auto backbuffer = fake_texture(3);
+
+        const auto passes = eastl::vector<RenderGraphPass>{
+            make_pass(nullptr, gbuffer),
+            make_pass(gbuffer, lighting),
+            make_pass(lighting, backbuffer),
+        };
+        auto transients = RenderGraphTransients{};
+        transients.textures.insert(gbuffer);
+        transients.textures.insert(lighting);
+
+        const auto schedule = compile_render_graph(passes, transients, {});
+        REQUIRE(schedule.batches.size() == 3);
+
+        const auto lifetimes = compute_transient_lifetimes(passes, schedule, transients);
+        CHECK(lifetimes.textures.size() == 2);
+        CHECK(lifetimes.textures.at(gbuffer) == batches(0, 1));
+        CHECK(lifetimes.textures.at(lighting) == batches(1, 2));
+        CHECK(lifetimes.textures.count(backbuffer) == 0);
+    }
+
+    TEST_CASE("alias_transient_resources shares memory between transients that never overlap", "[render_graph]") {
+        const auto requests = eastl::vector<TransientAllocationRequest>{
+            {.size = 1024, .alignment = 256, .lifetime = batches(0, 1)},
+            {.size = 1024, .alignment = 256, .lifetime = batches(2, 3)},
+            {.size = 512, .alignment = 256, .lifetime = batches(1, 2)},
+        };
+
+        const auto layout = alias_transient_resources(requests);
+
+        CHECK(is_valid_layout(requests, layout));
+        CHECK(layout.offsets[0] == layout.offsets[1]);
+        CHECK(layout.size == 1536);
+        CHECK(layout.alignment == 256);
+    }
+
+    TEST_CASE("alias_transient_resources respects lifetimes and alignments", "[render_graph]") {
+        // Small LCG so the test is the same on every platform
+        auto state = uint32_t{12345};
+        const auto next = [&](const uint32_t max) {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) % max;
+        };
+
+        for (auto iteration = 0; iteration < 100; iteration++) {
+            auto requests = eastl::vector<TransientAllocationRequest>(1 + next(24));
+            for (auto& request : requests) {
+                const auto first = next(16);
+                request.size = (1 + next(64)) * 256;
+                request.alignment = VkDeviceSize{256} << next(4);
+                request.lifetime = batches(first, first + next(6));
+            }
+
+            const auto layout = alias_transient_resources(requests);
+            REQUIRE(is_valid_layout(requests, layout));
+
+            auto placements = eastl::vector<TransientPlacement>{};
+            for (auto i = 0u; i < requests.size(); i++) {
+                placements.push_back({layout.offsets[i], requests[i].size, requests[i].lifetime});
+            }
+            REQUIRE(find_aliasing_conflicts(placements).empty());
+        }
+    }
+
+    TEST_CASE("find_aliasing_conflicts catches a graph that changed shape", "[render_graph]") {
+        // Last frame, a and b were never alive together, so they got the same memory
+        const auto requests = eastl::vector<TransientAllocationRequest>{
+            {.size = 1024, .alignment = 256, .lifetime = batches(0, 1)},
+            {.size = 1024, .alignment = 256, .lifetime = batches(2, 3)},
+        };
+        const auto layout = alias_transient_resources(requests);
+        REQUIRE(layout.offsets[0] == layout.offsets[1]);
+
+        // This frame they overlap. Moving b out of the heap is enough
+        const auto placements = eastl::vector<TransientPlacement>{
+            {layout.offsets[0], 1024, batches(0, 2)},
+            {layout.offsets[1], 1024, batches(2, 3)},
+        };
+        CHECK(find_aliasing_conflicts(placements) == eastl::vector<uint32_t>{1});
+    }
+
+    TEST_CASE("find_aliasing_conflicts only moves what it has to", "[render_graph]") {
+        // b conflicts with both a and c, but a and c don't conflict with each other
+        const auto placements = eastl::vector<TransientPlacement>{
+            {0, 1024, batches(0, 1)},
+            {512, 1024, batches(1, 2)},
+            {1024, 1024, batches(2, 3)},
+        };
+        CHECK(find_aliasing_conflicts(placements) == eastl::vector<uint32_t>{1});
+
+        const auto disjoint = eastl::vector<TransientPlacement>{
+            {0, 1024, batches(0, 5)},
+            {1024, 1024, batches(0, 5)},
+            {0, 1024, ResourceLifetime{}},
+        };
+        CHECK(find_aliasing_conflicts(disjoint).empty());
+    }
+}
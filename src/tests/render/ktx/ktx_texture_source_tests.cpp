@@ -0,0 +1,273 @@
+#include <cstring>
+#include <random>
+
+#include <EASTL/algorithm.h>
+#include <basisu_transcoder.h>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/test_system_interface.hpp"
+#include "render/ktx/ktx_texture_source.hpp"
+
+namespace render {
+    constexpr auto KTX2_IDENTIFIER = eastl::array<uint8_t, 12>{
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    constexpr uint8_t KHR_DF_MODEL_RGBSDA = 1;
+    constexpr uint8_t KHR_DF_MODEL_UASTC = 166;
+    constexpr uint8_t KHR_DF_CHANNEL_UASTC_RGBA = 3;
+
+    template <typename ValueType>
+    static void append(eastl::vector<std::byte>& file, const ValueType& value) {
+        const auto offset = file.size();
+        file.resize(offset + sizeof(ValueType));
+        std::memcpy(file.data() + offset, &value, sizeof(ValueType));
+    }
+
+    /**
+     * Makes a data format descriptor with one sample. That's all the Basis transcoder reads, and our own parser
+     * doesn't look at the DFD
+     */
+    static eastl::vector<std::byte> make_dfd(
+        const uint8_t color_model, const uint8_t block_size, const uint8_t bytes_per_block, const uint8_t channel
+        ) {
+        constexpr auto dfd_size = uint32_t{44};
+        constexpr auto descriptor_block_size = uint32_t{40};
+        constexpr auto version = uint32_t{2};
+        constexpr auto primaries_bt709 = uint32_t{1};
+        constexpr auto transfer_linear = uint32_t{1};
+
+        auto dfd = eastl::vector<std::byte>{};
+        append(dfd, dfd_size);
+        append(dfd, uint32_t{0});
+        append(dfd, version | descriptor_block_size << 16);
+        append(dfd, color_model | primaries_bt709 << 8 | transfer_linear << 16);
+        append(dfd, uint32_t{block_size - 1u} | uint32_t{block_size - 1u} << 8);
+        append(dfd, uint32_t{bytes_per_block});
+        append(dfd, uint32_t{0});
+
+        const auto bit_length = bytes_per_block * 8u - 1u;
+        append(dfd, bit_length << 16 | uint32_t{channel} << 24);
+        append(dfd, uint32_t{0});
+        append(dfd, uint32_t{0});
+        append(dfd, UINT32_MAX);
+
+        return dfd;
+    }
+
+    /**
+     * Writes a 2D KTX2 file with a full mip chain. make_mip gets the mip's resolution and returns its data
+     */
+    template <typename MakeMipFunc>
+    static eastl::vector<std::byte> make_ktx2_file(
+        const VkFormat format, const uint32_t resolution, const eastl::vector<std::byte>& dfd, MakeMipFunc&& make_mip
+        ) {
+        auto num_mips = 1u;
+        while((resolution >> num_mips) > 0) {
+            num_mips++;
+        }
+
+        const auto level_index_offset = sizeof(KtxTextureHeader) + sizeof(KtxTextureIndex);
+        const auto dfd_offset = level_index_offset + num_mips * sizeof(KtxTextureLevelIndex);
+
+        const auto header = KtxTextureHeader{
+            .identifier = KTX2_IDENTIFIER,
+            .format = format,
+            .type_size = 1,
+            .pixel_width = resolution,
+            .pixel_height = resolution,
+            .pixel_depth = 0,
+            .layer_count = 0,
+            .face_count = 1,
+            .level_count = num_mips,
+            .supercompression_scheme = static_cast<uint32_t>(KtxSupercompressionScheme::None),
+        };
+        const auto index = KtxTextureIndex{
+            .dfd_byte_offset = static_cast<uint32_t>(dfd_offset),
+            .dfd_byte_length = static_cast<uint32_t>(dfd.size()),
+        };
+
+        auto file = eastl::vector<std::byte>{};
+        append(file, header);
+        append(file, index);
+        file.resize(dfd_offset);
+        file.insert(file.end(), dfd.begin(), dfd.end());
+
+        // KTX2 stores the smallest mip first
+        auto levels = eastl::vector<KtxTextureLevelIndex>(num_mips);
+        for(auto mip = num_mips; mip-- > 0;) {
+            file.resize((file.size() + 15) & ~size_t{15});
+
+            const auto mip_data = make_mip(eastl::max(resolution >> mip, 1u));
+            levels[mip] = KtxTextureLevelIndex{
+                .byte_offset = file.size(),
+                .byte_length = mip_data.size(),
+                .uncompressed_byte_length = mip_data.size(),
+            };
+            file.insert(file.end(), mip_data.begin(), mip_data.end());
+        }
+
+        std::memcpy(file.data() + level_index_offset, levels.data(), num_mips * sizeof(KtxTextureLevelIndex));
+
+        return file;
+    }
+
+    /**
+     * Makes a UASTC texture out of random blocks. We throw away the blocks that aren't valid UASTC, and the solid
+     * color blocks because they skip most of the transcoder
+     */
+    static eastl::vector<std::byte> make_uastc_file(const uint32_t resolution) {
+        basist::basisu_transcoder_init();
+
+        auto random = std::mt19937{12345};
+        auto unpacked = basist::unpacked_uastc_block{};
+
+        const auto dfd = make_dfd(KHR_DF_MODEL_UASTC, 4, 16, KHR_DF_CHANNEL_UASTC_RGBA);
+        return make_ktx2_file(
+            VK_FORMAT_UNDEFINED,
+            resolution,
+            dfd,
+            [&](const uint32_t mip_resolution) {
+                const auto num_blocks = (mip_resolution + 3) / 4 * ((mip_resolution + 3) / 4);
+                auto blocks = eastl::vector<std::byte>{};
+                blocks.reserve(num_blocks * sizeof(basist::uastc_block));
+                while(blocks.size() < num_blocks * sizeof(basist::uastc_block)) {
+                    auto block = basist::uastc_block{};
+                    for(auto& dword : block.m_dwords) {
+                        dword = random();
+                    }
+                    if(basist::unpack_uastc(block, unpacked, false) &&
+                        unpacked.m_mode != basist::UASTC_MODE_INDEX_SOLID_COLOR) {
+                        append(blocks, block);
+                    }
+                }
+                return blocks;
+            });
+    }
+
+    static eastl::vector<std::byte> make_rgba8_file(const uint32_t resolution) {
+        const auto dfd = make_dfd(KHR_DF_MODEL_RGBSDA, 1, 4, 0);
+        return make_ktx2_file(
+            VK_FORMAT_R8G8B8A8_UNORM,
+            resolution,
+            dfd,
+            [](const uint32_t mip_resolution) {
+                auto pixels = eastl::vector<std::byte>(mip_resolution * mip_resolution * 4);
+                for(auto i = 0u; i < pixels.size(); i++) {
+                    pixels[i] = static_cast<std::byte>(i * 31 + mip_resolution);
+                }
+                return pixels;
+            });
+    }
+
+    TEST_CASE("KtxTexture::parse reads KTX2 files and rejects broken ones", "[ktx]") {
+        const auto file = make_rgba8_file(64);
+
+        const auto texture = KtxTexture::parse(file);
+        REQUIRE(texture.has_value());
+        CHECK(texture->header.pixel_width == 64);
+        CHECK(texture->levels.size() == 7);
+        CHECK(texture->level_images[0].size() == 64 * 64 * 4);
+        CHECK(texture->level_images[6].size() == 4);
+        CHECK(!texture->is_basis());
+
+        auto wrong_identifier = file;
+        wrong_identifier[1] = std::byte{'J'};
+        CHECK(!KtxTexture::parse(wrong_identifier).has_value());
+
+        auto truncated = file;
+        truncated.pop_back();
+        CHECK(!KtxTexture::parse(truncated).has_value());
+
+        CHECK(!KtxTexture::parse(eastl::span<const std::byte>{file}.first(sizeof(KtxTextureHeader))).has_value());
+    }
+
+    TEST_CASE("KtxTextureSource loads textures that have a Vulkan format as-is", "[ktx]") {
+        initialize_system_interface();
+
+        const auto file = make_rgba8_file(64);
+        const auto expected = KtxTexture::parse(file);
+        REQUIRE(expected.has_value());
+
+        const auto source = KtxTextureSource{
+            "RGBA8", eastl::vector<std::byte>(file), TextureType::Color, KtxTranscodeTarget::BC7
+        };
+        CHECK(source.get_format() == VK_FORMAT_R8G8B8A8_UNORM);
+        CHECK(source.get_resolution() == glm::uvec2{64, 64});
+        REQUIRE(source.get_num_mips() == 7);
+
+        const auto mips = source.load_mips(2);
+        REQUIRE(mips.size() == 5);
+        for(auto i = 0u; i < mips.size(); i++) {
+            const auto& level = expected->level_images[i + 2];
+            REQUIRE(mips[i].size() == level.size());
+            CHECK(std::memcmp(mips[i].data(), level.data(), level.size()) == 0);
+        }
+    }
+
+    TEST_CASE("KtxTextureSource transcodes UASTC to the target format", "[ktx]") {
+        initialize_system_interface();
+
+        const auto file = make_uastc_file(64);
+
+        auto target = KtxTranscodeTarget::BC7;
+        auto format = VK_FORMAT_UNDEFINED;
+        auto top_mip_size = uint64_t{0};
+        auto bottom_mip_size = uint64_t{0};
+        SECTION("BC7") {
+            format = VK_FORMAT_BC7_SRGB_BLOCK;
+            top_mip_size = 16 * 16 * 16;
+            bottom_mip_size = 16;
+        }
+        SECTION("ASTC") {
+            target = KtxTranscodeTarget::ASTC_4x4;
+            format = VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+            top_mip_size = 16 * 16 * 16;
+            bottom_mip_size = 16;
+        }
+        SECTION("RGBA8") {
+            target = KtxTranscodeTarget::RGBA8;
+            format = VK_FORMAT_R8G8B8A8_SRGB;
+            top_mip_size = 64 * 64 * 4;
+            bottom_mip_size = 4;
+        }
+
+        const auto source = KtxTextureSource{"UASTC", eastl::vector<std::byte>(file), TextureType::Color, target};
+        CHECK(source.get_format() == format);
+        REQUIRE(source.get_num_mips() == 7);
+        CHECK(source.get_mip_size(0) == top_mip_size);
+        CHECK(source.get_mip_size(6) == bottom_mip_size);
+
+        const auto mips = source.load_mips(0);
+        REQUIRE(mips.size() == 7);
+        for(auto mip = 0u; mip < mips.size(); mip++) {
+            CHECK(mips[mip].size() == source.get_mip_size(mip));
+        }
+    }
+
+    TEST_CASE("KTX2 transcoding", "[.benchmark]") {
+        initialize_system_interface();
+
+        // What the texture streamer does when it loads a whole texture
+        const auto file = make_uastc_file(1024);
+        for(const auto& [target, target_name] : {
+                eastl::pair{KtxTranscodeTarget::BC7, "BC7"},
+                eastl::pair{KtxTranscodeTarget::ASTC_4x4, "ASTC 4x4"},
+                eastl::pair{KtxTranscodeTarget::ETC2, "ETC2"},
+                eastl::pair{KtxTranscodeTarget::RGBA8, "RGBA8"},
+            }) {
+            const auto source = KtxTextureSource{"UASTC", eastl::vector<std::byte>(file), TextureType::Color, target};
+            BENCHMARK(fmt::format("1024x1024 UASTC to {}", target_name)) {
+                return source.load_mips(0);
+            };
+        }
+
+        const auto uncompressed = KtxTextureSource{
+            "RGBA8", make_rgba8_file(1024), TextureType::Color, KtxTranscodeTarget::BC7
+        };
+        BENCHMARK("1024x1024 RGBA8, no transcoding") {
+            return uncompressed.load_mips(0);
+        };
+    }
+}
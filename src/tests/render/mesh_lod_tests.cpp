@@ -0,0 +1,63 @@
+#include <EASTL/array.h>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/mesh_lod.hpp"
+
+namespace render {
+    /**
+     * Four LODs, each with twice the error of the last
+     */
+    static const auto test_lods = eastl::array{
+        MeshLod{.first_index = 0, .num_indices = 3000, .error = 0},
+        MeshLod{.first_index = 3000, .num_indices = 1500, .error = 0.01f},
+        MeshLod{.first_index = 4500, .num_indices = 750, .error = 0.02f},
+        MeshLod{.first_index = 5250, .num_indices = 375, .error = 0.04f},
+    };
+
+    TEST_CASE("get_lod_pixels_per_unit matches the projection", "[mesh_lod]") {
+        // A 90 degree FOV sees one unit on either side of the view direction at a distance of one unit
+        CHECK(get_lod_pixels_per_unit(90, 1080) == Catch::Approx(540));
+        CHECK(get_lod_pixels_per_unit(90, 2160) == Catch::Approx(1080));
+        CHECK(get_lod_pixels_per_unit(60, 1080) > get_lod_pixels_per_unit(90, 1080));
+    }
+
+    TEST_CASE("select_mesh_lod picks the coarsest LOD that's within the error", "[mesh_lod]") {
+        // At a distance of 100 units, 0.01 units of error covers one pixel
+        constexpr auto pixels_per_unit = 10000.f;
+
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 1) == 1);
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 2) == 2);
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 3.9f) == 2);
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 4) == 3);
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 0.5f) == 0);
+        CHECK(select_mesh_lod(test_lods, 1, 100, pixels_per_unit, 0) == 0);
+    }
+
+    TEST_CASE("select_mesh_lod gets coarser with distance and finer with scale", "[mesh_lod]") {
+        constexpr auto pixels_per_unit = 10000.f;
+
+        CHECK(select_mesh_lod(test_lods, 1, 50, pixels_per_unit, 1) == 0);
+        CHECK(select_mesh_lod(test_lods, 1, 200, pixels_per_unit, 1) == 2);
+        CHECK(select_mesh_lod(test_lods, 1, 10000, pixels_per_unit, 1) == 3);
+
+        CHECK(select_mesh_lod(test_lods, 2, 200, pixels_per_unit, 1) == 1);
+        CHECK(select_mesh_lod(test_lods, 0.5f, 100, pixels_per_unit, 1) == 2);
+
+        auto last_lod = 0u;
+        for(auto distance = 1.f; distance < 1000; distance *= 1.5f) {
+            const auto lod = select_mesh_lod(test_lods, 1, distance, pixels_per_unit, 1);
+            CHECK(lod >= last_lod);
+            last_lod = lod;
+        }
+    }
+
+    TEST_CASE("select_mesh_lod handles cameras inside the bounds and meshes without LODs", "[mesh_lod]") {
+        CHECK(select_mesh_lod(test_lods, 1, 0, 540, 1) == 0);
+        CHECK(select_mesh_lod(test_lods, 1, -5, 540, 1) == 0);
+
+        CHECK(select_mesh_lod(eastl::span<const MeshLod>{test_lods}.first(1), 1, 10000, 540, 1) == 0);
+        CHECK(select_mesh_lod({}, 1, 10000, 540, 1) == 0);
+    }
+}
@@ -0,0 +1,148 @@
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/meshlet_culling.hpp"
+#include "resources/cooked_mesh_file.hpp"
+#include "resources/mesh_optimization.hpp"
+
+namespace render {
+    /**
+     * A camera at the origin that looks down -Z, with a 90 degree field of view in both directions
+     */
+    static ViewDataGPU make_view() {
+        constexpr auto plane = 0.70710678f;
+        return ViewDataGPU{
+            .view = float4x4{1.f},
+            .inverse_view = float4x4{1.f},
+            .frustum = float4{plane, -plane, plane, -plane},
+            .z_near = 0.1f,
+        };
+    }
+
+    static MeshletGPU make_meshlet(const float3& center, const float radius, const float4& cone = {0, 0, 1, 1}) {
+        return MeshletGPU{.bounding_sphere = float4{center, radius}, .cone_axis_and_cutoff = cone};
+    }
+
+    /**
+     * A flat grid of quads over [-1, 1] on X and Y, facing +Z
+     */
+    static MeshPrimitiveData make_grid(const uint32_t num_quads) {
+        auto primitive = MeshPrimitiveData{};
+        const auto num_vertices_per_side = num_quads + 1;
+        for(auto y = 0u; y < num_vertices_per_side; y++) {
+            for(auto x = 0u; x < num_vertices_per_side; x++) {
+                const auto uv = float2{x, y} / static_cast<float>(num_quads);
+                primitive.positions.emplace_back(uv * 2.f - 1.f, 0.f);
+                primitive.vertex_data.push_back(
+                    {.normal = {0, 0, 1}, .tangent = {1, 0, 0, 1}, .texcoord = uv, .color = 0xFFFFFFFF});
+            }
+        }
+
+        for(auto y = 0u; y < num_quads; y++) {
+            for(auto x = 0u; x < num_quads; x++) {
+                const auto corner = y * num_vertices_per_side + x;
+                primitive.indices.insert(
+                    primitive.indices.end(),
+                    {
+                        corner, corner + 1, corner + num_vertices_per_side + 1,
+                        corner, corner + num_vertices_per_side + 1, corner + num_vertices_per_side
+                    });
+            }
+        }
+
+        return primitive;
+    }
+
+    TEST_CASE("Meshlets outside the frustum are culled", "[meshlet_culling]") {
+        const auto view = make_view();
+        const auto model = float4x4{1.f};
+
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, -10}, 1), model, view));
+        CHECK(!is_meshlet_visible(make_meshlet({0, 0, 10}, 1), model, view));
+        CHECK(!is_meshlet_visible(make_meshlet({-30, 0, -10}, 1), model, view));
+        CHECK(!is_meshlet_visible(make_meshlet({0, 30, -10}, 1), model, view));
+
+        // Straddles the right plane, which is at x = 10 at this distance
+        CHECK(is_meshlet_visible(make_meshlet({10.5f, 0, -10}, 1), model, view));
+
+        // In front of the near plane
+        CHECK(!is_meshlet_visible(make_meshlet({0, 0, -0.05f}, 0.01f), model, view));
+
+        // The model matrix moves the meshlet, and scales its center and radius
+        const auto moved = glm::translate(float4x4{1.f}, float3{0, 0, -20});
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, 10}, 1), moved, view));
+        const auto scaled = glm::scale(float4x4{1.f}, float3{10});
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, -0.05f}, 0.01f), scaled, view));
+    }
+
+    TEST_CASE("Meshlets that face away from the camera are culled", "[meshlet_culling]") {
+        const auto view = make_view();
+        const auto model = float4x4{1.f};
+
+        // The cone's axis is the average normal of the meshlet's triangles
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, -10}, 1, {0, 0, 1, 0.5f}), model, view));
+        CHECK(!is_meshlet_visible(make_meshlet({0, 0, -10}, 1, {0, 0, -1, 0.5f}), model, view));
+
+        // Seen edge-on, some of the normals face the camera
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, -10}, 1, {1, 0, 0, 0.5f}), model, view));
+
+        // A cutoff of 1 never culls
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, -10}, 1, {0, 0, -1, 1}), model, view));
+
+        // Turning the mesh around turns the cone around
+        const auto turned = glm::rotate(float4x4{1.f}, glm::radians(180.f), float3{0, 1, 0});
+        CHECK(is_meshlet_visible(make_meshlet({0, 0, 10}, 1, {0, 0, -1, 0.5f}), turned, view));
+        CHECK(!is_meshlet_visible(make_meshlet({0, 0, 10}, 1, {0, 0, 1, 0.5f}), turned, view));
+    }
+
+    TEST_CASE("Cooked meshlets cover LOD 0's indices in order", "[meshlet_culling]") {
+        auto grid = make_grid(32);
+        optimize_mesh(grid);
+        REQUIRE(!grid.meshlets.empty());
+        REQUIRE(!grid.lods.empty());
+
+        auto next_index = 0u;
+        for(const auto& meshlet : grid.meshlets) {
+            CHECK(meshlet.first_index == next_index);
+            CHECK(meshlet.num_triangles > 0);
+            CHECK(meshlet.num_triangles <= MESHLET_MAX_TRIANGLES);
+
+            const auto first = grid.indices.begin() + meshlet.first_index;
+            auto vertices = eastl::vector<uint32_t>(first, first + meshlet.num_triangles * 3);
+            eastl::sort(vertices.begin(), vertices.end());
+            vertices.erase(eastl::unique(vertices.begin(), vertices.end()), vertices.end());
+            CHECK(vertices.size() <= MESHLET_MAX_VERTICES);
+
+            const auto center = float3{meshlet.bounding_sphere};
+            for(const auto vertex : vertices) {
+                CHECK(glm::distance(grid.positions[vertex], center) <= meshlet.bounding_sphere.w * 1.001f);
+            }
+
+            next_index += meshlet.num_triangles * 3;
+        }
+        CHECK(next_index == grid.lods[0].num_indices);
+    }
+
+    TEST_CASE("cull_meshlets keeps the meshlets that face the camera", "[meshlet_culling]") {
+        auto grid = make_grid(32);
+        optimize_mesh(grid);
+
+        const auto view = make_view();
+        auto visible_meshlets = eastl::vector<uint32_t>{};
+
+        const auto facing = glm::translate(float4x4{1.f}, float3{0, 0, -5});
+        cull_meshlets(grid.meshlets, facing, view, visible_meshlets);
+        CHECK(visible_meshlets.size() == grid.meshlets.size());
+
+        const auto facing_away = glm::rotate(facing, glm::radians(180.f), float3{0, 1, 0});
+        cull_meshlets(grid.meshlets, facing_away, view, visible_meshlets);
+        CHECK(visible_meshlets.empty());
+
+        const auto off_screen = glm::translate(float4x4{1.f}, float3{50, 0, -5});
+        cull_meshlets(grid.meshlets, off_screen, view, visible_meshlets);
+        CHECK(visible_meshlets.empty());
+    }
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/texture_residency_manager.hpp"
+
+namespace render {
+    /**
+     * Mip sizes of a square RGBA8 texture, finest first
+     */
+    static eastl::vector<uint64_t> make_mip_sizes(const uint32_t resolution) {
+        auto mip_sizes = eastl::vector<uint64_t>{};
+        for(auto mip_resolution = resolution; mip_resolution > 0; mip_resolution /= 2) {
+            mip_sizes.push_back(uint64_t{mip_resolution} * mip_resolution * 4);
+        }
+        return mip_sizes;
+    }
+
+    static uint64_t get_size_from_mip(const eastl::vector<uint64_t>& mip_sizes, const uint32_t first_mip) {
+        auto size = uint64_t{0};
+        for(auto mip = first_mip; mip < mip_sizes.size(); mip++) {
+            size += mip_sizes[mip];
+        }
+        return size;
+    }
+
+    /**
+     * Pretends that the streamer finished every change right away
+     */
+    static void finish_changes(TextureResidencyManager& manager, const eastl::vector<ResidencyChange>& changes) {
+        for(const auto& change : changes) {
+            manager.on_change_finished(change.texture, change.first_mip);
+        }
+    }
+
+    TEST_CASE("get_mip_for_screen_size keeps at least one texel per pixel", "[texture_residency]") {
+        CHECK(get_mip_for_screen_size(1024, 1024.f) == 0);
+        CHECK(get_mip_for_screen_size(1024, 4096.f) == 0);
+        CHECK(get_mip_for_screen_size(1024, 512.f) == 1);
+        CHECK(get_mip_for_screen_size(1024, 256.f) == 2);
+
+        // Between two mips, we round towards the finer one
+        CHECK(get_mip_for_screen_size(1024, 600.f) == 0);
+        CHECK(get_mip_for_screen_size(1024, 300.f) == 1);
+
+        // Tiny or off-screen objects get the last mip, and the residency manager clamps that to the tail
+        CHECK(get_mip_for_screen_size(1024, 1.f) == 10);
+        CHECK(get_mip_for_screen_size(1024, 0.f) == 10);
+    }
+
+    TEST_CASE("TextureResidencyManager loads tails first and the biggest loads next", "[texture_residency]") {
+        const auto big_mips = make_mip_sizes(256);
+        const auto small_mips = make_mip_sizes(128);
+
+        auto manager = TextureResidencyManager{0};
+        const auto big = manager.add_texture(big_mips, 4);
+        const auto small = manager.add_texture(small_mips, 3);
+
+        // Tails load even when they don't fit, or there'd be nothing to draw
+        const auto tails = manager.update(16);
+        REQUIRE(tails.size() == 2);
+        CHECK(tails[0].texture == big);
+        CHECK(tails[0].first_mip == 4);
+        CHECK(tails[1].texture == small);
+        CHECK(tails[1].first_mip == 3);
+
+        // Nothing else happens until the changes finish
+        CHECK(manager.is_change_pending(big));
+        CHECK(manager.update(16).empty());
+        finish_changes(manager, tails);
+        CHECK(manager.get_resident_bytes() == get_size_from_mip(big_mips, 4) + get_size_from_mip(small_mips, 3));
+
+        manager.set_budget(get_size_from_mip(big_mips, 0) + get_size_from_mip(small_mips, 0));
+        manager.request_mip(small, 0);
+        manager.request_mip(big, 0);
+        const auto loads = manager.update(16);
+        REQUIRE(loads.size() == 2);
+        CHECK(loads[0].texture == big);
+        CHECK(loads[1].texture == small);
+        finish_changes(manager, loads);
+        CHECK(manager.get_first_resident_mip(big) == 0);
+        CHECK(manager.get_first_resident_mip(small) == 0);
+
+        // max_changes holds the rest back for a later update
+        manager.remove_texture(small);
+        const auto other = manager.add_texture(small_mips, 3);
+        CHECK(manager.update(0).empty());
+        CHECK(manager.update(1).size() == 1);
+        CHECK(manager.get_resident_bytes() == get_size_from_mip(big_mips, 0));
+        CHECK(manager.is_change_pending(other));
+    }
+
+    TEST_CASE("TextureResidencyManager evicts the biggest mips when over budget", "[texture_residency]") {
+        const auto big_mips = make_mip_sizes(256);
+        const auto small_mips = make_mip_sizes(128);
+
+        auto manager = TextureResidencyManager{UINT64_MAX};
+        const auto big = manager.add_texture(big_mips, 4);
+        const auto small = manager.add_texture(small_mips, 3);
+        finish_changes(manager, manager.update(16));
+
+        const auto update = [&] {
+            manager.request_mip(big, 0);
+            manager.request_mip(small, 0);
+            return manager.update(16);
+        };
+        finish_changes(manager, update());
+        REQUIRE(manager.get_resident_bytes() == get_size_from_mip(big_mips, 0) + get_size_from_mip(small_mips, 0));
+
+        // Dropping the big texture's mip 0 frees the most memory, and that's enough
+        manager.set_budget(get_size_from_mip(big_mips, 1) + get_size_from_mip(small_mips, 0));
+        const auto first_eviction = update();
+        REQUIRE(first_eviction.size() == 1);
+        CHECK(first_eviction[0].texture == big);
+        CHECK(first_eviction[0].first_mip == 1);
+        CHECK(manager.get_target_mip(small) == 0);
+        finish_changes(manager, first_eviction);
+        CHECK(manager.get_resident_bytes() == manager.get_budget());
+
+        // Now both textures have a 64 KB mip on top, so going one byte under the budget evicts one of them
+        manager.set_budget(get_size_from_mip(big_mips, 1) + get_size_from_mip(small_mips, 0) - 1);
+        finish_changes(manager, update());
+        CHECK(manager.get_resident_bytes() <= manager.get_budget());
+        CHECK(manager.get_first_resident_mip(big) + manager.get_first_resident_mip(small) == 2);
+
+        manager.set_budget(get_size_from_mip(big_mips, 2) + get_size_from_mip(small_mips, 1) - 1);
+        finish_changes(manager, update());
+        CHECK(manager.get_first_resident_mip(big) == 2);
+        CHECK(manager.get_first_resident_mip(small) == 2);
+
+        // Tails are never evicted, even when the budget is too small for them
+        manager.set_budget(0);
+        finish_changes(manager, update());
+        CHECK(manager.get_first_resident_mip(big) == 4);
+        CHECK(manager.get_first_resident_mip(small) == 3);
+        CHECK(manager.get_resident_bytes() == get_size_from_mip(big_mips, 4) + get_size_from_mip(small_mips, 3));
+
+        // Evictions come before loads, so the loads can use the memory they free
+        manager.set_budget(get_size_from_mip(big_mips, 0) + get_size_from_mip(small_mips, 3));
+        manager.request_mip(big, 0);
+        manager.request_mip(small, 3);
+        finish_changes(manager, manager.update(16));
+        REQUIRE(manager.get_resident_bytes() == manager.get_budget());
+
+        manager.request_mip(big, 3);
+        manager.request_mip(small, 0);
+        const auto swap = manager.update(16);
+        REQUIRE(swap.size() == 2);
+        CHECK(swap[0].texture == big);
+        CHECK(swap[0].first_mip == 3);
+        CHECK(swap[1].texture == small);
+        CHECK(swap[1].first_mip == 0);
+    }
+
+    TEST_CASE("TextureResidencyManager keeps wanted mips for a grace period", "[texture_residency]") {
+        const auto mips = make_mip_sizes(256);
+
+        auto manager = TextureResidencyManager{UINT64_MAX};
+        const auto texture = manager.add_texture(mips, 4);
+        finish_changes(manager, manager.update(16));
+
+        manager.request_mip(texture, 0);
+        finish_changes(manager, manager.update(16));
+        REQUIRE(manager.get_first_resident_mip(texture) == 0);
+
+        // A texture that goes off-screen for a moment keeps its mips
+        for(auto i = 1u; i < TextureResidencyManager::WANTED_MIP_GRACE_UPDATES; i++) {
+            REQUIRE(manager.update(16).empty());
+        }
+        CHECK(manager.get_target_mip(texture) == 0);
+
+        // Looking at it again starts the grace period over
+        manager.request_mip(texture, 0);
+        for(auto i = 0u; i < TextureResidencyManager::WANTED_MIP_GRACE_UPDATES; i++) {
+            REQUIRE(manager.update(16).empty());
+        }
+
+        // Once the grace period is over, the texture falls back to its tail
+        const auto eviction = manager.update(16);
+        REQUIRE(eviction.size() == 1);
+        CHECK(eviction[0].first_mip == 4);
+        finish_changes(manager, eviction);
+        CHECK(manager.get_resident_bytes() == get_size_from_mip(mips, 4));
+    }
+
+    TEST_CASE("TextureResidencyManager uses the finest mip requested since the last update", "[texture_residency]") {
+        const auto mips = make_mip_sizes(256);
+
+        auto manager = TextureResidencyManager{UINT64_MAX};
+        const auto texture = manager.add_texture(mips, 4);
+        finish_changes(manager, manager.update(16));
+
+        // Several objects use the texture, the closest one wins. Mips past the tail are clamped to it
+        manager.request_mip(texture, 3);
+        manager.request_mip(texture, 1);
+        manager.request_mip(texture, 8);
+        finish_changes(manager, manager.update(16));
+        CHECK(manager.get_first_resident_mip(texture) == 1);
+
+        // A coarser request in a later update replaces the old one right away
+        manager.request_mip(texture, 2);
+        finish_changes(manager, manager.update(16));
+        CHECK(manager.get_first_resident_mip(texture) == 2);
+
+        manager.request_mip(texture, 8);
+        finish_changes(manager, manager.update(16));
+        CHECK(manager.get_first_resident_mip(texture) == 4);
+    }
+}
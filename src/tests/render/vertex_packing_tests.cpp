@@ -0,0 +1,143 @@
+#include <cstring>
+#include <random>
+
+#include <glm/geometric.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "render/vertex_packing.hpp"
+
+namespace render {
+    /**
+     * Random unit normals and tangents, with both tangent signs and texcoords that tile a few times. The first
+     * vertices point down the axes and diagonals, since those are where the octahedral encoding folds
+     */
+    static eastl::vector<StandardVertexData> make_vertices(const uint32_t count) {
+        auto vertices = eastl::vector<StandardVertexData>{};
+        vertices.reserve(count);
+
+        const auto edge_cases = {
+            float3{1, 0, 0}, float3{-1, 0, 0}, float3{0, 1, 0}, float3{0, -1, 0}, float3{0, 0, 1}, float3{0, 0, -1},
+            float3{1, 1, 1}, float3{-1, 1, -1}, float3{1, -1, -1}, float3{-1, -1, -1}, float3{0, 0, 0},
+        };
+        for(const auto& direction : edge_cases) {
+            const auto normal = glm::length(direction) > 0.f ? glm::normalize(direction) : direction;
+            vertices.push_back({.normal = normal, .tangent = {normal.z, normal.x, normal.y, -1}, .color = 0xFF00FF00});
+        }
+
+        auto random = std::mt19937{12345};
+        auto unit = std::uniform_real_distribution<float>{-1.f, 1.f};
+        auto texcoord = std::uniform_real_distribution<float>{-4.f, 4.f};
+        const auto random_direction = [&] {
+            auto direction = float3{unit(random), unit(random), unit(random)};
+            while(glm::length(direction) < 0.01f) {
+                direction = float3{unit(random), unit(random), unit(random)};
+            }
+            return glm::normalize(direction);
+        };
+        while(vertices.size() < count) {
+            const auto normal = random_direction();
+            const auto tangent = glm::normalize(glm::cross(normal, random_direction()));
+            vertices.push_back(
+                {
+                    .normal = normal,
+                    .tangent = float4{tangent, random() % 2 == 0 ? 1.f : -1.f},
+                    .texcoord = float2{texcoord(random), texcoord(random)},
+                    .color = static_cast<uint32_t>(random()),
+                });
+        }
+
+        return vertices;
+    }
+
+    /**
+     * Normals whose octahedral coordinates land on or near halfway between two snorm16 values
+     */
+    static eastl::vector<StandardVertexData> make_rounding_ties(const uint32_t count) {
+        auto vertices = eastl::vector<StandardVertexData>{};
+        vertices.reserve(count);
+        for(auto i = 0u; i < count; i++) {
+            const auto x = static_cast<float>(i) + 0.5f;
+            const auto normal = float3{x, -x, 32767.f - 2.f * x};
+            vertices.push_back({.normal = normal, .tangent = float4{normal, 1}});
+        }
+        return vertices;
+    }
+
+    TEST_CASE("Packed vertices round trip within the error bounds", "[vertex_packing]") {
+        const auto vertices = make_vertices(10000);
+        auto packed = eastl::vector<PackedVertexData>(vertices.size());
+        pack_vertex_data(vertices, packed);
+
+        // 16 bits per octahedral coordinate is a few thousandths of a degree. The tangent gives up a bit of u for
+        // the sign. Halves have 11 bits of mantissa, so texcoords below 4 are within 2^-10
+        const auto error = measure_vertex_packing_error(vertices, packed);
+        CHECK(error.max_normal_error_degrees < 0.02f);
+        CHECK(error.max_tangent_error_degrees < 0.04f);
+        CHECK(error.max_texcoord_error <= 1.f / 1024.f);
+        CHECK(error.num_tangent_sign_errors == 0);
+
+        auto unpacked = eastl::vector<StandardVertexData>(vertices.size());
+        unpack_vertex_data(packed, unpacked);
+        auto num_wrong_colors = 0u;
+        auto num_wrong_signs = 0u;
+        for(auto i = 0u; i < vertices.size(); i++) {
+            num_wrong_colors += unpacked[i].color != vertices[i].color ? 1 : 0;
+            num_wrong_signs += unpacked[i].tangent.w != (vertices[i].tangent.w < 0.f ? -1.f : 1.f) ? 1 : 0;
+        }
+        CHECK(num_wrong_colors == 0);
+        CHECK(num_wrong_signs == 0);
+
+        // Degenerate normals decode to +Z
+        CHECK(unpacked[10].normal == float3{0, 0, 1});
+    }
+
+    TEST_CASE("Vertices pack to the same bits in a batch and on their own", "[vertex_packing]") {
+        // On x64, batches go through SSE2 four vertices at a time. A single vertex always takes the scalar path
+        auto vertices = make_vertices(1001);
+        const auto ties = make_rounding_ties(1000);
+        vertices.insert(vertices.end(), ties.begin(), ties.end());
+
+        auto batched = eastl::vector<PackedVertexData>(vertices.size());
+        pack_vertex_data(vertices, batched);
+
+        auto num_mismatches = 0u;
+        for(auto i = 0u; i < vertices.size(); i++) {
+            auto alone = PackedVertexData{};
+            pack_vertex_data({&vertices[i], 1}, {&alone, 1});
+            if(std::memcmp(&alone, &batched[i], sizeof(PackedVertexData)) != 0) {
+                num_mismatches++;
+            }
+        }
+        CHECK(num_mismatches == 0);
+    }
+
+    TEST_CASE("Vertex packing", "[.benchmark]") {
+        const auto vertices = make_vertices(100000);
+        auto packed = eastl::vector<PackedVertexData>(vertices.size());
+        auto unpacked = eastl::vector<StandardVertexData>(vertices.size());
+
+        BENCHMARK("Pack 100k vertices") {
+            pack_vertex_data(vertices, packed);
+            return packed[0].normal;
+        };
+
+        BENCHMARK("Pack 100k vertices one at a time") {
+            for(auto i = 0u; i < vertices.size(); i++) {
+                pack_vertex_data({&vertices[i], 1}, {&packed[i], 1});
+            }
+            return packed[0].normal;
+        };
+
+        pack_vertex_data(vertices, packed);
+
+        BENCHMARK("Unpack 100k vertices") {
+            unpack_vertex_data(packed, unpacked);
+            return unpacked[0].normal.x;
+        };
+
+        BENCHMARK("Measure the error of 100k vertices") {
+            return measure_vertex_packing_error(vertices, packed).max_normal_error_degrees;
+        };
+    }
+}
@@ -0,0 +1,676 @@
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <EASTL/algorithm.h>
+#include <glm/gtc/quaternion.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "console/cvars.hpp"
+#include "core/test_system_interface.hpp"
+#include "core/thread_pool.hpp"
+#include "scene/entity_info_component.hpp"
+#include "scene/world.hpp"
+
+static entt::entity create_transform_entity(World& world, const entt::entity parent, const float3 location) {
+    auto& registry = world.get_registry();
+    const auto entity = registry.create();
+    registry.emplace<TransformComponent>(entity, TransformComponent{.location = location});
+    if(parent != entt::null) {
+        world.parent_entity_to_entity(entity, parent);
+    }
+
+    return entity;
+}
+
+/**
+ * Creates num_chains chains of chain_length entities, each one unit above its parent. Returns every entity, one chain
+ * after another, roots first
+ */
+static eastl::vector<entt::entity> create_chains(World& world, const uint32_t num_chains, const uint32_t chain_length) {
+    auto entities = eastl::vector<entt::entity>{};
+    entities.reserve(num_chains * chain_length);
+    for(auto chain = 0u; chain < num_chains; chain++) {
+        auto parent = entt::entity{entt::null};
+        for(auto link = 0u; link < chain_length; link++) {
+            const auto location = link == 0 ? float3{static_cast<float>(chain), 0, 0} : float3{0, 1, 0};
+            parent = create_transform_entity(world, parent, location);
+            entities.emplace_back(parent);
+        }
+    }
+
+    return entities;
+}
+
+static void move_entity(entt::registry& registry, const entt::entity entity, const float3 offset) {
+    registry.patch<TransformComponent>(
+        entity,
+        [&](TransformComponent& transform) {
+            transform.location += offset;
+        });
+}
+
+/**
+ * Marks the entities that find_component_in_children looks for
+ */
+struct SearchTarget {
+    uint32_t value = 0;
+};
+
+/**
+ * find_component_in_children before it checked how big the tree was. Checks the entity's children, then recurses into
+ * each child in turn, so it may return a deeper child than the closest one
+ */
+template<typename ComponentType>
+static entt::handle find_component_recursively(const entt::handle entity) {
+    if(const auto* trans = entity.try_get<TransformComponent>(); trans != nullptr) {
+        for(const auto child : trans->children) {
+            auto child_handle = entt::handle{*entity.registry(), child};
+            if(child_handle.try_get<ComponentType>() != nullptr) {
+                return child_handle;
+            }
+        }
+
+        for(const auto child : trans->children) {
+            auto child_handle = entt::handle{*entity.registry(), child};
+            const auto found_child = find_component_recursively<ComponentType>(child_handle);
+            if(found_child.valid()) {
+                return found_child;
+            }
+        }
+    }
+
+    return {};
+}
+
+/**
+ * Creates an entity with a transform and a name. Entities without a parent are top-level
+ */
+static entt::entity create_named_entity(World& world, const entt::entity parent, const eastl::string_view name) {
+    const auto entity = create_transform_entity(world, parent, {});
+    world.get_registry().emplace<EntityInfoComponent>(
+        entity,
+        EntityInfoComponent{.name = eastl::string{name.data(), name.size()}});
+    if(parent == entt::null) {
+        world.add_top_level_entities(eastl::array{world.make_handle(entity)});
+    }
+
+    return entity;
+}
+
+/**
+ * find_child before the name index. Checks the entity's children, then recurses into each child in turn
+ */
+static entt::handle find_child_recursively(const entt::handle entity, const eastl::string_view child_name) {
+    if(const auto* transform = entity.try_get<TransformComponent>()) {
+        for(const auto& child : transform->children) {
+            if(const auto* info = entity.registry()->try_get<EntityInfoComponent>(child)) {
+                if(info->name == child_name) {
+                    return entt::handle{*entity.registry(), child};
+                }
+            }
+        }
+
+        for(const auto& child : transform->children) {
+            if(const auto child_maybe = find_child_recursively(entt::handle{*entity.registry(), child}, child_name)) {
+                return child_maybe;
+            }
+        }
+    }
+
+    return {};
+}
+
+/**
+ * find_entity before the name index. Checks the top-level entities, then searches below each of them
+ */
+static entt::handle find_entity_recursively(World& world, const eastl::string_view name) {
+    auto& registry = world.get_registry();
+    for(const auto entity : world.get_top_level_entities()) {
+        if(const auto* info = registry.try_get<EntityInfoComponent>(entity); info && info->name == name) {
+            return entt::handle{registry, entity};
+        }
+    }
+
+    for(const auto entity : world.get_top_level_entities()) {
+        if(const auto result = find_child_recursively(entt::handle{registry, entity}, name)) {
+            return result;
+        }
+    }
+
+    return {};
+}
+
+/**
+ * Changes the transform the way PhysicsWorld::tick does when it copies a body's position back
+ */
+static void move_entity_from_physics(entt::registry& registry, const entt::entity entity, const float3 offset) {
+    move_entity(registry, entity, offset);
+    registry.get<TransformComponent>(entity).is_moved_by_physics = true;
+}
+
+/**
+ * Creates a forest of entities with made-up transforms. Each entity's parent is a random earlier entity, or nothing.
+ * The same seed gives the same forest in any world. Returns the roots
+ */
+static eastl::vector<entt::entity> create_random_forest(World& world, const uint32_t count, uint32_t seed) {
+    const auto next = [&](const uint32_t max) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % max;
+    };
+    const auto next_float = [&] {
+        return static_cast<float>(next(2001)) / 1000.f - 1.f;
+    };
+
+    auto entities = eastl::vector<entt::entity>{};
+    auto roots = eastl::vector<entt::entity>{};
+    entities.reserve(count);
+    for(auto i = 0u; i < count; i++) {
+        const auto is_root = entities.empty() || next(64) == 0;
+        const auto parent = is_root ? entt::entity{entt::null} : entities[next(static_cast<uint32_t>(entities.size()))];
+        const auto entity = create_transform_entity(world, parent, float3{next_float(), next_float(), next_float()});
+
+        auto& transform = world.get_registry().get<TransformComponent>(entity);
+        transform.rotation = glm::angleAxis(next_float() * 3.f, glm::normalize(float3{next_float(), 1, next_float()}));
+        transform.scale = float3{1.f + next_float() * 0.5f};
+
+        entities.emplace_back(entity);
+        if(is_root) {
+            roots.emplace_back(entity);
+        }
+    }
+
+    return roots;
+}
+
+/**
+ * Sets how many entities World::tick updates in each thread pool task, and puts the old value back when it goes away
+ */
+class ScopedTransformChunkSize {
+public:
+    explicit ScopedTransformChunkSize(const int32_t chunk_size) :
+        old_chunk_size{*CVarSystem::Get()->GetIntCVar("s.Transforms.ChunkSize")} {
+        CVarSystem::Get()->SetIntCVar("s.Transforms.ChunkSize", chunk_size);
+    }
+
+    ~ScopedTransformChunkSize() {
+        CVarSystem::Get()->SetIntCVar("s.Transforms.ChunkSize", old_chunk_size);
+    }
+
+private:
+    int32_t old_chunk_size;
+};
+
+TEST_CASE("World::tick updates each changed entity once, parents first", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto chain = create_chains(world, 1, 3);
+    world.tick(0);
+
+    move_entity(registry, chain[2], {0, 0, 1});
+    move_entity(registry, chain[0], {1, 0, 0});
+    move_entity(registry, chain[1], {0, 0, 1});
+    world.tick(0);
+
+    const auto changed = world.get_changed_transforms();
+    REQUIRE(changed.size() == 3);
+    CHECK(changed[0] == chain[0]);
+    CHECK(changed[1] == chain[1]);
+    CHECK(changed[2] == chain[2]);
+
+    const auto leaf_to_world = world.get_changed_local_to_world()[2];
+    CHECK(float3{leaf_to_world[3]} == float3{1, 2, 2});
+    CHECK(registry.get<TransformComponent>(chain[2]).get_local_to_world() == leaf_to_world);
+
+    world.tick(0);
+    CHECK(world.get_changed_transforms().empty());
+}
+
+TEST_CASE("World::tick keeps the physics tag only on entities that physics alone moved", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto chain = create_chains(world, 1, 3);
+    world.tick(0);
+
+    SECTION("Moved by physics") {
+        move_entity_from_physics(registry, chain[1], {1, 0, 0});
+        world.tick(0);
+        CHECK(registry.get<TransformComponent>(chain[1]).is_moved_by_physics);
+        CHECK_FALSE(registry.get<TransformComponent>(chain[2]).is_moved_by_physics);
+    }
+
+    SECTION("Moved again after physics") {
+        move_entity_from_physics(registry, chain[1], {1, 0, 0});
+        move_entity(registry, chain[1], {1, 0, 0});
+        world.tick(0);
+        CHECK_FALSE(registry.get<TransformComponent>(chain[1]).is_moved_by_physics);
+    }
+
+    SECTION("Parent moved too") {
+        move_entity_from_physics(registry, chain[2], {1, 0, 0});
+        move_entity(registry, chain[0], {1, 0, 0});
+        world.tick(0);
+        CHECK_FALSE(registry.get<TransformComponent>(chain[2]).is_moved_by_physics);
+    }
+}
+
+TEST_CASE("World::tick with 100k entities in deep hierarchies", "[.benchmark]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    constexpr auto num_chains = 1000u;
+    constexpr auto chain_length = 100u;
+    const auto entities = create_chains(world, num_chains, chain_length);
+    world.tick(0);
+
+    BENCHMARK("Nothing moved") {
+        world.tick(0);
+        return world.get_changed_transforms().size();
+    };
+
+    BENCHMARK("Every root moved") {
+        for(auto chain = 0u; chain < num_chains; chain++) {
+            move_entity(registry, entities[chain * chain_length], {0, 0, 1});
+        }
+        world.tick(0);
+        return world.get_changed_transforms().size();
+    };
+
+    BENCHMARK("Every chain moved halfway down") {
+        for(auto chain = 0u; chain < num_chains; chain++) {
+            move_entity(registry, entities[chain * chain_length + chain_length / 2], {0, 0, 1});
+        }
+        world.tick(0);
+        return world.get_changed_transforms().size();
+    };
+
+    BENCHMARK("Every leaf moved by physics") {
+        for(auto chain = 0u; chain < num_chains; chain++) {
+            move_entity_from_physics(registry, entities[chain * chain_length + chain_length - 1], {0, 0, 1});
+        }
+        world.tick(0);
+        return world.get_changed_transforms().size();
+    };
+}
+
+TEST_CASE("World::tick gives the same transforms on any number of threads", "[world]") {
+    initialize_system_interface();
+
+    constexpr auto num_entities = 20000u;
+    constexpr auto seed = 42u;
+
+    const auto tick_moved_roots = [&](World& world) {
+        const auto roots = create_random_forest(world, num_entities, seed);
+        world.tick(0);
+        for(const auto root : roots) {
+            move_entity(world.get_registry(), root, {0.5f, 0.25f, -1});
+        }
+        world.tick(0);
+    };
+
+    // One chunk per level runs every level on the calling thread
+    auto serial_world = World{};
+    {
+        const auto chunk_size = ScopedTransformChunkSize{eastl::numeric_limits<int32_t>::max()};
+        tick_moved_roots(serial_world);
+    }
+    const auto expected_entities = serial_world.get_changed_transforms();
+    const auto expected_matrices = serial_world.get_changed_local_to_world();
+    REQUIRE(expected_entities.size() == num_entities);
+
+    const auto chunk_size = ScopedTransformChunkSize{16};
+    for(const auto num_threads : {1u, 2u, 3u, 7u}) {
+        auto thread_pool = ThreadPool{num_threads};
+        auto world = World{thread_pool};
+        tick_moved_roots(world);
+
+        INFO(num_threads << " worker threads");
+        REQUIRE(world.get_changed_transforms().size() == expected_entities.size());
+        CHECK(eastl::equal(expected_entities.begin(), expected_entities.end(), world.get_changed_transforms().begin()));
+        CHECK(
+            std::memcmp(
+                expected_matrices.data(),
+                world.get_changed_local_to_world().data(),
+                expected_matrices.size_bytes()) == 0);
+    }
+}
+
+TEST_CASE("World::tick thread scaling", "[.benchmark]") {
+    initialize_system_interface();
+
+    // 10k chains of 10 entities, so every level has 10k entities to split up
+    const auto max_threads = eastl::max(std::thread::hardware_concurrency(), 1u);
+    for(auto num_threads = 1u; num_threads <= max_threads; num_threads *= 2) {
+        // The calling thread helps out, so the pool only needs the other threads. A single thread runs everything
+        // inline
+        auto thread_pool = ThreadPool{eastl::max(num_threads - 1, 1u)};
+        const auto chunk_size = ScopedTransformChunkSize{
+            num_threads == 1 ? eastl::numeric_limits<int32_t>::max() : 256
+        };
+
+        auto world = World{thread_pool};
+        const auto entities = create_chains(world, 10000, 10);
+        world.tick(0);
+
+        BENCHMARK(fmt::format("100k entities, {} threads", num_threads)) {
+            for(auto chain = 0u; chain < 10000; chain++) {
+                move_entity(world.get_registry(), entities[chain * 10], {0, 0, 1});
+            }
+            world.tick(0);
+            return world.get_changed_transforms().size();
+        };
+    }
+}
+
+TEST_CASE("find_component_in_children finds the closest child with the component", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto root = create_transform_entity(world, entt::null, {});
+    const auto deep_chain = create_transform_entity(world, root, {});
+    const auto deep = create_transform_entity(world, create_transform_entity(world, deep_chain, {}), {});
+    const auto close = create_transform_entity(world, create_transform_entity(world, root, {}), {});
+    const auto outside = create_transform_entity(world, entt::null, {});
+    registry.emplace<SearchTarget>(root);
+    registry.emplace<SearchTarget>(deep);
+    registry.emplace<SearchTarget>(close);
+    registry.emplace<SearchTarget>(outside);
+
+    CHECK(World::find_component_in_children<SearchTarget>(world.make_handle(root)).entity() == close);
+    CHECK(World::find_component_in_children<SearchTarget>(world.make_handle(deep_chain)).entity() == deep);
+    CHECK_FALSE(World::find_component_in_children<SearchTarget>(world.make_handle(deep)).valid());
+    CHECK_FALSE(World::find_component_in_children<SearchTarget>(world.make_handle(outside)).valid());
+}
+
+TEST_CASE("find_component_in_children breaks ties by child order however it searches", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto root = create_transform_entity(world, entt::null, {});
+    const auto parent = create_transform_entity(world, root, {});
+    const auto first = create_transform_entity(world, parent, {});
+    const auto second = create_transform_entity(world, parent, {});
+
+    // Swap the children, so that child order, ID order, and the component storage's order all disagree
+    registry.emplace<SearchTarget>(first);
+    registry.emplace<SearchTarget>(second);
+    auto& children = registry.get<TransformComponent>(parent).children;
+    eastl::swap(children[0], children[1]);
+
+    SECTION("Walking down the tree") {
+        for(auto i = 0; i < 16; i++) {
+            registry.emplace<SearchTarget>(create_transform_entity(world, entt::null, {}));
+        }
+    }
+
+    SECTION("Walking up from each entity with the component") {
+        for(auto i = 0; i < 16; i++) {
+            create_transform_entity(world, root, {});
+        }
+    }
+
+    CHECK(World::find_component_in_children<SearchTarget>(world.make_handle(root)).entity() == second);
+
+    // A cousin under an earlier parent comes first, even though it's newer
+    const auto earlier_parent = create_transform_entity(world, root, {});
+    const auto cousin = create_transform_entity(world, earlier_parent, {});
+    registry.emplace<SearchTarget>(cousin);
+    auto& root_children = registry.get<TransformComponent>(root).children;
+    root_children.erase_first(earlier_parent);
+    root_children.insert(root_children.begin(), earlier_parent);
+
+    CHECK(World::find_component_in_children<SearchTarget>(world.make_handle(root)).entity() == cousin);
+}
+
+TEST_CASE("find_component_in_children against the recursive search", "[.benchmark]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    // 100 chains of 100 entities under one root, with the component at the end of the last chain
+    const auto root = create_transform_entity(world, entt::null, {});
+    const auto entities = create_chains(world, 100, 100);
+    for(auto chain = 0u; chain < 100; chain++) {
+        world.parent_entity_to_entity(entities[chain * 100], root);
+    }
+    registry.emplace<SearchTarget>(entities.back());
+
+    BENCHMARK("Large tree, one entity with the component") {
+        return World::find_component_in_children<SearchTarget>(world.make_handle(root));
+    };
+
+    BENCHMARK("Large tree, one entity with the component, recursive") {
+        return find_component_recursively<SearchTarget>(world.make_handle(root));
+    };
+
+    // Lots of entities with the component, the closest one right below the root
+    for(auto i = 1u; i < entities.size(); i += 10) {
+        registry.emplace_or_replace<SearchTarget>(entities[i]);
+    }
+    registry.emplace<SearchTarget>(create_transform_entity(world, root, {}));
+
+    BENCHMARK("Large tree, many entities with the component") {
+        return World::find_component_in_children<SearchTarget>(world.make_handle(root));
+    };
+
+    BENCHMARK("Large tree, many entities with the component, recursive") {
+        return find_component_recursively<SearchTarget>(world.make_handle(root));
+    };
+}
+
+TEST_CASE("World::tick destroys queued entities with their children", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto root = create_transform_entity(world, entt::null, {});
+    const auto doomed = create_transform_entity(world, root, {});
+    const auto doomed_child = create_transform_entity(world, doomed, {});
+    const auto survivor = create_transform_entity(world, root, {});
+
+    // Queueing a child along with its parent, or an entity twice, is fine
+    world.destroy_entity(doomed_child);
+    world.destroy_entity(doomed);
+    world.destroy_entity(doomed);
+    CHECK(registry.valid(doomed));
+
+    world.tick(0);
+    CHECK_FALSE(registry.valid(doomed));
+    CHECK_FALSE(registry.valid(doomed_child));
+    REQUIRE(registry.valid(root));
+    CHECK(registry.get<TransformComponent>(root).children.size() == 1);
+    CHECK(registry.get<TransformComponent>(root).children[0] == survivor);
+
+    world.destroy_entity(root);
+    world.tick(0);
+    CHECK_FALSE(registry.valid(root));
+    CHECK_FALSE(registry.valid(survivor));
+}
+
+TEST_CASE("World::tick destroying entity subtrees", "[.benchmark]") {
+    initialize_system_interface();
+
+    // Each run needs its own entities to destroy, so each run gets its own world
+    const auto benchmark_destroy = [](const uint32_t num_chains, const uint32_t chain_length) {
+        return [=](Catch::Benchmark::Chronometer meter) {
+            auto worlds = std::vector<std::unique_ptr<World>>{};
+            auto entities = eastl::vector<entt::entity>{};
+            for(auto run = 0; run < meter.runs(); run++) {
+                auto& world = *worlds.emplace_back(std::make_unique<World>());
+                entities = create_chains(world, num_chains, chain_length);
+                world.tick(0);
+            }
+
+            meter.measure([&](const int run) {
+                auto& world = *worlds[run];
+                for(auto chain = 0u; chain < num_chains; chain++) {
+                    world.destroy_entity(entities[chain * chain_length]);
+                }
+                world.tick(0);
+                return world.get_registry().valid(entities.back());
+            });
+        };
+    };
+
+    BENCHMARK_ADVANCED("1000 subtrees of 100 entities")(Catch::Benchmark::Chronometer meter) {
+        benchmark_destroy(1000, 100)(meter);
+    };
+
+    BENCHMARK_ADVANCED("One subtree of 100k entities")(Catch::Benchmark::Chronometer meter) {
+        benchmark_destroy(1, 100000)(meter);
+    };
+}
+
+TEST_CASE("find_entity and find_child see renamed entities", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    const auto root = create_named_entity(world, entt::null, "Root");
+    const auto arm = create_named_entity(world, root, "Arm");
+    const auto hand = create_named_entity(world, arm, "Hand");
+
+    CHECK(world.find_entity("Root").entity() == root);
+    CHECK(world.find_entity("Hand").entity() == hand);
+    CHECK(world.find_child(world.make_handle(root), "Hand").entity() == hand);
+    CHECK_FALSE(world.find_child(world.make_handle(hand), "Hand").valid());
+    CHECK_FALSE(world.find_child(world.make_handle(root), "Root").valid());
+
+    registry.patch<EntityInfoComponent>(
+        hand,
+        [](EntityInfoComponent& info) {
+            info.name = "Claw";
+        });
+    CHECK_FALSE(world.find_entity("Hand").valid());
+    CHECK_FALSE(world.find_child(world.make_handle(root), "Hand").valid());
+    CHECK(world.find_entity("Claw").entity() == hand);
+    CHECK(world.find_child(world.make_handle(root), "Claw").entity() == hand);
+
+    registry.replace<EntityInfoComponent>(arm, EntityInfoComponent{.name = "Tentacle"});
+    CHECK_FALSE(world.find_entity("Arm").valid());
+    CHECK(world.find_child(world.make_handle(root), "Tentacle").entity() == arm);
+
+    registry.emplace_or_replace<EntityInfoComponent>(arm, EntityInfoComponent{.name = "Arm"});
+    CHECK_FALSE(world.find_entity("Tentacle").valid());
+    CHECK(world.find_entity("Arm").entity() == arm);
+
+    registry.remove<EntityInfoComponent>(hand);
+    CHECK_FALSE(world.find_entity("Claw").valid());
+    CHECK_FALSE(world.find_child(world.make_handle(root), "Claw").valid());
+}
+
+TEST_CASE("find_entity and find_child forget destroyed entities", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+
+    const auto root = create_named_entity(world, entt::null, "Root");
+    const auto arm = create_named_entity(world, root, "Arm");
+    create_named_entity(world, arm, "Hand");
+
+    // Destruction waits for the next tick
+    world.destroy_entity(arm);
+    CHECK(world.find_entity("Hand").valid());
+
+    world.tick(0);
+    CHECK_FALSE(world.find_entity("Arm").valid());
+    CHECK_FALSE(world.find_entity("Hand").valid());
+    CHECK_FALSE(world.find_child(world.make_handle(root), "Hand").valid());
+
+    // New entities may reuse the destroyed entities' IDs, but not their names
+    const auto new_hand = create_named_entity(world, root, "New Hand");
+    create_named_entity(world, root, "New Arm");
+    CHECK_FALSE(world.find_entity("Hand").valid());
+    CHECK(world.find_child(world.make_handle(root), "New Hand").entity() == new_hand);
+}
+
+TEST_CASE("find_entity and find_child pick one of several entities with the same name", "[world]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    // find_entity prefers top-level entities, wherever they are in the index
+    const auto root = create_named_entity(world, entt::null, "Root");
+    const auto child_door = create_named_entity(world, root, "Door");
+    const auto top_level_door = create_named_entity(world, entt::null, "Door");
+    CHECK(world.find_entity("Door").entity() == top_level_door);
+
+    world.destroy_entity(top_level_door);
+    world.tick(0);
+    CHECK(world.find_entity("Door").entity() == child_door);
+
+    // find_child prefers the closest child, then the first in child order
+    const auto house = create_named_entity(world, root, "House");
+    const auto room = create_named_entity(world, house, "Room");
+    const auto deep_window = create_named_entity(world, room, "Window");
+    const auto first_window = create_named_entity(world, house, "Window");
+    const auto second_window = create_named_entity(world, house, "Window");
+    CHECK(world.find_child(world.make_handle(house), "Window").entity() == first_window);
+    CHECK(world.find_child(world.make_handle(room), "Window").entity() == deep_window);
+
+    auto& children = registry.get<TransformComponent>(house).children;
+    children.erase_first(second_window);
+    children.insert(children.begin(), second_window);
+    CHECK(world.find_child(world.make_handle(house), "Window").entity() == second_window);
+}
+
+TEST_CASE("find_entity and find_child against the recursive search", "[.benchmark]") {
+    initialize_system_interface();
+    auto world = World{};
+    auto& registry = world.get_registry();
+
+    // 100 top-level chains of 100 named entities
+    constexpr auto num_chains = 100u;
+    constexpr auto chain_length = 100u;
+    const auto entities = create_chains(world, num_chains, chain_length);
+    for(auto i = 0u; i < entities.size(); i++) {
+        const auto name = fmt::format("Node {}", i);
+        registry.emplace<EntityInfoComponent>(entities[i], EntityInfoComponent{.name = name.c_str()});
+    }
+    for(auto chain = 0u; chain < num_chains; chain++) {
+        world.add_top_level_entities(eastl::array{world.make_handle(entities[chain * chain_length])});
+    }
+
+    const auto root_name = fmt::format("Node {}", (num_chains - 1) * chain_length);
+    const auto leaf_name = fmt::format("Node {}", entities.size() - 1);
+    const auto last_root = world.make_handle(entities[(num_chains - 1) * chain_length]);
+
+    BENCHMARK("find_entity, top-level entity") {
+        return world.find_entity(root_name.c_str());
+    };
+
+    BENCHMARK("find_entity, top-level entity, recursive") {
+        return find_entity_recursively(world, root_name.c_str());
+    };
+
+    BENCHMARK("find_entity, leaf of the last chain") {
+        return world.find_entity(leaf_name.c_str());
+    };
+
+    BENCHMARK("find_entity, leaf of the last chain, recursive") {
+        return find_entity_recursively(world, leaf_name.c_str());
+    };
+
+    BENCHMARK("find_child, leaf of a chain") {
+        return world.find_child(last_root, leaf_name.c_str());
+    };
+
+    BENCHMARK("find_child, leaf of a chain, recursive") {
+        return find_child_recursively(last_root, leaf_name.c_str());
+    };
+
+    BENCHMARK("find_entity, missing name") {
+        return world.find_entity("Missing");
+    };
+
+    BENCHMARK("find_entity, missing name, recursive") {
+        return find_entity_recursively(world, "Missing");
+    };
+}